@@ -73,6 +73,17 @@ const std::optional<std::set<int>>& LocalClientOptions::allowed_devices()
   return allowed_devices_;
 }
 
+LocalClientOptions& LocalClientOptions::set_compilation_cache_options(
+    const CompilationCache::Options& compilation_cache_options) {
+  compilation_cache_options_ = compilation_cache_options;
+  return *this;
+}
+
+const CompilationCache::Options&
+LocalClientOptions::compilation_cache_options() const {
+  return compilation_cache_options_;
+}
+
 /* static */ ClientLibrary& ClientLibrary::Singleton() {
   static ClientLibrary* c = new ClientLibrary;
   return *c;
@@ -111,6 +122,8 @@ ClientLibrary::~ClientLibrary() = default;
   service_options.set_intra_op_parallelism_threads(
       options.intra_op_parallelism_threads());
   service_options.set_allowed_devices(options.allowed_devices());
+  service_options.set_compilation_cache_options(
+      options.compilation_cache_options());
   auto instance = std::make_unique<LocalInstance>();
   TF_ASSIGN_OR_RETURN(instance->service,
                       LocalService::NewService(service_options));
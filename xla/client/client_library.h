@@ -31,6 +31,7 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "xla/client/compile_only_client.h"
 #include "xla/client/local_client.h"
+#include "xla/service/compilation_cache.h"
 #include "xla/service/compile_only_service.h"
 #include "xla/service/local_service.h"
 #include "xla/statusor.h"
@@ -67,11 +68,18 @@ class LocalClientOptions {
       const std::optional<std::set<int>>& allowed_devices);
   const std::optional<std::set<int>>& allowed_devices() const;
 
+  // Sets the byte budget, eviction policy and sharding of the service's cache
+  // of compiled executables.
+  LocalClientOptions& set_compilation_cache_options(
+      const CompilationCache::Options& compilation_cache_options);
+  const CompilationCache::Options& compilation_cache_options() const;
+
  private:
   se::Platform* platform_;
   int number_of_replicas_;
   int intra_op_parallelism_threads_;
   std::optional<std::set<int>> allowed_devices_;
+  CompilationCache::Options compilation_cache_options_;
 };
 
 class ClientLibrary {
@@ -506,6 +506,58 @@ void MakeDebugOptionsFlags(std::vector<tsl::Flag>* flag_list,
                 bool_setter_for(&DebugOptions::set_xla_cpu_use_xla_runtime),
                 debug_options->xla_cpu_use_xla_runtime(),
                 "Enable XLA Runtime in the CPU backend."));
+  flag_list->push_back(tsl::Flag(
+      "xla_hlo_pass_computation_threads",
+      int32_setter_for(&DebugOptions::set_xla_hlo_pass_computation_threads),
+      debug_options->xla_hlo_pass_computation_threads(),
+      "Number of threads used to run computation-local HLO passes over "
+      "independent computations concurrently (<= 1 = serial)."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_persistent_cache_dir",
+      string_setter_for(&DebugOptions::set_xla_cpu_persistent_cache_dir),
+      debug_options->xla_cpu_persistent_cache_dir(),
+      "If non-empty, compiled CPU executables are stored in and reused from "
+      "this directory across processes."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_persistent_cache_max_size_bytes",
+      int64_setter_for(
+          &DebugOptions::set_xla_cpu_persistent_cache_max_size_bytes),
+      debug_options->xla_cpu_persistent_cache_max_size_bytes(),
+      "Maximum total size of --xla_cpu_persistent_cache_dir; least recently "
+      "used entries are evicted beyond it (<= 0 = unbounded)."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_memory_limit_bytes",
+      int64_setter_for(&DebugOptions::set_xla_cpu_memory_limit_bytes),
+      debug_options->xla_cpu_memory_limit_bytes(),
+      "If positive, CPU modules are rematerialized until their peak memory "
+      "fits in this many bytes (<= 0 = no limit)."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_fusion_profile_path",
+      string_setter_for(&DebugOptions::set_xla_cpu_fusion_profile_path),
+      debug_options->xla_cpu_fusion_profile_path(),
+      "Path to a ProfiledInstructionsProto text file whose per-instruction "
+      "run times guide the CPU fusion decisions."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_codegen_parallelism",
+      int32_setter_for(&DebugOptions::set_xla_cpu_codegen_parallelism),
+      debug_options->xla_cpu_codegen_parallelism(),
+      "If greater than 1, the CPU JIT splits the LLVM IR of a module into up "
+      "to this many modules that are compiled concurrently (<= 1 = a single "
+      "module)."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_aot_parallelism",
+      int32_setter_for(&DebugOptions::set_xla_cpu_aot_parallelism),
+      debug_options->xla_cpu_aot_parallelism(),
+      "If greater than 1, ahead-of-time compiled CPU executables run large "
+      "loops on up to this many threads of the thread pool passed at run time "
+      "(<= 1 = single-threaded)."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_host_throughput_path",
+      string_setter_for(&DebugOptions::set_xla_cpu_host_throughput_path),
+      debug_options->xla_cpu_host_throughput_path(),
+      "Path to a file caching the measured throughput of this machine for "
+      "the CPU JIT's parallel task assignment; measured and written if "
+      "missing (empty = fixed defaults)."));
   flag_list->push_back(tsl::Flag(
       "xla_cpu_sparse_cuda_threads",
       int32_setter_for(&DebugOptions::set_xla_cpu_sparse_cuda_threads),
@@ -93,6 +93,17 @@ const Eigen::ThreadPoolDevice* ExecutableRunOptions::intra_op_thread_pool()
   return intra_op_thread_pool_;
 }
 
+ExecutableRunOptions& ExecutableRunOptions::set_cpu_runtime_thread_pool(
+    const cpu::RuntimeThreadPool* cpu_runtime_thread_pool) {
+  cpu_runtime_thread_pool_ = cpu_runtime_thread_pool;
+  return *this;
+}
+
+const cpu::RuntimeThreadPool* ExecutableRunOptions::cpu_runtime_thread_pool()
+    const {
+  return cpu_runtime_thread_pool_;
+}
+
 ExecutableRunOptions& ExecutableRunOptions::set_execution_profile(
     ExecutionProfile* profile) {
   execution_profile_ = profile;
@@ -51,6 +51,10 @@ class DeviceAssignment;
 class ExecutionProfile;
 class Shape;
 
+namespace cpu {
+class RuntimeThreadPool;
+}  // namespace cpu
+
 namespace gpu {
 class GpuExecutableRunOptions;
 }  // namespace gpu
@@ -160,6 +164,16 @@ class ExecutableRunOptions {
       const Eigen::ThreadPoolDevice* intra_op_thread_pool);
   const Eigen::ThreadPoolDevice* intra_op_thread_pool() const;
 
+  // Sets the thread pool on which XLA:CPU executables run their parallel
+  // loops, in place of the intra-op thread pool. This lets ahead-of-time
+  // compiled models run multi-threaded on a pool of the client's choosing. If
+  // neither pool is set, parallel loops run on the calling thread.
+  //
+  // Does not take ownership.
+  ExecutableRunOptions& set_cpu_runtime_thread_pool(
+      const cpu::RuntimeThreadPool* cpu_runtime_thread_pool);
+  const cpu::RuntimeThreadPool* cpu_runtime_thread_pool() const;
+
   // If set, profiling information is written to 'profile'.
   ExecutionProfile* execution_profile() const;
   ExecutableRunOptions& set_execution_profile(ExecutionProfile* profile);
@@ -222,6 +236,7 @@ class ExecutableRunOptions {
   const DeviceAssignment* device_assignment_ = nullptr;
   stream_executor::Stream* stream_ = nullptr;
   const Eigen::ThreadPoolDevice* intra_op_thread_pool_ = nullptr;
+  const cpu::RuntimeThreadPool* cpu_runtime_thread_pool_ = nullptr;
   ExecutionProfile* execution_profile_ = nullptr;
   int rng_seed_ = 0;
   int32_t launch_id_ = 0;
@@ -76,6 +76,8 @@ namespace xla {
 
 namespace {
 
+using hlo_evaluator_internal::HaveSameDenseLayout;
+using hlo_evaluator_internal::PopulateLinearParallel;
 using primitive_util::NativeTypeOf;
 
 template <typename OperandT>
@@ -116,8 +118,17 @@ StatusOr<Literal> Compare(const Shape& shape, ComparisonDirection direction,
   }
 
   Literal result(shape);
-  TF_RETURN_IF_ERROR(
-      result.Populate<bool>([&](absl::Span<const int64_t> multi_index) {
+  if (HaveSameDenseLayout(result, lhs_literal) &&
+      HaveSameDenseLayout(result, rhs_literal)) {
+    absl::Span<const OperandT> lhs_data = lhs_literal.data<OperandT>();
+    absl::Span<const OperandT> rhs_data = rhs_literal.data<OperandT>();
+    PopulateLinearParallel<bool>(result, [&](int64_t i) {
+      return compare_op(lhs_data[i], rhs_data[i]);
+    });
+    return std::move(result);
+  }
+  TF_RETURN_IF_ERROR(result.PopulateParallel<bool>(
+      [&](absl::Span<const int64_t> multi_index, int /*thread_id*/) {
         return compare_op(lhs_literal.Get<OperandT>(multi_index),
                           rhs_literal.Get<OperandT>(multi_index));
       }));
@@ -148,8 +159,17 @@ StatusOr<Literal> Compare<complex64>(const Shape& shape,
   }
 
   Literal result(shape);
-  TF_RETURN_IF_ERROR(
-      result.Populate<bool>([&](absl::Span<const int64_t> multi_index) {
+  if (HaveSameDenseLayout(result, lhs_literal) &&
+      HaveSameDenseLayout(result, rhs_literal)) {
+    absl::Span<const complex64> lhs_data = lhs_literal.data<complex64>();
+    absl::Span<const complex64> rhs_data = rhs_literal.data<complex64>();
+    PopulateLinearParallel<bool>(result, [&](int64_t i) {
+      return compare_op(lhs_data[i], rhs_data[i]);
+    });
+    return std::move(result);
+  }
+  TF_RETURN_IF_ERROR(result.PopulateParallel<bool>(
+      [&](absl::Span<const int64_t> multi_index, int /*thread_id*/) {
         return compare_op(lhs_literal.Get<complex64>(multi_index),
                           rhs_literal.Get<complex64>(multi_index));
       }));
@@ -180,8 +200,17 @@ StatusOr<Literal> Compare<complex128>(const Shape& shape,
   }
 
   Literal result(shape);
-  TF_RETURN_IF_ERROR(
-      result.Populate<bool>([&](absl::Span<const int64_t> multi_index) {
+  if (HaveSameDenseLayout(result, lhs_literal) &&
+      HaveSameDenseLayout(result, rhs_literal)) {
+    absl::Span<const complex128> lhs_data = lhs_literal.data<complex128>();
+    absl::Span<const complex128> rhs_data = rhs_literal.data<complex128>();
+    PopulateLinearParallel<bool>(result, [&](int64_t i) {
+      return compare_op(lhs_data[i], rhs_data[i]);
+    });
+    return std::move(result);
+  }
+  TF_RETURN_IF_ERROR(result.PopulateParallel<bool>(
+      [&](absl::Span<const int64_t> multi_index, int /*thread_id*/) {
         return compare_op(lhs_literal.Get<complex128>(multi_index),
                           rhs_literal.Get<complex128>(multi_index));
       }));
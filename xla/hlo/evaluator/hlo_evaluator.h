@@ -30,6 +30,7 @@ limitations under the License.
 #include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_instruction.h"
 #include "xla/hlo/ir/hlo_module.h"
+#include "xla/layout_util.h"
 #include "xla/literal.h"
 #include "xla/literal_util.h"
 #include "xla/service/call_graph.h"
@@ -75,6 +76,34 @@ constexpr ParsedWhileLoop kParsedDynamicWhileLoop = ParsedWhileLoop();
 std::optional<ParsedWhileLoop> PatternMatchParseWhileLoop(
     HloInstruction* while_op);
 
+namespace hlo_evaluator_internal {
+
+// Returns whether the static array literals `a` and `b` store their elements
+// in the same order, so that an elementwise op can walk their backing buffers
+// by position instead of by multi-dimensional index.
+inline bool HaveSameDenseLayout(const LiteralBase& a, const LiteralBase& b) {
+  return a.shape().is_static() && b.shape().is_static() &&
+         ShapeUtil::SameDimensions(a.shape(), b.shape()) &&
+         LayoutUtil::Equal(a.shape().layout(), b.shape().layout());
+}
+
+// Sets element i of the backing buffer of `result` to generator(i), splitting
+// the buffer into contiguous blocks that are populated in parallel. The
+// literals read by `generator` must have the same dense layout as `result`.
+template <typename ReturnT, typename Generator>
+void PopulateLinearParallel(Literal& result, const Generator& generator) {
+  absl::Span<ReturnT> data = result.data<ReturnT>();
+  ShapeUtil::ForEachLinearBlockParallel(
+      data.size(), /*min_block_size=*/1024,
+      [&](int64_t begin, int64_t end, int /*thread_id*/) {
+        for (int64_t i = begin; i < end; ++i) {
+          data[i] = generator(i);
+        }
+      });
+}
+
+}  // namespace hlo_evaluator_internal
+
 // Responsible for evaluating HLO and obtain literal as the evaluation results.
 //
 // This class is not thread-safe.
@@ -486,6 +515,12 @@ class HloEvaluator : public DfsHloVisitorWithDefault {
     TF_RET_CHECK(ShapeUtil::SameDimensions(shape, operand->shape()));
 
     Literal result(shape);
+    if (hlo_evaluator_internal::HaveSameDenseLayout(result, operand_literal)) {
+      absl::Span<const NativeT> operand_data = operand_literal.data<NativeT>();
+      hlo_evaluator_internal::PopulateLinearParallel<ReturnT>(
+          result, [&](int64_t i) { return unary_op(operand_data[i]); });
+      return std::move(result);
+    }
     TF_RETURN_IF_ERROR(result.PopulateParallel<ReturnT>(
         [&](absl::Span<const int64_t> multi_index, int) {
           return unary_op(operand_literal.Get<NativeT>(multi_index));
@@ -23,9 +23,11 @@ limitations under the License.
 #include <vector>
 
 #include "absl/strings/str_format.h"
+#include "xla/array2d.h"
 #include "xla/client/xla_builder.h"
 #include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/layout_util.h"
 #include "xla/literal.h"
 #include "xla/permutation_util.h"
 #include "xla/reference_util.h"
@@ -348,6 +350,52 @@ TEST_F(HloEvaluatorTest, DoesAdd) {
   TestBinaryOp(HloOpcode::kAdd, std::move(expected), std::move(lhs),
                std::move(rhs));
 }
+// Elementwise ops walk the operand buffers directly when all layouts agree
+// and fall back to multi-dimensional indexing otherwise; both must agree.
+TEST_F(HloEvaluatorTest, ElementwiseOpsWithMixedLayouts) {
+  const char* hlo_text = R"(
+HloModule ElementwiseOpsWithMixedLayouts
+
+ENTRY main {
+  a = f32[64,48]{1,0} parameter(0)
+  b = f32[64,48]{0,1} parameter(1)
+  add_same = f32[64,48]{1,0} add(a, a)
+  add_mixed = f32[64,48]{1,0} add(a, b)
+  lt = pred[64,48]{0,1} compare(a, b), direction=LT
+  neg = f32[64,48]{0,1} negate(b)
+  select = f32[64,48]{1,0} select(lt, add_same, add_mixed)
+  ROOT tuple = (f32[64,48]{1,0}, f32[64,48]{1,0}, pred[64,48]{0,1},
+                f32[64,48]{0,1}, f32[64,48]{1,0})
+    tuple(add_same, add_mixed, lt, neg, select)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+  Array2D<float> a_values(64, 48);
+  Array2D<float> b_values(64, 48);
+  for (int64_t i = 0; i < 64; ++i) {
+    for (int64_t j = 0; j < 48; ++j) {
+      a_values(i, j) = i * 48 + j;
+      b_values(i, j) = (j * 64 + i) % 1000;
+    }
+  }
+  Literal a = LiteralUtil::CreateR2FromArray2D(a_values);
+  Literal b = LiteralUtil::CreateR2FromArray2D(b_values).Relayout(
+      LayoutUtil::MakeLayout({0, 1}));
+  TF_ASSERT_OK_AND_ASSIGN(Literal result, Evaluate({&a, &b}));
+
+  for (int64_t i = 0; i < 64; ++i) {
+    for (int64_t j = 0; j < 48; ++j) {
+      const float x = a_values(i, j);
+      const float y = b_values(i, j);
+      ASSERT_EQ(result.Get<float>({i, j}, {0}), x + x);
+      ASSERT_EQ(result.Get<float>({i, j}, {1}), x + y);
+      ASSERT_EQ(result.Get<bool>({i, j}, {2}), x < y);
+      ASSERT_EQ(result.Get<float>({i, j}, {3}), -y);
+      ASSERT_EQ(result.Get<float>({i, j}, {4}), x < y ? x + x : x + y);
+    }
+  }
+}
+
 // Verifies that HloEvaluator evaluates a HLO instruction that performs
 // element-wise and with 2 operands.
 TEST_P(HloEvaluatorBf16Test, DoesAnd) {
@@ -2628,6 +2676,41 @@ void BM_ReducePrecisely(::testing::benchmark::State& state) {
 
 BENCHMARK(BM_ReducePrecisely);
 
+// Folds an elementwise chain over large constants, which is what constant
+// folding does for models with big embedded weights.
+void BM_ElementwiseChain(::testing::benchmark::State& state) {
+  const int64_t num_elements = state.range(0);
+  HloComputation::Builder b("BM_ElementwiseChain");
+  HloModuleConfig config;
+  config.set_debug_options(GetDebugOptionsFromFlags());
+  HloModule module("BM_ElementwiseChain", config);
+
+  std::vector<float> v(num_elements, 1.5f);
+  HloInstruction* constant = b.AddInstruction(
+      HloInstruction::CreateConstant(LiteralUtil::CreateR1<float>(v)));
+  const Shape& shape = constant->shape();
+  HloInstruction* mul = b.AddInstruction(HloInstruction::CreateBinary(
+      shape, HloOpcode::kMultiply, constant, constant));
+  HloInstruction* add = b.AddInstruction(
+      HloInstruction::CreateBinary(shape, HloOpcode::kAdd, mul, constant));
+  HloInstruction* exp = b.AddInstruction(
+      HloInstruction::CreateUnary(shape, HloOpcode::kExp, add));
+  HloInstruction* compare = b.AddInstruction(HloInstruction::CreateCompare(
+      ShapeUtil::ChangeElementType(shape, PRED), exp, constant,
+      ComparisonDirection::kGt));
+  module.AddEntryComputation(b.Build());
+
+  for (auto s : state) {
+    HloEvaluator hlo_eval;
+    hlo_eval
+        .Evaluate(compare, /*recursively_evaluate_nonconstant_operands=*/true)
+        .value();
+  }
+  state.SetItemsProcessed(state.iterations() * num_elements);
+}
+
+BENCHMARK(BM_ElementwiseChain)->Arg(1 << 12)->Arg(1 << 16)->Arg(1 << 22);
+
 TEST_P(HloEvaluatorBf16Test, ReduceAdd) {
   HloComputation::Builder b(TestName());
 
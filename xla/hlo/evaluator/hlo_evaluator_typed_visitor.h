@@ -1442,11 +1442,10 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
                   is_complex_v<ElementwiseT> ||
                   std::is_floating_point_v<ElementwiseT>) {
       Literal result(iota->shape());
-      ShapeUtil::ForEachIndexNoStatus(
-          iota->shape(), [&](absl::Span<const int64_t> idx) {
-            result.Set(idx, static_cast<ReturnT>(idx[iota->iota_dimension()]));
-            return true;
-          });
+      TF_RETURN_IF_ERROR(result.PopulateParallel<ReturnT>(
+          [&](absl::Span<const int64_t> idx, int) {
+            return static_cast<ReturnT>(idx[iota->iota_dimension()]);
+          }));
       parent_->evaluated_[iota] = std::move(result);
       return OkStatus();
     }
@@ -1579,12 +1578,22 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
     const Literal& rhs_literal = parent_->GetEvaluatedLiteralFor(rhs);
 
     Literal result(shape);
-
+    auto converted_op = ConvertBinaryFunction(binary_op);
+
+    if (hlo_evaluator_internal::HaveSameDenseLayout(result, lhs_literal) &&
+        hlo_evaluator_internal::HaveSameDenseLayout(result, rhs_literal)) {
+      absl::Span<const ReturnT> lhs_data = lhs_literal.data<ReturnT>();
+      absl::Span<const ReturnT> rhs_data = rhs_literal.data<ReturnT>();
+      hlo_evaluator_internal::PopulateLinearParallel<ReturnT>(
+          result, [&](int64_t i) {
+            return converted_op(lhs_data[i], rhs_data[i]);
+          });
+      return std::move(result);
+    }
     TF_RETURN_IF_ERROR(result.PopulateParallel<ReturnT>(
         [&](absl::Span<const int64_t> multi_index, int) {
-          return ConvertBinaryFunction(binary_op)(
-              lhs_literal.Get<ReturnT>(multi_index),
-              rhs_literal.Get<ReturnT>(multi_index));
+          return converted_op(lhs_literal.Get<ReturnT>(multi_index),
+                              rhs_literal.Get<ReturnT>(multi_index));
         }));
     return std::move(result);
   }
@@ -1607,6 +1616,18 @@ class HloEvaluatorTypedVisitor : public DfsHloVisitorWithDefault {
 
     Literal result(shape);
 
+    if (hlo_evaluator_internal::HaveSameDenseLayout(result, lhs_literal) &&
+        hlo_evaluator_internal::HaveSameDenseLayout(result, rhs_literal) &&
+        hlo_evaluator_internal::HaveSameDenseLayout(result, ehs_literal)) {
+      absl::Span<const LhsType> lhs_data = lhs_literal.data<LhsType>();
+      absl::Span<const RhsType> rhs_data = rhs_literal.data<RhsType>();
+      absl::Span<const EhsType> ehs_data = ehs_literal.data<EhsType>();
+      hlo_evaluator_internal::PopulateLinearParallel<ReturnT>(
+          result, [&](int64_t i) {
+            return ternary_op(lhs_data[i], rhs_data[i], ehs_data[i]);
+          });
+      return std::move(result);
+    }
     TF_RETURN_IF_ERROR(result.PopulateParallel<ReturnT>(
         [&](absl::Span<const int64_t> multi_index, int) {
           return ternary_op(lhs_literal.Get<LhsType>(multi_index),
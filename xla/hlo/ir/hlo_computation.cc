@@ -85,6 +85,7 @@ HloComputation::HloComputation(
       custom_call_instruction_(nullptr),
       is_custom_call_computation_(false) {
   param_instructions_.resize(parameter_count, nullptr);
+  instruction_iterators_.reserve(instructions->size());
   bool root_found = false;
   for (auto& instruction : *instructions) {
     if (instruction->opcode() == HloOpcode::kParameter) {
@@ -141,7 +142,11 @@ HloInstruction* HloComputation::AddInstruction(
 HloInstruction* HloComputation::AddInstructionInternal(
     std::unique_ptr<HloInstruction> instruction) {
   if (parent() != nullptr) {
-    instruction->UniquifyName(&parent()->instruction_name_uniquer());
+    // Names are uniquified once concurrent mutation ends; the name uniquer is
+    // shared by all computations of the module.
+    if (!parent()->concurrent_computation_mutation()) {
+      instruction->UniquifyName(&parent()->instruction_name_uniquer());
+    }
     instruction->SetUniqueId(parent()->NewUniqueInstructionId());
   }
   instruction->set_parent(this);
@@ -86,6 +86,9 @@ void HloModule::ReplaceEntryComputation(HloComputation* entry_computation) {
 HloComputation* HloModule::AddComputationInternal(
     std::unique_ptr<HloComputation> computation, bool is_entry,
     bool uniquify_identifiers, bool preserve_entry_layouts) {
+  CHECK(!concurrent_computation_mutation_)
+      << "Computations cannot be added while computations are mutated "
+         "concurrently";
   if (is_entry) {
     CHECK_EQ(nullptr, entry_computation_);
     entry_computation_ = computation.get();
@@ -153,6 +156,9 @@ HloComputation* HloModule::AddEntryComputationWithLayouts(
 }
 
 Status HloModule::RemoveEmbeddedComputation(HloComputation* to_remove) {
+  CHECK(!concurrent_computation_mutation_)
+      << "Computations cannot be removed while computations are mutated "
+         "concurrently";
   if (has_schedule() && !to_remove->IsCalledComputation()) {
     schedule_->remove_computation(to_remove);
   }
@@ -174,6 +180,35 @@ HloComputation* HloModule::AddEmbeddedComputation(
                                 /*preserve_entry_layouts=*/false);
 }
 
+void HloModule::BeginConcurrentComputationMutation() {
+  CHECK(!concurrent_computation_mutation_);
+  next_provisional_unique_id_.store(next_unique_id_,
+                                    std::memory_order_relaxed);
+  concurrent_computation_mutation_ = true;
+}
+
+void HloModule::EndConcurrentComputationMutation() {
+  CHECK(concurrent_computation_mutation_);
+  concurrent_computation_mutation_ = false;
+  const int first_provisional_id = next_unique_id_;
+  if (next_provisional_unique_id_.load(std::memory_order_relaxed) ==
+      first_provisional_id) {
+    return;
+  }
+  // Serial passes visit computations in post order, callees first, and add
+  // instructions in the order they appear in their computation. Storage order
+  // is unrelated to either.
+  for (HloComputation* computation : MakeComputationPostOrder()) {
+    for (HloInstruction* instruction : computation->instructions()) {
+      if (instruction->unique_id() >= first_provisional_id) {
+        instruction->ClearUniqueIdInternal();
+        instruction->SetUniqueId(NewUniqueInstructionId());
+        instruction->UniquifyName(&instruction_name_uniquer_);
+      }
+    }
+  }
+}
+
 void HloModule::MarkFusionDuplications(
     const absl::flat_hash_map<HloComputation*, HloComputation*>& replacements) {
   for (std::unique_ptr<HloComputation>& computation : computations_) {
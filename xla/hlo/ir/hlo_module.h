@@ -407,11 +407,30 @@ class HloModule {
 
   // Assign a new unique dense id for an instruction
   int NewUniqueInstructionId() {
+    if (concurrent_computation_mutation_) {
+      return next_provisional_unique_id_.fetch_add(1,
+                                                   std::memory_order_relaxed);
+    }
     int result = next_unique_id_;
     next_unique_id_++;
     return result;
   }
 
+  // Brackets a phase in which several computations of this module are mutated
+  // concurrently, e.g. by a computation-local pass run in parallel (see
+  // HloPassPipeline). During the phase each computation may be touched by at
+  // most one thread and no computation may be added or removed. Instructions
+  // added in the meantime get provisional ids and are not uniquified by name;
+  // EndConcurrentComputationMutation assigns their final ids and names in
+  // computation post order and then instruction order, like a serial pass
+  // would, so the resulting module does not depend on how the work was
+  // scheduled.
+  void BeginConcurrentComputationMutation();
+  void EndConcurrentComputationMutation();
+  bool concurrent_computation_mutation() const {
+    return concurrent_computation_mutation_;
+  }
+
   // input_output_alias_config indicates the list of aliased buffers that are
   // expected from the module.
   HloInputOutputAliasConfig& input_output_alias_config() {
@@ -616,6 +635,11 @@ class HloModule {
   NameUniquer instruction_name_uniquer_{/*separator=*/"."};
   int next_unique_id_ = 0;
 
+  // State of BeginConcurrentComputationMutation. Provisional ids start at
+  // next_unique_id_ and are handed out atomically.
+  bool concurrent_computation_mutation_ = false;
+  std::atomic<int> next_provisional_unique_id_{0};
+
   // Used to keep track of the next unique module id that should be assigned.
   static std::atomic<int> next_unique_module_id_;
   // A unique id to label modules with.
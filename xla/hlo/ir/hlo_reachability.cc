@@ -16,6 +16,8 @@ limitations under the License.
 #include "xla/hlo/ir/hlo_reachability.h"
 
 #include <queue>
+#include <utility>
+#include <vector>
 
 #include "absl/algorithm/container.h"
 #include "xla/hlo/ir/hlo_instruction.h"
@@ -64,6 +66,7 @@ void HloReachabilityMap::SetReachabilityToUnionHelper(
 
 void HloReachabilityMap::SetReachabilityToUnionHelper(
     absl::Span<const Index> input_indices, Index index) {
+  DCHECK_LT(index, bit_sets_.size());
   BitSet& bit_set = bit_sets_[index];
   // If instruction is part of inputs, don't reset the bit-set.
   if (!absl::c_linear_search(input_indices, index)) {
@@ -83,6 +86,37 @@ void HloReachabilityMap::Replace(const HloInstruction* original,
     indices_[GetKey(replacement)] = GetIndex(original);
     indices_.erase(GetKey(original));
   }
+  if (original != replacement) {
+    ReplaceChannelEdges(channel_dependencies_, channel_dependents_, original,
+                        replacement);
+    ReplaceChannelEdges(channel_dependents_, channel_dependencies_, original,
+                        replacement);
+  }
+}
+
+void HloReachabilityMap::ReplaceChannelEdges(
+    ChannelEdges& edges, ChannelEdges& inverse, const HloInstruction* original,
+    const HloInstruction* replacement) {
+  auto it = edges.find(original);
+  if (it == edges.end()) {
+    return;
+  }
+  ChannelEdges::mapped_type others = std::move(it->second);
+  edges.erase(it);
+  for (const HloInstruction* other : others) {
+    ChannelEdges::mapped_type& back_edges = inverse[other];
+    if (replacement != nullptr) {
+      absl::c_replace(back_edges, original, replacement);
+    } else {
+      back_edges.erase(absl::c_find(back_edges, original));
+      if (back_edges.empty()) {
+        inverse.erase(other);
+      }
+    }
+  }
+  if (replacement != nullptr) {
+    edges[replacement] = std::move(others);
+  }
 }
 
 std::unique_ptr<HloReachabilityMap> HloReachabilityMap::BuildWithRestrictions(
@@ -133,6 +167,10 @@ std::unique_ptr<HloReachabilityMap> HloReachabilityMap::Build(
     auto it = channel_dependencies.find(instruction);
     if (it != channel_dependencies.end()) {
       absl::c_for_each(it->second, add_dependencies);
+      for (const HloInstruction* dependency : it->second) {
+        result->channel_dependencies_[instruction].push_back(dependency);
+        result->channel_dependents_[dependency].push_back(instruction);
+      }
     }
   }
   return result;
@@ -152,17 +190,78 @@ void HloReachabilityMap::UpdateReachabilityThroughInstruction(
     inputs.assign(item->operands().begin(), item->operands().end());
     inputs.insert(inputs.end(), item->control_predecessors().begin(),
                   item->control_predecessors().end());
+    auto dependencies = channel_dependencies_.find(item);
+    if (dependencies != channel_dependencies_.end()) {
+      for (const HloInstruction* dependency : dependencies->second) {
+        inputs.insert(inputs.end(), dependency->operands().begin(),
+                      dependency->operands().end());
+        inputs.insert(inputs.end(), dependency->control_predecessors().begin(),
+                      dependency->control_predecessors().end());
+      }
+    }
 
-    if (SetReachabilityToUnion(inputs, item)) {
-      // Add immediate successors to worklist.
-      for (const HloInstruction* user : item->users()) {
+    bool changed;
+    if (IsPresent(item)) {
+      changed = SetReachabilityToUnion(inputs, item);
+    } else {
+      // A new instruction: its users cannot have seen it yet.
+      SetReachabilityToUnionHelper(inputs, AddIndex(item));
+      changed = true;
+    }
+    // Add immediate successors to worklist. Successors that are not in the map
+    // yet are visited even if nothing changed, so that they get added.
+    for (const HloInstruction* user : item->users()) {
+      if (changed || !IsPresent(user)) {
         worklist.push(user);
       }
-      for (const HloInstruction* succ : item->control_successors()) {
+    }
+    for (const HloInstruction* succ : item->control_successors()) {
+      if (changed || !IsPresent(succ)) {
         worklist.push(succ);
       }
     }
+    // The instructions that depend on the predecessors of 'item' through a
+    // channel. Their predecessors changed iff the reachability of 'item' did.
+    auto dependents = channel_dependents_.find(item);
+    if (changed && dependents != channel_dependents_.end()) {
+      for (const HloInstruction* dependent : dependents->second) {
+        worklist.push(dependent);
+      }
+    }
+  }
+}
+
+HloReachabilityMap::Index HloReachabilityMap::AddInstruction(
+    const HloInstruction* instruction) {
+  CHECK(!IsPresent(instruction)) << instruction->name();
+  UpdateReachabilityThroughInstruction(instruction);
+  return GetIndex(instruction);
+}
+
+void HloReachabilityMap::RemoveInstruction(const HloInstruction* instruction) {
+  DCHECK_EQ(instruction->user_count(), 0) << instruction->name();
+  DCHECK(instruction->control_successors().empty()) << instruction->name();
+  auto it = indices_.find(GetKey(instruction));
+  if (it == indices_.end()) {
+    return;
   }
+  // Other bit-sets may still have the bit of the removed instruction set, which
+  // is harmless since its index is never handed out again.
+  bit_sets_[it->second].Clear();
+  indices_.erase(it);
+  ReplaceChannelEdges(channel_dependencies_, channel_dependents_, instruction,
+                      /*replacement=*/nullptr);
+  ReplaceChannelEdges(channel_dependents_, channel_dependencies_, instruction,
+                      /*replacement=*/nullptr);
+}
+
+HloReachabilityMap::Index HloReachabilityMap::AddIndex(
+    const HloInstruction* instruction) {
+  Index index = bit_sets_.size();
+  indices_[GetKey(instruction)] = index;
+  bit_sets_.emplace_back();
+  bit_sets_.back().Set(index);
+  return index;
 }
 
 }  // namespace xla
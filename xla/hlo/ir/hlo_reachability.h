@@ -16,12 +16,15 @@ limitations under the License.
 #ifndef XLA_HLO_IR_HLO_REACHABILITY_H_
 #define XLA_HLO_IR_HLO_REACHABILITY_H_
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <utility>
 #include <vector>
 
 #include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/types/span.h"
 #include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_instruction.h"
@@ -37,6 +40,15 @@ namespace xla {
 // transitive. That the graph be transitive is thus not an invariant of this
 // class, but it is required for the name of the class and its methods to make
 // sense.
+//
+// The map can be kept up to date while the computation is being rewritten,
+// which is much cheaper than calling Build again after every change: new
+// instructions are added with AddInstruction, instructions whose predecessors
+// changed (e.g. a fusion that absorbed another instruction) are refreshed with
+// UpdateReachabilityThroughInstruction, and dead instructions are dropped with
+// RemoveInstruction. Indices are never reused, and the bit-sets grow lazily,
+// so adding an instruction does not touch the bit-sets of the instructions
+// that cannot reach it.
 class HloReachabilityMap {
  public:
   using Index = size_t;
@@ -102,12 +114,37 @@ class HloReachabilityMap {
   void SetReachable(const HloInstruction* a, const HloInstruction* b) {
     SetReachable(GetIndex(a), GetIndex(b));
   }
-  void SetReachable(Index a, Index b) { bit_sets_[b].Set(a); }
+  void SetReachable(Index a, Index b) {
+    DCHECK_LT(a, bit_sets_.size());
+    DCHECK_LT(b, bit_sets_.size());
+    bit_sets_[b].Set(a);
+  }
 
   // Updates the given reachability map after the immediate predecessor set
-  // (operands and control predecessors) of 'instruction' has changed.
+  // (operands and control predecessors) of 'instruction' has changed. Only
+  // the instructions downstream of 'instruction' whose reachability actually
+  // changes are visited. 'instruction' and any of its transitive users that
+  // are not in the map yet (e.g. the get-tuple-elements created by a
+  // multi-output fusion) are added to it; their operands and control
+  // predecessors must already be present. The channel dependencies found by
+  // Build are followed like Build does; new channel instructions are not
+  // discovered, so the map must be rebuilt if any are added.
   void UpdateReachabilityThroughInstruction(const HloInstruction* instruction);
 
+  // Adds 'instruction', which must not be in the map yet, and computes its
+  // reachability from its operands and control predecessors, which must be.
+  // Reachability of the users of 'instruction' is updated as above. Returns
+  // the index of the new instruction.
+  Index AddInstruction(const HloInstruction* instruction);
+
+  // Drops 'instruction' from the map. It must not have any users or control
+  // successors and must still be alive, i.e. this is called before it is
+  // removed from its computation. Its index is not reused.
+  void RemoveInstruction(const HloInstruction* instruction);
+
+  // Returns the number of instructions in the map.
+  size_t size() const { return indices_.size(); }
+
   // Returns true if "b" is reachable from "a"
   //
   // Note that this function only correctly answers queries about reachability
@@ -115,7 +152,11 @@ class HloReachabilityMap {
   bool IsReachable(const HloInstruction* a, const HloInstruction* b) const {
     return IsReachable(GetIndex(a), GetIndex(b));
   }
-  bool IsReachable(Index a, Index b) const { return bit_sets_[b].Get(a); }
+  bool IsReachable(Index a, Index b) const {
+    DCHECK_LT(a, bit_sets_.size());
+    DCHECK_LT(b, bit_sets_.size());
+    return bit_sets_[b].Get(a);
+  }
 
   // Returns true if "b" is reachable from "a" or "a" is reachable from "b"
   //
@@ -140,28 +181,36 @@ class HloReachabilityMap {
 
  private:
   // A dynamically sized bit-set implementation specialized for this use case
-  // providing fast bitwise OR (not available in tsl::gtl::BitMap).
+  // providing fast bitwise OR (not available in tsl::gtl::BitMap). Bits past
+  // the end of the storage read as zero and the storage grows on demand, so
+  // bit-sets of different sizes can be combined.
   class BitSet {
    public:
     BitSet() = default;
-    explicit BitSet(size_t size)
-        : size_(size), vector_((size + kBits - 1) / kBits, 0) {}
+    explicit BitSet(size_t size) : vector_((size + kBits - 1) / kBits, 0) {}
 
     // Returns the bit at the given index.
     bool Get(Index index) const {
-      DCHECK(index >= 0 && index < size_);
-      return vector_[index / kBits] & (1ull << (index % kBits));
+      size_t word = index / kBits;
+      return word < vector_.size() &&
+             (vector_[word] & (1ull << (index % kBits)));
     }
 
     // Sets the bit at the given index.
     void Set(Index index) {
-      DCHECK(index >= 0 && index < size_);
-      vector_[index / kBits] |= 1ull << (index % kBits);
+      size_t word = index / kBits;
+      if (word >= vector_.size()) {
+        vector_.resize(word + 1, 0);
+      }
+      vector_[word] |= 1ull << (index % kBits);
     }
 
     // Sets this bit-set to union of this bit-set and `other`.
     void operator|=(const BitSet& other) {
-      for (size_t i = 0; i < vector_.size(); ++i) {
+      if (other.vector_.size() > vector_.size()) {
+        vector_.resize(other.vector_.size(), 0);
+      }
+      for (size_t i = 0; i < other.vector_.size(); ++i) {
         vector_[i] |= other.vector_[i];
       }
     }
@@ -169,8 +218,17 @@ class HloReachabilityMap {
     // Sets the bitvector to all zeros.
     void SetToZero() { absl::c_fill(vector_, 0); }
 
+    // Releases the storage of the bit-set.
+    void Clear() { std::vector<Word>().swap(vector_); }
+
     bool operator==(const BitSet& other) const {
-      return vector_ == other.vector_;
+      const std::vector<Word>& shorter =
+          vector_.size() < other.vector_.size() ? vector_ : other.vector_;
+      const std::vector<Word>& longer =
+          vector_.size() < other.vector_.size() ? other.vector_ : vector_;
+      return std::equal(shorter.begin(), shorter.end(), longer.begin()) &&
+             std::all_of(longer.begin() + shorter.size(), longer.end(),
+                         [](Word word) { return word == 0; });
     }
     bool operator!=(const BitSet& other) const { return !(*this == other); }
 
@@ -178,7 +236,6 @@ class HloReachabilityMap {
     using Word = uint64_t;
     static constexpr size_t kBits = 64;
 
-    size_t size_;  // Number of bits in the set.
     std::vector<Word> vector_;
   };
 
@@ -187,6 +244,21 @@ class HloReachabilityMap {
     return {instruction->GetModule()->unique_id(), instruction->unique_id()};
   }
 
+  // Assigns the next unused index to 'instruction', which is only reachable
+  // from itself.
+  Index AddIndex(const HloInstruction* instruction);
+
+  // Edges between the instructions of a channel, see channel_dependencies_.
+  using ChannelEdges =
+      absl::flat_hash_map<const HloInstruction*,
+                          absl::InlinedVector<const HloInstruction*, 1>>;
+
+  // Moves the edges of 'original' in 'edges' to 'replacement', or drops them
+  // if 'replacement' is null, and updates 'inverse' to match.
+  static void ReplaceChannelEdges(ChannelEdges& edges, ChannelEdges& inverse,
+                                  const HloInstruction* original,
+                                  const HloInstruction* replacement);
+
   // Helper for SetReachabilityToUnion/FastSetReachabilityToUnion.
   void SetReachabilityToUnionHelper(
       absl::Span<const HloInstruction* const> inputs, Index index);
@@ -204,6 +276,12 @@ class HloReachabilityMap {
   // A temporary used by SetReachabilityToUnion to avoid an allocation with each
   // call to the method.
   BitSet tmp_bit_set_;
+
+  // The channel dependencies found by Build, which the incremental updates
+  // follow: the predecessors of every instruction in channel_dependencies_[x]
+  // are also predecessors of x. channel_dependents_ is the inverse relation.
+  ChannelEdges channel_dependencies_;
+  ChannelEdges channel_dependents_;
 };
 
 }  // namespace xla
@@ -818,9 +818,29 @@ void MutableLiteralBase::PopulateInplaceInternal(
       return true;
     };
     if (parallel) {
-      ShapeUtil::ForEachIndexParallel(this_shape, stride_config.base,
-                                      stride_config.dimensions,
-                                      stride_config.step, init_function);
+      // Partition the backing buffer into contiguous blocks rather than
+      // scheduling a task per minor dimension row, which is too fine-grained
+      // for short rows and does not parallelize rank-1 literals at all.
+      absl::Span<const int64_t> minor_to_major =
+          this_shape.layout().minor_to_major();
+      ShapeUtil::ForEachLinearBlockParallel(
+          ShapeUtil::ElementsIn(this_shape), /*min_block_size=*/8,
+          [&](int64_t begin, int64_t end, int thread_id) {
+            std::vector<int64_t> indexes =
+                IndexUtil::LinearIndexToMultidimensionalIndex(this_shape,
+                                                              begin);
+            char* dest_ptr = dest_base + begin * primitive_size;
+            for (int64_t i = begin; i < end; ++i) {
+              populator(dest_ptr, indexes, thread_id);
+              dest_ptr += primitive_size;
+              for (int64_t dim : minor_to_major) {
+                if (++indexes[dim] < this_shape.dimensions(dim)) {
+                  break;
+                }
+                indexes[dim] = 0;
+              }
+            }
+          });
     } else {
       ShapeUtil::ForEachIndex(
           this_shape, stride_config.base, stride_config.dimensions,
@@ -2647,17 +2667,21 @@ BorrowingLiteral::BorrowingLiteral(absl::Span<const char* const> src_buf_ptrs,
                                    const Shape& shape)
     : LiteralBase(), shape_(std::make_unique<Shape>(shape)) {
   CHECK(shape_->IsTuple());
-  CHECK(!ShapeUtil::IsNestedTuple(*shape_));
-  CHECK_EQ(src_buf_ptrs.size(), ShapeUtil::TupleElementCount(*shape_));
   root_piece_ = Piece();
   root_piece_.set_subshape(shape_.get());
   BuildPieceSubtree(*shape_, &root_piece_);
 
-  for (int i = 0, end = src_buf_ptrs.size(); i < end; ++i) {
-    const auto& src_shape = shape_->tuple_shapes(i);
-    CHECK(src_shape.IsArray());
-    root_piece_.child(i).set_buffer(const_cast<char*>(src_buf_ptrs[i]));
-  }
+  int64_t next_buffer = 0;
+  root_piece_.ForEachMutableSubpiece(
+      [&](const ShapeIndex& index, Piece* piece) {
+        if (piece->subshape().IsTuple()) {
+          return;
+        }
+        CHECK(piece->subshape().IsArray());
+        CHECK_LT(next_buffer, src_buf_ptrs.size());
+        piece->set_buffer(const_cast<char*>(src_buf_ptrs[next_buffer++]));
+      });
+  CHECK_EQ(next_buffer, src_buf_ptrs.size());
 }
 
 }  // namespace xla
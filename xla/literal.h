@@ -1198,10 +1198,11 @@ class BorrowingLiteral : public LiteralBase {
   // data interpretered as indicated by 'shape'.
   // This constructor is only used for array shapes.
   BorrowingLiteral(const char* src_buf_ptr, const Shape& shape);
-  // Similar as above, except to be used for constructing non-nested tuples.
+  // Similar as above, except to be used for constructing tuples, possibly
+  // nested. 'src_buf_ptrs' holds one buffer per array leaf of 'shape', in the
+  // order the leaves are visited by ShapeUtil::ForEachSubshape.
   BorrowingLiteral(absl::Span<const char* const> src_buf_ptrs,
                    const Shape& shape);
-  // TODO(b/79707221): adding constructors for nested tuples as well.
 
  private:
   // Recursively builds the subtree for the given piece and sets the subshapes
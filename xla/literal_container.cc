@@ -0,0 +1,256 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/literal_container.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "absl/strings/string_view.h"
+#include "xla/layout_util.h"
+#include "xla/literal.h"
+#include "xla/primitive_util.h"
+#include "xla/shape.h"
+#include "xla/shape_util.h"
+#include "xla/status.h"
+#include "xla/statusor.h"
+#include "xla/util.h"
+#include "xla/xla_data.pb.h"
+#include "tsl/platform/byte_order.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+
+namespace xla {
+namespace {
+
+constexpr char kMagic[8] = {'X', 'L', 'A', 'L', 'I', 'T', '\0', '\1'};
+// Magic, shape size and number of buffers.
+constexpr int64_t kFixedHeaderSize = sizeof(kMagic) + 2 * sizeof(uint64_t);
+constexpr int64_t kIndexEntrySize = 2 * sizeof(uint64_t);
+
+void AppendUint64(uint64_t value, std::string* out) {
+  for (int i = 0; i < 8; ++i) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+uint64_t ReadUint64(absl::string_view data, int64_t offset) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i) {
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(data[offset + i]))
+             << (8 * i);
+  }
+  return value;
+}
+
+// Returns the array leaves of `shape` in ForEachSubshape order.
+StatusOr<std::vector<ShapeIndex>> ArrayLeafIndices(const Shape& shape) {
+  std::vector<ShapeIndex> leaves;
+  TF_RETURN_IF_ERROR(ShapeUtil::ForEachSubshapeWithStatus(
+      shape, [&](const Shape& subshape, const ShapeIndex& index) -> Status {
+        if (subshape.IsTuple()) {
+          return OkStatus();
+        }
+        if (!subshape.IsArray() || !LayoutUtil::IsDenseArray(subshape)) {
+          return InvalidArgument(
+              "Literal containers only support tuples and dense arrays, got "
+              "%s at index %s",
+              ShapeUtil::HumanStringWithLayout(subshape), index.ToString());
+        }
+        if (!subshape.is_static()) {
+          return InvalidArgument(
+              "Literal containers only support static shapes, got %s at index "
+              "%s",
+              ShapeUtil::HumanStringWithLayout(subshape), index.ToString());
+        }
+        leaves.push_back(index);
+        return OkStatus();
+      }));
+  return leaves;
+}
+
+// Writes `literal` as a container through `append`, which receives the
+// container in order as a sequence of chunks.
+Status WriteLiteralContainer(
+    const LiteralSlice& literal,
+    absl::FunctionRef<Status(absl::string_view)> append) {
+  if (!tsl::port::kLittleEndian) {
+    return Unimplemented("Literal containers require a little-endian host");
+  }
+  TF_ASSIGN_OR_RETURN(std::vector<ShapeIndex> leaves,
+                      ArrayLeafIndices(literal.shape()));
+  std::string shape_proto;
+  if (!literal.shape().ToProto().SerializeToString(&shape_proto)) {
+    return Internal("Failed to serialize shape %s",
+                    ShapeUtil::HumanStringWithLayout(literal.shape()));
+  }
+
+  std::string header(kMagic, sizeof(kMagic));
+  AppendUint64(shape_proto.size(), &header);
+  AppendUint64(leaves.size(), &header);
+  header.append(shape_proto);
+  header.resize(RoundUpTo<int64_t>(header.size(), 8), '\0');
+
+  int64_t offset = RoundUpTo<int64_t>(
+      header.size() + leaves.size() * kIndexEntrySize,
+      kLiteralContainerAlignment);
+  std::vector<int64_t> offsets;
+  offsets.reserve(leaves.size());
+  for (const ShapeIndex& index : leaves) {
+    int64_t size = literal.size_bytes(index);
+    offsets.push_back(offset);
+    AppendUint64(offset, &header);
+    AppendUint64(size, &header);
+    offset = RoundUpTo<int64_t>(offset + size, kLiteralContainerAlignment);
+  }
+
+  const std::string padding(kLiteralContainerAlignment, '\0');
+  int64_t written = 0;
+  auto write = [&](absl::string_view chunk) -> Status {
+    written += chunk.size();
+    return append(chunk);
+  };
+  TF_RETURN_IF_ERROR(write(header));
+  for (int64_t i = 0; i < leaves.size(); ++i) {
+    TF_RETURN_IF_ERROR(
+        write(absl::string_view(padding.data(), offsets[i] - written)));
+    TF_RETURN_IF_ERROR(write(absl::string_view(
+        static_cast<const char*>(literal.untyped_data(leaves[i])),
+        literal.size_bytes(leaves[i]))));
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+bool IsLiteralContainer(absl::string_view data) {
+  return data.size() >= sizeof(kMagic) &&
+         std::memcmp(data.data(), kMagic, sizeof(kMagic)) == 0;
+}
+
+StatusOr<bool> IsLiteralContainerFile(const std::string& path,
+                                      tsl::Env* env) {
+  std::unique_ptr<tsl::RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(path, &file));
+  char scratch[sizeof(kMagic)];
+  absl::string_view prefix;
+  Status status = file->Read(0, sizeof(kMagic), &prefix, scratch);
+  // Files shorter than the magic report OutOfRange.
+  if (!status.ok() && !tsl::errors::IsOutOfRange(status)) {
+    return status;
+  }
+  return IsLiteralContainer(prefix);
+}
+
+StatusOr<std::string> SerializeLiteralContainer(const LiteralSlice& literal) {
+  std::string out;
+  TF_RETURN_IF_ERROR(
+      WriteLiteralContainer(literal, [&](absl::string_view chunk) {
+        out.append(chunk.data(), chunk.size());
+        return OkStatus();
+      }));
+  return out;
+}
+
+Status WriteLiteralContainerToFile(const LiteralSlice& literal,
+                                   const std::string& path, tsl::Env* env) {
+  std::unique_ptr<tsl::WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(path, &file));
+  TF_RETURN_IF_ERROR(WriteLiteralContainer(
+      literal, [&](absl::string_view chunk) { return file->Append(chunk); }));
+  return file->Close();
+}
+
+StatusOr<BorrowingLiteral> ParseLiteralContainer(absl::string_view data) {
+  if (!tsl::port::kLittleEndian) {
+    return Unimplemented("Literal containers require a little-endian host");
+  }
+  if (data.size() < kFixedHeaderSize || !IsLiteralContainer(data)) {
+    return InvalidArgument("Data is not a literal container");
+  }
+  const uint64_t shape_size = ReadUint64(data, sizeof(kMagic));
+  const uint64_t num_buffers = ReadUint64(data, sizeof(kMagic) + 8);
+  if (shape_size > data.size() - kFixedHeaderSize) {
+    return InvalidArgument("Truncated literal container shape");
+  }
+  ShapeProto shape_proto;
+  if (!shape_proto.ParseFromArray(data.data() + kFixedHeaderSize,
+                                  shape_size)) {
+    return InvalidArgument("Failed to parse literal container shape");
+  }
+  Shape shape(shape_proto);
+  TF_RETURN_IF_ERROR(ShapeUtil::ValidateShapeWithOptionalLayout(shape));
+  if (!LayoutUtil::HasLayout(shape)) {
+    return InvalidArgument("Literal container shape %s has no layout",
+                           ShapeUtil::HumanString(shape));
+  }
+  TF_ASSIGN_OR_RETURN(std::vector<ShapeIndex> leaves, ArrayLeafIndices(shape));
+
+  const int64_t index_offset =
+      RoundUpTo<int64_t>(kFixedHeaderSize + shape_size, 8);
+  if (num_buffers != leaves.size() ||
+      index_offset + num_buffers * kIndexEntrySize > data.size()) {
+    return InvalidArgument(
+        "Literal container has %d buffers, but its shape %s has %d leaves",
+        num_buffers, ShapeUtil::HumanStringWithLayout(shape), leaves.size());
+  }
+
+  std::vector<const char*> buffers;
+  buffers.reserve(leaves.size());
+  for (int64_t i = 0; i < leaves.size(); ++i) {
+    const int64_t entry_offset = index_offset + i * kIndexEntrySize;
+    const uint64_t offset = ReadUint64(data, entry_offset);
+    const uint64_t size = ReadUint64(data, entry_offset + 8);
+    const Shape& leaf_shape = ShapeUtil::GetSubshape(shape, leaves[i]);
+    if (size != ShapeUtil::ByteSizeOf(leaf_shape) || offset > data.size() ||
+        size > data.size() - offset) {
+      return InvalidArgument(
+          "Literal container buffer %d (offset %d, size %d) does not hold a "
+          "%s array",
+          i, offset, size, ShapeUtil::HumanStringWithLayout(leaf_shape));
+    }
+    const char* buffer = data.data() + offset;
+    const int64_t alignment = std::min<int64_t>(
+        primitive_util::ByteWidth(leaf_shape.element_type()), 8);
+    if (reinterpret_cast<uintptr_t>(buffer) % alignment != 0) {
+      return InvalidArgument(
+          "Literal container buffer %d is not aligned to %d bytes", i,
+          alignment);
+    }
+    buffers.push_back(buffer);
+  }
+  if (shape.IsArray()) {
+    return BorrowingLiteral(buffers[0], shape);
+  }
+  return BorrowingLiteral(buffers, shape);
+}
+
+StatusOr<MappedLiteral> MappedLiteral::Open(const std::string& path,
+                                            tsl::Env* env) {
+  std::unique_ptr<tsl::ReadOnlyMemoryRegion> region;
+  TF_RETURN_IF_ERROR(env->NewReadOnlyMemoryRegionFromFile(path, &region));
+  absl::string_view data(static_cast<const char*>(region->data()),
+                         region->length());
+  TF_ASSIGN_OR_RETURN(BorrowingLiteral literal, ParseLiteralContainer(data));
+  return MappedLiteral(std::move(region), std::move(literal));
+}
+
+}  // namespace xla
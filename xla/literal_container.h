@@ -0,0 +1,100 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_LITERAL_CONTAINER_H_
+#define XLA_LITERAL_CONTAINER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "xla/literal.h"
+#include "xla/status.h"
+#include "xla/statusor.h"
+#include "tsl/platform/env.h"
+
+namespace xla {
+
+// A binary container for literals that can be used in place without parsing
+// or copying the array data, as an alternative to serialized LiteralProtos
+// for large inputs and outputs.
+//
+// Layout (all integers are little-endian uint64):
+//
+//   magic            8 bytes, "XLALIT\0" followed by the format version
+//   shape_size       size of the serialized ShapeProto
+//   num_buffers      number of array leaves of the shape
+//   shape            the serialized ShapeProto, padded to 8 bytes
+//   buffer index     num_buffers pairs of (offset, size) in bytes from the
+//                    start of the container, one per array leaf in the
+//                    order of ShapeUtil::ForEachSubshape
+//   buffers          the raw leaf data in the layout of the shape, each
+//                    starting at a multiple of kLiteralContainerAlignment
+//
+// Since every buffer is aligned relative to the start of the container, a
+// memory-mapped container can be wrapped in a BorrowingLiteral directly.
+// Only static shapes with dense array leaves are supported, and the buffers
+// are in host byte order, so containers are only portable between
+// little-endian hosts.
+inline constexpr int64_t kLiteralContainerAlignment = 64;
+
+// Returns true if `data` starts with the container magic.
+bool IsLiteralContainer(absl::string_view data);
+
+// Returns true if the file at `path` starts with the container magic.
+StatusOr<bool> IsLiteralContainerFile(const std::string& path,
+                                      tsl::Env* env = tsl::Env::Default());
+
+// Serializes `literal` into a container held in memory.
+StatusOr<std::string> SerializeLiteralContainer(const LiteralSlice& literal);
+
+// Writes `literal` as a container to `path`. The leaf buffers are streamed to
+// the file as they are, without building the container in memory first.
+Status WriteLiteralContainerToFile(const LiteralSlice& literal,
+                                   const std::string& path,
+                                   tsl::Env* env = tsl::Env::Default());
+
+// Returns a literal borrowing the leaf buffers of the container in `data`,
+// which must outlive it. Fails if the container is malformed or if a buffer is
+// not sufficiently aligned for its element type; containers mapped from a
+// file or held in heap memory always are.
+StatusOr<BorrowingLiteral> ParseLiteralContainer(absl::string_view data);
+
+// A literal container memory-mapped from a file. The literal is valid for the
+// lifetime of this object and pages in lazily as it is read.
+class MappedLiteral {
+ public:
+  static StatusOr<MappedLiteral> Open(const std::string& path,
+                                      tsl::Env* env = tsl::Env::Default());
+
+  MappedLiteral(MappedLiteral&&) = default;
+  MappedLiteral& operator=(MappedLiteral&&) = default;
+
+  const BorrowingLiteral& literal() const { return literal_; }
+
+ private:
+  MappedLiteral(std::unique_ptr<tsl::ReadOnlyMemoryRegion> region,
+                BorrowingLiteral literal)
+      : region_(std::move(region)), literal_(std::move(literal)) {}
+
+  std::unique_ptr<tsl::ReadOnlyMemoryRegion> region_;
+  BorrowingLiteral literal_;
+};
+
+}  // namespace xla
+
+#endif  // XLA_LITERAL_CONTAINER_H_
@@ -0,0 +1,178 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/literal_container.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "xla/array2d.h"
+#include "xla/layout_util.h"
+#include "xla/literal.h"
+#include "xla/literal_util.h"
+#include "xla/shape_util.h"
+#include "xla/test.h"
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+
+namespace xla {
+namespace {
+
+std::string TestPath(const std::string& name) {
+  return tsl::io::JoinPath(tsl::testing::TmpDir(), name);
+}
+
+TEST(LiteralContainerTest, RoundTripArray) {
+  Literal literal = LiteralUtil::CreateR2<float>({{1, 2, 3}, {4, 5, 6}});
+  TF_ASSERT_OK_AND_ASSIGN(std::string data, SerializeLiteralContainer(literal));
+  EXPECT_TRUE(IsLiteralContainer(data));
+  TF_ASSERT_OK_AND_ASSIGN(BorrowingLiteral parsed,
+                          ParseLiteralContainer(data));
+  EXPECT_EQ(parsed, literal);
+  // The array data is borrowed from the container, not copied.
+  const char* buffer = static_cast<const char*>(parsed.untyped_data());
+  EXPECT_GE(buffer, data.data());
+  EXPECT_LT(buffer, data.data() + data.size());
+  EXPECT_EQ((buffer - data.data()) % kLiteralContainerAlignment, 0);
+}
+
+TEST(LiteralContainerTest, RoundTripNonDefaultLayout) {
+  Literal literal = LiteralUtil::CreateR2WithLayout<int32_t>(
+      {{1, 2}, {3, 4}, {5, 6}}, LayoutUtil::MakeLayout({0, 1}));
+  TF_ASSERT_OK_AND_ASSIGN(std::string data, SerializeLiteralContainer(literal));
+  TF_ASSERT_OK_AND_ASSIGN(BorrowingLiteral parsed,
+                          ParseLiteralContainer(data));
+  EXPECT_TRUE(ShapeUtil::Equal(parsed.shape(), literal.shape()));
+  EXPECT_EQ(parsed, literal);
+}
+
+TEST(LiteralContainerTest, RoundTripNestedTuple) {
+  Literal literal = LiteralUtil::MakeTupleOwned(
+      LiteralUtil::CreateR0<bool>(true),
+      LiteralUtil::MakeTupleOwned(LiteralUtil::CreateR1<int8_t>({1, 2, 3}),
+                                  LiteralUtil::MakeTupleOwned()),
+      LiteralUtil::CreateR1<double>({}),
+      LiteralUtil::CreateR1<complex64>({complex64(1, 2), complex64(3, 4)}));
+  TF_ASSERT_OK_AND_ASSIGN(std::string data, SerializeLiteralContainer(literal));
+  TF_ASSERT_OK_AND_ASSIGN(BorrowingLiteral parsed,
+                          ParseLiteralContainer(data));
+  EXPECT_EQ(parsed, literal);
+}
+
+TEST(LiteralContainerTest, MappedFile) {
+  Array2D<float> values(123, 457);
+  values.FillIota(0.5f);
+  Literal literal = LiteralUtil::MakeTupleOwned(
+      LiteralUtil::CreateR2FromArray2D(values),
+      LiteralUtil::CreateR1<int64_t>({7, 8, 9}));
+  std::string path = TestPath("mapped_file.xlalit");
+  TF_ASSERT_OK(WriteLiteralContainerToFile(literal, path));
+
+  TF_ASSERT_OK_AND_ASSIGN(bool is_container, IsLiteralContainerFile(path));
+  EXPECT_TRUE(is_container);
+  TF_ASSERT_OK_AND_ASSIGN(MappedLiteral mapped, MappedLiteral::Open(path));
+  EXPECT_EQ(mapped.literal(), literal);
+
+  // Files written directly and serialized in memory are identical.
+  std::string contents;
+  TF_ASSERT_OK(tsl::ReadFileToString(tsl::Env::Default(), path, &contents));
+  TF_ASSERT_OK_AND_ASSIGN(std::string data, SerializeLiteralContainer(literal));
+  EXPECT_EQ(contents, data);
+}
+
+TEST(LiteralContainerTest, OtherFilesAreNotContainers) {
+  std::string path = TestPath("literal_proto.pb");
+  TF_ASSERT_OK(tsl::WriteBinaryProto(
+      tsl::Env::Default(), path, LiteralUtil::CreateR0<float>(1).ToProto()));
+  TF_ASSERT_OK_AND_ASSIGN(bool is_container, IsLiteralContainerFile(path));
+  EXPECT_FALSE(is_container);
+  EXPECT_FALSE(MappedLiteral::Open(path).ok());
+
+  std::string short_path = TestPath("short_file");
+  TF_ASSERT_OK(
+      tsl::WriteStringToFile(tsl::Env::Default(), short_path, "XLA"));
+  TF_ASSERT_OK_AND_ASSIGN(is_container, IsLiteralContainerFile(short_path));
+  EXPECT_FALSE(is_container);
+}
+
+TEST(LiteralContainerTest, RejectsTruncatedData) {
+  Literal literal = LiteralUtil::CreateR1<int32_t>({1, 2, 3, 4});
+  TF_ASSERT_OK_AND_ASSIGN(std::string data, SerializeLiteralContainer(literal));
+  for (int64_t size : {int64_t{4}, int64_t{20}, int64_t{40},
+                       static_cast<int64_t>(data.size()) - 1}) {
+    SCOPED_TRACE(size);
+    std::string truncated = data.substr(0, size);
+    EXPECT_FALSE(ParseLiteralContainer(truncated).ok());
+  }
+}
+
+TEST(LiteralContainerTest, RejectsUnsupportedShapes) {
+  EXPECT_FALSE(SerializeLiteralContainer(LiteralUtil::CreateToken()).ok());
+
+  Literal dynamic = LiteralUtil::CreateR1<float>({1, 2, 3});
+  dynamic.mutable_shape_do_not_use()->set_dynamic_dimension(0, true);
+  EXPECT_FALSE(SerializeLiteralContainer(dynamic).ok());
+}
+
+Literal MakeBenchmarkLiteral(int64_t num_elements) {
+  std::vector<float> values(num_elements);
+  for (int64_t i = 0; i < num_elements; ++i) {
+    values[i] = i;
+  }
+  return LiteralUtil::CreateR1<float>(values);
+}
+
+void BM_ReadLiteralProto(::testing::benchmark::State& state) {
+  const int64_t num_elements = state.range(0);
+  std::string path = TestPath("bm_literal.pb");
+  LiteralProto written = MakeBenchmarkLiteral(num_elements).ToProto();
+  TF_CHECK_OK(tsl::WriteBinaryProto(tsl::Env::Default(), path, written));
+  for (auto s : state) {
+    LiteralProto proto;
+    TF_CHECK_OK(tsl::ReadBinaryProto(tsl::Env::Default(), path, &proto));
+    Literal literal = Literal::CreateFromProto(proto).value();
+    tsl::testing::DoNotOptimize(literal);
+  }
+  state.SetBytesProcessed(state.iterations() * num_elements * sizeof(float));
+}
+BENCHMARK(BM_ReadLiteralProto)->Arg(1 << 10)->Arg(1 << 20)->Arg(1 << 24);
+
+void BM_OpenMappedLiteral(::testing::benchmark::State& state) {
+  const int64_t num_elements = state.range(0);
+  std::string path = TestPath("bm_literal.xlalit");
+  TF_CHECK_OK(
+      WriteLiteralContainerToFile(MakeBenchmarkLiteral(num_elements), path));
+  for (auto s : state) {
+    MappedLiteral mapped = MappedLiteral::Open(path).value();
+    // Touch one element per page so that the mapping is actually read.
+    absl::Span<const float> data = mapped.literal().data<float>();
+    float sum = 0;
+    for (int64_t i = 0; i < data.size(); i += 1024) {
+      sum += data[i];
+    }
+    tsl::testing::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * num_elements * sizeof(float));
+}
+BENCHMARK(BM_OpenMappedLiteral)->Arg(1 << 10)->Arg(1 << 20)->Arg(1 << 24);
+
+}  // namespace
+}  // namespace xla
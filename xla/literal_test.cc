@@ -1357,6 +1357,8 @@ TEST_F(LiteralUtilTest, PopulateParallel) {
       {{21, 12}, {0, 1}},
       {{6, 11, 17}, {2, 0, 1}},
       {{6, 11, 5, 17}, {3, 2, 0, 1}},
+      {{100003}, {0}},
+      {{37, 3, 41}, {1, 2, 0}},
   };
   for (const auto& data : populate_data) {
     Shape shape = ShapeUtil::MakeShapeWithDenseLayout(
@@ -1861,6 +1863,35 @@ TEST_F(LiteralUtilTest, BorrowingLiteralFromMultipleBufferPtrs) {
       literal_tuple.Get<int64_t>(/*multi_index=*/{2}, /*shape_index=*/{0}), 3);
 }
 
+TEST_F(LiteralUtilTest, BorrowingLiteralFromNestedTuple) {
+  std::vector<int64_t> one_two_three = {1, 2, 3};
+  const Shape one_two_three_shape = ShapeUtil::MakeShape(S64, {3});
+
+  std::vector<float> half = {0.5f};
+  const Shape half_shape = ShapeUtil::MakeShape(F32, {1});
+
+  std::vector<const char*> src_buf_ptrs;
+  src_buf_ptrs.emplace_back(
+      reinterpret_cast<const char*>(one_two_three.data()));
+  src_buf_ptrs.emplace_back(reinterpret_cast<const char*>(half.data()));
+  const Shape shape = ShapeUtil::MakeTupleShape(
+      {ShapeUtil::MakeTupleShape({one_two_three_shape}),
+       ShapeUtil::MakeTupleShape({}), half_shape});
+  BorrowingLiteral literal_tuple(src_buf_ptrs, shape);
+
+  EXPECT_EQ(literal_tuple.Get<int64_t>(/*multi_index=*/{2},
+                                       /*shape_index=*/{0, 0}),
+            3);
+  EXPECT_EQ(
+      literal_tuple.Get<float>(/*multi_index=*/{0}, /*shape_index=*/{2}), 0.5f);
+  EXPECT_EQ(literal_tuple,
+            LiteralUtil::MakeTupleOwned(
+                LiteralUtil::MakeTupleOwned(
+                    LiteralUtil::CreateR1<int64_t>({1, 2, 3})),
+                LiteralUtil::MakeTupleOwned(),
+                LiteralUtil::CreateR1<float>({0.5f})));
+}
+
 TEST_F(LiteralUtilTest, LiteralMove) {
   Literal matrix = LiteralUtil::CreateR2<float>({{1.0, 2.0}, {3.0, 4.0}});
   Literal literal(std::move(matrix));
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "xla/pjrt/abstract_tfrt_cpu_buffer.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstring>
 #include <functional>
@@ -26,11 +28,14 @@ limitations under the License.
 
 #include "absl/base/thread_annotations.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
+#include "xla/pjrt/cpu_buffer_allocator.h"
 #include "xla/pjrt/pjrt_client.h"
 #include "xla/pjrt/tracked_tfrt_cpu_device_buffer.h"
 #include "xla/pjrt/transpose.h"
@@ -56,6 +61,61 @@ namespace {
 using ::xla::runtime::CpuEvent;
 
 constexpr size_t kSmallDataTransferByteSize = 102400;  // 100 KiB
+// Contiguous host-to-device copies are split into chunks of at least this size
+// so that each chunk amortizes the cost of scheduling it.
+constexpr int64_t kMinH2DCopyChunkByteSize = 1 << 20;  // 1 MiB
+
+// Runs `work(i)` for every i in [0, num_chunks) and waits for all of them. The
+// first chunk runs on the calling thread, the others on `async_work_runner`.
+void RunChunks(AsyncWorkRunner* async_work_runner, int num_chunks,
+               const std::function<void(int)>& work) {
+  if (num_chunks <= 1) {
+    for (int i = 0; i < num_chunks; ++i) {
+      work(i);
+    }
+    return;
+  }
+  absl::BlockingCounter counter(num_chunks - 1);
+  for (int i = 1; i < num_chunks; ++i) {
+    async_work_runner->Schedule([&work, &counter, i]() {
+      tsl::profiler::TraceMe traceme("H2D Dispatch");
+      work(i);
+      counter.DecrementCount();
+    });
+  }
+  work(0);
+  counter.Wait();
+}
+
+// Schedules `work(i)` for every i in [0, num_chunks) on `async_work_runner`
+// without waiting for them. `done` runs once all chunks have finished, on the
+// thread that finished last.
+void ScheduleChunks(AsyncWorkRunner* async_work_runner, int num_chunks,
+                    std::function<void(int)> work,
+                    absl::AnyInvocable<void()> done) {
+  if (num_chunks == 0) {
+    done();
+    return;
+  }
+  struct State {
+    std::function<void(int)> work;
+    absl::AnyInvocable<void()> done;
+    std::atomic<int> pending_chunks;
+  };
+  auto state = std::make_shared<State>();
+  state->work = std::move(work);
+  state->done = std::move(done);
+  state->pending_chunks.store(num_chunks, std::memory_order_relaxed);
+  for (int i = 0; i < num_chunks; ++i) {
+    async_work_runner->Schedule([state, i]() {
+      tsl::profiler::TraceMe traceme("H2D Dispatch");
+      state->work(i);
+      if (state->pending_chunks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        state->done();
+      }
+    });
+  }
+}
 
 void CopyCpuBufferToLiteral(const Shape& device_shape,
                             TrackedTfrtCpuDeviceBuffer* device_buffer,
@@ -441,7 +501,9 @@ AbstractTfrtCpuBuffer::CopyToDeviceAcrossClients(PjRtDevice* dst_device) {
 }
 
 StatusOr<std::unique_ptr<TrackedTfrtCpuDeviceBuffer>>
-AbstractTfrtCpuBuffer::CopyToDeviceHelper(AsyncWorkRunner* async_work_runner) {
+AbstractTfrtCpuBuffer::CopyToDeviceHelper(
+    AsyncWorkRunner* async_work_runner,
+    const std::shared_ptr<CpuBufferAllocator>& allocator) {
   // Copy each leaf buffer to a destination buffer.
   auto usage_event = tfrt::MakeConstructedAsyncValueRef<CpuEvent>();
   auto* src_device_buffer = AcquireUsage(usage_event);
@@ -462,7 +524,7 @@ AbstractTfrtCpuBuffer::CopyToDeviceHelper(AsyncWorkRunner* async_work_runner) {
     auto src_buffer = src_device_buffer->Buffers()[i];
     TF_ASSIGN_OR_RETURN(
         std::shared_ptr<MaybeOwningCpuMemory> dst_buffer,
-        MaybeOwningCpuMemory::AllocateShared(src_buffer->size()));
+        MaybeOwningCpuMemory::AllocateShared(src_buffer->size(), allocator));
     src_buffers.push_back(std::move(src_buffer));
     dst_buffers.push_back(std::move(dst_buffer));
     dst_definition_events.push_back(
@@ -602,12 +664,14 @@ void AbstractTfrtCpuBuffer::CopyFromLiteral(
 /*static*/ StatusOr<std::unique_ptr<TrackedTfrtCpuDeviceBuffer>>
 AbstractTfrtCpuBuffer::AllocateTrackedDeviceBuffer(
     const Shape& on_device_shape,
-    absl::InlinedVector<tfrt::AsyncValueRef<CpuEvent>, 4> definition_events) {
+    absl::InlinedVector<tfrt::AsyncValueRef<CpuEvent>, 4> definition_events,
+    const std::shared_ptr<CpuBufferAllocator>& allocator) {
   absl::InlinedVector<std::shared_ptr<MaybeOwningCpuMemory>, 4> buffers;
   if (!on_device_shape.IsTuple()) {
     size_t byte_size = ShapeUtil::ByteSizeOf(on_device_shape);
-    TF_ASSIGN_OR_RETURN(std::shared_ptr<MaybeOwningCpuMemory> device_buffer,
-                        MaybeOwningCpuMemory::AllocateShared(byte_size));
+    TF_ASSIGN_OR_RETURN(
+        std::shared_ptr<MaybeOwningCpuMemory> device_buffer,
+        MaybeOwningCpuMemory::AllocateShared(byte_size, allocator));
     buffers.push_back(std::move(device_buffer));
     return std::make_unique<TrackedTfrtCpuDeviceBuffer>(
         /*is_tuple=*/false, std::move(buffers), std::move(definition_events));
@@ -616,8 +680,9 @@ AbstractTfrtCpuBuffer::AllocateTrackedDeviceBuffer(
   buffers.reserve(on_device_shape.tuple_shapes().size());
   for (const auto& leaf_shape : on_device_shape.tuple_shapes()) {
     size_t byte_size = ShapeUtil::ByteSizeOf(leaf_shape);
-    TF_ASSIGN_OR_RETURN(std::shared_ptr<MaybeOwningCpuMemory> device_buffer,
-                        MaybeOwningCpuMemory::AllocateShared(byte_size));
+    TF_ASSIGN_OR_RETURN(
+        std::shared_ptr<MaybeOwningCpuMemory> device_buffer,
+        MaybeOwningCpuMemory::AllocateShared(byte_size, allocator));
     buffers.push_back(std::move(device_buffer));
   }
   return std::make_unique<TrackedTfrtCpuDeviceBuffer>(
@@ -646,7 +711,8 @@ AbstractTfrtCpuBuffer::BufferFromHostBufferHelper(
     PjRtClient::HostBufferSemantics host_buffer_semantics,
     std::function<void()> on_done_with_host_buffer, const Shape& shape,
     AsyncWorkRunner* async_work_runner, absl::Mutex* transpose_mu,
-    TransposePlanCache* transpose_cache) {
+    TransposePlanCache* transpose_cache,
+    const std::shared_ptr<CpuBufferAllocator>& allocator) {
   bool has_default_layout =
       !byte_strides || HasMajorToMinorLayout(type, dims, *byte_strides);
   // If the input buffer has a default layout and is sufficiently aligned, we
@@ -668,61 +734,84 @@ AbstractTfrtCpuBuffer::BufferFromHostBufferHelper(
     buffers.push_back(std::move(device_buffer));
     on_delete_callback = std::move(on_done_with_host_buffer);
   } else {
-    TF_ASSIGN_OR_RETURN(std::shared_ptr<MaybeOwningCpuMemory> device_buffer,
-                        MaybeOwningCpuMemory::AllocateShared(byte_size));
+    TF_ASSIGN_OR_RETURN(
+        std::shared_ptr<MaybeOwningCpuMemory> device_buffer,
+        MaybeOwningCpuMemory::AllocateShared(byte_size, allocator));
     auto dst_data_ptr = device_buffer->data();
     buffers.push_back(device_buffer);
+    const bool is_small = byte_size < kSmallDataTransferByteSize;
+    const int num_threads = is_small ? 1 : std::max(1, DefaultThreadPoolSize());
+    // The transpose or copy is split into independent chunks that run in
+    // parallel on `async_work_runner`.
+    int num_chunks;
+    std::function<void(int)> work;
     if (!has_default_layout) {
       // If the input array does not have a major-to-minor layout, transpose it
-      // into major-to-minor layout. Currently we choose to always do this
-      // synchronously.
-      // TODO(phawkins): consider performing the transpose asynchronously.
-      // TODO(phawkins): parallelize the transpose.
+      // into major-to-minor layout.
       std::shared_ptr<TransposePlan> transpose;
       {
         absl::InlinedVector<int64_t, 4> permutation(dims.size());
         absl::c_iota(permutation, 0);
         absl::MutexLock lock(transpose_mu);
         TF_ASSIGN_OR_RETURN(
-            transpose, transpose_cache->GetOrCreate(
-                           primitive_util::ByteWidth(type), dims, permutation,
-                           TransposePlan::Striding{*byte_strides}));
+            transpose,
+            transpose_cache->GetOrCreate(
+                primitive_util::ByteWidth(type), dims, permutation,
+                TransposePlan::Striding{*byte_strides},
+                /*output_tiling=*/TransposePlan::Tiling{},
+                TransposePlan::Transformation::kNone, num_threads));
       }
-      transpose->Execute(data, dst_data_ptr);
+      num_chunks = transpose->Parallelism();
+      work = [transpose = std::move(transpose), data, dst_data_ptr](int i) {
+        transpose->ExecuteChunk(data, dst_data_ptr, i);
+      };
+    } else {
+      num_chunks = std::min<int64_t>(
+          num_threads,
+          CeilOfRatio<int64_t>(byte_size, kMinH2DCopyChunkByteSize));
+      const int64_t size_in_bytes = byte_size;
+      const int64_t chunk_size =
+          num_chunks == 0 ? 0 : CeilOfRatio<int64_t>(size_in_bytes, num_chunks);
+      work = [data, dst_data_ptr, size_in_bytes, chunk_size](int i) {
+        const int64_t offset = i * chunk_size;
+        const int64_t size = std::min(chunk_size, size_in_bytes - offset);
+        if (size > 0) {
+          std::memcpy(static_cast<char*>(dst_data_ptr) + offset,
+                      static_cast<const char*>(data) + offset, size);
+        }
+      };
+    }
+
+    // The host buffer may only be read during the call for
+    // kImmutableOnlyDuringCall, and small transfers are cheaper to do inline
+    // than to hand off to another thread.
+    bool should_sync_copy =
+        host_buffer_semantics ==
+            PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall ||
+        is_small;
+    if (should_sync_copy) {
+      RunChunks(async_work_runner, num_chunks, work);
       if (on_done_with_host_buffer) {
         on_done_with_host_buffer();
         on_done_with_host_buffer = nullptr;
       }
     } else {
-      bool should_sync_copy =
-          host_buffer_semantics ==
-              PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall ||
-          (byte_size < kSmallDataTransferByteSize);
-      if (should_sync_copy) {
-        std::memcpy(dst_data_ptr, data, byte_size);
-        if (on_done_with_host_buffer) {
-          on_done_with_host_buffer();
-          on_done_with_host_buffer = nullptr;
-        }
-      } else {
-        tfrt::AsyncValueRef<CpuEvent> copy_event =
-            tfrt::MakeConstructedAsyncValueRef<CpuEvent>();
-        definition_events.push_back(copy_event.CopyRef());
-        async_work_runner->Schedule(
-            [device_buffer = std::move(device_buffer), dst_data_ptr, data,
-             byte_size, copy_event = std::move(copy_event),
-             on_done_with_host_buffer =
-                 std::move(on_done_with_host_buffer)]() mutable {
-              tsl::profiler::TraceMe traceme("H2D Dispatch");
-              std::memcpy(dst_data_ptr, data, byte_size);
-              if (on_done_with_host_buffer) {
-                on_done_with_host_buffer();
-                on_done_with_host_buffer = nullptr;
-              }
-              // Signal copy is complete.
-              copy_event.SetStateConcrete();
-            });
-      }
+      tfrt::AsyncValueRef<CpuEvent> copy_event =
+          tfrt::MakeConstructedAsyncValueRef<CpuEvent>();
+      definition_events.push_back(copy_event.CopyRef());
+      ScheduleChunks(
+          async_work_runner, num_chunks, std::move(work),
+          [device_buffer = std::move(device_buffer),
+           copy_event = std::move(copy_event),
+           on_done_with_host_buffer =
+               std::move(on_done_with_host_buffer)]() mutable {
+            if (on_done_with_host_buffer) {
+              on_done_with_host_buffer();
+              on_done_with_host_buffer = nullptr;
+            }
+            // Signal copy is complete.
+            copy_event.SetStateConcrete();
+          });
     }
   }
   return std::make_unique<TrackedTfrtCpuDeviceBuffer>(
@@ -28,6 +28,7 @@ limitations under the License.
 #include "absl/base/thread_annotations.h"
 #include "absl/log/check.h"
 #include "absl/synchronization/mutex.h"
+#include "xla/pjrt/cpu_buffer_allocator.h"
 #include "xla/pjrt/pjrt_client.h"
 #include "xla/pjrt/pjrt_future.h"
 #include "xla/pjrt/tracked_tfrt_cpu_device_buffer.h"
@@ -226,12 +227,13 @@ class AbstractTfrtCpuBuffer : public PjRtBuffer {
       AsyncWorkRunner* async_work_runner);
 
   // Allocates a new `TrackedTfrtCpuDeviceBuffer` with the given shape and
-  // definition events.
+  // definition events. The leaf buffers come from `allocator` if it is set.
   static StatusOr<std::unique_ptr<TrackedTfrtCpuDeviceBuffer>>
   AllocateTrackedDeviceBuffer(
       const Shape& on_device_shape,
       absl::InlinedVector<tfrt::AsyncValueRef<runtime::CpuEvent>, 4>
-          definition_events);
+          definition_events,
+      const std::shared_ptr<CpuBufferAllocator>& allocator = nullptr);
 
   // Allocates new cpu events to `avs` and `definition_events`. If `shape` is a
   // tuple, multiple events will be allocated. Otherwise, `avs` and
@@ -245,7 +247,7 @@ class AbstractTfrtCpuBuffer : public PjRtBuffer {
   // A helper function for PjRtClient::BufferFromHostBuffer. Creates a new cpu
   // device buffer from the host buffer (maybe zero-copy or async).
   // `transpose_mu` and `transpose_cache` are used to transpose the input
-  // layout.
+  // layout. Copies are allocated from `allocator` if it is set.
   static StatusOr<std::unique_ptr<TrackedTfrtCpuDeviceBuffer>>
   BufferFromHostBufferHelper(
       const void* data, PrimitiveType type, absl::Span<int64_t const> dims,
@@ -253,7 +255,8 @@ class AbstractTfrtCpuBuffer : public PjRtBuffer {
       PjRtClient::HostBufferSemantics host_buffer_semantics,
       std::function<void()> on_done_with_host_buffer, const Shape& shape,
       AsyncWorkRunner* async_work_runner, absl::Mutex* transpose_mu,
-      TransposePlanCache* transpose_cache);
+      TransposePlanCache* transpose_cache,
+      const std::shared_ptr<CpuBufferAllocator>& allocator = nullptr);
 
  protected:
   virtual absl::string_view buffer_name() const = 0;
@@ -264,8 +267,10 @@ class AbstractTfrtCpuBuffer : public PjRtBuffer {
   StatusOr<std::unique_ptr<PjRtBuffer>> CopyToDeviceAcrossClients(
       PjRtDevice* dst_device);
 
+  // The destination buffers come from `allocator` if it is set.
   StatusOr<std::unique_ptr<TrackedTfrtCpuDeviceBuffer>> CopyToDeviceHelper(
-      AsyncWorkRunner* async_work_runner);
+      AsyncWorkRunner* async_work_runner,
+      const std::shared_ptr<CpuBufferAllocator>& allocator = nullptr);
 
   bool IsEmptyTuple() const {
     return on_device_shape_.IsTuple() &&
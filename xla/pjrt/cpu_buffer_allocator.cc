@@ -0,0 +1,193 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/cpu_buffer_allocator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/numeric/bits.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/cpu_function_runtime.h"
+#include "tsl/framework/allocator.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/mem.h"
+#include "tsl/platform/numa.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace xla {
+namespace {
+
+// Blocks are at least a cache line, so that small buffers of different
+// executions never share one.
+constexpr size_t kMinBlockSize = 64;
+constexpr size_t kBlockAlignment =
+    std::max<size_t>(kMinBlockSize, cpu_function_runtime::MinAlign());
+
+size_t RoundUp(size_t size, size_t multiple) {
+  return (size + multiple - 1) / multiple * multiple;
+}
+
+}  // namespace
+
+CpuBufferAllocator::CpuBufferAllocator(const Options& options)
+    : options_(options) {}
+
+CpuBufferAllocator::~CpuBufferAllocator() {
+  absl::MutexLock lock(&mu_);
+  if (stats_.bytes_in_use != 0) {
+    LOG(WARNING) << "CpuBufferAllocator destroyed with "
+                 << stats_.bytes_in_use << " bytes in use";
+  }
+  for (auto& [block_size, blocks] : free_lists_) {
+    for (void* ptr : blocks) {
+      FreeBlock(ptr, block_size);
+    }
+  }
+}
+
+size_t CpuBufferAllocator::SizeClass(size_t size) const {
+  // Size classes only make cached blocks reusable for similar requests.
+  if (options_.max_cached_bytes <= 0) {
+    return std::max<size_t>(size, 1);
+  }
+  if (size <= kMinBlockSize) {
+    return kMinBlockSize;
+  }
+  // Four classes between consecutive powers of two.
+  const size_t power = size_t{1} << (absl::bit_width(size - 1) - 1);
+  size_t block_size = RoundUp(size, power / 4);
+  if (options_.use_huge_pages && block_size >= kHugePageSize) {
+    block_size = RoundUp(block_size, kHugePageSize);
+  }
+  return block_size;
+}
+
+void* CpuBufferAllocator::AllocateBlock(size_t block_size) {
+  const bool huge = options_.use_huge_pages && block_size >= kHugePageSize;
+  const size_t alignment = huge ? kHugePageSize : kBlockAlignment;
+  void* ptr =
+      options_.numa_node == tsl::port::kNUMANoAffinity
+          ? tsl::port::AlignedMalloc(block_size, alignment)
+          : tsl::port::NUMAMalloc(options_.numa_node, block_size, alignment);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (huge && ptr != nullptr) {
+    // Best effort: fails harmlessly if transparent huge pages are disabled.
+    madvise(ptr, block_size, MADV_HUGEPAGE);
+  }
+#endif
+  return ptr;
+}
+
+void CpuBufferAllocator::FreeBlock(void* ptr, size_t block_size) {
+  if (options_.numa_node == tsl::port::kNUMANoAffinity) {
+    tsl::port::AlignedFree(ptr);
+  } else {
+    tsl::port::NUMAFree(ptr, block_size);
+  }
+}
+
+void* CpuBufferAllocator::Allocate(size_t size) {
+  const size_t block_size = SizeClass(size);
+  void* ptr = nullptr;
+  {
+    absl::MutexLock lock(&mu_);
+    auto it = free_lists_.find(block_size);
+    if (it != free_lists_.end() && !it->second.empty()) {
+      ptr = it->second.back();
+      it->second.pop_back();
+      cached_bytes_ -= block_size;
+    }
+  }
+  if (ptr == nullptr) {
+    // Allocate outside of the lock; fresh blocks are the slow path.
+    ptr = AllocateBlock(block_size);
+    if (ptr == nullptr) {
+      // The cached blocks of other size classes may be all that stands
+      // between us and the request.
+      ReleaseCachedMemory();
+      ptr = AllocateBlock(block_size);
+    }
+    if (ptr == nullptr) {
+      return nullptr;
+    }
+  }
+
+  absl::MutexLock lock(&mu_);
+  ++stats_.num_allocs;
+  stats_.bytes_in_use += block_size;
+  stats_.peak_bytes_in_use =
+      std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+  stats_.largest_alloc_size =
+      std::max<int64_t>(stats_.largest_alloc_size, block_size);
+  stats_.peak_pool_bytes =
+      std::max(stats_.peak_pool_bytes.value_or(0),
+               stats_.bytes_in_use + cached_bytes_);
+  return ptr;
+}
+
+void CpuBufferAllocator::Deallocate(void* ptr, size_t size) {
+  if (ptr == nullptr) {
+    return;
+  }
+  const size_t block_size = SizeClass(size);
+  {
+    absl::MutexLock lock(&mu_);
+    stats_.bytes_in_use -= block_size;
+    if (cached_bytes_ + static_cast<int64_t>(block_size) <=
+        options_.max_cached_bytes) {
+      free_lists_[block_size].push_back(ptr);
+      cached_bytes_ += block_size;
+      return;
+    }
+  }
+  FreeBlock(ptr, block_size);
+}
+
+void CpuBufferAllocator::ReleaseCachedMemory() {
+  absl::flat_hash_map<size_t, std::vector<void*>> free_lists;
+  {
+    absl::MutexLock lock(&mu_);
+    std::swap(free_lists, free_lists_);
+    cached_bytes_ = 0;
+  }
+  for (auto& [block_size, blocks] : free_lists) {
+    for (void* ptr : blocks) {
+      FreeBlock(ptr, block_size);
+    }
+  }
+}
+
+tsl::AllocatorStats CpuBufferAllocator::GetStats() const {
+  absl::MutexLock lock(&mu_);
+  tsl::AllocatorStats stats = stats_;
+  stats.pool_bytes = stats_.bytes_in_use + cached_bytes_;
+  stats.peak_pool_bytes = stats_.peak_pool_bytes.value_or(0);
+  for (const auto& [block_size, blocks] : free_lists_) {
+    if (!blocks.empty()) {
+      stats.largest_free_block_bytes =
+          std::max<int64_t>(stats.largest_free_block_bytes, block_size);
+    }
+  }
+  return stats;
+}
+
+}  // namespace xla
@@ -0,0 +1,105 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_PJRT_CPU_BUFFER_ALLOCATOR_H_
+#define XLA_PJRT_CPU_BUFFER_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "tsl/framework/allocator.h"
+#include "tsl/platform/numa.h"
+
+namespace xla {
+
+// A caching allocator for the host buffers of the CPU PjRt client.
+//
+// Requests are rounded up to a size class, four per power of two, so that at
+// most a quarter of every block is wasted. Freed blocks are kept on a free
+// list per size class and handed out again to later requests of the same
+// class, which avoids both the system allocator and the page faults of fresh
+// memory for the buffers of executables that are run over and over. The free
+// lists are bounded by `max_cached_bytes`, which is zero by default; blocks
+// freed beyond that are returned to the system, and without a cache requests
+// are not rounded up at all. If the system runs out of
+// memory, the cached blocks are released before the allocation fails.
+//
+// Each allocator is an arena for one NUMA node. This class is thread-safe.
+class CpuBufferAllocator {
+ public:
+  struct Options {
+    // The NUMA node to allocate from, or kNUMANoAffinity to use the aligned
+    // system allocator.
+    int numa_node = tsl::port::kNUMANoAffinity;
+
+    // Upper bound on the bytes held in free lists. Zero, the default,
+    // disables caching.
+    int64_t max_cached_bytes = 0;
+
+    // Asks the kernel to back blocks of at least kHugePageSize with
+    // transparent huge pages. Such blocks are rounded up to a multiple of the
+    // huge page size.
+    bool use_huge_pages = false;
+  };
+
+  static constexpr size_t kHugePageSize = size_t{2} << 20;
+
+  CpuBufferAllocator() : CpuBufferAllocator(Options()) {}
+  explicit CpuBufferAllocator(const Options& options);
+  ~CpuBufferAllocator();
+
+  CpuBufferAllocator(const CpuBufferAllocator&) = delete;
+  CpuBufferAllocator& operator=(const CpuBufferAllocator&) = delete;
+
+  // Returns a block of at least `size` bytes aligned to
+  // cpu_function_runtime::MinAlign(), or nullptr if out of memory.
+  void* Allocate(size_t size);
+
+  // Returns `ptr`, allocated with the same `size`, to the allocator.
+  void Deallocate(void* ptr, size_t size);
+
+  // Returns all cached blocks to the system.
+  void ReleaseCachedMemory();
+
+  // Sizes in the stats are those of the size classes, not of the requests.
+  // `pool_bytes` counts the blocks in use plus those cached.
+  tsl::AllocatorStats GetStats() const;
+
+  // The size of the block that serves a request of `size` bytes. Without a
+  // cache, that is the requested size.
+  size_t SizeClass(size_t size) const;
+
+  const Options& options() const { return options_; }
+
+ private:
+  void* AllocateBlock(size_t block_size);
+  void FreeBlock(void* ptr, size_t block_size);
+
+  const Options options_;
+
+  mutable absl::Mutex mu_;
+  absl::flat_hash_map<size_t, std::vector<void*>> free_lists_
+      ABSL_GUARDED_BY(mu_);
+  int64_t cached_bytes_ ABSL_GUARDED_BY(mu_) = 0;
+  tsl::AllocatorStats stats_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace xla
+
+#endif  // XLA_PJRT_CPU_BUFFER_ALLOCATOR_H_
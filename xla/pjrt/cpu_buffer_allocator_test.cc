@@ -0,0 +1,200 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/cpu_buffer_allocator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tsl/framework/allocator.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/mem.h"
+#include "tsl/platform/test_benchmark.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+namespace {
+
+CpuBufferAllocator::Options CachingOptions() {
+  CpuBufferAllocator::Options options;
+  options.max_cached_bytes = int64_t{1} << 30;
+  return options;
+}
+
+TEST(CpuBufferAllocatorTest, SizeClasses) {
+  CpuBufferAllocator allocator(CachingOptions());
+  EXPECT_EQ(allocator.SizeClass(0), 64);
+  EXPECT_EQ(allocator.SizeClass(1), 64);
+  EXPECT_EQ(allocator.SizeClass(64), 64);
+  EXPECT_EQ(allocator.SizeClass(65), 80);
+  EXPECT_EQ(allocator.SizeClass(128), 128);
+  EXPECT_EQ(allocator.SizeClass(129), 160);
+  EXPECT_EQ(allocator.SizeClass(1000), 1024);
+  EXPECT_EQ(allocator.SizeClass((1 << 20) + 1), (1 << 20) + (1 << 18));
+  for (size_t size = 1; size < (1 << 16); size = size * 3 / 2 + 1) {
+    size_t block_size = allocator.SizeClass(size);
+    EXPECT_GE(block_size, size);
+    if (size > 64) {
+      EXPECT_LE(block_size, size + size / 4) << size;
+    }
+  }
+}
+
+TEST(CpuBufferAllocatorTest, HugePageSizeClasses) {
+  CpuBufferAllocator::Options options = CachingOptions();
+  options.use_huge_pages = true;
+  CpuBufferAllocator allocator(options);
+  EXPECT_EQ(allocator.SizeClass(1 << 20), 1 << 20);
+  EXPECT_EQ(allocator.SizeClass(CpuBufferAllocator::kHugePageSize + 1),
+            2 * CpuBufferAllocator::kHugePageSize);
+
+  void* ptr = allocator.Allocate(3 << 20);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) %
+                CpuBufferAllocator::kHugePageSize,
+            0);
+  std::memset(ptr, 0, 3 << 20);
+  allocator.Deallocate(ptr, 3 << 20);
+}
+
+TEST(CpuBufferAllocatorTest, DoesNotCacheByDefault) {
+  CpuBufferAllocator allocator;
+  allocator.Deallocate(allocator.Allocate(1024), 1024);
+  tsl::AllocatorStats stats = allocator.GetStats();
+  EXPECT_EQ(stats.num_allocs, 1);
+  EXPECT_EQ(stats.pool_bytes, 0);
+}
+
+TEST(CpuBufferAllocatorTest, AllocatesExactSizesWithoutCache) {
+  CpuBufferAllocator allocator;
+  EXPECT_EQ(allocator.SizeClass(0), 1);
+  EXPECT_EQ(allocator.SizeClass(65), 65);
+  EXPECT_EQ(allocator.SizeClass((1 << 20) + 1), (1 << 20) + 1);
+
+  void* ptr = allocator.Allocate(1000);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % 64, 0);
+  tsl::AllocatorStats stats = allocator.GetStats();
+  EXPECT_EQ(stats.bytes_in_use, 1000);
+  EXPECT_EQ(stats.largest_alloc_size, 1000);
+  allocator.Deallocate(ptr, 1000);
+  EXPECT_EQ(allocator.GetStats().bytes_in_use, 0);
+}
+
+TEST(CpuBufferAllocatorTest, ReusesFreedBlocks) {
+  CpuBufferAllocator allocator(CachingOptions());
+  void* a = allocator.Allocate(1000);
+  ASSERT_NE(a, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 64, 0);
+  allocator.Deallocate(a, 1000);
+
+  // Any size of the same class gets the cached block back.
+  void* b = allocator.Allocate(1010);
+  EXPECT_EQ(a, b);
+  void* c = allocator.Allocate(1010);
+  EXPECT_NE(b, c);
+  allocator.Deallocate(b, 1010);
+  allocator.Deallocate(c, 1010);
+
+  tsl::AllocatorStats stats = allocator.GetStats();
+  EXPECT_EQ(stats.num_allocs, 3);
+  EXPECT_EQ(stats.bytes_in_use, 0);
+  EXPECT_EQ(stats.peak_bytes_in_use, 2048);
+  EXPECT_EQ(stats.largest_alloc_size, 1024);
+  EXPECT_EQ(stats.pool_bytes, 2048);
+  EXPECT_EQ(stats.largest_free_block_bytes, 1024);
+
+  allocator.ReleaseCachedMemory();
+  stats = allocator.GetStats();
+  EXPECT_EQ(stats.pool_bytes, 0);
+  EXPECT_EQ(stats.largest_free_block_bytes, 0);
+  EXPECT_EQ(stats.peak_pool_bytes, 2048);
+}
+
+TEST(CpuBufferAllocatorTest, CacheIsBounded) {
+  CpuBufferAllocator::Options options;
+  options.max_cached_bytes = 4096;
+  CpuBufferAllocator allocator(options);
+  std::vector<void*> blocks;
+  for (int i = 0; i < 8; ++i) {
+    blocks.push_back(allocator.Allocate(1024));
+  }
+  for (void* ptr : blocks) {
+    allocator.Deallocate(ptr, 1024);
+  }
+  tsl::AllocatorStats stats = allocator.GetStats();
+  EXPECT_EQ(stats.bytes_in_use, 0);
+  EXPECT_EQ(stats.pool_bytes, 4096);
+
+  options.max_cached_bytes = 0;
+  CpuBufferAllocator uncached(options);
+  uncached.Deallocate(uncached.Allocate(1024), 1024);
+  EXPECT_EQ(uncached.GetStats().pool_bytes, 0);
+}
+
+TEST(CpuBufferAllocatorTest, ConcurrentAllocations) {
+  CpuBufferAllocator allocator(CachingOptions());
+  {
+    tsl::thread::ThreadPool pool(tsl::Env::Default(), "test", 4);
+    for (int t = 0; t < 4; ++t) {
+      pool.Schedule([&allocator, t] {
+        for (int i = 0; i < 1000; ++i) {
+          size_t size = 64 + (i * 97 + t) % 8192;
+          void* ptr = allocator.Allocate(size);
+          CHECK(ptr != nullptr);
+          std::memset(ptr, t, size);
+          allocator.Deallocate(ptr, size);
+        }
+      });
+    }
+  }
+  tsl::AllocatorStats stats = allocator.GetStats();
+  EXPECT_EQ(stats.num_allocs, 4000);
+  EXPECT_EQ(stats.bytes_in_use, 0);
+}
+
+void BM_CpuBufferAllocator(::testing::benchmark::State& state) {
+  const size_t size = state.range(0);
+  CpuBufferAllocator allocator(CachingOptions());
+  for (auto s : state) {
+    void* ptr = allocator.Allocate(size);
+    // Touch every page as a freshly written output buffer would.
+    for (size_t i = 0; i < size; i += 4096) {
+      static_cast<char*>(ptr)[i] = 1;
+    }
+    allocator.Deallocate(ptr, size);
+  }
+}
+BENCHMARK(BM_CpuBufferAllocator)->Arg(1 << 10)->Arg(1 << 20)->Arg(16 << 20);
+
+void BM_AlignedMalloc(::testing::benchmark::State& state) {
+  const size_t size = state.range(0);
+  for (auto s : state) {
+    void* ptr = tsl::port::AlignedMalloc(size, 64);
+    for (size_t i = 0; i < size; i += 4096) {
+      static_cast<char*>(ptr)[i] = 1;
+    }
+    tsl::port::AlignedFree(ptr);
+  }
+}
+BENCHMARK(BM_AlignedMalloc)->Arg(1 << 10)->Arg(1 << 20)->Arg(16 << 20);
+
+}  // namespace
+}  // namespace xla
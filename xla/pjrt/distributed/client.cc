@@ -385,9 +385,32 @@ xla::Status DistributedRuntimeClientImpl::WaitAtBarrier(
 
 xla::StatusOr<std::vector<std::pair<std::string, std::string>>>
 DistributedRuntimeClientImpl::KeyValueDirGet(absl::string_view key) {
-  return xla::Unimplemented(
-      "KeyValueDirGet() is unimplemented. Enable coordination service to use "
-      "this method.");
+  {
+    absl::MutexLock lock(&mu_);
+    if (state_ != State::kConnected) {
+      return xla::FailedPrecondition(
+          "KeyValueDirGet() called when client not connected.");
+    }
+  }
+  ::grpc::ClientContext ctx;
+  ctx.set_fail_fast(false);
+  ctx.set_deadline(absl::ToChronoTime(absl::Now() + options_.rpc_timeout));
+  KeyValueDirGetRequest request;
+  request.set_session_id(session_id_);
+  request.set_directory(std::string(key));
+  VLOG(10) << "KeyValueDirGet: " << request.DebugString();
+  KeyValueDirGetResponse response;
+  ::grpc::Status status = stub_->KeyValueDirGet(&ctx, request, &response);
+  if (!status.ok()) {
+    return FromGrpcStatus(status);
+  }
+  std::vector<std::pair<std::string, std::string>> kvs;
+  kvs.reserve(response.entries_size());
+  for (KeyValueEntryProto& entry : *response.mutable_entries()) {
+    kvs.emplace_back(std::move(*entry.mutable_key()),
+                     std::move(*entry.mutable_value()));
+  }
+  return kvs;
 }
 
 xla::Status DistributedRuntimeClientImpl::KeyValueDelete(std::string key) {
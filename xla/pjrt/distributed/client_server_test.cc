@@ -734,16 +734,12 @@ TEST_P(ClientServerTest, KeyValueDirGet) {
 
   auto results = client->KeyValueDirGet("test_dir/");
 
-  if (GetParam().use_coordination_service) {
-    TF_ASSERT_OK(results.status());
-    auto kvs = results.value();
+  TF_ASSERT_OK(results.status());
+  auto kvs = results.value();
 
-    EXPECT_THAT(kvs, UnorderedElementsAre(Pair("test_dir/sub_dir/1", "1"),
-                                          Pair("test_dir/sub_dir/2", "2"),
-                                          Pair("test_dir/3", "3")));
-  } else {
-    EXPECT_EQ(results.status().code(), tsl::error::UNIMPLEMENTED);
-  }
+  EXPECT_THAT(kvs, UnorderedElementsAre(Pair("test_dir/sub_dir/1", "1"),
+                                        Pair("test_dir/sub_dir/2", "2"),
+                                        Pair("test_dir/3", "3")));
 }
 
 TEST_P(ClientServerTest, KeyValueDelete) {
@@ -15,30 +15,205 @@ limitations under the License.
 
 #include "xla/pjrt/distributed/key_value_store.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/cleanup/cleanup.h"
+#include "absl/hash/hash.h"
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
 namespace xla {
 
-KeyValueStore::KeyValueStore() = default;
+KeyValueStore::KeyValueStore() : KeyValueStore(kDefaultNumShards) {}
+
+KeyValueStore::KeyValueStore(int num_shards)
+    : num_shards_(std::max(num_shards, 1)),
+      shards_(std::make_unique<Shard[]>(num_shards_)) {}
+
+KeyValueStore::Shard& KeyValueStore::ShardFor(absl::string_view key) {
+  return shards_[absl::HashOf(key) % num_shards_];
+}
 
 ::grpc::Status KeyValueStore::Get(const std::string& key,
                                   absl::Duration timeout, std::string* value) {
+  Shard& shard = ShardFor(key);
+  {
+    absl::ReaderMutexLock lock(&shard.mu);
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end()) {
+      *value = it->second.value;
+      return ::grpc::Status::OK;
+    }
+  }
   auto key_is_present = [&]() {
-    mu_.AssertHeld();
-    return entries_.find(key) != entries_.end();
+    shard.mu.AssertReaderHeld();
+    return shard.entries.contains(key);
   };
-  absl::MutexLock lock(&mu_);
-  // TODO(phawkins): the synchronization here is very coarse, but probably
-  // sufficient for its current application.
-  if (!mu_.AwaitWithTimeout(absl::Condition(&key_is_present), timeout)) {
+  absl::ReaderMutexLock lock(&shard.mu);
+  if (!shard.mu.AwaitWithTimeout(absl::Condition(&key_is_present), timeout)) {
     return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, key);
   }
-  *value = entries_.find(key)->second;
+  *value = shard.entries.find(key)->second.value;
   return ::grpc::Status::OK;
 }
 
+::grpc::Status KeyValueStore::MultiGet(absl::Span<const std::string> keys,
+                                       absl::Duration timeout,
+                                       std::vector<std::string>* values) {
+  const absl::Time deadline = absl::Now() + timeout;
+  values->resize(keys.size());
+  for (int i = 0; i < keys.size(); ++i) {
+    ::grpc::Status status =
+        Get(keys[i], deadline - absl::Now(), &(*values)[i]);
+    if (!status.ok()) {
+      values->clear();
+      return status;
+    }
+  }
+  return ::grpc::Status::OK;
+}
+
+int64_t KeyValueStore::SetLocked(Shard& shard, std::string key,
+                                 std::string value) {
+  Value& entry = shard.entries[std::move(key)];
+  entry.value = std::move(value);
+  entry.version = version_.fetch_add(1) + 1;
+  return entry.version;
+}
+
+void KeyValueStore::NotifyWatchers(absl::string_view key, int64_t version) {
+  // A watcher registers itself before it reads `version_`, so if we miss it
+  // here it read a version at least as recent as ours, and its scan of the
+  // shards sees our write.
+  if (num_watchers_.load() == 0) {
+    return;
+  }
+  absl::MutexLock lock(&watchers_mu_);
+  for (Watcher* watcher : watchers_) {
+    if (absl::StartsWith(key, watcher->prefix)) {
+      watcher->latest_version = std::max(watcher->latest_version, version);
+    }
+  }
+}
+
 ::grpc::Status KeyValueStore::Set(const std::string& key, std::string value) {
-  absl::MutexLock lock(&mu_);
-  entries_[key] = std::move(value);
+  Shard& shard = ShardFor(key);
+  int64_t version;
+  {
+    absl::MutexLock lock(&shard.mu);
+    version = SetLocked(shard, key, std::move(value));
+  }
+  NotifyWatchers(key, version);
   return ::grpc::Status::OK;
 }
 
+::grpc::Status KeyValueStore::MultiSet(
+    std::vector<std::pair<std::string, std::string>> entries) {
+  // Group the entries by shard, keeping their order within each shard so that
+  // the last write to a repeated key wins.
+  std::vector<std::vector<std::pair<std::string, std::string>*>> by_shard(
+      num_shards_);
+  for (auto& entry : entries) {
+    by_shard[absl::HashOf(absl::string_view(entry.first)) % num_shards_]
+        .push_back(&entry);
+  }
+  std::vector<std::pair<const std::string*, int64_t>> versions;
+  versions.reserve(entries.size());
+  for (int i = 0; i < num_shards_; ++i) {
+    if (by_shard[i].empty()) {
+      continue;
+    }
+    Shard& shard = shards_[i];
+    absl::MutexLock lock(&shard.mu);
+    for (auto* entry : by_shard[i]) {
+      // Keep the key for NotifyWatchers() below.
+      const int64_t version =
+          SetLocked(shard, entry->first, std::move(entry->second));
+      versions.push_back({&entry->first, version});
+    }
+  }
+  for (const auto& [key, version] : versions) {
+    NotifyWatchers(*key, version);
+  }
+  return ::grpc::Status::OK;
+}
+
+void KeyValueStore::CollectPrefix(absl::string_view prefix,
+                                  int64_t after_version,
+                                  std::vector<Entry>* entries) {
+  for (int i = 0; i < num_shards_; ++i) {
+    Shard& shard = shards_[i];
+    absl::ReaderMutexLock lock(&shard.mu);
+    for (const auto& [key, value] : shard.entries) {
+      if (value.version > after_version && absl::StartsWith(key, prefix)) {
+        entries->push_back(Entry{key, value.value, value.version});
+      }
+    }
+  }
+  std::sort(entries->begin(), entries->end(),
+            [](const Entry& a, const Entry& b) { return a.key < b.key; });
+}
+
+std::vector<KeyValueStore::Entry> KeyValueStore::ListPrefix(
+    absl::string_view prefix) {
+  std::vector<Entry> entries;
+  CollectPrefix(prefix, /*after_version=*/0, &entries);
+  return entries;
+}
+
+::grpc::Status KeyValueStore::WatchPrefix(absl::string_view prefix,
+                                          int64_t after_version,
+                                          absl::Duration timeout,
+                                          std::vector<Entry>* entries,
+                                          int64_t* version) {
+  const absl::Time deadline = absl::Now() + timeout;
+  entries->clear();
+  Watcher watcher{std::string(prefix)};
+  {
+    absl::MutexLock lock(&watchers_mu_);
+    watchers_.insert(&watcher);
+    ++num_watchers_;
+  }
+  absl::Cleanup unregister = [&] {
+    absl::MutexLock lock(&watchers_mu_);
+    watchers_.erase(&watcher);
+    --num_watchers_;
+  };
+  while (true) {
+    const int64_t scan_version = version_.load();
+    CollectPrefix(prefix, after_version, entries);
+    // Every write up to `scan_version` was visible to the scan, but later
+    // ones may have been missed in shards scanned before they happened, so
+    // those are left for the next call.
+    entries->erase(std::remove_if(entries->begin(), entries->end(),
+                                  [&](const Entry& entry) {
+                                    return entry.version > scan_version;
+                                  }),
+                   entries->end());
+    if (!entries->empty()) {
+      *version = scan_version;
+      return ::grpc::Status::OK;
+    }
+    auto has_new_writes = [&]() {
+      watchers_mu_.AssertHeld();
+      return watcher.latest_version > scan_version;
+    };
+    absl::MutexLock lock(&watchers_mu_);
+    if (!watchers_mu_.AwaitWithDeadline(absl::Condition(&has_new_writes),
+                                        deadline)) {
+      return ::grpc::Status(::grpc::StatusCode::DEADLINE_EXCEEDED,
+                            std::string(prefix));
+    }
+  }
+}
+
 }  // namespace xla
@@ -16,18 +16,50 @@ limitations under the License.
 #ifndef XLA_PJRT_DISTRIBUTED_KEY_VALUE_STORE_H_
 #define XLA_PJRT_DISTRIBUTED_KEY_VALUE_STORE_H_
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "grpcpp/grpcpp.h"
 
 namespace xla {
 
-// A simple blocking key-value store class.
+// A blocking key-value store class.
+//
+// The keys are spread over shards by hash, each with its own reader-writer
+// lock, so that the many clients exchanging keys during startup of a large
+// job mostly touch different locks, lookups of present keys only take a shard
+// lock in shared mode, and a waiting Get() is only woken by writes to its own
+// shard.
+//
+// Every write is stamped with a version from a store-wide atomic counter,
+// which WatchPrefix() uses to report the entries written since a previous
+// call. Writers only notify the watchers of prefixes of their key, and take
+// no store-wide lock if nobody is watching.
 class KeyValueStore {
  public:
+  static constexpr int kDefaultNumShards = 32;
+
+  // An entry as returned by ListPrefix() and WatchPrefix().
+  struct Entry {
+    std::string key;
+    std::string value;
+    // The version of the write that set `value`.
+    int64_t version;
+  };
+
   KeyValueStore();
+  explicit KeyValueStore(int num_shards);
 
   KeyValueStore(const KeyValueStore&) = delete;
   KeyValueStore(KeyValueStore&&) = delete;
@@ -40,12 +72,85 @@ class KeyValueStore {
   ::grpc::Status Get(const std::string& key, absl::Duration timeout,
                      std::string* value);
 
+  // Looks up all of `keys`, waiting until `timeout` expires for the missing
+  // ones to arrive. On success `values` holds the values in the order of
+  // `keys`; if a key does not arrive in time, returns NOT_FOUND with the
+  // first such key.
+  ::grpc::Status MultiGet(absl::Span<const std::string> keys,
+                          absl::Duration timeout,
+                          std::vector<std::string>* values);
+
   // Replaces the value of `key` with `value`.
   ::grpc::Status Set(const std::string& key, std::string value);
 
+  // Replaces the values of all keys in `entries`, taking the lock of each
+  // shard once.
+  ::grpc::Status MultiSet(
+      std::vector<std::pair<std::string, std::string>> entries);
+
+  // Returns the entries whose key starts with `prefix`, sorted by key.
+  std::vector<Entry> ListPrefix(absl::string_view prefix);
+
+  // Waits until `timeout` expires for an entry whose key starts with `prefix`
+  // to be written with a version greater than `after_version`, then returns
+  // in `entries` all such entries, sorted by key. `version` receives the
+  // latest version of the store that the result reflects; passing it as
+  // `after_version` to the next call returns only the later writes. Returns
+  // DEADLINE_EXCEEDED if no such write happens in time.
+  ::grpc::Status WatchPrefix(absl::string_view prefix, int64_t after_version,
+                             absl::Duration timeout,
+                             std::vector<Entry>* entries, int64_t* version);
+
+  int num_shards() const { return num_shards_; }
+
  private:
-  absl::Mutex mu_;
-  absl::flat_hash_map<std::string, std::string> entries_ ABSL_GUARDED_BY(mu_);
+  struct Value {
+    std::string value;
+    int64_t version;
+  };
+
+  struct Shard {
+    absl::Mutex mu;
+    absl::flat_hash_map<std::string, Value> entries ABSL_GUARDED_BY(mu);
+  };
+
+  // A pending WatchPrefix() call.
+  struct Watcher {
+    std::string prefix;
+    // The latest version written under `prefix` since the watcher was
+    // registered. Guarded by `watchers_mu_`.
+    int64_t latest_version = 0;
+  };
+
+  Shard& ShardFor(absl::string_view key);
+
+  // Writes `value` to `key` in `shard`, whose lock must be held exclusively,
+  // with the next version of the store. Returns the version.
+  int64_t SetLocked(Shard& shard, std::string key, std::string value)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(shard.mu);
+
+  // Wakes up the watchers of prefixes of `key`, which was written with
+  // `version`. Must be called after the write, without holding a shard lock.
+  void NotifyWatchers(absl::string_view key, int64_t version);
+
+  // Appends to `entries` the entries under `prefix` with a version greater
+  // than `after_version`.
+  void CollectPrefix(absl::string_view prefix, int64_t after_version,
+                     std::vector<Entry>* entries);
+
+  const int num_shards_;
+  std::unique_ptr<Shard[]> shards_;
+
+  // The version of the latest write. Writers increment it while holding the
+  // lock of their shard, so a scan of the shards that starts after reading it
+  // sees every write with a version up to the value read.
+  std::atomic<int64_t> version_{0};
+
+  // The pending WatchPrefix() calls. `num_watchers_` lets writers skip
+  // `watchers_mu_` when there are none.
+  absl::Mutex watchers_mu_;
+  absl::flat_hash_set<Watcher*> watchers_ ABSL_GUARDED_BY(watchers_mu_);
+  std::atomic<int> num_watchers_{0};
 };
 
 }  // namespace xla
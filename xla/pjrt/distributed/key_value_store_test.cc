@@ -0,0 +1,168 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/distributed/key_value_store.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "grpcpp/grpcpp.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Field;
+
+TEST(KeyValueStoreTest, GetAndSet) {
+  KeyValueStore store;
+  std::string value;
+  EXPECT_EQ(store.Get("a", absl::Milliseconds(10), &value).error_code(),
+            ::grpc::StatusCode::NOT_FOUND);
+  EXPECT_TRUE(store.Set("a", "1").ok());
+  EXPECT_TRUE(store.Get("a", absl::ZeroDuration(), &value).ok());
+  EXPECT_EQ(value, "1");
+  EXPECT_TRUE(store.Set("a", "2").ok());
+  EXPECT_TRUE(store.Get("a", absl::ZeroDuration(), &value).ok());
+  EXPECT_EQ(value, "2");
+}
+
+TEST(KeyValueStoreTest, GetWaitsForSet) {
+  KeyValueStore store;
+  std::string value;
+  {
+    tsl::thread::ThreadPool pool(tsl::Env::Default(), "test", 1);
+    pool.Schedule([&] {
+      tsl::Env::Default()->SleepForMicroseconds(10000);
+      CHECK(store.Set("late", "value").ok());
+    });
+    EXPECT_TRUE(store.Get("late", absl::Seconds(10), &value).ok());
+  }
+  EXPECT_EQ(value, "value");
+}
+
+TEST(KeyValueStoreTest, MultiGetAndMultiSet) {
+  KeyValueStore store(/*num_shards=*/4);
+  EXPECT_TRUE(
+      store.MultiSet({{"x", "1"}, {"y", "2"}, {"z", "3"}, {"x", "4"}}).ok());
+  std::vector<std::string> values;
+  EXPECT_TRUE(
+      store.MultiGet({"z", "x", "y"}, absl::ZeroDuration(), &values).ok());
+  EXPECT_THAT(values, ElementsAre("3", "4", "2"));
+
+  ::grpc::Status status =
+      store.MultiGet({"x", "missing"}, absl::Milliseconds(10), &values);
+  EXPECT_EQ(status.error_code(), ::grpc::StatusCode::NOT_FOUND);
+  EXPECT_EQ(status.error_message(), "missing");
+}
+
+TEST(KeyValueStoreTest, ListPrefix) {
+  KeyValueStore store;
+  EXPECT_TRUE(store.MultiSet({{"dir/b", "2"},
+                              {"dir/a", "1"},
+                              {"dir/sub/c", "3"},
+                              {"dirt", "4"},
+                              {"other", "5"}})
+                  .ok());
+  EXPECT_THAT(store.ListPrefix("dir/"),
+              ElementsAre(Field(&KeyValueStore::Entry::key, "dir/a"),
+                          Field(&KeyValueStore::Entry::key, "dir/b"),
+                          Field(&KeyValueStore::Entry::key, "dir/sub/c")));
+  EXPECT_EQ(store.ListPrefix("").size(), 5);
+  EXPECT_TRUE(store.ListPrefix("none/").empty());
+}
+
+TEST(KeyValueStoreTest, WatchPrefix) {
+  KeyValueStore store;
+  EXPECT_TRUE(store.Set("other", "0").ok());
+  std::vector<KeyValueStore::Entry> entries;
+  int64_t version = 0;
+  EXPECT_EQ(store
+                .WatchPrefix("dir/", /*after_version=*/0,
+                             absl::Milliseconds(10), &entries, &version)
+                .error_code(),
+            ::grpc::StatusCode::DEADLINE_EXCEEDED);
+
+  EXPECT_TRUE(store.Set("dir/a", "1").ok());
+  EXPECT_TRUE(
+      store.WatchPrefix("dir/", 0, absl::Seconds(10), &entries, &version)
+          .ok());
+  EXPECT_THAT(entries,
+              ElementsAre(Field(&KeyValueStore::Entry::value, "1")));
+
+  // Only writes after `version` are returned by the next watch.
+  {
+    tsl::thread::ThreadPool pool(tsl::Env::Default(), "test", 1);
+    pool.Schedule([&] {
+      tsl::Env::Default()->SleepForMicroseconds(10000);
+      CHECK(store.Set("other", "1").ok());
+      CHECK(store.Set("dir/b", "2").ok());
+    });
+    EXPECT_TRUE(store
+                    .WatchPrefix("dir/", version, absl::Seconds(10), &entries,
+                                 &version)
+                    .ok());
+  }
+  EXPECT_THAT(entries, ElementsAre(Field(&KeyValueStore::Entry::key, "dir/b")));
+}
+
+// Simulates the startup of a job in which every client publishes its own keys
+// and then reads those of all other clients.
+TEST(KeyValueStoreTest, ManyClients) {
+  constexpr int kNumClients = 64;
+  constexpr int kKeysPerClient = 16;
+  KeyValueStore store;
+  std::vector<int> num_mismatches(kNumClients);
+  {
+    tsl::thread::ThreadPool pool(tsl::Env::Default(), "client", kNumClients);
+    for (int client = 0; client < kNumClients; ++client) {
+      pool.Schedule([&, client] {
+        std::vector<std::pair<std::string, std::string>> entries;
+        for (int i = 0; i < kKeysPerClient; ++i) {
+          entries.emplace_back(absl::StrCat("topology/", client, "/", i),
+                               absl::StrCat(client * i));
+        }
+        CHECK(store.MultiSet(std::move(entries)).ok());
+        for (int other = 0; other < kNumClients; ++other) {
+          for (int i = 0; i < kKeysPerClient; ++i) {
+            std::string value;
+            CHECK(store
+                      .Get(absl::StrCat("topology/", other, "/", i),
+                           absl::Seconds(60), &value)
+                      .ok());
+            num_mismatches[client] += value != absl::StrCat(other * i);
+          }
+        }
+      });
+    }
+  }
+  for (int client = 0; client < kNumClients; ++client) {
+    EXPECT_EQ(num_mismatches[client], 0);
+  }
+  EXPECT_EQ(store.ListPrefix("topology/").size(),
+            kNumClients * kKeysPerClient);
+}
+
+}  // namespace
+}  // namespace xla
@@ -416,6 +416,33 @@ void DistributedRuntimeServiceImpl::HeartbeatLoop() {
   return key_value_store_.Set(request->key(), request->value());
 }
 
+::grpc::Status DistributedRuntimeServiceImpl::KeyValueDirGet(
+    ::grpc::ServerContext* context, const KeyValueDirGetRequest* request,
+    KeyValueDirGetResponse* response) {
+  VLOG(10) << "KeyValueDirGet " << request->DebugString();
+  xla::Status status = ValidateSessionId(request->session_id());
+  if (!status.ok()) {
+    return xla::ToGrpcStatus(status);
+  }
+  {
+    absl::MutexLock lock(&mu_);
+    if (state_ != State::kRunning) {
+      if (!service_status_.ok()) {
+        return xla::ToGrpcStatus(service_status_);
+      }
+      return xla::ToGrpcStatus(xla::FailedPrecondition(
+          "KeyValueDirGet() called when system is not running."));
+    }
+  }
+  for (KeyValueStore::Entry& entry :
+       key_value_store_.ListPrefix(request->directory())) {
+    KeyValueEntryProto* entry_proto = response->add_entries();
+    entry_proto->set_key(std::move(entry.key));
+    entry_proto->set_value(std::move(entry.value));
+  }
+  return ::grpc::Status::OK;
+}
+
 ::grpc::Status DistributedRuntimeServiceImpl::WaitAtBarrier(
     ::grpc::ServerContext* context, const WaitAtBarrierRequest* request,
     WaitAtBarrierResponse* response) {
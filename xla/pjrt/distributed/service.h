@@ -96,6 +96,10 @@ class DistributedRuntimeServiceImpl final
                              const KeyValueSetRequest* request,
                              KeyValueSetResponse* response) override;
 
+  ::grpc::Status KeyValueDirGet(::grpc::ServerContext* context,
+                                const KeyValueDirGetRequest* request,
+                                KeyValueDirGetResponse* response) override;
+
   ::grpc::Status WaitAtBarrier(::grpc::ServerContext* context,
                                const WaitAtBarrierRequest* request,
                                WaitAtBarrierResponse* response) override;
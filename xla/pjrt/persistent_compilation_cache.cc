@@ -0,0 +1,305 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/persistent_compilation_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/status.h"
+#include "xla/statusor.h"
+#include "xla/util.h"
+#include "tsl/lib/monitoring/counter.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/fingerprint.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/random.h"
+
+namespace xla {
+namespace {
+
+auto* persistent_cache_hits = tsl::monitoring::Counter<0>::New(
+    "/xla/pjrt/persistent_compilation_cache_hits",
+    "The number of persistent compilation cache lookups that found an entry.");
+
+auto* persistent_cache_misses = tsl::monitoring::Counter<0>::New(
+    "/xla/pjrt/persistent_compilation_cache_misses",
+    "The number of persistent compilation cache lookups that found no valid "
+    "entry.");
+
+auto* persistent_cache_evictions = tsl::monitoring::Counter<0>::New(
+    "/xla/pjrt/persistent_compilation_cache_evictions",
+    "The number of entries evicted from persistent compilation caches.");
+
+// Every entry starts with this magic followed by the little-endian
+// Fingerprint64 of the payload.
+constexpr char kMagic[8] = {'X', 'L', 'A', 'P', 'C', 'C', '\0', '\1'};
+constexpr size_t kHeaderSize = sizeof(kMagic) + sizeof(uint64_t);
+constexpr absl::string_view kEntrySuffix = ".xpcc";
+
+std::string FileNameForKey(absl::string_view key) {
+  tsl::Fprint128 fp = tsl::Fingerprint128(key);
+  return absl::StrCat(absl::Hex(fp.high64, absl::kZeroPad16),
+                      absl::Hex(fp.low64, absl::kZeroPad16), kEntrySuffix);
+}
+
+std::string EncodeEntry(absl::string_view payload) {
+  uint64_t fingerprint = tsl::Fingerprint64(payload);
+  std::string entry;
+  entry.reserve(kHeaderSize + payload.size());
+  entry.append(kMagic, sizeof(kMagic));
+  for (int i = 0; i < 8; ++i) {
+    entry.push_back(static_cast<char>((fingerprint >> (8 * i)) & 0xff));
+  }
+  entry.append(payload.data(), payload.size());
+  return entry;
+}
+
+// Returns the payload of `entry`, or nullopt if the header does not verify.
+std::optional<absl::string_view> DecodeEntry(absl::string_view entry) {
+  if (entry.size() < kHeaderSize ||
+      std::memcmp(entry.data(), kMagic, sizeof(kMagic)) != 0) {
+    return std::nullopt;
+  }
+  uint64_t fingerprint = 0;
+  for (int i = 0; i < 8; ++i) {
+    fingerprint |= static_cast<uint64_t>(
+                       static_cast<unsigned char>(entry[sizeof(kMagic) + i]))
+                   << (8 * i);
+  }
+  absl::string_view payload = entry.substr(kHeaderSize);
+  if (tsl::Fingerprint64(payload) != fingerprint) {
+    return std::nullopt;
+  }
+  return payload;
+}
+
+}  // namespace
+
+PersistentCompilationCache::PersistentCompilationCache(Options options,
+                                                       tsl::Env* env)
+    : options_(std::move(options)), env_(env) {}
+
+StatusOr<std::unique_ptr<PersistentCompilationCache>>
+PersistentCompilationCache::Create(Options options, tsl::Env* env) {
+  if (options.directory.empty()) {
+    return InvalidArgument(
+        "PersistentCompilationCache requires a non-empty directory.");
+  }
+  std::unique_ptr<PersistentCompilationCache> cache(
+      new PersistentCompilationCache(std::move(options), env));
+  TF_RETURN_IF_ERROR(cache->Initialize());
+  return cache;
+}
+
+StatusOr<PersistentCompilationCache*> PersistentCompilationCache::GetOrCreate(
+    const Options& options) {
+  static absl::Mutex mu(absl::kConstInit);
+  static auto* caches =
+      new absl::flat_hash_map<std::string,
+                              std::unique_ptr<PersistentCompilationCache>>();
+  absl::MutexLock lock(&mu);
+  auto it = caches->find(options.directory);
+  if (it != caches->end()) {
+    it->second->set_max_size_bytes(options.max_size_bytes);
+    return it->second.get();
+  }
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<PersistentCompilationCache> cache,
+                      Create(options));
+  PersistentCompilationCache* result = cache.get();
+  caches->emplace(options.directory, std::move(cache));
+  return result;
+}
+
+Status PersistentCompilationCache::Initialize() {
+  TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(options_.directory));
+  std::vector<std::string> children;
+  TF_RETURN_IF_ERROR(env_->GetChildren(options_.directory, &children));
+
+  struct ExistingEntry {
+    std::string file_name;
+    int64_t size_bytes;
+    int64_t mtime_nsec;
+  };
+  std::vector<ExistingEntry> existing;
+  for (std::string& child : children) {
+    if (!absl::EndsWith(child, kEntrySuffix)) {
+      continue;
+    }
+    tsl::FileStatistics stat;
+    if (!env_->Stat(PathFor(child), &stat).ok() || stat.is_directory) {
+      continue;
+    }
+    existing.push_back({std::move(child), stat.length, stat.mtime_nsec});
+  }
+  // Oldest first, so that pushing each to the front leaves the newest entry
+  // as the most recently used.
+  std::sort(existing.begin(), existing.end(),
+            [](const ExistingEntry& a, const ExistingEntry& b) {
+              return a.mtime_nsec < b.mtime_nsec;
+            });
+
+  absl::MutexLock lock(&mu_);
+  for (ExistingEntry& e : existing) {
+    lru_.push_front({e.file_name, e.size_bytes});
+    index_[std::move(e.file_name)] = lru_.begin();
+    stats_.size_bytes += e.size_bytes;
+    ++stats_.num_entries;
+  }
+  EvictLocked();
+  VLOG(1) << "PersistentCompilationCache at " << options_.directory
+          << " indexed " << stats_.num_entries << " entries ("
+          << stats_.size_bytes << " bytes)";
+  return OkStatus();
+}
+
+void PersistentCompilationCache::set_max_size_bytes(int64_t max_size_bytes) {
+  absl::MutexLock lock(&mu_);
+  options_.max_size_bytes = max_size_bytes;
+  EvictLocked();
+}
+
+std::string PersistentCompilationCache::PathFor(
+    absl::string_view file_name) const {
+  return tsl::io::JoinPath(options_.directory, file_name);
+}
+
+std::optional<std::string> PersistentCompilationCache::Lookup(
+    absl::string_view key) {
+  std::string file_name = FileNameForKey(key);
+  std::string path = PathFor(file_name);
+
+  // The file is read even when it is not indexed: another process sharing the
+  // directory may have written it after this cache was initialized.
+  std::string contents;
+  Status read_status = tsl::ReadFileToString(env_, path, &contents);
+  std::optional<absl::string_view> payload;
+  if (read_status.ok()) {
+    payload = DecodeEntry(contents);
+    if (!payload.has_value()) {
+      LOG(WARNING) << "Deleting corrupted persistent compilation cache entry "
+                   << path;
+      env_->DeleteFile(path).IgnoreError();
+    }
+  }
+
+  absl::MutexLock lock(&mu_);
+  auto it = index_.find(file_name);
+  if (!payload.has_value()) {
+    if (read_status.ok()) {
+      ++stats_.corrupted_entries;
+    }
+    if (it != index_.end()) {
+      RemoveLocked(it->second);
+    }
+    ++stats_.misses;
+    persistent_cache_misses->GetCell()->IncrementBy(1);
+    return std::nullopt;
+  }
+
+  if (it == index_.end()) {
+    lru_.push_front({file_name, static_cast<int64_t>(contents.size())});
+    index_[file_name] = lru_.begin();
+    stats_.size_bytes += contents.size();
+    ++stats_.num_entries;
+    EvictLocked();
+  } else {
+    TouchLocked(it->second);
+  }
+  ++stats_.hits;
+  persistent_cache_hits->GetCell()->IncrementBy(1);
+  return std::string(*payload);
+}
+
+Status PersistentCompilationCache::Insert(absl::string_view key,
+                                          absl::string_view value) {
+  std::string file_name = FileNameForKey(key);
+  std::string path = PathFor(file_name);
+  std::string entry = EncodeEntry(value);
+
+  std::string tmp_path = absl::StrCat(
+      path, ".tmp.", absl::Hex(tsl::random::New64(), absl::kZeroPad16));
+  Status status = tsl::WriteStringToFile(env_, tmp_path, entry);
+  if (status.ok()) {
+    status = env_->RenameFile(tmp_path, path);
+  }
+  if (!status.ok()) {
+    env_->DeleteFile(tmp_path).IgnoreError();
+    return status;
+  }
+
+  absl::MutexLock lock(&mu_);
+  auto it = index_.find(file_name);
+  if (it != index_.end()) {
+    RemoveLocked(it->second);
+  }
+  lru_.push_front({file_name, static_cast<int64_t>(entry.size())});
+  index_[file_name] = lru_.begin();
+  stats_.size_bytes += entry.size();
+  ++stats_.num_entries;
+  ++stats_.insertions;
+  EvictLocked();
+  return OkStatus();
+}
+
+PersistentCompilationCache::Stats PersistentCompilationCache::stats() const {
+  absl::MutexLock lock(&mu_);
+  return stats_;
+}
+
+void PersistentCompilationCache::TouchLocked(EntryList::iterator it) {
+  lru_.splice(lru_.begin(), lru_, it);
+}
+
+void PersistentCompilationCache::RemoveLocked(EntryList::iterator it) {
+  stats_.size_bytes -= it->size_bytes;
+  --stats_.num_entries;
+  index_.erase(it->file_name);
+  lru_.erase(it);
+}
+
+void PersistentCompilationCache::EvictLocked() {
+  if (options_.max_size_bytes <= 0) {
+    return;
+  }
+  // The most recently used entry is always kept, even if it alone exceeds the
+  // budget; otherwise an oversized executable would be written and deleted on
+  // every compilation.
+  while (stats_.size_bytes > options_.max_size_bytes && lru_.size() > 1) {
+    auto victim = std::prev(lru_.end());
+    std::string path = PathFor(victim->file_name);
+    VLOG(2) << "Evicting persistent compilation cache entry " << path;
+    env_->DeleteFile(path).IgnoreError();
+    RemoveLocked(victim);
+    ++stats_.evictions;
+    persistent_cache_evictions->GetCell()->IncrementBy(1);
+  }
+}
+
+}  // namespace xla
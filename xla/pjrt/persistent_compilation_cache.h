@@ -0,0 +1,125 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_PJRT_PERSISTENT_COMPILATION_CACHE_H_
+#define XLA_PJRT_PERSISTENT_COMPILATION_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/status.h"
+#include "xla/statusor.h"
+#include "tsl/platform/env.h"
+
+namespace xla {
+
+// A directory-backed cache of serialized executables, keyed by an opaque
+// string (typically a fingerprint of the computation and everything else that
+// influences code generation). Entries survive process restarts, so repeated
+// runs of the same program skip compilation entirely.
+//
+// Each entry is a single file holding a small header (magic and a fingerprint
+// of the payload) followed by the payload. Writes go to a temporary file that
+// is renamed into place, so concurrent writers, including writers in other
+// processes, never expose a partially written entry. Entries whose header does
+// not verify are deleted and reported as misses.
+//
+// When `max_size_bytes` is positive the cache evicts least recently used
+// entries once the directory grows beyond it. Recency is tracked in memory;
+// on startup it is seeded from file modification times.
+//
+// Thread-safe.
+class PersistentCompilationCache {
+ public:
+  struct Options {
+    std::string directory;
+    // <= 0 means unbounded.
+    int64_t max_size_bytes = 0;
+  };
+
+  struct Stats {
+    int64_t hits = 0;
+    int64_t misses = 0;
+    int64_t insertions = 0;
+    int64_t evictions = 0;
+    int64_t corrupted_entries = 0;
+    int64_t size_bytes = 0;
+    int64_t num_entries = 0;
+  };
+
+  // Creates the cache directory if needed and indexes the entries already in
+  // it, evicting down to `max_size_bytes`.
+  static StatusOr<std::unique_ptr<PersistentCompilationCache>> Create(
+      Options options, tsl::Env* env = tsl::Env::Default());
+
+  // Returns the process-wide cache for `options.directory`, creating it on
+  // first use. Later calls for the same directory share the instance; a
+  // different `max_size_bytes` replaces the previous budget.
+  static StatusOr<PersistentCompilationCache*> GetOrCreate(
+      const Options& options);
+
+  PersistentCompilationCache(const PersistentCompilationCache&) = delete;
+  PersistentCompilationCache& operator=(const PersistentCompilationCache&) =
+      delete;
+
+  // Returns the value stored under `key`, or nullopt if there is no valid
+  // entry.
+  std::optional<std::string> Lookup(absl::string_view key);
+
+  // Stores `value` under `key`, replacing any existing entry, and evicts
+  // older entries if the cache is over budget.
+  Status Insert(absl::string_view key, absl::string_view value);
+
+  Stats stats() const;
+  const std::string& directory() const { return options_.directory; }
+
+ private:
+  struct Entry {
+    std::string file_name;
+    int64_t size_bytes;
+  };
+  // Most recently used at the front.
+  using EntryList = std::list<Entry>;
+
+  PersistentCompilationCache(Options options, tsl::Env* env);
+
+  Status Initialize();
+  void set_max_size_bytes(int64_t max_size_bytes);
+
+  std::string PathFor(absl::string_view file_name) const;
+  void TouchLocked(EntryList::iterator it) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void RemoveLocked(EntryList::iterator it) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void EvictLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Options options_;
+  tsl::Env* env_;
+
+  mutable absl::Mutex mu_;
+  EntryList lru_ ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_map<std::string, EntryList::iterator> index_
+      ABSL_GUARDED_BY(mu_);
+  Stats stats_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace xla
+
+#endif  // XLA_PJRT_PERSISTENT_COMPILATION_CACHE_H_
@@ -0,0 +1,131 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/persistent_compilation_cache.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "xla/test.h"
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+
+namespace xla {
+namespace {
+
+std::string TestDirectory(const std::string& name) {
+  std::string dir = tsl::io::JoinPath(tsl::testing::TmpDir(), name);
+  int64_t undeleted_files, undeleted_dirs;
+  tsl::Env::Default()
+      ->DeleteRecursively(dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  return dir;
+}
+
+TEST(PersistentCompilationCacheTest, InsertThenLookup) {
+  PersistentCompilationCache::Options options;
+  options.directory = TestDirectory("insert_then_lookup");
+  TF_ASSERT_OK_AND_ASSIGN(auto cache,
+                          PersistentCompilationCache::Create(options));
+
+  EXPECT_EQ(cache->Lookup("key"), std::nullopt);
+  TF_ASSERT_OK(cache->Insert("key", "value"));
+  EXPECT_EQ(cache->Lookup("key"), "value");
+  TF_ASSERT_OK(cache->Insert("key", "other value"));
+  EXPECT_EQ(cache->Lookup("key"), "other value");
+
+  PersistentCompilationCache::Stats stats = cache->stats();
+  EXPECT_EQ(stats.hits, 2);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.insertions, 2);
+  EXPECT_EQ(stats.num_entries, 1);
+}
+
+TEST(PersistentCompilationCacheTest, SurvivesReopening) {
+  PersistentCompilationCache::Options options;
+  options.directory = TestDirectory("survives_reopening");
+  {
+    TF_ASSERT_OK_AND_ASSIGN(auto cache,
+                            PersistentCompilationCache::Create(options));
+    TF_ASSERT_OK(cache->Insert("a", std::string(1000, 'a')));
+    TF_ASSERT_OK(cache->Insert("b", std::string(1000, 'b')));
+  }
+  TF_ASSERT_OK_AND_ASSIGN(auto cache,
+                          PersistentCompilationCache::Create(options));
+  EXPECT_EQ(cache->stats().num_entries, 2);
+  EXPECT_EQ(cache->Lookup("a"), std::string(1000, 'a'));
+  EXPECT_EQ(cache->Lookup("b"), std::string(1000, 'b'));
+}
+
+TEST(PersistentCompilationCacheTest, EvictsLeastRecentlyUsed) {
+  PersistentCompilationCache::Options options;
+  options.directory = TestDirectory("evicts_lru");
+  options.max_size_bytes = 2500;
+  TF_ASSERT_OK_AND_ASSIGN(auto cache,
+                          PersistentCompilationCache::Create(options));
+
+  TF_ASSERT_OK(cache->Insert("a", std::string(1000, 'a')));
+  TF_ASSERT_OK(cache->Insert("b", std::string(1000, 'b')));
+  // Touch "a" so that "b" is the least recently used entry.
+  EXPECT_TRUE(cache->Lookup("a").has_value());
+  TF_ASSERT_OK(cache->Insert("c", std::string(1000, 'c')));
+
+  EXPECT_EQ(cache->stats().evictions, 1);
+  EXPECT_LE(cache->stats().size_bytes, options.max_size_bytes);
+  EXPECT_TRUE(cache->Lookup("a").has_value());
+  EXPECT_FALSE(cache->Lookup("b").has_value());
+  EXPECT_TRUE(cache->Lookup("c").has_value());
+}
+
+TEST(PersistentCompilationCacheTest, CorruptedEntryIsAMiss) {
+  PersistentCompilationCache::Options options;
+  options.directory = TestDirectory("corrupted_entry");
+  TF_ASSERT_OK_AND_ASSIGN(auto cache,
+                          PersistentCompilationCache::Create(options));
+  TF_ASSERT_OK(cache->Insert("key", "some serialized executable"));
+
+  tsl::Env* env = tsl::Env::Default();
+  std::vector<std::string> children;
+  TF_ASSERT_OK(env->GetChildren(options.directory, &children));
+  ASSERT_EQ(children.size(), 1);
+  std::string path = tsl::io::JoinPath(options.directory, children[0]);
+  std::string contents;
+  TF_ASSERT_OK(tsl::ReadFileToString(env, path, &contents));
+  contents.back() ^= 1;
+  TF_ASSERT_OK(tsl::WriteStringToFile(env, path, contents));
+
+  EXPECT_EQ(cache->Lookup("key"), std::nullopt);
+  EXPECT_EQ(cache->stats().corrupted_entries, 1);
+  EXPECT_EQ(cache->stats().num_entries, 0);
+  EXPECT_FALSE(env->FileExists(path).ok());
+}
+
+TEST(PersistentCompilationCacheTest, GetOrCreateSharesInstances) {
+  PersistentCompilationCache::Options options;
+  options.directory = TestDirectory("get_or_create");
+  TF_ASSERT_OK_AND_ASSIGN(PersistentCompilationCache * a,
+                          PersistentCompilationCache::GetOrCreate(options));
+  TF_ASSERT_OK_AND_ASSIGN(PersistentCompilationCache * b,
+                          PersistentCompilationCache::GetOrCreate(options));
+  EXPECT_EQ(a, b);
+}
+
+}  // namespace
+}  // namespace xla
@@ -37,10 +37,14 @@ limitations under the License.
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/TargetParser/Host.h"
 #include "mlir/IR/BuiltinOps.h"  // from @llvm-project
 #include "xla/array.h"
 #include "xla/client/executable_build_options.h"
@@ -54,9 +58,11 @@ limitations under the License.
 #include "xla/literal.h"
 #include "xla/literal_util.h"
 #include "xla/pjrt/compile_options.pb.h"
+#include "xla/pjrt/cpu_buffer_allocator.h"
 #include "xla/pjrt/mlir_to_hlo.h"
 #include "xla/pjrt/pjrt_client.h"
 #include "xla/pjrt/pjrt_executable.h"
+#include "xla/pjrt/persistent_compilation_cache.h"
 #include "xla/pjrt/pjrt_future.h"
 #include "xla/pjrt/semaphore.h"
 #include "xla/pjrt/tracked_tfrt_cpu_device_buffer.h"
@@ -77,10 +83,14 @@ limitations under the License.
 #include "xla/shape.h"
 #include "xla/statusor.h"
 #include "xla/xla_data.pb.h"
+#include "tsl/lib/strings/proto_serialization.h"
 #include "tsl/platform/casts.h"
+#include "tsl/platform/cpu_info.h"
 #include "tsl/platform/denormal.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
+#include "tsl/platform/fingerprint.h"
+#include "tsl/platform/numa.h"
 #include "tsl/platform/setround.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/platform/threadpool.h"
@@ -88,11 +98,63 @@ limitations under the License.
 #include "tfrt/host_context/async_value_ref.h"  // from @tf_runtime
 #include "tfrt/support/forward_decls.h"  // from @tf_runtime
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
 namespace xla {
 namespace {
 
 using ::xla::runtime::CpuEvent;
 
+// Returns the CPUs the process may run on, or an empty vector if the
+// platform does not support CPU affinity.
+std::vector<int> AvailableCpus() {
+  std::vector<int> cpus;
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpu_set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+  return cpus;
+}
+
+// An Env that starts threads pinned to a set of CPUs.
+class CpuAffinityEnv : public tsl::EnvWrapper {
+ public:
+  CpuAffinityEnv(tsl::Env* env, std::vector<int> cpus)
+      : tsl::EnvWrapper(env), cpus_(std::move(cpus)) {}
+
+  tsl::Thread* StartThread(const tsl::ThreadOptions& thread_options,
+                           const std::string& name,
+                           absl::AnyInvocable<void()> fn) override {
+    return tsl::EnvWrapper::StartThread(
+        thread_options, name, [cpus = cpus_, fn = std::move(fn)]() mutable {
+#if defined(__linux__)
+          cpu_set_t cpu_set;
+          CPU_ZERO(&cpu_set);
+          for (int cpu : cpus) {
+            CPU_SET(cpu, &cpu_set);
+          }
+          if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+            LOG(WARNING) << "Failed to pin thread to CPUs "
+                         << absl::StrJoin(cpus, ",");
+          }
+#endif
+          fn();
+        });
+  }
+
+ private:
+  std::vector<int> cpus_;
+};
+
 StatusOr<std::unique_ptr<TfrtCpuBuffer>> AllocateDestinationBuffer(
     const Shape& on_device_shape,
     absl::InlinedVector<tfrt::AsyncValueRef<CpuEvent>, 4> definition_events,
@@ -100,7 +162,8 @@ StatusOr<std::unique_ptr<TfrtCpuBuffer>> AllocateDestinationBuffer(
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<TrackedTfrtCpuDeviceBuffer> tracked_device_buffer,
       AbstractTfrtCpuBuffer::AllocateTrackedDeviceBuffer(
-          on_device_shape, std::move(definition_events)));
+          on_device_shape, std::move(definition_events),
+          device->allocator()));
   return std::make_unique<TfrtCpuBuffer>(
       on_device_shape, std::move(tracked_device_buffer), client, device);
 }
@@ -347,11 +410,42 @@ absl::string_view TfrtCpuDeviceDescription::ToString() const {
   return to_string_;
 }
 
-TfrtCpuDevice::TfrtCpuDevice(int id, int max_inflight_computations)
+TfrtCpuDevice::TfrtCpuDevice(int id, int max_inflight_computations,
+                             std::shared_ptr<CpuBufferAllocator> allocator)
     : description_(id),
+      allocator_(std::move(allocator)),
       max_inflight_computations_semaphore_(
           /*capacity=*/max_inflight_computations) {}
 
+StatusOr<tsl::AllocatorStats> TfrtCpuDevice::GetAllocatorStats() const {
+  if (allocator_ == nullptr) {
+    return Unimplemented("GetAllocatorStats is not supported");
+  }
+  return allocator_->GetStats();
+}
+
+void TfrtCpuDevice::CreatePinnedThreadPools(std::vector<int> cpus,
+                                            int numa_node, int num_threads) {
+  CHECK(execution_thread_pool_ == nullptr);
+  VLOG(1) << "Pinning " << DebugString() << " to CPUs ["
+          << absl::StrJoin(cpus, ",") << "], NUMA node " << numa_node;
+  tsl::Env* env = tsl::Env::Default();
+  if (!cpus.empty()) {
+    pinned_env_ = std::make_unique<CpuAffinityEnv>(env, std::move(cpus));
+    env = pinned_env_.get();
+  }
+  tsl::ThreadOptions thread_options;
+  thread_options.numa_node = numa_node;
+  execution_thread_pool_ = std::make_unique<tsl::thread::ThreadPool>(
+      env, thread_options, absl::StrCat("XLATfrtCpuDevice", id()),
+      num_threads);
+  eigen_intraop_pool_ = std::make_unique<tsl::thread::ThreadPool>(
+      env, thread_options, absl::StrCat("XLAEigen", id()), num_threads);
+  eigen_intraop_device_ = std::make_unique<Eigen::ThreadPoolDevice>(
+      eigen_intraop_pool_->AsEigenThreadPool(),
+      eigen_intraop_pool_->NumThreads());
+}
+
 Status TfrtCpuDevice::TransferToInfeed(const LiteralSlice& literal) {
   return TransferLiteralToInfeedOnCpu(local_hardware_id(), literal);
 }
@@ -368,30 +462,93 @@ static int CpuDeviceCount() {
 }
 
 static StatusOr<std::vector<std::unique_ptr<TfrtCpuDevice>>> GetTfrtCpuDevices(
-    int cpu_device_count, int max_inflight_computations_per_device) {
+    int cpu_device_count, int max_inflight_computations_per_device,
+    const CpuBufferAllocator::Options& allocator_options,
+    bool pin_devices_to_cpus) {
+  // One allocator arena per NUMA node, with the devices spread round-robin
+  // over the nodes. Without NUMA support all devices share a single arena.
+  const int num_numa_nodes = tsl::port::NUMANumNodes();
+  std::vector<std::shared_ptr<CpuBufferAllocator>> allocators;
+  for (int node = 0; node < std::min(num_numa_nodes, cpu_device_count);
+       ++node) {
+    CpuBufferAllocator::Options options = allocator_options;
+    options.numa_node = num_numa_nodes > 1 ? node : tsl::port::kNUMANoAffinity;
+    allocators.push_back(std::make_shared<CpuBufferAllocator>(options));
+  }
+
   std::vector<std::unique_ptr<TfrtCpuDevice>> devices;
   for (int i = 0; i < cpu_device_count; ++i) {
     auto device = std::make_unique<TfrtCpuDevice>(
-        /*id=*/i, max_inflight_computations_per_device);
+        /*id=*/i, max_inflight_computations_per_device,
+        allocators[i % allocators.size()]);
     devices.push_back(std::move(device));
   }
+  if (!pin_devices_to_cpus || cpu_device_count == 0) {
+    return std::move(devices);
+  }
+
+  // With several NUMA nodes, the threads of a device are bound to the node of
+  // its allocator, so that the buffers it writes are first touched there.
+  // Otherwise every device gets a contiguous share of the available CPUs.
+  if (num_numa_nodes > 1) {
+    const int devices_per_node =
+        (cpu_device_count + num_numa_nodes - 1) / num_numa_nodes;
+    const int num_threads = std::max(
+        1, tsl::port::NumSchedulableCPUs() / num_numa_nodes / devices_per_node);
+    for (int i = 0; i < cpu_device_count; ++i) {
+      devices[i]->CreatePinnedThreadPools(/*cpus=*/{}, i % num_numa_nodes,
+                                          num_threads);
+    }
+    return std::move(devices);
+  }
+  std::vector<int> cpus = AvailableCpus();
+  const int num_cpus = cpus.empty() ? tsl::port::MaxParallelism()
+                                    : static_cast<int>(cpus.size());
+  const int cpus_per_device = std::max(1, num_cpus / cpu_device_count);
+  for (int i = 0; i < cpu_device_count; ++i) {
+    std::vector<int> device_cpus;
+    if (!cpus.empty()) {
+      // If there are fewer CPUs than devices, devices share CPUs.
+      for (int j = 0; j < cpus_per_device; ++j) {
+        device_cpus.push_back(cpus[(i * cpus_per_device + j) % cpus.size()]);
+      }
+    }
+    devices[i]->CreatePinnedThreadPools(std::move(device_cpus),
+                                        tsl::port::kNUMANoAffinity,
+                                        cpus_per_device);
+  }
   return std::move(devices);
 }
 
 StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(
-    bool asynchronous, int cpu_device_count,
-    int max_inflight_computations_per_device) {
+    const CpuClientOptions& options) {
+  const int cpu_device_count =
+      options.cpu_device_count.value_or(CpuDeviceCount());
   // Need at least CpuDeviceCount threads to launch one collective.
   size_t num_threads = std::max(DefaultThreadPoolSize(), cpu_device_count);
 
-  TF_ASSIGN_OR_RETURN(std::vector<std::unique_ptr<TfrtCpuDevice>> devices,
-                      GetTfrtCpuDevices(cpu_device_count,
-                                        max_inflight_computations_per_device));
+  TF_ASSIGN_OR_RETURN(
+      std::vector<std::unique_ptr<TfrtCpuDevice>> devices,
+      GetTfrtCpuDevices(cpu_device_count,
+                        options.max_inflight_computations_per_device,
+                        options.allocator_options,
+                        options.pin_devices_to_cpus));
 
   return std::unique_ptr<PjRtClient>(std::make_unique<TfrtCpuClient>(
       /*process_index=*/0, std::move(devices), num_threads));
 }
 
+StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(
+    bool asynchronous, int cpu_device_count,
+    int max_inflight_computations_per_device) {
+  CpuClientOptions options;
+  options.asynchronous = asynchronous;
+  options.cpu_device_count = cpu_device_count;
+  options.max_inflight_computations_per_device =
+      max_inflight_computations_per_device;
+  return GetTfrtCpuClient(options);
+}
+
 StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(bool asynchronous) {
   return GetTfrtCpuClient(asynchronous, CpuDeviceCount());
 }
@@ -435,7 +592,16 @@ TfrtCpuClient::TfrtCpuClient(
   LOG(INFO) << "TfrtCpuClient created.";
 }
 
-TfrtCpuClient::~TfrtCpuClient() { LOG(INFO) << "TfrtCpuClient destroyed."; }
+TfrtCpuClient::~TfrtCpuClient() {
+  // Buffers that outlive the client keep their allocator alive, and with it
+  // any blocks it cached; give those back to the system now.
+  for (const std::unique_ptr<TfrtCpuDevice>& device : owned_devices_) {
+    if (device->allocator() != nullptr) {
+      device->allocator()->ReleaseCachedMemory();
+    }
+  }
+  LOG(INFO) << "TfrtCpuClient destroyed.";
+}
 
 StatusOr<PjRtDevice*> TfrtCpuClient::LookupDevice(int device_id) const {
   auto it = id_to_device_.find(device_id);
@@ -685,6 +851,86 @@ static StatusOr<std::unique_ptr<xla::Executable>> JitCompile(
                              dummy);
 }
 
+// Bump whenever the serialized executable format or anything else that is not
+// captured by the inputs of PersistentCacheKey changes in an incompatible way.
+static constexpr int kPersistentCacheFormatVersion = 2;
+
+// Returns the persistent compilation cache configured in `debug_options`, or
+// nullptr if there is none or it cannot be opened.
+static PersistentCompilationCache* GetPersistentCompilationCache(
+    const DebugOptions& debug_options) {
+  if (debug_options.xla_cpu_persistent_cache_dir().empty()) {
+    return nullptr;
+  }
+  PersistentCompilationCache::Options cache_options;
+  cache_options.directory = debug_options.xla_cpu_persistent_cache_dir();
+  cache_options.max_size_bytes =
+      debug_options.xla_cpu_persistent_cache_max_size_bytes();
+  StatusOr<PersistentCompilationCache*> cache =
+      PersistentCompilationCache::GetOrCreate(cache_options);
+  if (!cache.ok()) {
+    LOG(WARNING) << "Disabling persistent compilation cache: "
+                 << cache.status();
+    return nullptr;
+  }
+  return *cache;
+}
+
+// Returns the host CPU name and its sorted feature string, which determine the
+// code the JIT generates.
+static const std::string& HostCpuFingerprintInput() {
+  static const std::string* const result = [] {
+    llvm::StringMap<bool> host_features;
+    std::vector<std::string> features;
+    if (llvm::sys::getHostCPUFeatures(host_features)) {
+      for (auto& feature : host_features) {
+        features.push_back((feature.second ? '+' : '-') +
+                           std::string(feature.first()));
+      }
+    }
+    std::sort(features.begin(), features.end());
+    return new std::string(absl::StrCat(llvm::sys::getHostCPUName().str(),
+                                        ";", absl::StrJoin(features, ",")));
+  }();
+  return *result;
+}
+
+// Computes the persistent compilation cache key for compiling `computation`
+// with `options` and `execution_options`, after all overrides were applied.
+static StatusOr<std::string> PersistentCacheKey(
+    const XlaComputation& computation, const CompileOptions& options,
+    ExecutionOptions execution_options) {
+  // The cache location does not influence the generated code.
+  auto clear_cache_options = [](DebugOptions* debug_options) {
+    debug_options->clear_xla_cpu_persistent_cache_dir();
+    debug_options->clear_xla_cpu_persistent_cache_max_size_bytes();
+  };
+  clear_cache_options(execution_options.mutable_debug_options());
+  TF_ASSIGN_OR_RETURN(CompileOptionsProto options_proto, options.ToProto());
+  if (options_proto.executable_build_options().has_debug_options()) {
+    clear_cache_options(options_proto.mutable_executable_build_options()
+                            ->mutable_debug_options());
+  }
+
+  std::string computation_bytes, options_bytes, execution_options_bytes;
+  if (!tsl::SerializeToStringDeterministic(computation.proto(),
+                                           &computation_bytes) ||
+      !tsl::SerializeToStringDeterministic(options_proto, &options_bytes) ||
+      !tsl::SerializeToStringDeterministic(execution_options,
+                                           &execution_options_bytes)) {
+    return Internal("Failed to serialize persistent compilation cache key");
+  }
+
+  std::string key_input = absl::StrCat(
+      kPersistentCacheFormatVersion, ";", LLVM_VERSION_STRING, ";",
+      HostCpuFingerprintInput(), ";", computation_bytes.size(), ";",
+      computation_bytes, options_bytes.size(), ";", options_bytes,
+      execution_options_bytes);
+  tsl::Fprint128 fingerprint = tsl::Fingerprint128(key_input);
+  return absl::StrCat("cpu_", absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+}
+
 StatusOr<std::unique_ptr<PjRtLoadedExecutable>> TfrtCpuClient::Compile(
     const XlaComputation& computation, CompileOptions options) {
   tsl::profiler::TraceMe traceme("TfrtCpuClient::Compile");
@@ -745,6 +991,29 @@ StatusOr<std::unique_ptr<PjRtLoadedExecutable>> TfrtCpuClient::Compile(
                       computation.GetProgramShape());
   ExecutionOptions execution_options =
       CreateExecutionOptions(build_options, &program_shape);
+
+  PersistentCompilationCache* persistent_cache =
+      GetPersistentCompilationCache(execution_options.debug_options());
+  std::string persistent_cache_key;
+  if (persistent_cache != nullptr) {
+    TF_ASSIGN_OR_RETURN(
+        persistent_cache_key,
+        PersistentCacheKey(computation, options, execution_options));
+    if (std::optional<std::string> serialized =
+            persistent_cache->Lookup(persistent_cache_key)) {
+      StatusOr<std::unique_ptr<PjRtLoadedExecutable>> cached =
+          DeserializeExecutable(*serialized, input_options);
+      if (cached.ok()) {
+        VLOG(1) << "Loaded executable " << persistent_cache_key
+                << " from the persistent compilation cache";
+        return cached;
+      }
+      LOG(WARNING) << "Failed to load executable " << persistent_cache_key
+                   << " from the persistent compilation cache, recompiling: "
+                   << cached.status();
+    }
+  }
+
   TF_ASSIGN_OR_RETURN(std::unique_ptr<Executable> cpu_executable,
                       JitCompile(computation, argument_layout_pointers,
                                  build_options, execution_options));
@@ -775,6 +1044,23 @@ StatusOr<std::unique_ptr<PjRtLoadedExecutable>> TfrtCpuClient::Compile(
   TF_RETURN_IF_ERROR(
       executable->SetUpDonation(options.parameter_is_tupled_arguments));
 
+  if (persistent_cache != nullptr) {
+    // The JIT keeps what it needs to export the executable when the cache is
+    // set; failures here never fail the compilation.
+    StatusOr<std::string> serialized = executable->SerializeExecutable();
+    if (serialized.ok()) {
+      Status status = persistent_cache->Insert(persistent_cache_key,
+                                               *serialized);
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed to write executable " << persistent_cache_key
+                     << " to the persistent compilation cache: " << status;
+      }
+    } else {
+      VLOG(1) << "Executable " << persistent_cache_key
+              << " is not cacheable: " << serialized.status();
+    }
+  }
+
   return std::unique_ptr<PjRtLoadedExecutable>(std::move(executable));
 }
 
@@ -838,7 +1124,8 @@ StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuClient::BufferFromHostBuffer(
       AbstractTfrtCpuBuffer::BufferFromHostBufferHelper(
           data, type, dims, byte_strides, host_buffer_semantics,
           std::move(on_done_with_host_buffer), shape, async_work_runner(),
-          &transpose_mu_, &transpose_cache_));
+          &transpose_mu_, &transpose_cache_,
+          tensorflow::down_cast<TfrtCpuDevice*>(device)->allocator()));
 
   return std::unique_ptr<PjRtBuffer>(std::make_unique<TfrtCpuBuffer>(
       shape, std::move(tracked_device_buffer), this,
@@ -906,7 +1193,9 @@ StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuBuffer::CopyToDevice(
 
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<TrackedTfrtCpuDeviceBuffer> tracked_device_buffer,
-      CopyToDeviceHelper(client()->async_work_runner()));
+      CopyToDeviceHelper(
+          client()->async_work_runner(),
+          tensorflow::down_cast<TfrtCpuDevice*>(dst_device)->allocator()));
 
   return std::unique_ptr<PjRtBuffer>(std::make_unique<TfrtCpuBuffer>(
       on_device_shape_, std::move(tracked_device_buffer), client(),
@@ -986,7 +1275,8 @@ Status TfrtCpuExecutable::SetUpDonation(bool tuple_inputs) {
 // and assemble the buffer pointers in order to call into CpuExecutable.
 static StatusOr<std::shared_ptr<MaybeOwningCpuMemory>> MemoryForAllocation(
     const BufferAllocation& allocation,
-    absl::Span<std::pair<bool, TrackedTfrtCpuDeviceBuffer*> const> arguments) {
+    absl::Span<std::pair<bool, TrackedTfrtCpuDeviceBuffer*> const> arguments,
+    const std::shared_ptr<CpuBufferAllocator>& allocator) {
   if (allocation.is_entry_computation_parameter()) {
     auto [can_donate, arg] = arguments[allocation.parameter_number()];
     std::shared_ptr<MaybeOwningCpuMemory> out =
@@ -999,8 +1289,8 @@ static StatusOr<std::shared_ptr<MaybeOwningCpuMemory>> MemoryForAllocation(
     // example we might be pointing to a buffer owned by the client whose
     // lifetime will not extend past the lifetime of the donated input buffer.
     if ((!can_donate || !out->owns_data()) && !allocation.is_readonly()) {
-      TF_ASSIGN_OR_RETURN(
-          auto copy, MaybeOwningCpuMemory::AllocateShared(allocation.size()));
+      TF_ASSIGN_OR_RETURN(auto copy, MaybeOwningCpuMemory::AllocateShared(
+                                         allocation.size(), allocator));
       std::memcpy(copy->data(), out->data(), allocation.size());
       return copy;
     }
@@ -1012,8 +1302,9 @@ static StatusOr<std::shared_ptr<MaybeOwningCpuMemory>> MemoryForAllocation(
   }
 
   // Output and temporary buffer.
-  TF_ASSIGN_OR_RETURN(auto out,
-                      MaybeOwningCpuMemory::AllocateShared(allocation.size()));
+  TF_ASSIGN_OR_RETURN(
+      auto out, MaybeOwningCpuMemory::AllocateShared(allocation.size(),
+                                                     allocator));
 
   // Since the output buffer and all the temporary buffers were written into
   // by the JITed code, msan has no way of knowing their memory was
@@ -1026,13 +1317,15 @@ static StatusOr<std::shared_ptr<MaybeOwningCpuMemory>> MemoryForAllocation(
 static StatusOr<std::vector<std::shared_ptr<MaybeOwningCpuMemory>>>
 CreateBufferTable(
     const BufferAssignment& assignment,
-    absl::Span<std::pair<bool, TrackedTfrtCpuDeviceBuffer*> const> arguments) {
+    absl::Span<std::pair<bool, TrackedTfrtCpuDeviceBuffer*> const> arguments,
+    const std::shared_ptr<CpuBufferAllocator>& allocator) {
   std::vector<std::shared_ptr<MaybeOwningCpuMemory>> buffers(
       assignment.Allocations().size());
   for (BufferAllocation::Index i = 0; i < assignment.Allocations().size();
        ++i) {
     const BufferAllocation& allocation = assignment.GetAllocation(i);
-    TF_ASSIGN_OR_RETURN(buffers[i], MemoryForAllocation(allocation, arguments));
+    TF_ASSIGN_OR_RETURN(buffers[i],
+                        MemoryForAllocation(allocation, arguments, allocator));
   }
   return std::move(buffers);
 }
@@ -1223,7 +1516,8 @@ StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
       tensorflow::down_cast<cpu::CpuExecutable*>(cpu_executable_.get());
   TF_ASSIGN_OR_RETURN(
       std::vector<std::shared_ptr<MaybeOwningCpuMemory>> buffer_table,
-      CreateBufferTable(cpu_executable->buffer_assignment(), tracked_buffers));
+      CreateBufferTable(cpu_executable->buffer_assignment(), tracked_buffers,
+                        device->allocator()));
   auto result_buffers =
       CreateResultShapedBuffer(result_buffer_indices_, buffer_table);
 
@@ -1248,7 +1542,15 @@ StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
   run_options.set_device_ordinal(device->local_hardware_id());
   // Need to keep device_assignment alive until execution completes.
   run_options.set_device_assignment(device_assignment.get());
-  run_options.set_intra_op_thread_pool(client_->eigen_intraop_device());
+  // Devices with pinned thread pools run their computations on them.
+  run_options.set_intra_op_thread_pool(
+      device->eigen_intraop_device() != nullptr
+          ? device->eigen_intraop_device()
+          : client_->eigen_intraop_device());
+  tsl::thread::ThreadPool* execution_thread_pool =
+      device->execution_thread_pool() != nullptr
+          ? device->execution_thread_pool()
+          : client()->pjrt_client_thread_pool();
 
   // Schedule only one collective at a time.
   bool is_a_collective_launch = !!last_collective_launch_event;
@@ -1311,7 +1613,7 @@ StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
     std::vector<tfrt::RCReference<tfrt::AsyncValue>> input_deps_avs_copy =
         CopyAsyncValues(input_deps);
     EnqueueWorkWhenReady(
-        client()->pjrt_client_thread_pool(), input_deps,
+        execution_thread_pool, input_deps,
         [cpu_executable, result_buffer,
          buffer_pointers = std::move(buffer_pointers),
          buffer_table = std::move(buffer_table),
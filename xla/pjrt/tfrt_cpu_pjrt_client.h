@@ -38,6 +38,7 @@ limitations under the License.
 #include "xla/hlo/ir/hlo_module.h"
 #include "xla/literal.h"
 #include "xla/pjrt/abstract_tfrt_cpu_buffer.h"
+#include "xla/pjrt/cpu_buffer_allocator.h"
 #include "xla/pjrt/pjrt_client.h"
 #include "xla/pjrt/pjrt_executable.h"
 #include "xla/pjrt/pjrt_future.h"
@@ -54,6 +55,7 @@ limitations under the License.
 #include "xla/status.h"
 #include "xla/util.h"
 #include "xla/xla_data.pb.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/fingerprint.h"
 #include "tsl/platform/threadpool.h"
@@ -89,7 +91,12 @@ class TfrtCpuDeviceDescription final : public PjRtDeviceDescription {
 
 class TfrtCpuDevice final : public PjRtDevice {
  public:
-  explicit TfrtCpuDevice(int id, int max_inflight_computations = 32);
+  // Buffers of the device are allocated from `allocator`, which may be shared
+  // with the other devices on the same NUMA node. If it is null, they come
+  // from the aligned system allocator.
+  explicit TfrtCpuDevice(
+      int id, int max_inflight_computations = 32,
+      std::shared_ptr<CpuBufferAllocator> allocator = nullptr);
 
   const TfrtCpuDeviceDescription& description() const override {
     return description_;
@@ -123,9 +130,40 @@ class TfrtCpuDevice final : public PjRtDevice {
     return nullptr;
   }
 
+  const std::shared_ptr<CpuBufferAllocator>& allocator() const {
+    return allocator_;
+  }
+
+  // Stats of the allocator of the device, which covers every device sharing
+  // it.
+  StatusOr<tsl::AllocatorStats> GetAllocatorStats() const override;
+
+  // Gives the device its own pools of `num_threads` threads for running its
+  // computations and for their intra-op parallelism, instead of those of the
+  // client. The threads are pinned to `cpus` where the platform supports it
+  // (if not empty) and to `numa_node` (if not kNUMANoAffinity).
+  void CreatePinnedThreadPools(std::vector<int> cpus, int numa_node,
+                               int num_threads);
+
+  // The pools created by CreatePinnedThreadPools, or null if the device uses
+  // those of the client.
+  tsl::thread::ThreadPool* execution_thread_pool() const {
+    return execution_thread_pool_.get();
+  }
+  Eigen::ThreadPoolDevice* eigen_intraop_device() const {
+    return eigen_intraop_device_.get();
+  }
+
  private:
   PjRtClient* client_ = nullptr;
   TfrtCpuDeviceDescription description_;
+  std::shared_ptr<CpuBufferAllocator> allocator_;
+
+  // Starts the threads of the pinned pools; must outlive them.
+  std::unique_ptr<tsl::Env> pinned_env_;
+  std::unique_ptr<tsl::thread::ThreadPool> execution_thread_pool_;
+  std::unique_ptr<tsl::thread::ThreadPool> eigen_intraop_pool_;
+  std::unique_ptr<Eigen::ThreadPoolDevice> eigen_intraop_device_;
 
   // TODO(zhangqiaorjc): Optimize semaphore related overhead.
   // Semaphore used to limit how many programs can be enqueued by the host
@@ -496,6 +534,32 @@ StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(
     bool asynchronous, int cpu_device_count,
     int max_inflight_computations_per_device = 32);
 
+struct CpuClientOptions {
+  bool asynchronous = true;
+
+  // Number of CPU devices. If not provided, the value of
+  // --xla_force_host_platform_device_count is used.
+  std::optional<int> cpu_device_count;
+
+  int max_inflight_computations_per_device = 32;
+
+  // The devices share one buffer allocator per NUMA node, configured by these
+  // options; `numa_node` is ignored. Freed buffers are only cached for reuse
+  // if `max_cached_bytes` is set, and the caches are released when the client
+  // is destroyed.
+  CpuBufferAllocator::Options allocator_options;
+
+  // Partitions the host's CPUs between the devices: every device runs its
+  // computations and their intra-op parallelism on its own thread pools,
+  // pinned to a disjoint share of the CPUs, or to the device's NUMA node if
+  // the host has several. Replicas then neither share cores nor thrash each
+  // other's caches, at the cost of idle cores when only some devices are busy.
+  bool pin_devices_to_cpus = false;
+};
+
+StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(
+    const CpuClientOptions& options);
+
 }  // namespace xla
 
 #endif  // XLA_PJRT_TFRT_CPU_PJRT_CLIENT_H_
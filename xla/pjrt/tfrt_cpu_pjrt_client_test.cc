@@ -16,14 +16,19 @@ limitations under the License.
 #include "xla/pjrt/tfrt_cpu_pjrt_client.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <numeric>
 #include <string>
 #include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "absl/cleanup/cleanup.h"
+#include "absl/synchronization/notification.h"
 #include "xla/literal.h"
 #include "xla/literal_util.h"
+#include "xla/pjrt/persistent_compilation_cache.h"
 #include "xla/service/custom_call_status.h"
 #include "xla/service/custom_call_target_registry.h"
 #include "xla/service/hlo_parser.h"
@@ -33,9 +38,11 @@ limitations under the License.
 #include "xla/tests/test_utils.h"
 #include "xla/util.h"
 #include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/casts.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/file_system.h"
+#include "tsl/platform/path.h"
 #include "tsl/platform/status_matchers.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/platform/test.h"
@@ -47,6 +54,7 @@ using ::testing::Each;
 using ::testing::ElementsAreArray;
 using ::testing::HasSubstr;
 using ::testing::IsFalse;
+using ::tsl::testing::IsOkAndHolds;
 
 void TestError(void* out, const void** in, XlaCustomCallStatus* status) {
   static constexpr char kError[] = "test error.";
@@ -163,6 +171,256 @@ TEST(TfrtCpuClientTest, HloSnapshot) {
       LiteralUtil::CreateR2<float>({{11.0, 22.0}, {33.0, 44.0}, {55.0, 66.0}}));
 }
 
+// Compiles a program twice with the persistent compilation cache in a fresh
+// directory, and checks that the second compilation hits the cache and that
+// the cached executable runs.
+void TestPersistentCompilationCache(const std::string& dir_name,
+                                    bool use_xla_runtime) {
+  constexpr char kProgram[] = R"(
+    HloModule add
+    ENTRY add {
+      x = f32[3,2] parameter(0)
+      y = f32[3,2] parameter(1)
+      ROOT add = f32[3,2] add(x, y)
+    })";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(/*asynchronous=*/true));
+  TF_ASSERT_OK_AND_ASSIGN(auto hlo_module,
+                          ParseAndReturnUnverifiedModule(kProgram, {}));
+  XlaComputation xla_computation(hlo_module->ToProto());
+
+  std::string dir = tsl::io::JoinPath(tsl::testing::TmpDir(), dir_name);
+  absl::Cleanup delete_dir = [&dir] {
+    int64_t undeleted_files, undeleted_dirs;
+    TF_EXPECT_OK(tsl::Env::Default()->DeleteRecursively(dir, &undeleted_files,
+                                                        &undeleted_dirs));
+  };
+  xla::CompileOptions options;
+  auto* debug_opts = options.executable_build_options.mutable_debug_options();
+  if (use_xla_runtime) {
+    debug_opts->set_xla_cpu_use_xla_runtime(true);
+  }
+  debug_opts->set_xla_cpu_persistent_cache_dir(dir);
+
+  TF_ASSERT_OK(client->Compile(xla_computation, options).status());
+  TF_ASSERT_OK_AND_ASSIGN(auto pjrt_executable,
+                          client->Compile(xla_computation, options));
+
+  PersistentCompilationCache::Options cache_options;
+  cache_options.directory = dir;
+  TF_ASSERT_OK_AND_ASSIGN(
+      PersistentCompilationCache * cache,
+      PersistentCompilationCache::GetOrCreate(cache_options));
+  EXPECT_EQ(cache->stats().insertions, 1);
+  EXPECT_EQ(cache->stats().hits, 1);
+
+  std::vector<float> data1{1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  std::vector<float> data2{10.0, 20.0, 30.0, 40.0, 50.0, 60.0};
+  Shape shape = ShapeUtil::MakeShape(F32, {3, 2});
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto buffer1,
+      client->BufferFromHostBuffer(
+          data1.data(), shape.element_type(), shape.dimensions(),
+          /*byte_strides=*/std::nullopt,
+          PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall, nullptr,
+          client->addressable_devices()[0]));
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto buffer2,
+      client->BufferFromHostBuffer(
+          data2.data(), shape.element_type(), shape.dimensions(),
+          /*byte_strides=*/std::nullopt,
+          PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall, nullptr,
+          client->addressable_devices()[0]));
+  auto result = pjrt_executable->Execute(
+      /*argument_handles=*/{{buffer1.get(), buffer2.get()}},
+      /*options=*/{});
+  ASSERT_TRUE(result.ok());
+  ASSERT_EQ(result->size(), 1);
+  ASSERT_EQ((*result)[0].size(), 1);
+  TF_ASSERT_OK_AND_ASSIGN(auto literal, (*result)[0][0]->ToLiteralSync());
+  EXPECT_EQ(*literal, LiteralUtil::CreateR2<float>(
+                          {{11.0, 22.0}, {33.0, 44.0}, {55.0, 66.0}}));
+}
+
+// Uses the default debug options, which compile with the legacy JIT.
+TEST(TfrtCpuClientTest, PersistentCompilationCache) {
+  TestPersistentCompilationCache("persistent_compilation_cache",
+                                 /*use_xla_runtime=*/false);
+}
+
+TEST(TfrtCpuClientTest, PersistentCompilationCacheWithXlaRuntime) {
+  TestPersistentCompilationCache("persistent_compilation_cache_xla_runtime",
+                                 /*use_xla_runtime=*/true);
+}
+
+TEST(TfrtCpuClientTest, BufferFromHostBufferTransposesInParallel) {
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(/*asynchronous=*/true));
+  // A column-major array large enough to be transposed in several chunks.
+  constexpr int64_t kRows = 1024;
+  constexpr int64_t kCols = 768;
+  std::vector<float> expected(kRows * kCols);
+  std::iota(expected.begin(), expected.end(), 0.0f);
+  std::vector<float> data(kRows * kCols);
+  for (int64_t r = 0; r < kRows; ++r) {
+    for (int64_t c = 0; c < kCols; ++c) {
+      data[c * kRows + r] = expected[r * kCols + c];
+    }
+  }
+  std::vector<int64_t> dims = {kRows, kCols};
+  std::vector<int64_t> byte_strides = {sizeof(float), kRows * sizeof(float)};
+  for (auto semantics :
+       {PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall,
+        PjRtClient::HostBufferSemantics::kImmutableUntilTransferCompletes,
+        PjRtClient::HostBufferSemantics::kZeroCopy}) {
+    SCOPED_TRACE(static_cast<int>(semantics));
+    absl::Notification done;
+    TF_ASSERT_OK_AND_ASSIGN(
+        auto buffer, client->BufferFromHostBuffer(
+                         data.data(), F32, dims, byte_strides, semantics,
+                         [&]() { done.Notify(); },
+                         client->addressable_devices()[0]));
+    TF_ASSERT_OK_AND_ASSIGN(auto literal, buffer->ToLiteralSync());
+    EXPECT_THAT(literal->data<float>(), ElementsAreArray(expected));
+    done.WaitForNotification();
+  }
+}
+
+TEST(TfrtCpuClientTest, BufferFromHostBufferCopiesInParallel) {
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(/*asynchronous=*/true));
+  // Large enough to be copied in several chunks.
+  std::vector<int32_t> data(3 << 20);
+  std::iota(data.begin(), data.end(), 0);
+  std::vector<int64_t> dims = {static_cast<int64_t>(data.size())};
+  absl::Notification done;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto buffer,
+      client->BufferFromHostBuffer(
+          data.data(), S32, dims, /*byte_strides=*/std::nullopt,
+          PjRtClient::HostBufferSemantics::kImmutableUntilTransferCompletes,
+          [&]() { done.Notify(); }, client->addressable_devices()[0]));
+  TF_ASSERT_OK_AND_ASSIGN(auto literal, buffer->ToLiteralSync());
+  EXPECT_THAT(literal->data<int32_t>(), ElementsAreArray(data));
+  done.WaitForNotification();
+}
+
+TEST(TfrtCpuClientTest, BuffersArePooled) {
+  CpuClientOptions options;
+  options.cpu_device_count = 1;
+  options.allocator_options.max_cached_bytes = 1 << 20;
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(options));
+  PjRtDevice* device = client->addressable_devices()[0];
+  std::vector<float> data(1000, 1.0f);
+  std::vector<int64_t> dims = {static_cast<int64_t>(data.size())};
+  auto transfer = [&]() {
+    return client->BufferFromHostBuffer(
+        data.data(), F32, dims, /*byte_strides=*/std::nullopt,
+        PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall, nullptr,
+        device);
+  };
+
+  TF_ASSERT_OK_AND_ASSIGN(auto buffer, transfer());
+  TF_ASSERT_OK_AND_ASSIGN(tsl::AllocatorStats stats,
+                          device->GetAllocatorStats());
+  EXPECT_EQ(stats.num_allocs, 1);
+  EXPECT_EQ(stats.bytes_in_use, 4096);
+  TF_ASSERT_OK_AND_ASSIGN(std::uintptr_t ptr,
+                          client->UnsafeBufferPointer(buffer.get()));
+  buffer.reset();
+
+  TF_ASSERT_OK_AND_ASSIGN(stats, device->GetAllocatorStats());
+  EXPECT_EQ(stats.bytes_in_use, 0);
+  EXPECT_EQ(stats.pool_bytes, 4096);
+
+  // The freed block is reused by the next buffer of the same size class.
+  TF_ASSERT_OK_AND_ASSIGN(buffer, transfer());
+  EXPECT_THAT(client->UnsafeBufferPointer(buffer.get()), IsOkAndHolds(ptr));
+}
+
+TEST(TfrtCpuClientTest, CachedBuffersAreReleasedWithClient) {
+  CpuClientOptions options;
+  options.cpu_device_count = 1;
+  options.allocator_options.max_cached_bytes = 1 << 20;
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(options));
+  PjRtDevice* device = client->addressable_devices()[0];
+  std::shared_ptr<CpuBufferAllocator> allocator =
+      tensorflow::down_cast<TfrtCpuDevice*>(device)->allocator();
+  ASSERT_NE(allocator, nullptr);
+
+  std::vector<float> data(1000, 1.0f);
+  std::vector<int64_t> dims = {static_cast<int64_t>(data.size())};
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto buffer,
+      client->BufferFromHostBuffer(
+          data.data(), F32, dims, /*byte_strides=*/std::nullopt,
+          PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall, nullptr,
+          device));
+  buffer.reset();
+  EXPECT_EQ(allocator->GetStats().pool_bytes, 4096);
+
+  client.reset();
+  EXPECT_EQ(allocator->GetStats().pool_bytes, 0);
+}
+
+TEST(TfrtCpuClientTest, PinnedDevicesHaveTheirOwnThreadPools) {
+  constexpr char kProgram[] = R"(
+    HloModule add
+    ENTRY add {
+      x = f32[3,2] parameter(0)
+      y = f32[3,2] parameter(1)
+      ROOT add = f32[3,2] add(x, y)
+    })";
+
+  CpuClientOptions client_options;
+  client_options.cpu_device_count = 2;
+  client_options.pin_devices_to_cpus = true;
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(client_options));
+  ASSERT_EQ(client->addressable_device_count(), 2);
+  auto* device0 = tensorflow::down_cast<TfrtCpuDevice*>(
+      client->addressable_devices()[0]);
+  auto* device1 = tensorflow::down_cast<TfrtCpuDevice*>(
+      client->addressable_devices()[1]);
+  ASSERT_NE(device0->execution_thread_pool(), nullptr);
+  ASSERT_NE(device0->eigen_intraop_device(), nullptr);
+  EXPECT_NE(device0->execution_thread_pool(),
+            device1->execution_thread_pool());
+  EXPECT_NE(device0->eigen_intraop_device(), device1->eigen_intraop_device());
+
+  TF_ASSERT_OK_AND_ASSIGN(auto hlo_module,
+                          ParseAndReturnUnverifiedModule(kProgram, {}));
+  XlaComputation xla_computation(hlo_module->ToProto());
+  CompileOptions compile_options;
+  compile_options.executable_build_options.set_num_replicas(2);
+  TF_ASSERT_OK_AND_ASSIGN(auto pjrt_executable,
+                          client->Compile(xla_computation, compile_options));
+
+  std::vector<float> data{1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  Shape shape = ShapeUtil::MakeShape(F32, {3, 2});
+  std::vector<std::vector<std::unique_ptr<PjRtBuffer>>> buffers(2);
+  std::vector<std::vector<PjRtBuffer*>> arguments(2);
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 2; ++j) {
+      TF_ASSERT_OK_AND_ASSIGN(
+          auto buffer,
+          client->BufferFromHostBuffer(
+              data.data(), shape.element_type(), shape.dimensions(),
+              /*byte_strides=*/std::nullopt,
+              PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall,
+              nullptr, client->addressable_devices()[i]));
+      arguments[i].push_back(buffer.get());
+      buffers[i].push_back(std::move(buffer));
+    }
+  }
+
+  TF_ASSERT_OK_AND_ASSIGN(auto results,
+                          pjrt_executable->Execute(arguments, /*options=*/{}));
+  ASSERT_EQ(results.size(), 2);
+  for (int i = 0; i < 2; ++i) {
+    TF_ASSERT_OK_AND_ASSIGN(auto literal, results[i][0]->ToLiteralSync());
+    EXPECT_EQ(*literal, LiteralUtil::CreateR2<float>(
+                            {{2.0, 4.0}, {6.0, 8.0}, {10.0, 12.0}}));
+  }
+}
+
 TEST(TfrtCpuClientTest, AsyncTransferRawData) {
   TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(/*asynchronous=*/true));
   xla::Shape shape = ShapeUtil::MakeShape(U32, {3, 2});
@@ -24,6 +24,7 @@ limitations under the License.
 #include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xla/cpu_function_runtime.h"
+#include "xla/pjrt/cpu_buffer_allocator.h"
 #include "xla/runtime/cpu_event.h"
 #include "xla/shape_util.h"
 #include "xla/util.h"
@@ -40,9 +41,21 @@ class MaybeOwningCpuMemory {
   explicit MaybeOwningCpuMemory(void* buf, size_t size)
       : buf_(buf), size_(size) {}
 
-  // Owning.
-  using OwnedDataPtr =
-      std::unique_ptr<uint8_t[], decltype(tsl::port::AlignedFree)*>;
+  // Owning. Memory comes from `allocator` if it is set and from the aligned
+  // system allocator otherwise.
+  struct Deleter {
+    std::shared_ptr<CpuBufferAllocator> allocator;
+    size_t size = 0;
+
+    void operator()(uint8_t* data) const {
+      if (allocator) {
+        allocator->Deallocate(data, size);
+      } else {
+        tsl::port::AlignedFree(data);
+      }
+    }
+  };
+  using OwnedDataPtr = std::unique_ptr<uint8_t[], Deleter>;
   explicit MaybeOwningCpuMemory(OwnedDataPtr data, size_t size)
       : buf_(data.get()), data_(std::move(data)), size_(size) {}
 
@@ -52,16 +65,19 @@ class MaybeOwningCpuMemory {
   MaybeOwningCpuMemory(const MaybeOwningCpuMemory&) = delete;
   MaybeOwningCpuMemory& operator=(const MaybeOwningCpuMemory&) = delete;
 
-  // Owning.
+  // Owning. Allocates from `allocator` if it is not null.
   static StatusOr<std::shared_ptr<MaybeOwningCpuMemory>> AllocateShared(
-      size_t size) {
+      size_t size,
+      const std::shared_ptr<CpuBufferAllocator>& allocator = nullptr) {
     uint8_t* data = static_cast<uint8_t*>(
-        tsl::port::AlignedMalloc(size, cpu_function_runtime::MinAlign()));
+        allocator ? allocator->Allocate(size)
+                  : tsl::port::AlignedMalloc(size,
+                                             cpu_function_runtime::MinAlign()));
     if (!data) {
       return ResourceExhausted("Out of memory allocating %d bytes.", size);
     }
     return std::make_shared<MaybeOwningCpuMemory>(
-        OwnedDataPtr{data, tsl::port::AlignedFree}, size);
+        OwnedDataPtr{data, Deleter{allocator, size}}, size);
   }
 
   void* data() const { return buf_; }
@@ -70,7 +86,7 @@ class MaybeOwningCpuMemory {
 
  private:
   void* buf_ = nullptr;                  // Non-owning data pointer.
-  OwnedDataPtr data_ = {nullptr, free};  // Owning data pointer;
+  OwnedDataPtr data_;                    // Owning data pointer;
   size_t size_ = 0;                      // Size in number of bytes.
 };
 
@@ -36,9 +36,13 @@ limitations under the License.
 // In the event that the stride-1 dimensions of the input and output are the
 // same, we use a simpler kernel which is a memcpy().
 //
+// Outputs much larger than the cache are written with non-temporal stores,
+// one macrokernel block at a time, so that they do not evict the input.
+//
 // To improve cache locality, we use another level of blocking, namely
 // "macrokernels". The outer "macrokernel" level is a block of, for example,
-// 4x4 microkernels. Macrokernels are the basic unit of work of the loop nest
+// 4x4 microkernels, sized to span at least a cache line of each row of the
+// input and output. Macrokernels are the basic unit of work of the loop nest
 // plan. For dimensions that aren't exactly divisible by the macrokernel size,
 // we repeatedly halve the kernel size for trailing elements. For dimensions
 // that aren't exactly divisible by the microkernel size, we use a scalar
@@ -59,8 +63,7 @@ limitations under the License.
 // * we don't incorporate a number of optimizations from HPTT, notably explicit
 //   prefetching, and manual loop unrolling.
 // * we could use vector-aligned stores for some arrays, which might
-//   be worth something. We could also use nontemporal stores in the aligned
-//   case.
+//   be worth something.
 // * we don't yet search for a good loop ordering. This probably matters less
 //   for arrays that fit entirely in cache.
 // * we could do a better job of vectorizing where the stride-1 dimensions are
@@ -70,7 +73,10 @@ limitations under the License.
 #include "xla/pjrt/transpose.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <memory>
 #include <numeric>
 #include <stack>
 #include <string>
@@ -84,6 +90,7 @@ limitations under the License.
 #include "absl/types/variant.h"
 #include "xla/permutation_util.h"
 #include "xla/pjrt/transpose_kernels.h"
+#include "xla/pjrt/transpose_kernels_avx512.h"
 #include "xla/status.h"
 #include "xla/util.h"
 #include "tsl/platform/logging.h"
@@ -124,8 +131,17 @@ void ConvertF64ToEf57(const double* input, float* output, int n) {
   }
 }
 
+constexpr int64_t kCacheLineBytes = 64;
+
+// Outputs at least this large are written with non-temporal stores.
+constexpr int64_t kStreamingStoreMinBytes = 32 << 20;  // 32 MiB
+
+// Upper bound on the size of a macrokernel's output block, which bounds the
+// stack buffer used for streaming stores.
+constexpr int kMaxStreamingBlockBytes = 4096;
+
 template <typename T, int inner_bs,
-          TransposePlan::Transformation transformation>
+          TransposePlan::Transformation transformation, bool streaming>
 void MacroKernel(const char* __restrict a, int64_t lda, int outer_bs_a,
                  char* __restrict b, int64_t ldb, int outer_bs_b,
                  void* __restrict scratch) {
@@ -133,7 +149,7 @@ void MacroKernel(const char* __restrict a, int64_t lda, int outer_bs_a,
             << " outer_bs_a=" << outer_bs_a << " outer_bs_b=" << outer_bs_b
             << " inner_bs=" << inner_bs;
 
-  // TODO(phawkins): consider adding prefetching and streaming stores.
+  // TODO(phawkins): consider adding prefetching.
 
   if (transformation == TransposePlan::Transformation::kF64ToEf57) {
     DCHECK_EQ(outer_bs_a * inner_bs % 2, 0);
@@ -147,11 +163,30 @@ void MacroKernel(const char* __restrict a, int64_t lda, int outer_bs_a,
     lda = outer_bs_a * inner_bs * sizeof(float);
   }
 
+  // With streaming stores, the block is transposed into a buffer that stays in
+  // cache, whose rows, each a contiguous run of the output, are then streamed
+  // out to `b`. This only pays off if the rows consist of whole cache lines.
+  const int64_t rows = outer_bs_a * inner_bs;
+  const int64_t row_bytes = outer_bs_b * inner_bs * sizeof(T);
+  alignas(64) char block[streaming ? kMaxStreamingBlockBytes : 1];
+  const bool stream_block =
+      streaming && rows * row_bytes <= kMaxStreamingBlockBytes &&
+      (reinterpret_cast<uintptr_t>(b) | ldb | row_bytes) % kCacheLineBytes ==
+          0;
+  char* out = stream_block ? block : b;
+  const int64_t ldo = stream_block ? row_bytes : ldb;
+
   for (int i = 0; i < outer_bs_a; ++i) {
     for (int j = 0; j < outer_bs_b; ++j) {
       TransposeMicroKernel<T, inner_bs>::Apply(
           a + inner_bs * j * lda + i * inner_bs * sizeof(T), lda,
-          b + inner_bs * i * ldb + j * inner_bs * sizeof(T), ldb);
+          out + inner_bs * i * ldo + j * inner_bs * sizeof(T), ldo);
+    }
+  }
+
+  if (stream_block) {
+    for (int64_t i = 0; i < rows; ++i) {
+      StreamingMemcpy(b + i * ldb, block + i * row_bytes, row_bytes);
     }
   }
 }
@@ -159,7 +194,7 @@ void MacroKernel(const char* __restrict a, int64_t lda, int outer_bs_a,
 // Transpose() is a driver function that implements a multidimensional loop nest
 // following by iterating over the linked Node data structure.
 template <typename T, int inner_bs,
-          TransposePlan::Transformation transformation>
+          TransposePlan::Transformation transformation, bool streaming>
 void Transpose(const char* __restrict a, int outer_bs_a, char* __restrict b,
                int outer_bs_b, TransposePlan::Node const* __restrict node,
                void* __restrict scratch) {
@@ -181,9 +216,9 @@ void Transpose(const char* __restrict a, int outer_bs_a, char* __restrict b,
     const int64_t ldb_block = next_node->ldb;
     int64_t i;
     for (i = start; i < stop; i += inc) {
-      MacroKernel<T, inner_bs, transformation>(a + i * lda, lda_block,
-                                               outer_bs_a, b + i * ldb,
-                                               ldb_block, outer_bs_b, scratch);
+      MacroKernel<T, inner_bs, transformation, streaming>(
+          a + i * lda, lda_block, outer_bs_a, b + i * ldb, ldb_block,
+          outer_bs_b, scratch);
     }
     // Handle trailing elements that didn't fit in a complete macrokernel.
     // Only the innermost dimensions have non-trivial outer_bs blocking.
@@ -193,7 +228,7 @@ void Transpose(const char* __restrict a, int outer_bs_a, char* __restrict b,
       if (node->is_inner_dim_in_a) {
         outer_bs_a = (end - i) / inner_bs;
         if (outer_bs_a > 0) {
-          MacroKernel<T, inner_bs, transformation>(
+          MacroKernel<T, inner_bs, transformation, streaming>(
               a + i * lda, lda_block, outer_bs_a, b + i * ldb, ldb_block,
               outer_bs_b, scratch);
           i += outer_bs_a * inner_bs;
@@ -201,22 +236,22 @@ void Transpose(const char* __restrict a, int outer_bs_a, char* __restrict b,
         // If there are still trailing elements left over that don't fit in the
         // inner block size, handle them via an unvectorized transpose.
         if (i < end) {
-          MacroKernel<T, 1, transformation>(a + i * lda, lda_block, end - i,
-                                            b + i * ldb, ldb_block,
-                                            outer_bs_b * inner_bs, scratch);
+          MacroKernel<T, 1, transformation, streaming>(
+              a + i * lda, lda_block, end - i, b + i * ldb, ldb_block,
+              outer_bs_b * inner_bs, scratch);
         }
       } else if (node->is_inner_dim_in_b) {
         outer_bs_b = (end - i) / inner_bs;
         if (outer_bs_b > 0) {
-          MacroKernel<T, inner_bs, transformation>(
+          MacroKernel<T, inner_bs, transformation, streaming>(
               a + i * lda, lda_block, outer_bs_a, b + i * ldb, ldb_block,
               outer_bs_b, scratch);
           i += outer_bs_b * inner_bs;
         }
         if (i < end) {
-          MacroKernel<T, 1, transformation>(a + i * lda, lda_block,
-                                            outer_bs_a * inner_bs, b + i * ldb,
-                                            ldb_block, end - i, scratch);
+          MacroKernel<T, 1, transformation, streaming>(
+              a + i * lda, lda_block, outer_bs_a * inner_bs, b + i * ldb,
+              ldb_block, end - i, scratch);
         }
       }
     } else if (node->trailing_tile_next_node_inc) {
@@ -230,13 +265,13 @@ void Transpose(const char* __restrict a, int outer_bs_a, char* __restrict b,
       if (trailing_next_node->inc < 0) {
         const int64_t lda_block = trailing_next_node->lda;
         const int64_t ldb_block = trailing_next_node->ldb;
-        MacroKernel<T, inner_bs, transformation>(
+        MacroKernel<T, inner_bs, transformation, streaming>(
             a + i * lda, lda_block, outer_bs_a, b + i * ldb, ldb_block,
             outer_bs_b, scratch);
       } else {
-        Transpose<T, inner_bs, transformation>(a + i * lda, outer_bs_a,
-                                               b + i * ldb, outer_bs_b,
-                                               trailing_next_node, scratch);
+        Transpose<T, inner_bs, transformation, streaming>(
+            a + i * lda, outer_bs_a, b + i * ldb, outer_bs_b,
+            trailing_next_node, scratch);
       }
     }
   } else {
@@ -245,7 +280,7 @@ void Transpose(const char* __restrict a, int outer_bs_a, char* __restrict b,
     // but we call Transpose() recursively instead of MacroKernel().
     int64_t i;
     for (i = start; i < stop; i += inc) {
-      Transpose<T, inner_bs, transformation>(
+      Transpose<T, inner_bs, transformation, streaming>(
           a + i * lda, outer_bs_a, b + i * ldb, outer_bs_b, next_node, scratch);
     }
     if (i < end) {
@@ -254,28 +289,28 @@ void Transpose(const char* __restrict a, int outer_bs_a, char* __restrict b,
       if (node->is_inner_dim_in_a) {
         outer_bs_a = (end - i) / inner_bs;
         if (outer_bs_a > 0) {
-          Transpose<T, inner_bs, transformation>(a + i * lda, outer_bs_a,
-                                                 b + i * ldb, outer_bs_b,
-                                                 next_node, scratch);
+          Transpose<T, inner_bs, transformation, streaming>(
+              a + i * lda, outer_bs_a, b + i * ldb, outer_bs_b, next_node,
+              scratch);
           i += outer_bs_a * inner_bs;
         }
         if (i < end) {
-          Transpose<T, 1, transformation>(a + i * lda, end - i, b + i * ldb,
-                                          outer_bs_b * inner_bs, next_node,
-                                          scratch);
+          Transpose<T, 1, transformation, streaming>(
+              a + i * lda, end - i, b + i * ldb, outer_bs_b * inner_bs,
+              next_node, scratch);
         }
       } else if (node->is_inner_dim_in_b) {
         outer_bs_b = (end - i) / inner_bs;
         if (outer_bs_b > 0) {
-          Transpose<T, inner_bs, transformation>(a + i * lda, outer_bs_a,
-                                                 b + i * ldb, outer_bs_b,
-                                                 next_node, scratch);
+          Transpose<T, inner_bs, transformation, streaming>(
+              a + i * lda, outer_bs_a, b + i * ldb, outer_bs_b, next_node,
+              scratch);
           i += outer_bs_b * inner_bs;
         }
         if (i < end) {
-          Transpose<T, 1, transformation>(a + i * lda, outer_bs_a * inner_bs,
-                                          b + i * ldb, end - i, next_node,
-                                          scratch);
+          Transpose<T, 1, transformation, streaming>(
+              a + i * lda, outer_bs_a * inner_bs, b + i * ldb, end - i,
+              next_node, scratch);
         }
       }
     } else if (node->trailing_tile_next_node_inc) {
@@ -284,26 +319,36 @@ void Transpose(const char* __restrict a, int outer_bs_a, char* __restrict b,
       if (trailing_next_node->inc < 0) {
         const int64_t lda_block = trailing_next_node->lda;
         const int64_t ldb_block = trailing_next_node->ldb;
-        MacroKernel<T, inner_bs, transformation>(
+        MacroKernel<T, inner_bs, transformation, streaming>(
             a + i * lda, lda_block, outer_bs_a, b + i * ldb, ldb_block,
             outer_bs_b, scratch);
       } else {
-        Transpose<T, inner_bs, transformation>(a + i * lda, outer_bs_a,
-                                               b + i * ldb, outer_bs_b,
-                                               trailing_next_node, scratch);
+        Transpose<T, inner_bs, transformation, streaming>(
+            a + i * lda, outer_bs_a, b + i * ldb, outer_bs_b,
+            trailing_next_node, scratch);
       }
     }
   }
 }
 
-template <typename T>
+template <bool streaming>
+inline void CopyRow(char* __restrict b, const char* __restrict a,
+                    int64_t num_bytes) {
+  if constexpr (streaming) {
+    StreamingMemcpy(b, a, num_bytes);
+  } else {
+    std::memcpy(b, a, num_bytes);
+  }
+}
+
+template <typename T, bool streaming>
 void TransposeConstStride1(const char* __restrict a, char* __restrict b,
                            TransposePlan::Node const* __restrict node) {
   a += node[0].start * node[0].lda;
   b += node[0].start * node[0].ldb;
   if (node[0].is_inner_dim_in_a) {
     int64_t num_bytes = (node->end - node->start) * sizeof(T);
-    std::memcpy(b, a, num_bytes);
+    CopyRow<streaming>(b, a, num_bytes);
   } else if (node[1].is_inner_dim_in_a) {
     int64_t offset_a = node[1].start * node[1].lda;
     int64_t offset_b = node[1].start * node[1].ldb;
@@ -311,12 +356,12 @@ void TransposeConstStride1(const char* __restrict a, char* __restrict b,
     a += offset_a;
     b += offset_b;
     for (int64_t i = node[0].start; i < node[0].end; ++i) {
-      std::memcpy(b, a, num_bytes);
+      CopyRow<streaming>(b, a, num_bytes);
       a += node[0].lda;
       b += node[0].ldb;
     }
     if (node[0].trailing_tile_next_node_inc) {
-      TransposeConstStride1<T>(a - offset_a, b - offset_b,
+      TransposeConstStride1<T, streaming>(a - offset_a, b - offset_b,
                                node + node[0].trailing_tile_next_node_inc);
     }
   } else if (node[2].is_inner_dim_in_a) {
@@ -331,12 +376,12 @@ void TransposeConstStride1(const char* __restrict a, char* __restrict b,
       const char* a1 = a;
       char* b1 = b;
       for (int64_t j = node[1].start; j < node[1].end; ++j) {
-        std::memcpy(b1, a1, num_bytes);
+        CopyRow<streaming>(b1, a1, num_bytes);
         a1 += node[1].lda;
         b1 += node[1].ldb;
       }
       if (node[1].trailing_tile_next_node_inc) {
-        TransposeConstStride1<T>(
+        TransposeConstStride1<T, streaming>(
             a1 - offset_a2, b1 - offset_b2,
             &node[1] + node[1].trailing_tile_next_node_inc);
       }
@@ -344,7 +389,7 @@ void TransposeConstStride1(const char* __restrict a, char* __restrict b,
       b += node[0].ldb;
     }
     if (node[0].trailing_tile_next_node_inc) {
-      TransposeConstStride1<T>(a - offset_a1 - offset_a2,
+      TransposeConstStride1<T, streaming>(a - offset_a1 - offset_a2,
                                b - offset_b1 - offset_b2,
                                node + node[0].trailing_tile_next_node_inc);
     }
@@ -353,95 +398,92 @@ void TransposeConstStride1(const char* __restrict a, char* __restrict b,
       const char* a1 = a + node[1].start * node[1].lda;
       char* b1 = b + node[1].start * node[1].ldb;
       for (int64_t j = node[1].start; j < node[1].end; ++j) {
-        TransposeConstStride1<T>(a1, b1, node + 2);
+        TransposeConstStride1<T, streaming>(a1, b1, node + 2);
         a1 += node[1].lda;
         b1 += node[1].ldb;
       }
       if (node[1].trailing_tile_next_node_inc) {
-        TransposeConstStride1<T>(
+        TransposeConstStride1<T, streaming>(
             a1, b1, &node[1] + node[1].trailing_tile_next_node_inc);
       }
       a += node[0].lda;
       b += node[0].ldb;
     }
     if (node[0].trailing_tile_next_node_inc) {
-      TransposeConstStride1<T>(a, b,
+      TransposeConstStride1<T, streaming>(a, b,
                                node + node[0].trailing_tile_next_node_inc);
     }
   }
 }
 
+// Runs the loop nest in `nodes` with microkernels of size `inner_bs`.
+template <typename T, int inner_bs,
+          TransposePlan::Transformation transformation, bool streaming>
+void ExecuteBlocked(const char* a, int outer_bs_a, char* b, int outer_bs_b,
+                    absl::Span<TransposePlan::Node const> nodes,
+                    void* scratch) {
+  if (nodes.size() > 1) {
+    Transpose<T, inner_bs, transformation, streaming>(
+        a, outer_bs_a, b, outer_bs_b, nodes.data(), scratch);
+  } else {
+    MacroKernel<T, inner_bs, transformation, streaming>(
+        a, nodes.back().lda, outer_bs_a, b, nodes.back().ldb, outer_bs_b,
+        scratch);
+  }
+}
+
+template <typename T, TransposePlan::Transformation transformation,
+          bool streaming>
+void TransposePlan::ExecuteStreamingOrNot(const char* a, char* b,
+                                          absl::Span<Node const> nodes) const {
+  if (inner_kernel_is_memcpy_) {
+    DCHECK(transformation_ == Transformation::kNone);
+    TransposeConstStride1<T, streaming>(a, b, nodes.data());
+    return;
+  }
+  std::unique_ptr<char[]> scratch;
+  if (scratch_size_ > 0) {
+    scratch.reset(new char[scratch_size_]);
+  }
+  switch (inner_block_elems_) {
+    case 1:
+      ExecuteBlocked<T, 1, transformation, streaming>(
+          a, outer_block_elems_a_, b, outer_block_elems_b_, nodes,
+          scratch.get());
+      break;
+    case 2:
+      ExecuteBlocked<T, 2, transformation, streaming>(
+          a, outer_block_elems_a_, b, outer_block_elems_b_, nodes,
+          scratch.get());
+      break;
+    case 4:
+      ExecuteBlocked<T, 4, transformation, streaming>(
+          a, outer_block_elems_a_, b, outer_block_elems_b_, nodes,
+          scratch.get());
+      break;
+    case 8:
+      ExecuteBlocked<T, 8, transformation, streaming>(
+          a, outer_block_elems_a_, b, outer_block_elems_b_, nodes,
+          scratch.get());
+      break;
+    case 16:
+      ExecuteBlocked<T, 16, transformation, streaming>(
+          a, outer_block_elems_a_, b, outer_block_elems_b_, nodes,
+          scratch.get());
+      break;
+    default:
+      LOG(FATAL) << "Invalid inner_block_size " << inner_block_elems_;
+  }
+}
+
 template <typename T, TransposePlan::Transformation transformation>
 void TransposePlan::ExecuteTyped(const char* a, char* b,
                                  absl::Span<Node const> nodes) const {
-  if (inner_kernel_is_memcpy_) {
-    DCHECK(transformation_ == Transformation::kNone);
-    TransposeConstStride1<T>(a, b, nodes.data());
+  if (use_streaming_stores_) {
+    ExecuteStreamingOrNot<T, transformation, /*streaming=*/true>(a, b, nodes);
+    StreamingStoreFence();
   } else {
-    std::unique_ptr<char[]> scratch;
-    if (scratch_size_ > 0) {
-      scratch.reset(new char[scratch_size_]);
-    }
-    switch (inner_block_elems_) {
-      case 1:
-        if (nodes.size() > 1) {
-          Transpose<T, 1, transformation>(a, outer_block_elems_a_, b,
-                                          outer_block_elems_b_, nodes.data(),
-                                          scratch.get());
-        } else {
-          MacroKernel<T, 1, transformation>(
-              a, nodes.back().lda, outer_block_elems_a_, b, nodes.back().ldb,
-              outer_block_elems_b_, scratch.get());
-        }
-        break;
-      case 2:
-        if (nodes.size() > 1) {
-          Transpose<T, 2, transformation>(a, outer_block_elems_a_, b,
-                                          outer_block_elems_b_, nodes.data(),
-                                          scratch.get());
-        } else {
-          MacroKernel<T, 2, transformation>(
-              a, nodes.back().lda, outer_block_elems_a_, b, nodes.back().ldb,
-              outer_block_elems_b_, scratch.get());
-        }
-        break;
-      case 4:
-
-        if (nodes.size() > 1) {
-          Transpose<T, 4, transformation>(a, outer_block_elems_a_, b,
-                                          outer_block_elems_b_, nodes.data(),
-                                          scratch.get());
-        } else {
-          MacroKernel<T, 4, transformation>(
-              a, nodes.back().lda, outer_block_elems_a_, b, nodes.back().ldb,
-              outer_block_elems_b_, scratch.get());
-        }
-        break;
-      case 8:
-        if (nodes.size() > 1) {
-          Transpose<T, 8, transformation>(a, outer_block_elems_a_, b,
-                                          outer_block_elems_b_, nodes.data(),
-                                          scratch.get());
-        } else {
-          MacroKernel<T, 8, transformation>(
-              a, nodes.back().lda, outer_block_elems_a_, b, nodes.back().ldb,
-              outer_block_elems_b_, scratch.get());
-        }
-        break;
-      case 16:
-        if (nodes.size() > 1) {
-          Transpose<T, 16, transformation>(a, outer_block_elems_a_, b,
-                                           outer_block_elems_b_, nodes.data(),
-                                           scratch.get());
-        } else {
-          MacroKernel<T, 16, transformation>(
-              a, nodes.back().lda, outer_block_elems_a_, b, nodes.back().ldb,
-              outer_block_elems_b_, scratch.get());
-        }
-        break;
-      default:
-        LOG(FATAL) << "Invalid inner_block_size " << inner_block_elems_;
-    }
+    ExecuteStreamingOrNot<T, transformation, /*streaming=*/false>(a, b, nodes);
   }
 }
 
@@ -451,6 +493,34 @@ struct uint128 {
 };
 static_assert(sizeof(uint128) == 16, "uint128 should be 16 bytes in size");
 
+void TransposePlan::ExecuteNodes(const char* a, char* b,
+                                 absl::Span<Node const> nodes) const {
+  switch (elem_size_in_bytes_) {
+    case 1:
+      ExecuteTyped<uint8_t, Transformation::kNone>(a, b, nodes);
+      break;
+    case 2:
+      ExecuteTyped<uint16_t, Transformation::kNone>(a, b, nodes);
+      break;
+    case 4:
+      if (transformation_ == Transformation::kNone) {
+        ExecuteTyped<uint32_t, Transformation::kNone>(a, b, nodes);
+      } else {
+        DCHECK(transformation_ == Transformation::kF64ToEf57);
+        ExecuteTyped<uint32_t, Transformation::kF64ToEf57>(a, b, nodes);
+      }
+      break;
+    case 8:
+      ExecuteTyped<uint64_t, Transformation::kNone>(a, b, nodes);
+      break;
+    case 16:
+      ExecuteTyped<uint128, Transformation::kNone>(a, b, nodes);
+      break;
+    default:
+      LOG(FATAL) << "Unimplemented element size " << elem_size_in_bytes_;
+  }
+}
+
 void TransposePlan::Execute(
     const void* a, void* b,
     const std::function<void(std::function<void(void)>)>& schedule_work) const {
@@ -461,36 +531,9 @@ void TransposePlan::Execute(
   const char* ac = static_cast<const char*>(a);
   char* bc = static_cast<char*>(b);
 
-  auto execute_by_type = [&](absl::Span<Node const> nodes) {
-    switch (elem_size_in_bytes_) {
-      case 1:
-        ExecuteTyped<uint8_t, Transformation::kNone>(ac, bc, nodes);
-        break;
-      case 2:
-        ExecuteTyped<uint16_t, Transformation::kNone>(ac, bc, nodes);
-        break;
-      case 4:
-        if (transformation_ == Transformation::kNone) {
-          ExecuteTyped<uint32_t, Transformation::kNone>(ac, bc, nodes);
-        } else {
-          DCHECK(transformation_ == Transformation::kF64ToEf57);
-          ExecuteTyped<uint32_t, Transformation::kF64ToEf57>(ac, bc, nodes);
-        }
-        break;
-      case 8:
-        ExecuteTyped<uint64_t, Transformation::kNone>(ac, bc, nodes);
-        break;
-      case 16:
-        ExecuteTyped<uint128, Transformation::kNone>(ac, bc, nodes);
-        break;
-      default:
-        LOG(FATAL) << "Unimplemented element size " << elem_size_in_bytes_;
-    }
-  };
-
   if (!schedule_work || nodes_.size() <= 1) {
     for (const auto& nodes : nodes_) {
-      execute_by_type(nodes);
+      ExecuteNodes(ac, bc, nodes);
     }
   } else {
     absl::BlockingCounter counter(nodes_.size());
@@ -498,7 +541,7 @@ void TransposePlan::Execute(
       schedule_work([&, nodes]() {
         tsl::profiler::TraceMe traceme("Transpose::Execute",
                                        /*level=*/2);
-        execute_by_type(nodes);
+        ExecuteNodes(ac, bc, nodes);
         counter.DecrementCount();
       });
     }
@@ -506,6 +549,16 @@ void TransposePlan::Execute(
   }
 }
 
+void TransposePlan::ExecuteChunk(const void* a, void* b, int chunk) const {
+  DCHECK_GE(chunk, 0);
+  DCHECK_LT(chunk, nodes_.size());
+  if (num_elems_ == 0) {
+    return;
+  }
+  ExecuteNodes(static_cast<const char*>(a), static_cast<char*>(b),
+               nodes_[chunk]);
+}
+
 // Everything above this point pertains to executing plans.
 // Everything below this point pertains to building plans.
 
@@ -1103,6 +1156,10 @@ void TransposePlan::Initialize() {
     // vectorized kernel for this element size?
     int min_inner_block_elems;
     int max_inner_block_elems;
+    // This must agree with the kernels in transpose_kernels.h available for
+    // the vector extensions we are compiled for, and the AVX-512 kernels if
+    // the host supports them.
+    const bool avx512 = TransposeKernelsAvx512Supported();
     switch (elem_size_in_bytes_) {
       case 1:
         min_inner_block_elems = 4;
@@ -1110,15 +1167,19 @@ void TransposePlan::Initialize() {
         break;
       case 2:
         min_inner_block_elems = 8;
-        max_inner_block_elems = 8;
+        max_inner_block_elems = avx512 ? 16 : 8;
         break;
       case 4:
         min_inner_block_elems = 4;
-        max_inner_block_elems = 8;
+#if defined(EIGEN_VECTORIZE_NEON) && !defined(EIGEN_VECTORIZE_AVX)
+        max_inner_block_elems = 4;
+#else
+        max_inner_block_elems = avx512 ? 16 : 8;
+#endif
         break;
       case 8:
         min_inner_block_elems = 2;
-        max_inner_block_elems = 4;
+        max_inner_block_elems = avx512 ? 8 : 4;
         break;
       case 16:
         min_inner_block_elems = 1;
@@ -1136,10 +1197,18 @@ void TransposePlan::Initialize() {
       // path.
       inner_block_elems_ = 1;
     }
+    // The macrokernel is the cache-level block: it covers at least 16
+    // elements and at least one cache line of the stride-1 dimension of both
+    // the input and the output, so that small element types still read and
+    // write whole cache lines.
+    const int64_t outer_block_size =
+        std::max<int64_t>(16, kCacheLineBytes / elem_size_in_bytes_);
     outer_block_elems_a_ = FloorOfRatio<int64_t>(
-        std::min<int64_t>(16, a_stride1_size), inner_block_elems_);
+        std::min<int64_t>(outer_block_size, a_stride1_size),
+        inner_block_elems_);
     outer_block_elems_b_ = FloorOfRatio<int64_t>(
-        std::min<int64_t>(16, b_stride1_size), inner_block_elems_);
+        std::min<int64_t>(outer_block_size, b_stride1_size),
+        inner_block_elems_);
   }
 
   // Loop order heuristic: try to make loops with small strides innermost.
@@ -1206,6 +1275,10 @@ void TransposePlan::Initialize() {
       DCHECK(!inner_kernel_is_memcpy_);
       break;
   }
+
+  use_streaming_stores_ =
+      kHasStreamingStores &&
+      OutputNumElems() * elem_size_in_bytes_ >= kStreamingStoreMinBytes;
 }
 
 std::vector<int> TransposePlan::ChooseParallelizationStrategy(
@@ -1311,7 +1384,7 @@ std::string TransposePlan::ToString() const {
       "elem_size=%d a_dims=%s b_dims=%s permutation=%s a_tiling=%s b_tiling=%s "
       "lda=%s lda_tile=%s ldb=%s ldb_tile=%s loop_order=%s "
       "loop_parallelism=%s outer_bs=[%d,%d] inner_bs=%d "
-      "transformation=%s scratch_size=%d\n"
+      "transformation=%s scratch_size=%d streaming_stores=%d\n"
       "nodes:\n%s",
       elem_size_in_bytes_, absl::StrJoin(a_dims_, ","),
       absl::StrJoin(Permute(a_dims_, permutation_), ","),
@@ -1322,7 +1395,7 @@ std::string TransposePlan::ToString() const {
       absl::StrJoin(loop_order_, ",", format_loop_order),
       absl::StrJoin(loop_parallelism_, ","), outer_block_elems_a_,
       outer_block_elems_b_, inner_block_elems_, transformation_str,
-      scratch_size_, nodes_str);
+      scratch_size_, use_streaming_stores_, nodes_str);
 }
 
 bool TransposePlanCacheKey::operator==(
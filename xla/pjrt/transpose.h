@@ -105,6 +105,12 @@ class TransposePlan {
                const std::function<void(std::function<void(void)>)>&
                    schedule_work = {}) const;
 
+  // Executes the `chunk`-th of the Parallelism() independent pieces of work of
+  // the plan. Executing every chunk exactly once, in any order and on any
+  // threads, is equivalent to Execute(a, b). Unlike Execute, this allows
+  // callers to run a transposition without blocking on its completion.
+  void ExecuteChunk(const void* a, void* b, int chunk) const;
+
   // Returns a human-readable description of the plan.
   std::string ToString() const;
 
@@ -162,6 +168,13 @@ class TransposePlan {
   template <typename T, Transformation transformation>
   void ExecuteTyped(const char* a, char* b, absl::Span<Node const> nodes) const;
 
+  template <typename T, Transformation transformation, bool streaming>
+  void ExecuteStreamingOrNot(const char* a, char* b,
+                             absl::Span<Node const> nodes) const;
+
+  // Dispatches to ExecuteTyped for the element size and transformation.
+  void ExecuteNodes(const char* a, char* b, absl::Span<Node const> nodes) const;
+
   // Number of threads requested.
   int num_threads_requested_ = 1;
 
@@ -238,6 +251,10 @@ class TransposePlan {
 
   // Size of the per-thread scratch buffer. 0 means "no scratch buffer required"
   int64_t scratch_size_ = 0;
+
+  // If true, the output is written with non-temporal stores. Used for outputs
+  // much larger than the cache, which would otherwise evict the input.
+  bool use_streaming_stores_ = false;
 };
 
 struct TransposePlanCacheKey {
@@ -16,9 +16,16 @@ limitations under the License.
 #ifndef XLA_PJRT_TRANSPOSE_KERNELS_H_
 #define XLA_PJRT_TRANSPOSE_KERNELS_H_
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 
 #include "Eigen/Core"  // from @eigen_archive
+#include "xla/pjrt/transpose_kernels_avx512.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace xla {
 
@@ -287,6 +294,127 @@ struct TransposeMicroKernel<uint64_t, /*bs=*/4> {
 
 #endif  // EIGEN_VECTORIZE_AVX
 
+#ifdef XLA_HAS_AVX512_TRANSPOSE_KERNELS
+
+// The AVX-512 kernels are dispatched at runtime: TransposePlan only picks
+// these block sizes if TransposeKernelsAvx512Supported().
+
+template <>
+struct TransposeMicroKernel<uint16_t, /*bs=*/16> {
+  static void Apply(const char* __restrict a, int64_t lda, char* __restrict b,
+                    int64_t ldb) {
+    Transpose16x16x2BytesAvx512(a, lda, b, ldb);
+  }
+};
+
+template <>
+struct TransposeMicroKernel<uint32_t, /*bs=*/16> {
+  static void Apply(const char* __restrict a, int64_t lda, char* __restrict b,
+                    int64_t ldb) {
+    Transpose16x16x4BytesAvx512(a, lda, b, ldb);
+  }
+};
+
+template <>
+struct TransposeMicroKernel<uint64_t, /*bs=*/8> {
+  static void Apply(const char* __restrict a, int64_t lda, char* __restrict b,
+                    int64_t ldb) {
+    Transpose8x8x8BytesAvx512(a, lda, b, ldb);
+  }
+};
+
+#endif  // XLA_HAS_AVX512_TRANSPOSE_KERNELS
+
+// On x86 the SSE kernels above cover the 4x4 float case, so the NEON kernels
+// are only used on ARM.
+#if defined(EIGEN_VECTORIZE_NEON) && !defined(EIGEN_VECTORIZE_AVX)
+
+template <>
+struct TransposeMicroKernel<uint32_t, /*bs=*/4> {
+  static void Apply(const char* __restrict a, int64_t lda, char* __restrict b,
+                    int64_t ldb) {
+    using Eigen::internal::Packet4f;
+    using Eigen::internal::PacketBlock;
+    constexpr int bs = 4;
+    PacketBlock<Packet4f, bs> block;
+    for (int i = 0; i < bs; ++i) {
+      block.packet[i] = Eigen::internal::ploadu<Packet4f>(
+          reinterpret_cast<const float*>(a + lda * i));
+    }
+    Eigen::internal::ptranspose(block);
+    for (int i = 0; i < bs; ++i) {
+      Eigen::internal::pstoreu<float>(reinterpret_cast<float*>(b + ldb * i),
+                                      block.packet[i]);
+    }
+  }
+};
+
+#if EIGEN_ARCH_ARM64
+template <>
+struct TransposeMicroKernel<uint64_t, /*bs=*/2> {
+  static void Apply(const char* __restrict a, int64_t lda, char* __restrict b,
+                    int64_t ldb) {
+    using Eigen::internal::Packet2d;
+    using Eigen::internal::PacketBlock;
+    constexpr int bs = 2;
+    PacketBlock<Packet2d, bs> block;
+    for (int i = 0; i < bs; ++i) {
+      block.packet[i] = Eigen::internal::ploadu<Packet2d>(
+          reinterpret_cast<const double*>(a + lda * i));
+    }
+    Eigen::internal::ptranspose(block);
+    for (int i = 0; i < bs; ++i) {
+      Eigen::internal::pstoreu<double>(reinterpret_cast<double*>(b + ldb * i),
+                                       block.packet[i]);
+    }
+  }
+};
+#endif  // EIGEN_ARCH_ARM64
+
+#endif  // EIGEN_VECTORIZE_NEON && !EIGEN_VECTORIZE_AVX
+
+#ifdef __SSE2__
+inline constexpr bool kHasStreamingStores = true;
+#else
+inline constexpr bool kHasStreamingStores = false;
+#endif
+
+// Copies `n` bytes from `src` to `dst`, using non-temporal stores for the
+// whole cache lines of `dst` if the target supports them. Non-temporal stores
+// bypass the cache, which avoids evicting useful data when writing outputs
+// much larger than the cache. Partial cache lines are written normally, since
+// partial non-temporal writes are slow. The stores must be followed by
+// StreamingStoreFence() before the data is handed to another thread.
+inline void StreamingMemcpy(char* __restrict dst, const char* __restrict src,
+                            int64_t n) {
+#ifdef __SSE2__
+  const int64_t head = std::min<int64_t>(
+      n, (64 - reinterpret_cast<uintptr_t>(dst) % 64) % 64);
+  std::memcpy(dst, src, head);
+  dst += head;
+  src += head;
+  n -= head;
+  for (; n >= 64; n -= 64, dst += 64, src += 64) {
+    __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+    __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+    __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst), x0);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), x1);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), x2);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), x3);
+  }
+#endif
+  std::memcpy(dst, src, n);
+}
+
+// Orders the preceding non-temporal stores before any later stores.
+inline void StreamingStoreFence() {
+#ifdef __SSE2__
+  _mm_sfence();
+#endif
+}
+
 }  // namespace xla
 
 #endif  // XLA_PJRT_TRANSPOSE_KERNELS_H_
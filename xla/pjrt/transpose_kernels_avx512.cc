@@ -0,0 +1,165 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/transpose_kernels_avx512.h"
+
+#include <cstdint>
+
+#include "tsl/platform/cpu_info.h"
+
+#ifdef XLA_HAS_AVX512_TRANSPOSE_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace xla {
+
+bool TransposeKernelsAvx512Supported() {
+#ifdef XLA_HAS_AVX512_TRANSPOSE_KERNELS
+  static const bool supported =
+      tsl::port::TestCPUFeature(tsl::port::CPUFeature::AVX512F);
+  return supported;
+#else
+  return false;
+#endif
+}
+
+#ifdef XLA_HAS_AVX512_TRANSPOSE_KERNELS
+
+#define XLA_AVX512_TARGET __attribute__((target("avx512f")))
+
+XLA_AVX512_TARGET void Transpose16x16x2BytesAvx512(const char* __restrict a,
+                                                   int64_t lda,
+                                                   char* __restrict b,
+                                                   int64_t ldb) {
+  // Each row is a 256-bit vector. The unpacks transpose the 8x8 blocks within
+  // each 128-bit lane of rows 0-7 and of rows 8-15; then the lanes are
+  // recombined. After the unpacks, lane 0 of x[j] (resp. y[j]) holds column
+  // j of rows 0-7 (resp. 8-15), and lane 1 holds column j + 8.
+  __m256i r[16];
+  for (int i = 0; i < 16; ++i) {
+    r[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + lda * i));
+  }
+  __m256i x[8], y[8];
+  for (int half = 0; half < 2; ++half) {
+    const __m256i* rows = r + 8 * half;
+    __m256i* out = half == 0 ? x : y;
+    __m256i t0 = _mm256_unpacklo_epi16(rows[0], rows[1]);
+    __m256i t1 = _mm256_unpacklo_epi16(rows[2], rows[3]);
+    __m256i t2 = _mm256_unpacklo_epi16(rows[4], rows[5]);
+    __m256i t3 = _mm256_unpacklo_epi16(rows[6], rows[7]);
+    __m256i t4 = _mm256_unpackhi_epi16(rows[0], rows[1]);
+    __m256i t5 = _mm256_unpackhi_epi16(rows[2], rows[3]);
+    __m256i t6 = _mm256_unpackhi_epi16(rows[4], rows[5]);
+    __m256i t7 = _mm256_unpackhi_epi16(rows[6], rows[7]);
+    __m256i u0 = _mm256_unpacklo_epi32(t0, t1);
+    __m256i u1 = _mm256_unpacklo_epi32(t2, t3);
+    __m256i u2 = _mm256_unpackhi_epi32(t0, t1);
+    __m256i u3 = _mm256_unpackhi_epi32(t2, t3);
+    __m256i u4 = _mm256_unpacklo_epi32(t4, t5);
+    __m256i u5 = _mm256_unpacklo_epi32(t6, t7);
+    __m256i u6 = _mm256_unpackhi_epi32(t4, t5);
+    __m256i u7 = _mm256_unpackhi_epi32(t6, t7);
+    out[0] = _mm256_unpacklo_epi64(u0, u1);
+    out[1] = _mm256_unpackhi_epi64(u0, u1);
+    out[2] = _mm256_unpacklo_epi64(u2, u3);
+    out[3] = _mm256_unpackhi_epi64(u2, u3);
+    out[4] = _mm256_unpacklo_epi64(u4, u5);
+    out[5] = _mm256_unpackhi_epi64(u4, u5);
+    out[6] = _mm256_unpacklo_epi64(u6, u7);
+    out[7] = _mm256_unpackhi_epi64(u6, u7);
+  }
+  for (int j = 0; j < 8; ++j) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(b + ldb * j),
+                        _mm256_permute2x128_si256(x[j], y[j], 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(b + ldb * (j + 8)),
+                        _mm256_permute2x128_si256(x[j], y[j], 0x31));
+  }
+}
+
+XLA_AVX512_TARGET void Transpose16x16x4BytesAvx512(const char* __restrict a,
+                                                   int64_t lda,
+                                                   char* __restrict b,
+                                                   int64_t ldb) {
+  __m512i r[16];
+  for (int i = 0; i < 16; ++i) {
+    r[i] = _mm512_loadu_si512(a + lda * i);
+  }
+  // Transpose the 4x4 blocks within each 128-bit lane.
+  __m512i t[16];
+  for (int i = 0; i < 16; i += 4) {
+    t[i + 0] = _mm512_unpacklo_epi32(r[i + 0], r[i + 1]);
+    t[i + 1] = _mm512_unpackhi_epi32(r[i + 0], r[i + 1]);
+    t[i + 2] = _mm512_unpacklo_epi32(r[i + 2], r[i + 3]);
+    t[i + 3] = _mm512_unpackhi_epi32(r[i + 2], r[i + 3]);
+  }
+  for (int i = 0; i < 16; i += 4) {
+    r[i + 0] = _mm512_unpacklo_epi64(t[i + 0], t[i + 2]);
+    r[i + 1] = _mm512_unpackhi_epi64(t[i + 0], t[i + 2]);
+    r[i + 2] = _mm512_unpacklo_epi64(t[i + 1], t[i + 3]);
+    r[i + 3] = _mm512_unpackhi_epi64(t[i + 1], t[i + 3]);
+  }
+  // Now lane l of r[4 * g + k] holds column 4 * l + k of rows 4 * g to
+  // 4 * g + 3. Transpose the 4x4 matrix of lanes.
+  for (int k = 0; k < 4; ++k) {
+    t[k + 0] = _mm512_shuffle_i32x4(r[k + 0], r[k + 4], 0x88);
+    t[k + 4] = _mm512_shuffle_i32x4(r[k + 0], r[k + 4], 0xdd);
+    t[k + 8] = _mm512_shuffle_i32x4(r[k + 8], r[k + 12], 0x88);
+    t[k + 12] = _mm512_shuffle_i32x4(r[k + 8], r[k + 12], 0xdd);
+  }
+  for (int k = 0; k < 8; ++k) {
+    r[k + 0] = _mm512_shuffle_i32x4(t[k], t[k + 8], 0x88);
+    r[k + 8] = _mm512_shuffle_i32x4(t[k], t[k + 8], 0xdd);
+  }
+  for (int i = 0; i < 16; ++i) {
+    _mm512_storeu_si512(b + ldb * i, r[i]);
+  }
+}
+
+XLA_AVX512_TARGET void Transpose8x8x8BytesAvx512(const char* __restrict a,
+                                                 int64_t lda,
+                                                 char* __restrict b,
+                                                 int64_t ldb) {
+  __m512i r[8];
+  for (int i = 0; i < 8; ++i) {
+    r[i] = _mm512_loadu_si512(a + lda * i);
+  }
+  // Transpose the 2x2 blocks within each 128-bit lane.
+  __m512i t[8];
+  for (int i = 0; i < 8; i += 2) {
+    t[i + 0] = _mm512_unpacklo_epi64(r[i], r[i + 1]);
+    t[i + 1] = _mm512_unpackhi_epi64(r[i], r[i + 1]);
+  }
+  // Now lane l of t[2 * g + k] holds column 2 * l + k of rows 2 * g and
+  // 2 * g + 1. Transpose the 4x4 matrix of lanes.
+  for (int k = 0; k < 2; ++k) {
+    r[k + 0] = _mm512_shuffle_i64x2(t[k + 0], t[k + 2], 0x88);
+    r[k + 2] = _mm512_shuffle_i64x2(t[k + 0], t[k + 2], 0xdd);
+    r[k + 4] = _mm512_shuffle_i64x2(t[k + 4], t[k + 6], 0x88);
+    r[k + 6] = _mm512_shuffle_i64x2(t[k + 4], t[k + 6], 0xdd);
+  }
+  for (int k = 0; k < 4; ++k) {
+    t[k + 0] = _mm512_shuffle_i64x2(r[k], r[k + 4], 0x88);
+    t[k + 4] = _mm512_shuffle_i64x2(r[k], r[k + 4], 0xdd);
+  }
+  for (int i = 0; i < 8; ++i) {
+    _mm512_storeu_si512(b + ldb * i, t[i]);
+  }
+}
+
+#undef XLA_AVX512_TARGET
+
+#endif  // XLA_HAS_AVX512_TRANSPOSE_KERNELS
+
+}  // namespace xla
@@ -0,0 +1,50 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_PJRT_TRANSPOSE_KERNELS_AVX512_H_
+#define XLA_PJRT_TRANSPOSE_KERNELS_AVX512_H_
+
+#include <cstdint>
+
+// The AVX-512 kernels are compiled with function target attributes, so they
+// are available whatever vector extensions the library is built for, and are
+// only called after checking that the host supports them.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define XLA_HAS_AVX512_TRANSPOSE_KERNELS 1
+#endif
+
+namespace xla {
+
+// Returns whether the host supports the AVX-512 kernels below. Always false
+// if they are not compiled in.
+bool TransposeKernelsAvx512Supported();
+
+#ifdef XLA_HAS_AVX512_TRANSPOSE_KERNELS
+
+// Transposes a block of bs x bs elements of the given size, with the same
+// contract as TransposeMicroKernel. lda, ldb are strides in bytes. Must only
+// be called if TransposeKernelsAvx512Supported().
+void Transpose16x16x2BytesAvx512(const char* __restrict a, int64_t lda,
+                                 char* __restrict b, int64_t ldb);
+void Transpose16x16x4BytesAvx512(const char* __restrict a, int64_t lda,
+                                 char* __restrict b, int64_t ldb);
+void Transpose8x8x8BytesAvx512(const char* __restrict a, int64_t lda,
+                               char* __restrict b, int64_t ldb);
+
+#endif  // XLA_HAS_AVX512_TRANSPOSE_KERNELS
+
+}  // namespace xla
+
+#endif  // XLA_PJRT_TRANSPOSE_KERNELS_AVX512_H_
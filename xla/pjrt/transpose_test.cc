@@ -310,6 +310,11 @@ std::vector<TransposeTestCase> GetTransposeTestCases() {
       TransposeTestCase(/*dims=*/{4, 8, 16, 32}, /*permutation=*/{3, 1, 0, 2}),
       TransposeTestCase(/*dims=*/{64, 224, 224, 3},
                         /*permutation=*/{3, 1, 2, 0}),
+      TransposeTestCase(/*dims=*/{32, 48}, /*permutation=*/{1, 0}),
+      TransposeTestCase(/*dims=*/{67, 129}, /*permutation=*/{1, 0}),
+      TransposeTestCase(/*dims=*/{17, 33, 65}, /*permutation=*/{2, 0, 1}),
+      TransposeTestCase(/*dims=*/{2, 19, 21, 70},
+                        /*permutation=*/{0, 3, 1, 2}),
 
       TransposeTestCase(/*dims=*/{3}, /*permutation=*/{0},
                         /*input_tiling=*/{3}),
@@ -433,6 +438,46 @@ TEST(TransposeTest, NegativeStrides2D) {
   EXPECT_EQ(expected, output);
 }
 
+TEST(TransposeTest, LargeOutputs) {
+  // Outputs of this size are written with streaming stores, both for
+  // transposes and for strided copies.
+  constexpr int64_t kRows = 2048;
+  constexpr int64_t kCols = 4104;
+  std::vector<float> input(kRows * kCols);
+  absl::c_iota(input, 0.0f);
+  {
+    TF_ASSERT_OK_AND_ASSIGN(
+        auto plan, TransposePlan::Create(sizeof(float), {kRows, kCols},
+                                         /*permutation=*/{1, 0}));
+#ifdef __SSE2__
+    EXPECT_THAT(plan->ToString(), ::testing::HasSubstr("streaming_stores=1"));
+#endif
+    std::vector<float> output(kRows * kCols);
+    plan->Execute(input.data(), output.data());
+    for (int64_t r = 0; r < kRows; ++r) {
+      for (int64_t c = 0; c < kCols; ++c) {
+        ASSERT_EQ(output[c * kRows + r], input[r * kCols + c]);
+      }
+    }
+  }
+  {
+    // Copies all but the last 5 columns of every row.
+    constexpr int64_t kCopiedCols = kCols - 5;
+    TF_ASSERT_OK_AND_ASSIGN(
+        auto plan,
+        TransposePlan::Create(
+            sizeof(float), {kRows, kCopiedCols}, /*permutation=*/{0, 1},
+            TransposePlan::Striding{{kCols * sizeof(float), sizeof(float)}}));
+    std::vector<float> output(kRows * kCopiedCols);
+    plan->Execute(input.data(), output.data());
+    for (int64_t r = 0; r < kRows; ++r) {
+      for (int64_t c = 0; c < kCopiedCols; ++c) {
+        ASSERT_EQ(output[r * kCopiedCols + c], input[r * kCols + c]);
+      }
+    }
+  }
+}
+
 static std::vector<TransposeTestCase> BenchmarkCases() {
   return std::vector<TransposeTestCase>{
       TransposeTestCase(/*dims=*/{256, 256},
@@ -465,6 +510,15 @@ static std::vector<TransposeTestCase> BenchmarkCases() {
                         /*permutation=*/{1, 2, 3, 0}),
       TransposeTestCase(/*dims=*/{256, 64, 64, 3},
                         /*permutation=*/{1, 3, 2, 0}),
+      // [B,H,W,C] <-> [B,C,H,W] activation relayouts.
+      TransposeTestCase(/*dims=*/{32, 56, 56, 256},
+                        /*permutation=*/{0, 3, 1, 2}),
+      TransposeTestCase(/*dims=*/{32, 256, 56, 56},
+                        /*permutation=*/{0, 2, 3, 1}),
+      TransposeTestCase(/*dims=*/{8, 224, 224, 64},
+                        /*permutation=*/{0, 3, 1, 2}),
+      TransposeTestCase(/*dims=*/{16, 32, 32, 8, 64},
+                        /*permutation=*/{0, 3, 4, 1, 2}),
   };
 }
 
@@ -481,6 +535,8 @@ void BM_Eigen(const TransposeTestCase& bm, int parallelism,
                         bm.permutation);
     tsl::testing::DoNotOptimize(output);
   }
+  state.SetBytesProcessed(state.iterations() * input.num_elements() *
+                          sizeof(T));
 }
 static void BM_Eigen_uint8(const TransposeTestCase& bm, int parallelism,
                            ::testing::benchmark::State& state) {
@@ -511,15 +567,25 @@ void BM_Transpose(const TransposeTestCase& bm, int parallelism,
     });
     tsl::testing::DoNotOptimize(output);
   }
+  state.SetBytesProcessed(state.iterations() * input.num_elements() *
+                          sizeof(T));
 }
 static void BM_Transpose_uint8(const TransposeTestCase& bm, int parallelism,
                                ::testing::benchmark::State& state) {
   BM_Transpose<uint8_t>(bm, parallelism, state);
 }
+static void BM_Transpose_uint16(const TransposeTestCase& bm, int parallelism,
+                                ::testing::benchmark::State& state) {
+  BM_Transpose<uint16_t>(bm, parallelism, state);
+}
 static void BM_Transpose_float(const TransposeTestCase& bm, int parallelism,
                                ::testing::benchmark::State& state) {
   BM_Transpose<float>(bm, parallelism, state);
 }
+static void BM_Transpose_uint64(const TransposeTestCase& bm, int parallelism,
+                                ::testing::benchmark::State& state) {
+  BM_Transpose<uint64_t>(bm, parallelism, state);
+}
 
 static void* benchmarks = []() {
   using BenchmarkFn =
@@ -528,8 +594,10 @@ static void* benchmarks = []() {
       {
           {"BM_Eigen_uint8", BM_Eigen_uint8, {1}},
           {"BM_Transpose_uint8", BM_Transpose_uint8, {1, 4, 8}},  //
+          {"BM_Transpose_uint16", BM_Transpose_uint16, {1, 4, 8}},  //
           {"BM_Eigen_float", BM_Eigen_float, {1}},
           {"BM_Transpose_float", BM_Transpose_float, {1, 4, 8}},  //
+          {"BM_Transpose_uint64", BM_Transpose_uint64, {1, 4, 8}},  //
   };
   auto benchmark_cases = BenchmarkCases();
   for (const auto& benchmark_case : benchmark_cases) {
@@ -152,9 +152,10 @@ std::string CallSignature::DebugString() const {
   auto py_object_formatter = [](std::string* out, const py::object& o) {
     out->append(py::cast<std::string>(py::str(o)));
   };
-  auto treedef_formatter = [](std::string* out, const xla::PyTreeDef& d) {
-    out->append(d.ToString());
-  };
+  auto treedef_formatter =
+      [](std::string* out, const std::shared_ptr<const xla::PyTreeDef>& d) {
+        out->append(d->ToString());
+      };
   auto signature_formatter = [](std::string* out,
                                 const xla::PyArgSignature& s) {
     out->append(s.DebugString());
@@ -190,13 +191,19 @@ std::string CallSignature::DebugString() const {
 bool CallSignature::operator==(const CallSignature& other) const {
   // TODO(chky): Consider implementing hashing and equality for sharding in cpp
   // instead of hashing and checking sharding's pointer values.
-  return std::tie(dynamic_arg_treedefs, dynamic_arg_names,
-                  dynamic_arg_signatures, device, jax_enable_x64,
-                  static_arg_names, committed_args) ==
-             std::tie(other.dynamic_arg_treedefs, other.dynamic_arg_names,
-                      other.dynamic_arg_signatures, other.device,
-                      other.jax_enable_x64, other.static_arg_names,
-                      other.committed_args) &&
+  return std::tie(dynamic_arg_names, dynamic_arg_signatures, device,
+                  jax_enable_x64, static_arg_names, committed_args) ==
+             std::tie(other.dynamic_arg_names, other.dynamic_arg_signatures,
+                      other.device, other.jax_enable_x64,
+                      other.static_arg_names, other.committed_args) &&
+         // Calls whose structure matched the same hint share its PyTreeDef.
+         std::equal(dynamic_arg_treedefs.begin(), dynamic_arg_treedefs.end(),
+                    other.dynamic_arg_treedefs.begin(),
+                    other.dynamic_arg_treedefs.end(),
+                    [](const std::shared_ptr<const xla::PyTreeDef>& a,
+                       const std::shared_ptr<const xla::PyTreeDef>& b) {
+                      return a == b || *a == *b;
+                    }) &&
          // `==` on py:objects is the Python `is`. We need equal.
          std::equal(dynamic_arg_shardings.begin(), dynamic_arg_shardings.end(),
                     other.dynamic_arg_shardings.begin(),
@@ -235,16 +242,55 @@ bool CallSignature::operator==(const CallSignature& other) const {
               *other.thread_local_extra_jit_context));
 }
 
+bool PyTreeDefHints::Flatten(
+    int index, py::handle arg, absl::InlinedVector<py::object, 2>& leaves,
+    std::shared_ptr<const xla::PyTreeDef>& pytree_def) {
+  // Take our own reference: the vector may be resized or the entry replaced by
+  // another thread while Python code runs below.
+  std::shared_ptr<const xla::PyTreeDef> hint;
+  if (index < hints_.size()) {
+    hint = hints_[index];
+  }
+  if (hint != nullptr && hint->FlattenIntoIfMatches(arg, leaves)) {
+    pytree_def = std::move(hint);
+    return true;
+  }
+  auto flattened = std::make_shared<xla::PyTreeDef>();
+  flattened->FlattenInto(arg, leaves);
+  pytree_def = flattened;
+  if (index >= hints_.size()) {
+    hints_.resize(index + 1);
+  }
+  hints_[index] = std::move(flattened);
+  return false;
+}
+
 // Filter out static arguments, flatten and concatenate other arguments (i.e.
 // dynamic positional and keyword arguments), filling `arguments` in place.
-xla::Status ParseArguments(absl::Span<PyObject* const> positional_args,
-                           absl::Span<PyObject* const> keyword_args,
-                           py::handle kwnames,
-                           absl::Span<int const> static_argnums,
-                           absl::Span<py::str const> static_argnames,
-                           ParsedArgumentsAsBuffers& arguments) {
+xla::Status ParseArguments(
+    absl::Span<PyObject* const> positional_args,
+    absl::Span<PyObject* const> keyword_args, py::handle kwnames,
+    absl::Span<int const> static_argnums,
+    absl::Span<py::str const> static_argnames,
+    ParsedArgumentsAsBuffers& arguments, PyTreeDefHints* treedef_hints) {
   tsl::profiler::TraceMe traceme("ParseArguments");
 
+  // Flattens the next dynamic argument into `pytree_def`, reusing the PyTreeDef
+  // of the same argument in the previous call if its structure is unchanged.
+  int num_dynamic_args = 0;
+  auto flatten_dynamic_arg =
+      [&](py::handle arg, std::shared_ptr<const xla::PyTreeDef>& pytree_def) {
+        const int index = num_dynamic_args++;
+        if (treedef_hints == nullptr) {
+          auto flattened = std::make_shared<xla::PyTreeDef>();
+          flattened->FlattenInto(arg, arguments.flat_dynamic_args);
+          pytree_def = std::move(flattened);
+        } else {
+          treedef_hints->Flatten(index, arg, arguments.flat_dynamic_args,
+                                 pytree_def);
+        }
+      };
+
   arguments.flat_dynamic_args.reserve(positional_args.size() +
                                       keyword_args.size());
   if (static_argnums.empty()) {
@@ -252,8 +298,8 @@ xla::Status ParseArguments(absl::Span<PyObject* const> positional_args,
 
     // Positional arguments.
     for (int i = 0; i < positional_args.size(); ++i) {
-      xla::PyTreeDef& pytree_def = arguments.signature.dynamic_arg_treedefs[i];
-      pytree_def.FlattenInto(positional_args[i], arguments.flat_dynamic_args);
+      flatten_dynamic_arg(positional_args[i],
+                          arguments.signature.dynamic_arg_treedefs[i]);
     }
   } else {
     arguments.signature.dynamic_arg_treedefs.reserve(positional_args.size());
@@ -263,9 +309,8 @@ xla::Status ParseArguments(absl::Span<PyObject* const> positional_args,
       if (std::find(static_argnums.begin(), static_argnums.end(), i) ==
           static_argnums.end()) {
         arguments.signature.dynamic_arg_treedefs.emplace_back();
-        xla::PyTreeDef& pytree_def =
-            arguments.signature.dynamic_arg_treedefs.back();
-        pytree_def.FlattenInto(positional_args[i], arguments.flat_dynamic_args);
+        flatten_dynamic_arg(positional_args[i],
+                            arguments.signature.dynamic_arg_treedefs.back());
       } else {
         arguments.signature.static_args.emplace_back(
             py::reinterpret_borrow<py::object>(positional_args[i]));
@@ -313,9 +358,8 @@ xla::Status ParseArguments(absl::Span<PyObject* const> positional_args,
         arguments.signature.dynamic_arg_names.push_back(
             py::reinterpret_steal<py::object>(kwargs[i].first));
         arguments.signature.dynamic_arg_treedefs.emplace_back();
-        xla::PyTreeDef& pytree_def =
-            arguments.signature.dynamic_arg_treedefs.back();
-        pytree_def.FlattenInto(kwargs[i].second, arguments.flat_dynamic_args);
+        flatten_dynamic_arg(kwargs[i].second,
+                            arguments.signature.dynamic_arg_treedefs.back());
       }
     }
   }
@@ -365,6 +409,28 @@ void BuildJaxjitSubmodule(py::module& m) {
              xla::ValueOrThrowWrapper(xla::PyArgSignatureOfValue));
 
   jitlib.def("_is_float0", &xla::IsFloat0);
+
+  // Exposed for testing and benchmarking the fast path of ParseArguments.
+  py::class_<PyTreeDefHints>(jitlib, "_PyTreeDefHints")
+      .def(py::init<>())
+      .def("flatten", [](PyTreeDefHints& hints, int index, py::handle arg) {
+        absl::InlinedVector<py::object, 2> leaves;
+        std::shared_ptr<const xla::PyTreeDef> pytree_def;
+        bool matched = hints.Flatten(index, arg, leaves, pytree_def);
+        py::list leaves_list;
+        for (py::object& leaf : leaves) {
+          leaves_list.append(std::move(leaf));
+        }
+        return py::make_tuple(leaves_list, *pytree_def, matched);
+      })
+      // Like flatten, but leaves the PyTreeDef in C++ as dispatch does.
+      .def("flatten_leaves",
+           [](PyTreeDefHints& hints, int index, py::handle arg) {
+             absl::InlinedVector<py::object, 2> leaves;
+             std::shared_ptr<const xla::PyTreeDef> pytree_def;
+             bool matched = hints.Flatten(index, arg, leaves, pytree_def);
+             return py::make_tuple(leaves.size(), matched);
+           });
 }
 
 }  // namespace jax
@@ -100,8 +100,10 @@ struct CallSignature {
 
   // A PyTreeDef for each dynamic argument, positional arguments first
   // followed by keyword arguments. Keyword arguments are in the order given
-  // by dynamic_arg_names.
-  absl::InlinedVector<xla::PyTreeDef, 2> dynamic_arg_treedefs;
+  // by dynamic_arg_names. They are shared with the PyTreeDefHints they were
+  // matched against, so that a call with unchanged structure copies none.
+  absl::InlinedVector<std::shared_ptr<const xla::PyTreeDef>, 2>
+      dynamic_arg_treedefs;
   // Dynamic keyword argument names. Interned, and sorted by the keyword
   // name.
   std::vector<pybind11::object> dynamic_arg_names;
@@ -146,7 +148,10 @@ struct CallSignature {
 
 template <typename H>
 H AbslHashValue(H h, const CallSignature& s) {
-  h = H::combine(std::move(h), s.dynamic_arg_treedefs,
+  for (const auto& treedef : s.dynamic_arg_treedefs) {
+    h = H::combine(std::move(h), *treedef);
+  }
+  h = H::combine(std::move(h), s.dynamic_arg_treedefs.size(),
                  s.dynamic_arg_signatures);
 
   DCHECK(s.dynamic_arg_shardings.empty() ||
@@ -213,14 +218,41 @@ struct ParsedArgumentsAsBuffers {
   std::vector<tsl::RCReference<xla::ifrt::Array>> ifrt_arg_arrays;
 };
 
+// The PyTreeDefs of the dynamic arguments of the previous call of a function.
+// Arguments that still have the same structure are flattened with
+// PyTreeDef::FlattenIntoIfMatches, without rebuilding their PyTreeDef.
+//
+// Matching an argument may run Python code, e.g. the flatten function of a
+// custom node, which may release the GIL and let another thread call the same
+// function. The hints are therefore immutable and reference counted: a call
+// matches against its own reference to a hint, and publishes a replacement
+// only once it is done flattening.
+class PyTreeDefHints {
+ public:
+  // Flattens `arg`, the dynamic argument at position `index`, appending its
+  // leaves to `leaves` and setting `pytree_def` to its structure, which is
+  // the hint itself if it matched. Returns true if the hint for `index`
+  // matched. Must be called with the GIL held.
+  bool Flatten(int index, pybind11::handle arg,
+               absl::InlinedVector<pybind11::object, 2>& leaves,
+               std::shared_ptr<const xla::PyTreeDef>& pytree_def);
+
+ private:
+  absl::InlinedVector<std::shared_ptr<const xla::PyTreeDef>, 2> hints_;
+};
+
 // Filter out static arguments, flatten and concatenate other arguments (i.e.
 // dynamic positional and keyword arguments), filling `arguments` in place.
-xla::Status ParseArguments(absl::Span<PyObject* const> positional_args,
-                           absl::Span<PyObject* const> keyword_args,
-                           pybind11::handle kwnames,
-                           absl::Span<int const> static_argnums,
-                           absl::Span<pybind11::str const> static_argnames,
-                           ParsedArgumentsAsBuffers& arguments);
+//
+// If `treedef_hints` is given, the dynamic arguments are flattened with it and
+// it is updated with their structure.
+xla::Status ParseArguments(
+    absl::Span<PyObject* const> positional_args,
+    absl::Span<PyObject* const> keyword_args, pybind11::handle kwnames,
+    absl::Span<int const> static_argnums,
+    absl::Span<pybind11::str const> static_argnames,
+    ParsedArgumentsAsBuffers& arguments,
+    PyTreeDefHints* treedef_hints = nullptr);
 
 // The function to call in `xla.cc` to add the bindings for this module.
 void BuildJaxjitSubmodule(pybind11::module& m);
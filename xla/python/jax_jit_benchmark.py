@@ -0,0 +1,74 @@
+# Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Benchmarks flattening the arguments of a jitted function call.
+
+This is the part of pjit and pmap dispatch that depends on the structure of the
+arguments. Each benchmark prints the time per call of flattening the same
+arguments without hints, as when every call rebuilds their PyTreeDefs, and
+with hints that match, as on the dispatch fast path.
+"""
+
+import collections
+import timeit
+
+from absl import app
+from absl import flags
+
+from xla.python import xla_client
+
+jax_jit = xla_client._xla.jax_jit
+pytree = xla_client._xla.pytree
+
+_NUM_CALLS = flags.DEFINE_integer(
+    "num_calls", 100000, "Number of calls to time per benchmark.")
+
+Params = collections.namedtuple("Params", ["w", "b"])
+
+
+def _Arguments():
+  """Returns typical argument structures, from small to large."""
+  return {
+      "scalar": 1.0,
+      "tuple_of_4": (1.0, 2.0, 3.0, 4.0),
+      "dict_of_16": {f"x{i}": float(i) for i in range(16)},
+      "mlp_params": [
+          {"layer": Params(float(i), float(i)), "scale": None}
+          for i in range(32)
+      ],
+  }
+
+
+def _TimePerCall(fn):
+  return min(timeit.repeat(fn, number=_NUM_CALLS, repeat=3)) / _NUM_CALLS
+
+
+def main(argv):
+  del argv
+  print(f"{'arguments':<12} {'no hints (ns)':>14} {'hints (ns)':>11}")
+  for name, arg in _Arguments().items():
+    hints = jax_jit._PyTreeDefHints()
+    _, matched = hints.flatten_leaves(0, arg)
+    assert not matched
+    _, matched = hints.flatten_leaves(0, arg)
+    assert matched
+    without_hints = _TimePerCall(
+        lambda arg=arg: jax_jit._PyTreeDefHints().flatten_leaves(0, arg))
+    with_hints = _TimePerCall(
+        lambda arg=arg, hints=hints: hints.flatten_leaves(0, arg))
+    print(f"{name:<12} {without_hints * 1e9:>14.0f} {with_hints * 1e9:>11.0f}")
+
+
+if __name__ == "__main__":
+  app.run(main)
@@ -0,0 +1,157 @@
+# Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+import collections
+import threading
+import time
+
+from absl.testing import absltest
+
+from xla.python import xla_client
+
+jax_jit = xla_client._xla.jax_jit
+pytree = xla_client._xla.pytree
+
+Point = collections.namedtuple("Point", ["x", "y"])
+OtherPoint = collections.namedtuple("OtherPoint", ["x", "y"])
+
+
+class Box:
+  """A custom pytree node with a child and auxiliary data."""
+
+  def __init__(self, value, label):
+    self.value = value
+    self.label = label
+
+
+class SlowBox(Box):
+  """A custom pytree node that releases the GIL while being flattened."""
+
+
+def _box_to_iterable(box):
+  return (box.value,), box.label
+
+
+def _slow_box_to_iterable(box):
+  time.sleep(0.001)
+  return (box.value,), box.label
+
+
+pytree.register_node(Box, _box_to_iterable,
+                     lambda label, children: Box(children[0], label))
+pytree.register_node(SlowBox, _slow_box_to_iterable,
+                     lambda label, children: SlowBox(children[0], label))
+
+
+class PyTreeDefHintsTest(absltest.TestCase):
+
+  def assertFlattensLike(self, hints, x, index=0):
+    """Checks `hints` flattens `x` like pytree.flatten; returns if it hit."""
+    leaves, treedef, matched = hints.flatten(index, x)
+    expected_leaves, expected_treedef = pytree.flatten(x)
+    self.assertEqual(leaves, expected_leaves)
+    self.assertEqual(treedef, expected_treedef)
+    return matched
+
+  def assertMatches(self, first, second):
+    hints = jax_jit._PyTreeDefHints()
+    self.assertFalse(self.assertFlattensLike(hints, first))
+    self.assertTrue(self.assertFlattensLike(hints, second))
+
+  def assertDoesNotMatch(self, first, second):
+    hints = jax_jit._PyTreeDefHints()
+    self.assertFalse(self.assertFlattensLike(hints, first))
+    self.assertFalse(self.assertFlattensLike(hints, second))
+    # The hint was replaced by the structure of `second`.
+    self.assertTrue(self.assertFlattensLike(hints, second))
+
+  def testDicts(self):
+    self.assertMatches({"a": 1, "b": 2}, {"a": 3, "b": 4})
+    self.assertMatches({"a": 1, "b": 2}, {"b": 3, "a": 4})
+    self.assertDoesNotMatch({"a": 1, "b": 2}, {"a": 1, "c": 2})
+    self.assertDoesNotMatch({"a": 1, "b": 2}, {"a": 1, "b": 2, "c": 3})
+    self.assertDoesNotMatch({"a": 1, "b": 2}, {"a": 1, "b": (2,)})
+
+  def testListsAndTuples(self):
+    self.assertMatches([1, (2, 3)], [4, (5, 6)])
+    self.assertDoesNotMatch([1, 2], [1, 2, 3])
+    self.assertDoesNotMatch((1, 2), (1,))
+    self.assertDoesNotMatch([1, 2], (1, 2))
+    self.assertDoesNotMatch([1, (2, 3)], [1, [2, 3]])
+
+  def testNamedTuples(self):
+    self.assertMatches(Point(1, 2), Point(3, 4))
+    self.assertDoesNotMatch(Point(1, 2), OtherPoint(1, 2))
+    self.assertDoesNotMatch(Point(1, 2), (1, 2))
+
+  def testNone(self):
+    self.assertMatches([None, 1], [None, 2])
+    self.assertDoesNotMatch([None, 1], [1, 1])
+    self.assertDoesNotMatch([1, 1], [None, 1])
+
+  def testCustomNodes(self):
+    self.assertMatches(Box(1, "a"), Box(2, "a"))
+    self.assertMatches(Box([1, 2], "a"), Box([3, 4], "a"))
+    self.assertDoesNotMatch(Box(1, "a"), Box(1, "b"))
+    self.assertDoesNotMatch(Box([1, 2], "a"), Box([1], "a"))
+    self.assertDoesNotMatch(Box(1, "a"), SlowBox(1, "a"))
+
+  def testMismatchLeavesNoPartialLeaves(self):
+    # The mismatch is only found after some leaves were matched.
+    hints = jax_jit._PyTreeDefHints()
+    self.assertFalse(self.assertFlattensLike(hints, [1, 2, {"a": 3}]))
+    self.assertFalse(self.assertFlattensLike(hints, [4, 5, {"b": 6}]))
+    self.assertFalse(self.assertFlattensLike(hints, [7, 8, Box(9, "a")]))
+
+  def testArgumentsHaveSeparateHints(self):
+    hints = jax_jit._PyTreeDefHints()
+    self.assertFalse(self.assertFlattensLike(hints, (1, 2), index=0))
+    self.assertFalse(self.assertFlattensLike(hints, [1], index=2))
+    self.assertTrue(self.assertFlattensLike(hints, (3, 4), index=0))
+    self.assertFalse(self.assertFlattensLike(hints, (3, 4), index=1))
+    self.assertTrue(self.assertFlattensLike(hints, [5], index=2))
+
+  def testConcurrentCalls(self):
+    # SlowBox releases the GIL while it is matched, so that the other threads
+    # replace the hints and grow the vector of hints in the meantime.
+    hints = jax_jit._PyTreeDefHints()
+    values = [
+        SlowBox(1, "a"),
+        SlowBox([1, 2], "a"),
+        SlowBox(1, "b"),
+        [SlowBox(1, "a"), 2],
+        {"x": SlowBox(1, "a")},
+    ]
+    errors = []
+
+    def Worker(thread_id):
+      try:
+        for i in range(50):
+          value = values[(thread_id + i) % len(values)]
+          index = (thread_id * i) % 4
+          self.assertFlattensLike(hints, value, index=index)
+      except Exception as e:  # pylint: disable=broad-except
+        errors.append(e)
+
+    threads = [threading.Thread(target=Worker, args=(i,)) for i in range(8)]
+    for t in threads:
+      t.start()
+    for t in threads:
+      t.join()
+    self.assertEmpty(errors)
+
+
+if __name__ == "__main__":
+  absltest.main()
@@ -26,6 +26,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/container/inlined_vector.h"
 #include "absl/synchronization/notification.h"
 #include "xla/pjrt/lru_cache.h"
 #include "xla/python/ifrt/array.h"
@@ -34,6 +35,7 @@ limitations under the License.
 #include "xla/python/py_executable.h"
 #include "xla/python/py_values.h"
 #include "xla/python/python_utils.h"
+#include "xla/python/pytree.h"
 #include "xla/python/sharding.h"
 #include "xla/python/status_casters.h"
 #include "xla/python/util.h"
@@ -247,6 +249,9 @@ class PjitFunction {
   std::vector<int> donate_argnums_;
   std::shared_ptr<PjitFunctionCache> cache_;
   std::shared_ptr<PjitFunctionCache::Cache> executables_;
+  // The PyTreeDefs of the dynamic arguments of the last call, used to flatten
+  // arguments of the same structure quickly. See ParseArguments.
+  PyTreeDefHints treedef_hints_;
 };
 
 // thread-compatible.
@@ -443,8 +448,9 @@ xla::StatusOr<py::object> PjitFunction::Call(py::handle callable,
   absl::Span<PyObject* const> positional_args(args, num_positional_args);
   absl::Span<PyObject* const> keyword_args(args + num_positional_args,
                                            num_keyword_args);
-  auto status = ParseArguments(positional_args, keyword_args, kwnames,
-                               static_argnums_, static_argnames_, arguments);
+  auto status =
+      ParseArguments(positional_args, keyword_args, kwnames, static_argnums_,
+                     static_argnames_, arguments, &treedef_hints_);
   if (!status.ok()) {
     VLOG(2) << "ParseArguments failed: " << status;
     return fallback_to_cache_miss();
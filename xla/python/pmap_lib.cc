@@ -46,6 +46,7 @@ limitations under the License.
 #include "xla/python/py_executable.h"
 #include "xla/python/py_values.h"
 #include "xla/python/python_utils.h"
+#include "xla/python/pytree.h"
 #include "xla/python/sharded_device_array.h"
 #include "xla/python/sharding.h"
 #include "xla/python/status_casters.h"
@@ -410,6 +411,9 @@ class PmapFunction {
   // We need a `unique_ptr` here to ensure value pointer stability.
   absl::flat_hash_map<CallSignature, std::unique_ptr<PmapCacheEntry>>
       executables_;
+  // The PyTreeDefs of the dynamic arguments of the last call, used to flatten
+  // arguments of the same structure quickly. See ParseArguments.
+  PyTreeDefHints treedef_hints_;
 
   // The fallback function to use with `ShardArgs`.
   // TODO(jblespiau): Add support for more types from C++.
@@ -559,7 +563,7 @@ xla::StatusOr<py::object> PmapFunction::Call(py::handle callable,
   ParsedArgumentsAsBuffers arguments;
   xla::Status status =
       ParseArguments(positional_args, keyword_args, kwnames, static_argnums_,
-                     /*static_argnames=*/{}, arguments);
+                     /*static_argnames=*/{}, arguments, &treedef_hints_);
   if (!status.ok()) {
     VLOG(2) << "ParseArguments failed: " << status;
     return fallback_to_cache_miss();
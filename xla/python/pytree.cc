@@ -153,6 +153,22 @@ bool PyTreeDef::operator==(const PyTreeDef& other) const {
 
 /*static*/ PyTreeKind PyTreeDef::GetKind(
     const py::handle& obj, PyTreeTypeRegistry::Registration const** custom) {
+  // The builtin types cannot be registered again, so they can be identified
+  // without a registry lookup.
+  PyTypeObject* type = Py_TYPE(obj.ptr());
+  if (type == &PyTuple_Type) {
+    *custom = nullptr;
+    return PyTreeKind::kTuple;
+  } else if (type == &PyList_Type) {
+    *custom = nullptr;
+    return PyTreeKind::kList;
+  } else if (type == &PyDict_Type) {
+    *custom = nullptr;
+    return PyTreeKind::kDict;
+  } else if (obj.ptr() == Py_None) {
+    *custom = nullptr;
+    return PyTreeKind::kNone;
+  }
   const PyTreeTypeRegistry::Registration* registration =
       PyTreeTypeRegistry::Lookup(obj.get_type());
   if (registration) {
@@ -258,6 +274,123 @@ void PyTreeDef::FlattenInto(py::handle handle, std::vector<py::object>& leaves,
   FlattenIntoImpl(handle, leaves, leaf_predicate);
 }
 
+bool PyTreeDef::MatchAndExtractLeaves(py::handle handle, int index,
+                                      py::object* leaves_end) const {
+  const Node& node = traversal_[index];
+  // The nodes are in post-order, so the children of a node precede it from
+  // last to first, each followed by the subtree of its left sibling. Visiting
+  // them in that order fills the leaf slots from the back.
+  auto match_children = [&](auto get_child) {
+    int child_index = index - 1;
+    py::object* child_leaves_end = leaves_end;
+    for (int i = node.arity - 1; i >= 0; --i) {
+      // Hold a reference: matching a sibling may run Python code that mutates
+      // the container.
+      py::object child = py::reinterpret_borrow<py::object>(get_child(i));
+      if (!child ||
+          !MatchAndExtractLeaves(child, child_index, child_leaves_end)) {
+        return false;
+      }
+      child_leaves_end -= traversal_[child_index].num_leaves;
+      child_index -= traversal_[child_index].num_nodes;
+    }
+    return true;
+  };
+  PyObject* obj = handle.ptr();
+  switch (node.kind) {
+    case PyTreeKind::kLeaf: {
+      const PyTreeTypeRegistry::Registration* custom;
+      if (GetKind(handle, &custom) != PyTreeKind::kLeaf) {
+        return false;
+      }
+      *(leaves_end - 1) = py::reinterpret_borrow<py::object>(handle);
+      return true;
+    }
+    case PyTreeKind::kNone:
+      return obj == Py_None;
+    case PyTreeKind::kTuple:
+      if (!PyTuple_CheckExact(obj) || PyTuple_GET_SIZE(obj) != node.arity) {
+        return false;
+      }
+      return match_children(
+          [obj](int i) { return py::handle(PyTuple_GET_ITEM(obj, i)); });
+    case PyTreeKind::kNamedTuple:
+      if (Py_TYPE(obj) != reinterpret_cast<PyTypeObject*>(
+                              node.node_data.ptr()) ||
+          PyTuple_GET_SIZE(obj) != node.arity ||
+          PyTreeTypeRegistry::Lookup(handle.get_type()) != nullptr) {
+        return false;
+      }
+      return match_children(
+          [obj](int i) { return py::handle(PyTuple_GET_ITEM(obj, i)); });
+    case PyTreeKind::kList:
+      if (!PyList_CheckExact(obj) || PyList_GET_SIZE(obj) != node.arity) {
+        return false;
+      }
+      return match_children(
+          [obj](int i) { return py::handle(PyList_GET_ITEM(obj, i)); });
+    case PyTreeKind::kDict:
+      // With as many entries as keys in the node, the dict has the same keys
+      // if it has an entry for every key in the node.
+      if (!PyDict_CheckExact(obj) || PyDict_GET_SIZE(obj) != node.arity) {
+        return false;
+      }
+      return match_children([&node, obj](int i) {
+        return py::handle(PyDict_GetItem(obj, node.sorted_dict_keys[i].ptr()));
+      });
+    case PyTreeKind::kCustom: {
+      if (PyTreeTypeRegistry::Lookup(handle.get_type()) != node.custom) {
+        return false;
+      }
+      py::tuple out = py::cast<py::tuple>(node.custom->to_iterable(handle));
+      if (out.size() != 2 || node.node_data.not_equal(out[1])) {
+        return false;
+      }
+      absl::InlinedVector<py::object, 4> children;
+      for (py::handle entry : py::cast<py::iterable>(out[0])) {
+        children.push_back(py::reinterpret_borrow<py::object>(entry));
+      }
+      if (children.size() != static_cast<size_t>(node.arity)) {
+        return false;
+      }
+      return match_children(
+          [&children](int i) { return py::handle(children[i]); });
+    }
+  }
+  return false;
+}
+
+template <typename T>
+bool PyTreeDef::FlattenIntoIfMatchesImpl(py::handle handle, T& leaves) const {
+  if (traversal_.empty()) {
+    return false;
+  }
+  const size_t start = leaves.size();
+  leaves.resize(start + num_leaves());
+  bool matches;
+  try {
+    matches = MatchAndExtractLeaves(handle, traversal_.size() - 1,
+                                    leaves.data() + leaves.size());
+  } catch (...) {
+    leaves.resize(start);
+    throw;
+  }
+  if (!matches) {
+    leaves.resize(start);
+  }
+  return matches;
+}
+
+bool PyTreeDef::FlattenIntoIfMatches(py::handle handle,
+                                     std::vector<py::object>& leaves) const {
+  return FlattenIntoIfMatchesImpl(handle, leaves);
+}
+
+bool PyTreeDef::FlattenIntoIfMatches(
+    py::handle handle, absl::InlinedVector<py::object, 2>& leaves) const {
+  return FlattenIntoIfMatchesImpl(handle, leaves);
+}
+
 /*static*/ std::pair<std::vector<py::object>, std::unique_ptr<PyTreeDef>>
 PyTreeDef::Flatten(py::handle x, std::optional<py::function> leaf_predicate) {
   std::vector<py::object> leaves;
@@ -121,6 +121,22 @@ class PyTreeDef {
       pybind11::handle handle, absl::InlinedVector<pybind11::object, 2>& leaves,
       std::optional<pybind11::function> leaf_predicate = std::nullopt);
 
+  // Fast path for flattening a value expected to have the structure of this
+  // PyTreeDef, e.g. an argument of repeated calls to a jitted function. If
+  // `handle` has exactly this structure, appends its leaves to `leaves` and
+  // returns true, in which case this PyTreeDef is also its PyTreeDef.
+  // Otherwise leaves `leaves` unchanged and returns false, and the value
+  // must be flattened with FlattenInto.
+  //
+  // The leaves are written in place into space reserved up front, builtin
+  // containers are matched by their exact type and dict keys by lookup,
+  // without consulting the registry or sorting the keys.
+  bool FlattenIntoIfMatches(pybind11::handle handle,
+                            std::vector<pybind11::object>& leaves) const;
+  bool FlattenIntoIfMatches(
+      pybind11::handle handle,
+      absl::InlinedVector<pybind11::object, 2>& leaves) const;
+
   // Tests whether the given list is a flat list of leaves.
   static bool AllLeaves(const pybind11::iterable& x);
 
@@ -230,6 +246,15 @@ class PyTreeDef {
   void FlattenIntoImpl(pybind11::handle handle, T& leaves,
                        const std::optional<pybind11::function>& leaf_predicate);
 
+  template <typename T>
+  bool FlattenIntoIfMatchesImpl(pybind11::handle handle, T& leaves) const;
+
+  // Recursive helper of FlattenIntoIfMatches(): matches `handle` against the
+  // subtree rooted at traversal_[index] and writes its leaves to the slots
+  // just below `leaves_end`.
+  bool MatchAndExtractLeaves(pybind11::handle handle, int index,
+                             pybind11::object* leaves_end) const;
+
   template <typename T>
   pybind11::object UnflattenImpl(T leaves) const;
 
@@ -15,11 +15,19 @@ limitations under the License.
 
 #include "xla/service/compilation_cache.h"
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/ir/hlo_opcode.h"
 #include "xla/types.h"
 #include "xla/util.h"
 #include "xla/xla_data.pb.h"
+#include "tsl/lib/monitoring/counter.h"
+#include "tsl/platform/cpu_info.h"
 #include "tsl/platform/logging.h"
 #include "tsl/platform/strcat.h"
 
@@ -27,6 +35,18 @@ namespace xla {
 
 namespace {
 
+auto* compilation_cache_hits = tsl::monitoring::Counter<0>::New(
+    "/xla/service/compilation_cache_hits",
+    "The number of CompilationCache lookups that found an executable.");
+
+auto* compilation_cache_misses = tsl::monitoring::Counter<0>::New(
+    "/xla/service/compilation_cache_misses",
+    "The number of CompilationCache lookups that found no executable.");
+
+auto* compilation_cache_evictions = tsl::monitoring::Counter<0>::New(
+    "/xla/service/compilation_cache_evictions",
+    "The number of executables evicted from CompilationCaches.");
+
 int64_t GetUniqueId() {
   static absl::Mutex mu(absl::kConstInit);
   static int64_t counter = 0;
@@ -37,14 +57,64 @@ int64_t GetUniqueId() {
 
 }  // namespace
 
+CompilationCache::CompilationCache(const Options& options)
+    : options_([&] {
+        Options result = options;
+        if (result.num_shards <= 0) {
+          result.num_shards = DefaultNumShards(tsl::port::MaxParallelism());
+        }
+        return result;
+      }()),
+      max_shard_size_bytes_(
+          options_.max_size_bytes > 0
+              ? CeilOfRatio<int64_t>(options_.max_size_bytes,
+                                     options_.num_shards)
+              : 0),
+      shards_(new Shard[options_.num_shards]) {}
+
+/*static*/ int CompilationCache::DefaultNumShards(int num_threads) {
+  constexpr int kMaxShards = 16;
+  return std::clamp(num_threads, 1, kMaxShards);
+}
+
+/*static*/ int64_t CompilationCache::EstimateSizeInBytes(
+    const Executable& executable) {
+  int64_t size_bytes = std::max<int64_t>(
+      0, executable.SizeOfGeneratedCodeInBytes());
+  if (executable.has_module()) {
+    for (const HloComputation* computation :
+         executable.module().computations()) {
+      for (const HloInstruction* instruction : computation->instructions()) {
+        if (instruction->opcode() == HloOpcode::kConstant) {
+          size_bytes += instruction->literal().size_bytes();
+        }
+      }
+    }
+  }
+  return size_bytes;
+}
+
+CompilationCache::Shard& CompilationCache::ShardFor(CacheKey key) const {
+  return shards_[static_cast<uint64_t>(key) % options_.num_shards];
+}
+
 ExecutionHandle CompilationCache::Insert(
     std::unique_ptr<Executable> executable) {
-  absl::MutexLock lock(&mutex_);
-
   CacheKey key = GetUniqueId();
-  VLOG(2) << "inserting cache key: " << key;
-  CHECK_EQ(cache_.count(key), 0);
-  cache_.emplace(key, std::move(executable));
+  int64_t size_bytes = EstimateSizeInBytes(*executable);
+  VLOG(2) << "inserting cache key: " << key << " (" << size_bytes
+          << " bytes)";
+
+  Shard& shard = ShardFor(key);
+  {
+    absl::MutexLock lock(&shard.mutex);
+    CHECK_EQ(shard.cache.count(key), 0);
+    shard.lru.push_front(Entry{key, std::move(executable), size_bytes});
+    shard.cache.emplace(key, shard.lru.begin());
+    shard.size_bytes += size_bytes;
+    EvictLocked(shard, /*keep=*/&shard.lru.front());
+  }
+  insertions_.fetch_add(1, std::memory_order_relaxed);
 
   ExecutionHandle handle;
   handle.set_handle(key);
@@ -53,18 +123,72 @@ ExecutionHandle CompilationCache::Insert(
 
 StatusOr<std::shared_ptr<Executable>> CompilationCache::LookUp(
     const ExecutionHandle& handle) const {
-  absl::MutexLock lock(&mutex_);
-
   CacheKey key = handle.handle();
   VLOG(2) << "looking up cache key: " << key;
-  if (cache_.count(key) == 0) {
+
+  Shard& shard = ShardFor(key);
+  absl::MutexLock lock(&shard.mutex);
+  auto it = shard.cache.find(key);
+  if (it == shard.cache.end()) {
     VLOG(2) << "cache key not found: " << key;
-    return InvalidArgumentStrCat("can not find executable with handle ", key);
-  } else {
-    auto& result = cache_.at(key);
-    VLOG(2) << "hit executable: " << result->module().name();
-    return result;
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    compilation_cache_misses->GetCell()->IncrementBy(1);
+    return InvalidArgumentStrCat(
+        "can not find executable with handle ", key,
+        "; it was never compiled or has been evicted from the cache");
+  }
+  EntryList::iterator entry = it->second;
+  ++entry->use_count;
+  shard.lru.splice(shard.lru.begin(), shard.lru, entry);
+  VLOG(2) << "hit executable: " << entry->executable->module().name();
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  compilation_cache_hits->GetCell()->IncrementBy(1);
+  return entry->executable;
+}
+
+void CompilationCache::EvictLocked(Shard& shard, const Entry* keep) {
+  if (max_shard_size_bytes_ <= 0) {
+    return;
+  }
+  while (shard.size_bytes > max_shard_size_bytes_ && shard.lru.size() > 1) {
+    // Walk from the least recently used end so that ties in use count are
+    // broken by recency.
+    auto victim = shard.lru.end();
+    for (auto it = shard.lru.rbegin(); it != shard.lru.rend(); ++it) {
+      if (&*it == keep) {
+        continue;
+      }
+      if (victim == shard.lru.end() ||
+          (options_.eviction_policy == EvictionPolicy::kLeastFrequentlyUsed &&
+           it->use_count < victim->use_count)) {
+        victim = std::prev(it.base());
+        if (options_.eviction_policy == EvictionPolicy::kLeastRecentlyUsed) {
+          break;
+        }
+      }
+    }
+    VLOG(2) << "evicting cache key: " << victim->key << " ("
+            << victim->size_bytes << " bytes)";
+    shard.size_bytes -= victim->size_bytes;
+    shard.cache.erase(victim->key);
+    shard.lru.erase(victim);
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+    compilation_cache_evictions->GetCell()->IncrementBy(1);
+  }
+}
+
+CompilationCache::Stats CompilationCache::stats() const {
+  Stats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  stats.insertions = insertions_.load(std::memory_order_relaxed);
+  stats.evictions = evictions_.load(std::memory_order_relaxed);
+  for (int i = 0; i < options_.num_shards; ++i) {
+    absl::MutexLock lock(&shards_[i].mutex);
+    stats.size_bytes += shards_[i].size_bytes;
+    stats.num_entries += shards_[i].lru.size();
   }
+  return stats;
 }
 
 }  // namespace xla
@@ -16,11 +16,13 @@ limitations under the License.
 #ifndef XLA_SERVICE_COMPILATION_CACHE_H_
 #define XLA_SERVICE_COMPILATION_CACHE_H_
 
-#include <map>
+#include <atomic>
+#include <cstdint>
+#include <list>
 #include <memory>
-#include <string>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
 #include "xla/service/executable.h"
 #include "xla/service/hlo_module_config.h"
 #include "xla/types.h"
@@ -29,11 +31,44 @@ namespace xla {
 
 // A cache which stores Executables indexed by computation handle and version.
 //
-// TODO(b/119042872): Provide mechanism for removing computations from the
-// compilation cache.
+// The cache is split into shards, each with its own lock, so that concurrent
+// lookups of different handles do not contend. When a byte budget is set,
+// every shard gets an equal slice of it and evicts entries according to the
+// configured policy once it is exceeded; looking up an evicted handle fails
+// as if it had never been inserted. Executables already handed out stay alive
+// through their shared_ptr.
 class CompilationCache {
  public:
-  CompilationCache() {}
+  enum class EvictionPolicy {
+    // Evict the entry that was inserted or looked up least recently.
+    kLeastRecentlyUsed,
+    // Evict the entry with the fewest lookups, least recently used first
+    // among ties.
+    kLeastFrequentlyUsed,
+  };
+
+  struct Options {
+    // Upper bound on the total estimated size of the cached executables. Zero
+    // or negative means unbounded.
+    int64_t max_size_bytes = 0;
+    EvictionPolicy eviction_policy = EvictionPolicy::kLeastRecentlyUsed;
+    // The number of independently locked shards the entries and the byte
+    // budget are split into. Zero or negative means
+    // DefaultNumShards(tsl::port::MaxParallelism()).
+    int num_shards = 0;
+  };
+
+  struct Stats {
+    int64_t hits = 0;
+    int64_t misses = 0;
+    int64_t insertions = 0;
+    int64_t evictions = 0;
+    int64_t size_bytes = 0;
+    int64_t num_entries = 0;
+  };
+
+  CompilationCache() : CompilationCache(Options()) {}
+  explicit CompilationCache(const Options& options);
 
   ExecutionHandle Insert(std::unique_ptr<Executable> executable);
 
@@ -42,17 +77,58 @@ class CompilationCache {
   StatusOr<std::shared_ptr<Executable>> LookUp(
       const ExecutionHandle& handle) const;
 
- protected:
-  mutable absl::Mutex mutex_;
+  Stats stats() const;
+
+  int num_shards() const { return options_.num_shards; }
+
+  // The number of shards for a cache that up to `num_threads` threads use
+  // concurrently: one per thread, but at most 16, since every shard only gets
+  // its slice of the byte budget.
+  static int DefaultNumShards(int num_threads);
+
+  // Estimated memory held by `executable`: its generated code plus the
+  // constants of its module.
+  static int64_t EstimateSizeInBytes(const Executable& executable);
 
+ protected:
   using CacheKey = int64_t;
 
-  absl::flat_hash_map<CacheKey, std::shared_ptr<Executable>> cache_
-      ABSL_GUARDED_BY(mutex_);
+  struct Entry {
+    CacheKey key;
+    std::shared_ptr<Executable> executable;
+    int64_t size_bytes;
+    int64_t use_count = 0;
+  };
+  // Most recently used at the front.
+  using EntryList = std::list<Entry>;
+
+  struct Shard {
+    absl::Mutex mutex;
+    EntryList lru ABSL_GUARDED_BY(mutex);
+    absl::flat_hash_map<CacheKey, EntryList::iterator> cache
+        ABSL_GUARDED_BY(mutex);
+    int64_t size_bytes ABSL_GUARDED_BY(mutex) = 0;
+  };
+
+  Shard& ShardFor(CacheKey key) const;
+
+  // Evicts entries from `shard` until it fits its budget. `keep` is never
+  // evicted, so that a single oversized executable can still be used.
+  void EvictLocked(Shard& shard, const Entry* keep)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(shard.mutex);
 
  private:
   CompilationCache(const CompilationCache&) = delete;
   CompilationCache& operator=(const CompilationCache&) = delete;
+
+  const Options options_;
+  const int64_t max_shard_size_bytes_;
+  std::unique_ptr<Shard[]> shards_;
+
+  mutable std::atomic<int64_t> hits_{0};
+  mutable std::atomic<int64_t> misses_{0};
+  std::atomic<int64_t> insertions_{0};
+  std::atomic<int64_t> evictions_{0};
 };
 
 }  // namespace xla
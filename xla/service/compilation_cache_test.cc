@@ -0,0 +1,199 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/compilation_cache.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/service/hlo_module_config.h"
+#include "xla/service/hlo_parser.h"
+#include "xla/test.h"
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/cpu_info.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test_benchmark.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+namespace {
+
+class FakeExecutable : public Executable {
+ public:
+  FakeExecutable(std::shared_ptr<HloModule> module, int64_t code_size_bytes)
+      : Executable(std::move(module)), code_size_bytes_(code_size_bytes) {}
+
+  StatusOr<ExecutionOutput> ExecuteAsyncOnStream(
+      const ServiceExecutableRunOptions* run_options,
+      std::vector<ExecutionInput> arguments,
+      HloExecutionProfile* hlo_execution_profile) override {
+    return Unimplemented("FakeExecutable");
+  }
+
+  int64_t SizeOfGeneratedCodeInBytes() const override {
+    return code_size_bytes_;
+  }
+
+ private:
+  int64_t code_size_bytes_;
+};
+
+std::unique_ptr<Executable> MakeExecutable(int64_t code_size_bytes) {
+  return std::make_unique<FakeExecutable>(
+      std::make_shared<HloModule>("test", HloModuleConfig()), code_size_bytes);
+}
+
+TEST(CompilationCacheTest, InsertAndLookUp) {
+  CompilationCache cache;
+  ExecutionHandle handle = cache.Insert(MakeExecutable(100));
+  TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Executable> executable,
+                          cache.LookUp(handle));
+  EXPECT_EQ(executable->SizeOfGeneratedCodeInBytes(), 100);
+
+  ExecutionHandle unknown;
+  unknown.set_handle(handle.handle() + 1000);
+  EXPECT_FALSE(cache.LookUp(unknown).ok());
+
+  CompilationCache::Stats stats = cache.stats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.insertions, 1);
+  EXPECT_EQ(stats.evictions, 0);
+  EXPECT_EQ(stats.size_bytes, 100);
+  EXPECT_EQ(stats.num_entries, 1);
+}
+
+TEST(CompilationCacheTest, SizeIncludesConstants) {
+  constexpr char kHlo[] = R"(
+    HloModule m
+    ENTRY e {
+      ROOT c = f32[4] constant({1, 2, 3, 4})
+    })";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseAndReturnUnverifiedModule(kHlo));
+  FakeExecutable executable(std::move(module), /*code_size_bytes=*/64);
+  EXPECT_EQ(CompilationCache::EstimateSizeInBytes(executable), 64 + 16);
+}
+
+TEST(CompilationCacheTest, EvictsLeastRecentlyUsed) {
+  CompilationCache::Options options;
+  options.max_size_bytes = 250;
+  options.num_shards = 1;
+  CompilationCache cache(options);
+
+  ExecutionHandle a = cache.Insert(MakeExecutable(100));
+  ExecutionHandle b = cache.Insert(MakeExecutable(100));
+  TF_ASSERT_OK(cache.LookUp(a).status());
+  ExecutionHandle c = cache.Insert(MakeExecutable(100));
+
+  EXPECT_TRUE(cache.LookUp(a).ok());
+  EXPECT_FALSE(cache.LookUp(b).ok());
+  EXPECT_TRUE(cache.LookUp(c).ok());
+  EXPECT_EQ(cache.stats().evictions, 1);
+  EXPECT_EQ(cache.stats().size_bytes, 200);
+}
+
+TEST(CompilationCacheTest, EvictsLeastFrequentlyUsed) {
+  CompilationCache::Options options;
+  options.max_size_bytes = 250;
+  options.num_shards = 1;
+  options.eviction_policy =
+      CompilationCache::EvictionPolicy::kLeastFrequentlyUsed;
+  CompilationCache cache(options);
+
+  ExecutionHandle a = cache.Insert(MakeExecutable(100));
+  ExecutionHandle b = cache.Insert(MakeExecutable(100));
+  TF_ASSERT_OK(cache.LookUp(a).status());
+  TF_ASSERT_OK(cache.LookUp(a).status());
+  TF_ASSERT_OK(cache.LookUp(b).status());
+  // `a` is now the least recently used entry, but `b` was used less often.
+  TF_ASSERT_OK(cache.LookUp(a).status());
+  TF_ASSERT_OK(cache.LookUp(b).status());
+  ExecutionHandle c = cache.Insert(MakeExecutable(100));
+
+  EXPECT_TRUE(cache.LookUp(a).ok());
+  EXPECT_FALSE(cache.LookUp(b).ok());
+  EXPECT_TRUE(cache.LookUp(c).ok());
+}
+
+TEST(CompilationCacheTest, KeepsOversizedExecutable) {
+  CompilationCache::Options options;
+  options.max_size_bytes = 50;
+  options.num_shards = 1;
+  CompilationCache cache(options);
+
+  ExecutionHandle a = cache.Insert(MakeExecutable(100));
+  EXPECT_TRUE(cache.LookUp(a).ok());
+  ExecutionHandle b = cache.Insert(MakeExecutable(100));
+  EXPECT_FALSE(cache.LookUp(a).ok());
+  EXPECT_TRUE(cache.LookUp(b).ok());
+}
+
+TEST(CompilationCacheTest, DerivesShardCountFromThreads) {
+  EXPECT_EQ(CompilationCache::DefaultNumShards(0), 1);
+  EXPECT_EQ(CompilationCache::DefaultNumShards(4), 4);
+  EXPECT_EQ(CompilationCache::DefaultNumShards(128), 16);
+
+  CompilationCache derived;
+  EXPECT_EQ(derived.num_shards(),
+            CompilationCache::DefaultNumShards(tsl::port::MaxParallelism()));
+
+  CompilationCache::Options options;
+  options.num_shards = 3;
+  CompilationCache explicit_shards(options);
+  EXPECT_EQ(explicit_shards.num_shards(), 3);
+}
+
+TEST(CompilationCacheTest, ConcurrentLookUps) {
+  CompilationCache cache;
+  std::vector<ExecutionHandle> handles;
+  for (int i = 0; i < 64; ++i) {
+    handles.push_back(cache.Insert(MakeExecutable(i)));
+  }
+  {
+    tsl::thread::ThreadPool pool(tsl::Env::Default(), "lookup", 8);
+    for (int t = 0; t < 8; ++t) {
+      pool.Schedule([&] {
+        for (int i = 0; i < 1000; ++i) {
+          EXPECT_TRUE(cache.LookUp(handles[i % handles.size()]).ok());
+        }
+      });
+    }
+  }
+  EXPECT_EQ(cache.stats().hits, 8000);
+}
+
+void BM_ConcurrentLookUp(::testing::benchmark::State& state) {
+  static CompilationCache* cache = new CompilationCache();
+  static std::vector<ExecutionHandle>* handles = [] {
+    auto* handles = new std::vector<ExecutionHandle>();
+    for (int i = 0; i < 256; ++i) {
+      handles->push_back(cache->Insert(MakeExecutable(i)));
+    }
+    return handles;
+  }();
+  int i = state.thread_index() * 17;
+  for (auto s : state) {
+    auto executable = cache->LookUp((*handles)[i++ % handles->size()]);
+    tsl::testing::DoNotOptimize(executable);
+  }
+}
+BENCHMARK(BM_ConcurrentLookUp)->ThreadRange(1, 16);
+
+}  // namespace
+}  // namespace xla
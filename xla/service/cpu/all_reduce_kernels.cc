@@ -0,0 +1,51 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/all_reduce_kernels.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+#include "xla/util.h"
+
+namespace xla {
+namespace cpu {
+
+std::pair<int64_t, int64_t> AllReduceSliceBounds(int64_t element_count,
+                                                 int64_t element_size,
+                                                 int num_participants,
+                                                 int rank) {
+  // Below this size splitting the work costs more in cross-core traffic than
+  // it saves in reduction time.
+  constexpr int64_t kMinSliceBytes = 16 * 1024;
+  constexpr int64_t kCacheLineBytes = 64;
+
+  const int64_t alignment =
+      std::max<int64_t>(1, kCacheLineBytes / element_size);
+  const int64_t min_slice_elements =
+      std::max<int64_t>(alignment, kMinSliceBytes / element_size);
+  int64_t slice_elements =
+      std::max(min_slice_elements,
+               CeilOfRatio<int64_t>(element_count, num_participants));
+  slice_elements = RoundUpTo(slice_elements, alignment);
+
+  const int64_t begin = std::min(element_count, rank * slice_elements);
+  const int64_t end = std::min(element_count, begin + slice_elements);
+  return {begin, end};
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,135 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_ALL_REDUCE_KERNELS_H_
+#define XLA_SERVICE_CPU_ALL_REDUCE_KERNELS_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "absl/base/casts.h"
+#include "absl/types/span.h"
+#include "xla/service/collective_ops_utils.h"
+#include "xla/types.h"
+#include "tsl/platform/logging.h"
+
+namespace xla {
+namespace cpu {
+
+// Returns the [begin, end) range of elements of a buffer with
+// `element_count` elements of `element_size` bytes each that participant
+// `rank` of `num_participants` reduces in a reduce-scatter style all-reduce.
+// Slices are aligned to cache lines and are never smaller than a minimum size,
+// so for small buffers only the first few participants get non-empty slices.
+std::pair<int64_t, int64_t> AllReduceSliceBounds(int64_t element_count,
+                                                 int64_t element_size,
+                                                 int num_participants,
+                                                 int rank);
+
+namespace all_reduce_internal {
+
+// Signed integer sums and products are computed in the corresponding
+// unsigned type so that overflow wraps around instead of being UB.
+template <typename T, bool kIsSignedIntegralType =
+                          std::is_integral_v<T> && std::is_signed_v<T>>
+struct WrappingTypeFor {
+  using type = T;
+};
+
+template <typename T>
+struct WrappingTypeFor<T, /*kIsSignedIntegralType=*/true> {
+  using type = std::make_unsigned_t<T>;
+};
+
+template <typename T>
+using WrappingType = typename WrappingTypeFor<T>::type;
+
+// acc[i] = acc[i] <op> in[i] for i in [0, n). The switch on the reduction
+// kind is hoisted out of the loop so that each loop vectorizes.
+template <typename T>
+void Accumulate(ReductionKind reduction_kind, T* __restrict acc,
+                const T* __restrict in, int64_t n) {
+  using W = WrappingType<T>;
+  switch (reduction_kind) {
+    case ReductionKind::SUM:
+      for (int64_t i = 0; i < n; ++i) {
+        acc[i] = absl::bit_cast<T>(static_cast<W>(absl::bit_cast<W>(acc[i]) +
+                                                  absl::bit_cast<W>(in[i])));
+      }
+      return;
+    case ReductionKind::PRODUCT:
+      for (int64_t i = 0; i < n; ++i) {
+        acc[i] = absl::bit_cast<T>(static_cast<W>(absl::bit_cast<W>(acc[i]) *
+                                                  absl::bit_cast<W>(in[i])));
+      }
+      return;
+    case ReductionKind::MIN:
+      if constexpr (is_complex_v<T>) {
+        LOG(FATAL) << "min/max not valid for complex types";
+      } else {
+        for (int64_t i = 0; i < n; ++i) {
+          acc[i] = std::min(acc[i], in[i]);
+        }
+      }
+      return;
+    case ReductionKind::MAX:
+      if constexpr (is_complex_v<T>) {
+        LOG(FATAL) << "min/max not valid for complex types";
+      } else {
+        for (int64_t i = 0; i < n; ++i) {
+          acc[i] = std::max(acc[i], in[i]);
+        }
+      }
+      return;
+  }
+}
+
+}  // namespace all_reduce_internal
+
+// Reduces elements [begin, end) of all `inputs` and writes the result to the
+// same elements of all `outputs`. Inputs are combined in the order in which
+// they are given, so every output receives bitwise identical values. An output
+// may alias the input at the same position: all inputs of a block are read
+// before any output of that block is written.
+template <typename T>
+void AllReduceSlice(ReductionKind reduction_kind,
+                    absl::Span<const T* const> inputs,
+                    absl::Span<T* const> outputs, int64_t begin, int64_t end) {
+  CHECK(!inputs.empty());
+  // Reduce in blocks that stay in L1 cache while all inputs are folded in.
+  constexpr int64_t kBlockBytes = 8 * 1024;
+  constexpr int64_t kBlockElements =
+      std::max<int64_t>(1, kBlockBytes / sizeof(T));
+  T acc[kBlockElements];
+  for (int64_t block = begin; block < end; block += kBlockElements) {
+    const int64_t n = std::min(kBlockElements, end - block);
+    std::memcpy(acc, inputs[0] + block, n * sizeof(T));
+    for (int64_t i = 1; i < inputs.size(); ++i) {
+      all_reduce_internal::Accumulate(reduction_kind, acc, inputs[i] + block,
+                                      n);
+    }
+    for (T* output : outputs) {
+      std::memcpy(output + block, acc, n * sizeof(T));
+    }
+  }
+}
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_ALL_REDUCE_KERNELS_H_
@@ -0,0 +1,198 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/all_reduce_kernels.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/types/span.h"
+#include "xla/service/collective_ops_utils.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+TEST(AllReduceKernelsTest, SliceBoundsCoverBuffer) {
+  for (int64_t element_count : {0, 1, 100, 4096, 100000, 1234567}) {
+    for (int num_participants : {1, 2, 3, 8, 32}) {
+      int64_t covered = 0;
+      for (int rank = 0; rank < num_participants; ++rank) {
+        auto [begin, end] = AllReduceSliceBounds(element_count, sizeof(float),
+                                                 num_participants, rank);
+        EXPECT_EQ(begin, covered);
+        EXPECT_LE(begin, end);
+        covered = end;
+      }
+      EXPECT_EQ(covered, element_count);
+    }
+  }
+}
+
+TEST(AllReduceKernelsTest, SmallBuffersAreReducedByOneParticipant) {
+  auto [begin, end] = AllReduceSliceBounds(100, sizeof(float), 8, 0);
+  EXPECT_EQ(begin, 0);
+  EXPECT_EQ(end, 100);
+  std::tie(begin, end) = AllReduceSliceBounds(100, sizeof(float), 8, 1);
+  EXPECT_EQ(begin, end);
+}
+
+TEST(AllReduceKernelsTest, SumInPlace) {
+  constexpr int kNumParticipants = 3;
+  constexpr int64_t kElementCount = 5000;
+  std::vector<std::vector<int32_t>> buffers(kNumParticipants);
+  std::vector<const int32_t*> inputs;
+  std::vector<int32_t*> outputs;
+  for (int p = 0; p < kNumParticipants; ++p) {
+    buffers[p].resize(kElementCount);
+    std::iota(buffers[p].begin(), buffers[p].end(), p);
+    inputs.push_back(buffers[p].data());
+    outputs.push_back(buffers[p].data());
+  }
+  AllReduceSlice<int32_t>(ReductionKind::SUM, inputs, outputs, 0,
+                          kElementCount);
+  for (int p = 0; p < kNumParticipants; ++p) {
+    for (int64_t i = 0; i < kElementCount; ++i) {
+      ASSERT_EQ(buffers[p][i], 3 * i + 3);
+    }
+  }
+}
+
+TEST(AllReduceKernelsTest, MaxOfNegativeFloats) {
+  std::vector<float> a = {-3.0f, -1.0f};
+  std::vector<float> b = {-2.0f, -5.0f};
+  std::vector<float> out_a(2), out_b(2);
+  std::vector<const float*> inputs = {a.data(), b.data()};
+  std::vector<float*> outputs = {out_a.data(), out_b.data()};
+  AllReduceSlice<float>(ReductionKind::MAX, inputs, outputs, 0, 2);
+  EXPECT_EQ(out_a, std::vector<float>({-2.0f, -1.0f}));
+  EXPECT_EQ(out_b, out_a);
+}
+
+TEST(AllReduceKernelsTest, SignedSumWrapsAround) {
+  std::vector<int8_t> a = {127};
+  std::vector<int8_t> b = {1};
+  std::vector<int8_t> out(1);
+  std::vector<const int8_t*> inputs = {a.data(), b.data()};
+  std::vector<int8_t*> outputs = {out.data()};
+  AllReduceSlice<int8_t>(ReductionKind::SUM, inputs, outputs, 0, 1);
+  EXPECT_EQ(out[0], -128);
+}
+
+// The previous implementation, where the last participant to arrive reduced
+// every element on its own: it starts from the identity of the reduction,
+// switches on the reduction kind for every element and input, and copies the
+// result to all outputs before moving on to the next element.
+template <typename T>
+void PreviousAllReduce(ReductionKind reduction_kind,
+                       absl::Span<const T* const> inputs,
+                       absl::Span<T* const> outputs, int64_t element_count) {
+  for (int64_t idx = 0; idx < element_count; ++idx) {
+    T out;
+    switch (reduction_kind) {
+      case ReductionKind::SUM:
+        out = 0;
+        break;
+      case ReductionKind::PRODUCT:
+        out = 1;
+        break;
+      case ReductionKind::MIN:
+        out = std::numeric_limits<T>::max();
+        break;
+      case ReductionKind::MAX:
+        out = std::numeric_limits<T>::min();
+        break;
+    }
+    for (const T* input : inputs) {
+      switch (reduction_kind) {
+        case ReductionKind::SUM:
+          out = out + input[idx];
+          break;
+        case ReductionKind::PRODUCT:
+          out = out * input[idx];
+          break;
+        case ReductionKind::MIN:
+          out = std::min(out, input[idx]);
+          break;
+        case ReductionKind::MAX:
+          out = std::max(out, input[idx]);
+          break;
+      }
+    }
+    for (T* output : outputs) {
+      output[idx] = out;
+    }
+  }
+}
+
+// Compares the previous implementation against every participant reducing its
+// own slice.
+void BM_AllReduce(::testing::benchmark::State& state) {
+  const int num_participants = state.range(0);
+  const int64_t element_count = state.range(1);
+  const bool reduce_scatter = state.range(2);
+
+  std::vector<std::vector<float>> inputs(num_participants);
+  std::vector<std::vector<float>> outputs(num_participants);
+  std::vector<const float*> input_ptrs;
+  std::vector<float*> output_ptrs;
+  for (int p = 0; p < num_participants; ++p) {
+    inputs[p].assign(element_count, 1.0f + p);
+    outputs[p].resize(element_count);
+    input_ptrs.push_back(inputs[p].data());
+    output_ptrs.push_back(outputs[p].data());
+  }
+
+  tsl::thread::ThreadPool pool(tsl::Env::Default(), "all_reduce_benchmark",
+                               num_participants);
+  for (auto s : state) {
+    if (!reduce_scatter) {
+      PreviousAllReduce<float>(ReductionKind::SUM, input_ptrs, output_ptrs,
+                               element_count);
+      continue;
+    }
+    absl::BlockingCounter done(num_participants);
+    for (int rank = 0; rank < num_participants; ++rank) {
+      pool.Schedule([&, rank] {
+        auto [begin, end] = AllReduceSliceBounds(element_count, sizeof(float),
+                                                 num_participants, rank);
+        AllReduceSlice<float>(ReductionKind::SUM, input_ptrs, output_ptrs,
+                              begin, end);
+        done.DecrementCount();
+      });
+    }
+    done.Wait();
+  }
+  state.SetBytesProcessed(state.iterations() * num_participants *
+                          element_count * sizeof(float));
+}
+
+BENCHMARK(BM_AllReduce)
+    ->ArgNames({"participants", "elements", "reduce_scatter"})
+    ->ArgsProduct({{2, 8, 32}, {1 << 10, 1 << 16, 1 << 22}, {0, 1}});
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
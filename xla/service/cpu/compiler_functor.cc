@@ -200,8 +200,11 @@ llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> CompilerFunctor::operator()(
   target_machine_->addPassesToEmitMC(codegen_passes, mc_context, ostream);
   codegen_passes.run(module);
 
+  // Name the object after the module, which tells apart the objects of a
+  // module that was split for parallel compilation.
   std::unique_ptr<llvm::MemoryBuffer> memory_buffer(
-      new llvm::SmallVectorMemoryBuffer(std::move(stream_buffer)));
+      new llvm::SmallVectorMemoryBuffer(std::move(stream_buffer),
+                                        module.getModuleIdentifier()));
 
   if (post_codegen_hook_) {
     llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>> obj_file =
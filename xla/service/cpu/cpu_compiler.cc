@@ -18,6 +18,8 @@ limitations under the License.
 #include <stddef.h>
 #include <string.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
@@ -35,11 +37,20 @@ limitations under the License.
 
 #include "absl/base/call_once.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Mangler.h"
 #include "llvm/IR/Module.h"
@@ -48,12 +59,16 @@ limitations under the License.
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/CodeGen.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/MemoryBufferRef.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/TargetParser/Host.h"
 #include "llvm/TargetParser/Triple.h"
 #include "llvm/TargetParser/X86TargetParser.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "mlir/Conversion/AffineToStandard/AffineToStandard.h"  // from @llvm-project
 #include "mlir/Conversion/ReconcileUnrealizedCasts/ReconcileUnrealizedCasts.h"  // from @llvm-project
 #include "mlir/Dialect/Affine/IR/AffineOps.h"  // from @llvm-project
@@ -116,12 +131,15 @@ limitations under the License.
 #include "xla/service/cpu/compiler_functor.h"
 #include "xla/service/cpu/conv_canonicalization.h"
 #include "xla/service/cpu/cpu_executable.h"
+#include "xla/service/cpu/cpu_float_support.h"
 #include "xla/service/cpu/cpu_instruction_fusion.h"
 #include "xla/service/cpu/cpu_layout_assignment.h"
 #include "xla/service/cpu/cpu_options.h"
+#include "xla/service/cpu/cpu_rematerialization.h"
 #include "xla/service/cpu/cpu_shape_verifier.h"
 #include "xla/service/cpu/dot_op_emitter.h"
 #include "xla/service/cpu/hlo_xla_runtime_pipeline.h"
+#include "xla/service/cpu/host_throughput.h"
 #include "xla/service/cpu/ir_emitter.h"
 #include "xla/service/cpu/parallel_task_assignment.h"
 #include "xla/service/cpu/runtime/collectives.h"
@@ -190,8 +208,10 @@ limitations under the License.
 #include "xla/translate/hlo_to_mhlo/hlo_to_mlir_hlo.h"
 #include "xla/util.h"
 #include "xla/xla_data.pb.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/status.h"
+#include "tsl/platform/threadpool.h"
 
 namespace {
 
@@ -614,8 +634,13 @@ Status CpuCompiler::RunHloPassesThroughLayoutAssn(
   HloPassPipeline pipeline("HLO passes through layout assignment");
   AddHloVerifier(&pipeline, allow_sparse_shapes_);
 
-  pipeline.AddPass<OperandUpcaster>();
-  pipeline.AddPass<ResultCaster>();
+  // Mixed precision dots keep their operands until DotDecomposer has put them
+  // in canonical form, after which we can tell whether we can emit them as is.
+  auto not_mixed_precision_dot = [](const HloInstruction* hlo) {
+    return !IsMixedPrecisionDot(*hlo);
+  };
+  pipeline.AddPass<OperandUpcaster>(not_mixed_precision_dot);
+  pipeline.AddPass<ResultCaster>(not_mixed_precision_dot);
 
   // Expand random number generation.
   pipeline.AddPass<RngExpander>();
@@ -646,6 +671,11 @@ Status CpuCompiler::RunHloPassesThroughLayoutAssn(
   pipeline.AddPass<CallInliner>(/*single_call_site=*/true);
   pipeline.AddPass<BatchDotSimplification>();
   pipeline.AddPass<DotDecomposer>();
+  pipeline.AddPass<OperandUpcaster>(
+      [=](const HloInstruction* hlo) {
+        return is_mlir_compile || !DotImplementationCanHandleMixedPrecision(
+                                      *hlo, *target_machine_features);
+      });
   // Promote BF16 all-reduce to F32.
   const std::pair<PrimitiveType, PrimitiveType> ar_promoted_types[] = {
       {BF16, F32}};
@@ -653,8 +683,12 @@ Status CpuCompiler::RunHloPassesThroughLayoutAssn(
   // Convert BF16 and F8 operations to F32 and F16 respectively so that the CPU
   // backend can support BF16/F8 operations without directly implementing a
   // BF16/F8 lowering for most ops.
+  // The runtime GEMMs accumulate bf16 products in f32, so dots that call into
+  // them keep their bf16 operands.
   FloatSupport bf16_support(BF16);
-  pipeline.AddPass<FloatNormalization>(&bf16_support);
+  CpuFloatSupport cpu_bf16_support(BF16, target_machine_features);
+  pipeline.AddPass<FloatNormalization>(is_mlir_compile ? &bf16_support
+                                                       : &cpu_bf16_support);
   FloatSupport f8e5m2_support(F8E5M2);
   pipeline.AddPass<FloatNormalization>(&f8e5m2_support);
   FloatSupport f8e4m3fn_support(F8E4M3FN);
@@ -759,7 +793,16 @@ Status CpuCompiler::RunHloPassesThroughLayoutAssn(
   // support libcalls. Disable this for now.
   if (!is_mlir_compile) {
     pipeline.AddPass<TopkRewriter>([](const HloSortInstruction* sort, int64_t) {
-      return sort->operand(0)->shape().element_type() == F32;
+      switch (sort->operand(0)->shape().element_type()) {
+        case BF16:
+        case F16:
+        case F32:
+        case S32:
+        case U32:
+          return true;
+        default:
+          return false;
+      }
     });
   }
   pipeline.AddPass<IndexedArrayAnalysisPrinterPass>();
@@ -823,7 +866,16 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
   pipeline.AddPass<ReshapeDecomposer>();
 
   // Add a fusion pass now that layout assignment is done.
-  pipeline.AddPass<CpuInstructionFusion>();
+  const std::string& fusion_profile_path =
+      module->config().debug_options().xla_cpu_fusion_profile_path();
+  if (fusion_profile_path.empty()) {
+    pipeline.AddPass<CpuInstructionFusion>();
+  } else {
+    ProfiledInstructionsProto fusion_profile;
+    TF_RETURN_IF_ERROR(tsl::ReadTextProto(
+        tsl::Env::Default(), fusion_profile_path, &fusion_profile));
+    pipeline.AddPass<CpuInstructionFusion>(std::move(fusion_profile));
+  }
 
   // The LayoutAssignment pass may leave behind kCopy instructions which are
   // duplicate or NOPs, so remove them with algebraic simplification and CSE.
@@ -849,18 +901,36 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
   }();
 
   // Outline ops in the entry computation into calls to subcomputations.
-  const int max_parallelism =
-      module->config().intra_op_parallelism_threads() > 0
-          ? module->config().intra_op_parallelism_threads()
-          : tsl::port::NumSchedulableCPUs();
   if (!is_aot_compile) {
     // Run ParallelTaskAssigner to assign parallel tasks to HLOs in module.
-    // Note this is not run for AOT because it would bring in thread pool
-    // and thread synchronization dependencies which would likely increase
-    // binary size (and most AOT applications are single-threaded).
-    // TODO(b/29630486) Support multi-threaded AOT.
+    const int max_parallelism =
+        module->config().intra_op_parallelism_threads() > 0
+            ? module->config().intra_op_parallelism_threads()
+            : tsl::port::NumSchedulableCPUs();
+    // The host is not measured here, since that is slow and would make task
+    // assignment differ between processes. It is read from a per-machine
+    // file if there is one.
+    HostThroughput host_throughput = DefaultHostThroughput();
+    const std::string& host_throughput_path =
+        module->config().debug_options().xla_cpu_host_throughput_path();
+    if (!host_throughput_path.empty()) {
+      TF_ASSIGN_OR_RETURN(host_throughput,
+                          LoadOrMeasureHostThroughput(host_throughput_path));
+    }
     pipeline.AddPass<ParallelTaskAssigner>(
-        max_parallelism, ShapeSizeBytesFunction(), target_machine_features);
+        max_parallelism, ShapeSizeBytesFunction(), target_machine_features,
+        host_throughput);
+  } else if (std::optional<int> aot_parallelism =
+                 options::AotParallelism(module->config())) {
+    // AOT executables are single-threaded unless requested, since parallel
+    // loops link in the fork/join runtime and most AOT applications are
+    // single-threaded. The machine they run on is not known here, so the
+    // thread count comes from the flag, and the fixed default throughput is
+    // assumed rather than that of the build host, which keeps AOT builds
+    // reproducible.
+    pipeline.AddPass<ParallelTaskAssigner>(
+        *aot_parallelism, ShapeSizeBytesFunction(), target_machine_features,
+        DefaultHostThroughput());
   }
   // Copy insertion should be performed immediately before IR emission to
   // avoid inserting unnecessary copies (later pass adds an instruction which
@@ -871,6 +941,13 @@ Status CpuCompiler::RunHloPassesAfterLayoutAssn(
   pipeline.AddPass<HloDCE>();
   pipeline.AddPass<CopyInsertion>();
   pipeline.AddPass<HloDCE>();
+  // Rematerialization works on the final graph, which it schedules for
+  // emission.
+  if (std::optional<int64_t> memory_limit_bytes =
+          options::MemoryLimitBytes(module->config())) {
+    pipeline.AddPass<CpuRematerialization>(*memory_limit_bytes,
+                                           ShapeSizeBytesFunction());
+  }
   return pipeline.Run(module).status();
 }
 
@@ -892,6 +969,20 @@ int64_t memory_alignment(LogicalBuffer::Color) {
   return cpu_function_runtime::MinAlign();
 }
 
+// Selects an order for emitting the HLO instructions for each computation. If
+// the module has a memory limit, it was already scheduled by
+// CpuRematerialization and that schedule is kept, as the peak memory only fits
+// the limit in that order.
+StatusOr<HloSchedule> ScheduleForEmission(
+    const HloModule* module, const LogicalBuffer::SizeFunction& size_function,
+    const ModuleSchedulerAlgorithm& algorithm = {}) {
+  if (module->has_schedule() &&
+      options::MemoryLimitBytes(module->config()).has_value()) {
+    return module->schedule();
+  }
+  return ScheduleModule(module, size_function, algorithm);
+}
+
 llvm::TargetOptions CompilerTargetOptions(
     const HloModuleConfig& module_config) {
   llvm::TargetOptions target_options;
@@ -915,6 +1006,19 @@ llvm::CodeGenOpt::Level CodeGenOptLevel(const HloModuleConfig& module_config) {
   }
 }
 
+// The LLVM modules split off for parallel compilation are named with this
+// prefix followed by their shard, which also tells apart their dumps.
+constexpr absl::string_view kSplitModuleNamePrefix = "__compute_module.";
+
+// Returns the suffix of the IR and object file dumps of the LLVM module named
+// `module_name`.
+absl::string_view DumpSuffixForModule(absl::string_view module_name) {
+  if (!absl::ConsumePrefix(&module_name, kSplitModuleNamePrefix)) {
+    return "";
+  }
+  return module_name;
+}
+
 std::pair<LLVMCompiler::ModuleHook, LLVMCompiler::ModuleHook> GetIRModuleHooks(
     const HloModule& hlo_module,
     const LLVMCompiler::ModuleHook& user_pre_optimization_hook,
@@ -933,7 +1037,9 @@ std::pair<LLVMCompiler::ModuleHook, LLVMCompiler::ModuleHook> GetIRModuleHooks(
     if (user_hook) {
       user_hook(llvm_module);
     }
-    llvm_ir::DumpIrIfEnabled(*hlo_module_ptr, llvm_module, optimized);
+    llvm_ir::DumpIrIfEnabled(
+        *hlo_module_ptr, llvm_module, optimized,
+        DumpSuffixForModule(llvm_module.getModuleIdentifier()));
   };
   return {[hook](const llvm::Module& llvm_module) {
             return hook(/*optimized=*/false, llvm_module);
@@ -958,6 +1064,71 @@ Status VerifyLlvmModule(const llvm::Module& llvm_module) {
   return OkStatus();
 }
 
+// Splits `llvm_module` into up to `num_shards` modules that can be optimized
+// and compiled concurrently. Each of them gets its own context, as compiling a
+// module holds the lock of its context.
+//
+// Local symbols are preserved, which keeps the internal functions of nested
+// computations (reducers, scatter and map callees, ...) in the module of their
+// callers, where they can still be inlined into the loops that call them.
+StatusOr<std::vector<llvm::orc::ThreadSafeModule>>
+SplitModuleForParallelCompilation(llvm::Module& llvm_module, int num_shards) {
+  XLA_SCOPED_LOGGING_TIMER("CpuCompiler - Splitting LLVM module");
+  int num_functions = 0;
+  for (const llvm::Function& function : llvm_module.functions()) {
+    if (!function.isDeclaration()) {
+      ++num_functions;
+    }
+  }
+
+  // The split leaves only declarations of a constant in the modules that use
+  // but don't define it. Give small constants back their initializer there, so
+  // that they can still be folded; large ones would be duplicated in memory.
+  constexpr uint64_t kMaxCopiedConstantBytes = 1024;
+  llvm::DenseMap<llvm::StringRef, llvm::Constant*> constant_initializers;
+  for (llvm::GlobalVariable& global : llvm_module.globals()) {
+    if (global.hasName() && global.isConstant() && global.hasInitializer() &&
+        llvm::isa<llvm::ConstantData>(global.getInitializer()) &&
+        llvm_module.getDataLayout().getTypeAllocSize(global.getValueType()) <=
+            kMaxCopiedConstantBytes) {
+      constant_initializers[global.getName()] = global.getInitializer();
+    }
+  }
+
+  std::vector<llvm::SmallVector<char, 0>> bitcodes;
+  llvm::SplitModule(
+      llvm_module, std::max(1, std::min(num_shards, num_functions)),
+      [&](std::unique_ptr<llvm::Module> module) {
+        for (llvm::GlobalVariable& global : module->globals()) {
+          auto it = constant_initializers.find(global.getName());
+          if (global.isDeclaration() && it != constant_initializers.end()) {
+            global.setInitializer(it->second);
+            global.setLinkage(llvm::GlobalValue::InternalLinkage);
+          }
+        }
+        llvm::raw_svector_ostream stream(bitcodes.emplace_back());
+        llvm::WriteBitcodeToFile(*module, stream);
+      },
+      /*PreserveLocals=*/true);
+
+  std::vector<llvm::orc::ThreadSafeModule> modules;
+  for (int i = 0; i < bitcodes.size(); ++i) {
+    auto context = std::make_unique<llvm::LLVMContext>();
+    llvm::Expected<std::unique_ptr<llvm::Module>> module =
+        llvm::parseBitcodeFile(
+            llvm::MemoryBufferRef(
+                llvm::StringRef(bitcodes[i].data(), bitcodes[i].size()), ""),
+            *context);
+    if (!module) {
+      return InternalError("Failed to parse split LLVM module: %s",
+                           llvm::toString(module.takeError()));
+    }
+    (*module)->setModuleIdentifier(absl::StrCat(kSplitModuleNamePrefix, i));
+    modules.emplace_back(std::move(*module), std::move(context));
+  }
+  return modules;
+}
+
 Status CreateHloProfilingArtifacts(
     const HloModule& module,
     absl::flat_hash_map<const HloInstruction*, int64_t>*
@@ -1015,10 +1186,11 @@ StatusOr<std::unique_ptr<BufferAssignment>> CpuCompiler::AssignBuffers(
   // Select an order for emitting the HLO instructions for each computation.
   // Using this sequence enables tighter buffer liveness analysis and reduced
   // memory usage (as compared to using DependencyHloOrdering).
-  TF_ASSIGN_OR_RETURN(HloSchedule schedule,
-                      ScheduleModule(module, BufferSizeBytesFunction(),
-                                     ComputationSchedulerToModuleScheduler(
-                                         DFSMemoryScheduler)));
+  TF_ASSIGN_OR_RETURN(
+      HloSchedule schedule,
+      ScheduleForEmission(
+          module, BufferSizeBytesFunction(),
+          ComputationSchedulerToModuleScheduler(DFSMemoryScheduler)));
   TF_RETURN_IF_ERROR(module->set_schedule(std::move(schedule)));
 
   // Run buffer allocation on the HLO graph.
@@ -1036,14 +1208,17 @@ namespace {
 
 // Post-compilation callback functor for use by SimpleOrcJIT.
 //
-// Dumps machine code if dumping is enabled for the module.
+// Dumps machine code if dumping is enabled for the module, and keeps a copy of
+// it in `obj_files` if that is not null.
 struct OrcJITPostCompilationHook {
-  // Gets an std::function that implements this hook.
+  // Gets an std::function that implements this hook. The hook may be called
+  // concurrently when modules are compiled in parallel.
   static std::function<void(const llvm::object::ObjectFile& obj_file)> Create(
-      const HloModule* module) {
+      const HloModule* module, std::vector<std::string>* obj_files = nullptr) {
     // This struct is not copyable, but std::functions must be.  So to create an
     // std::function out of this struct, we have to wrap it in a shared_ptr.
-    auto wrapped = std::make_shared<OrcJITPostCompilationHook>(module);
+    auto wrapped =
+        std::make_shared<OrcJITPostCompilationHook>(module, obj_files);
     return [wrapped](const llvm::object::ObjectFile& obj_file) {
       (*wrapped)(obj_file);
     };
@@ -1051,20 +1226,31 @@ struct OrcJITPostCompilationHook {
 
   // Constructor can't be private because we want to call it from
   // std::make_shared, but users should call Create() instead.
-  explicit OrcJITPostCompilationHook(const HloModule* module)
-      : module(module) {}
+  OrcJITPostCompilationHook(const HloModule* module,
+                            std::vector<std::string>* obj_files)
+      : module(module), obj_files(obj_files) {}
 
  private:
   void operator()(const llvm::object::ObjectFile& obj_file) {
+    if (obj_files != nullptr) {
+      absl::MutexLock lock(&mu);
+      obj_files->emplace_back(obj_file.getData().data(),
+                              obj_file.getData().size());
+    }
     if (!DumpingEnabledForHloModule(*module)) {
       return;
     }
-    DumpToFileInDir(*module, /*file_prefix=*/"", /*file_suffix=*/"o",
+    const std::string file_name = obj_file.getFileName().str();
+    absl::string_view suffix = DumpSuffixForModule(file_name);
+    DumpToFileInDir(*module, /*file_prefix=*/"",
+                    suffix.empty() ? "o" : absl::StrCat(suffix, ".o"),
                     absl::string_view(obj_file.getData().data(),
                                       obj_file.getData().size()));
   }
 
   const HloModule* module;
+  absl::Mutex mu;
+  std::vector<std::string>* obj_files ABSL_GUARDED_BY(mu);
 };
 
 void InitializeLLVMCommandLineOptions(const HloModuleConfig& config) {
@@ -1282,6 +1468,17 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
   auto llvm_module =
       std::make_unique<llvm::Module>("__compute_module", *llvm_context);
 
+  // Executables are only exported to the persistent compilation cache, so we
+  // only keep the object files the JIT links when there is one. Profiling
+  // artifacts are not serialized, so profiled executables are not exported.
+  const bool keep_obj_files =
+      !module->config()
+           .debug_options()
+           .xla_cpu_persistent_cache_dir()
+           .empty() &&
+      !module->config().hlo_profiling_enabled();
+  std::vector<std::string> obj_files;
+
   auto jit = SimpleOrcJIT::Create(
       CompilerTargetOptions(module->config()),
       CodeGenOptLevel(module->config()),
@@ -1290,7 +1487,8 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
       options::SlpVectorizerDisabled(module->config()),
       llvm_ir::GetCpuFastMathFlags(module->config()), pre_optimization_ir_hook,
       post_optimization_ir_hook,
-      OrcJITPostCompilationHook::Create(module.get()));
+      OrcJITPostCompilationHook::Create(module.get(),
+                                        keep_obj_files ? &obj_files : nullptr));
   if (!jit) {
     return InternalError("Creating JIT failed: %s",
                          llvm::toString(jit.takeError()));
@@ -1319,10 +1517,17 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
   // Select an order for emitting the HLO instructions for each
   // computation. Using this sequence enables tighter buffer liveness analysis
   // and reduced memory usage (as compared to using DependencyHloOrdering).
-  TF_ASSIGN_OR_RETURN(HloSchedule schedule,
-                      ScheduleModule(module.get(), BufferSizeBytesFunction(),
-                                     ComputationSchedulerToModuleScheduler(
-                                         DFSMemoryScheduler)));
+  TF_ASSIGN_OR_RETURN(
+      HloSchedule schedule,
+      ScheduleForEmission(
+          module.get(), BufferSizeBytesFunction(),
+          ComputationSchedulerToModuleScheduler(DFSMemoryScheduler)));
+
+  // An exported executable assigns its buffers again when it is loaded, with
+  // the schedule saved in its module.
+  if (keep_obj_files) {
+    TF_RETURN_IF_ERROR(module->set_schedule(schedule));
+  }
 
   // Run buffer allocation on the HLO graph.
   TF_ASSIGN_OR_RETURN(
@@ -1395,9 +1600,23 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
   TF_RETURN_IF_ERROR(VerifyLlvmModule(*llvm_module));
 
   // JIT compile the LLVM IR module to in-memory machine code.
-  llvm::orc::ThreadSafeModule thread_safe_module(std::move(llvm_module),
-                                                 std::move(llvm_context));
-  cantFail((*jit)->AddModule(std::move(thread_safe_module)));
+  if (std::optional<int> parallelism =
+          options::CodegenParallelism(module->config())) {
+    TF_ASSIGN_OR_RETURN(
+        std::vector<llvm::orc::ThreadSafeModule> split_modules,
+        SplitModuleForParallelCompilation(*llvm_module, *parallelism));
+    tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "xla_cpu_codegen",
+                                        *parallelism);
+    if (llvm::Error error = (*jit)->AddModulesInParallel(
+            std::move(split_modules), &thread_pool)) {
+      return InternalError("Compiling LLVM modules failed: %s",
+                           llvm::toString(std::move(error)));
+    }
+  } else {
+    llvm::orc::ThreadSafeModule thread_safe_module(std::move(llvm_module),
+                                                   std::move(llvm_context));
+    cantFail((*jit)->AddModule(std::move(thread_safe_module)));
+  }
 
   auto cpu_executable = std::make_unique<CpuExecutable>(
       std::move(*jit), std::move(assignment), std::move(module), function_name,
@@ -1406,6 +1625,9 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
   if (embed_ir_in_executable) {
     cpu_executable->set_ir_module_string(ir_module_string);
   }
+  if (keep_obj_files) {
+    cpu_executable->set_obj_files(std::move(obj_files));
+  }
 
   // Dump computation proto state and buffer assignment for
   // GetCompiledMemoryStats results.
@@ -1418,6 +1640,79 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
   return cpu_executable;
 }
 
+CpuLegacyAotCompilationResult::CpuLegacyAotCompilationResult(
+    HloModuleProto hlo, absl::Span<const std::string> obj_files,
+    std::string_view entry_function_name) {
+  *legacy_cpu_executable_.mutable_hlo_module_proto() = std::move(hlo);
+  for (const std::string& obj_file : obj_files) {
+    legacy_cpu_executable_.add_obj_files(obj_file);
+  }
+  legacy_cpu_executable_.set_entry_function_name(
+      std::string(entry_function_name));
+}
+
+StatusOr<std::unique_ptr<Executable>>
+CpuLegacyAotCompilationResult::LoadExecutable(
+    Compiler* compiler, se::StreamExecutor* executor) const {
+  TF_ASSIGN_OR_RETURN(HloModuleConfig hlo_module_config,
+                      HloModule::CreateModuleConfigFromProto(
+                          legacy_cpu_executable_.hlo_module_proto(),
+                          GetDebugOptionsFromFlags()));
+  TF_ASSIGN_OR_RETURN(
+      std::unique_ptr<HloModule> module,
+      HloModule::CreateFromProto(legacy_cpu_executable_.hlo_module_proto(),
+                                 hlo_module_config));
+  TF_RET_CHECK(module->has_schedule())
+      << "Exported module " << module->name() << " has no schedule";
+
+  // The object files address the buffers by their allocation indices, so we
+  // must assign them exactly like the compilation did.
+  TF_ASSIGN_OR_RETURN(
+      std::unique_ptr<BufferAssignment> assignment,
+      BufferAssigner::Run(
+          module.get(),
+          std::make_unique<SequentialHloOrdering>(module->schedule()),
+          compiler->BufferSizeBytesFunction(), memory_alignment,
+          /*allocate_buffers_for_constants=*/true));
+
+  auto jit = SimpleOrcJIT::Create(
+      CompilerTargetOptions(module->config()),
+      CodeGenOptLevel(module->config()),
+      options::OptimizeForSizeRequested(module->config()),
+      module->config().debug_options().xla_llvm_disable_expensive_passes(),
+      options::SlpVectorizerDisabled(module->config()),
+      llvm_ir::GetCpuFastMathFlags(module->config()),
+      /*pre_optimization_hook=*/nullptr, /*post_optimization_hook=*/nullptr,
+      /*post_codegen_hook=*/nullptr);
+  if (!jit) {
+    return InternalError("Creating JIT failed: %s",
+                         llvm::toString(jit.takeError()));
+  }
+  for (int i = 0; i < legacy_cpu_executable_.obj_files_size(); ++i) {
+    std::unique_ptr<llvm::MemoryBuffer> obj_file =
+        llvm::MemoryBuffer::getMemBufferCopy(
+            legacy_cpu_executable_.obj_files(i),
+            absl::StrCat(module->name(), ".", i));
+    if (llvm::Error error = (*jit)->AddObjFile(std::move(obj_file))) {
+      return InternalError("Loading object file failed: %s",
+                           llvm::toString(std::move(error)));
+    }
+  }
+
+  auto cpu_executable = std::make_unique<CpuExecutable>(
+      std::move(*jit), std::move(assignment), std::move(module),
+      legacy_cpu_executable_.entry_function_name(),
+      /*hlo_profile_printer_data=*/nullptr, /*hlo_profile_index_map=*/nullptr);
+
+  auto hlo_proto = std::make_unique<HloProto>();
+  *hlo_proto->mutable_hlo_module() = cpu_executable->module().ToProto();
+  *hlo_proto->mutable_buffer_assignment() =
+      cpu_executable->buffer_assignment().ToProto();
+  cpu_executable->set_hlo_proto(std::move(hlo_proto));
+
+  return std::unique_ptr<Executable>(std::move(cpu_executable));
+}
+
 namespace {
 
 StatusOr<std::unique_ptr<XlaRuntimeCpuExecutable>> GetXlaRuntimeCpuExecutable(
@@ -1455,7 +1750,7 @@ CpuCompiler::CompileXlaRuntimeCpuExecutable(
   // and reduced memory usage (as compared to using DependencyHloOrdering).
   TF_ASSIGN_OR_RETURN(
       HloSchedule schedule,
-      ScheduleModule(
+      ScheduleForEmission(
           hlo_module.get(), BufferSizeBytesFunction(),
           ComputationSchedulerToModuleScheduler(DFSMemoryScheduler)));
 
@@ -1641,8 +1936,9 @@ CpuCompiler::CompileAheadOfTime(std::unique_ptr<HloModuleGroup> module_group,
         RunHloPasses(module, /*is_aot_compile=*/true, target_machine.get(),
                      /*is_mlir_compile=*/options.use_mlir_hlo_lowering()));
 
-    TF_ASSIGN_OR_RETURN(HloSchedule schedule,
-                        ScheduleModule(module, BufferSizeBytesFunction()));
+    TF_ASSIGN_OR_RETURN(
+        HloSchedule schedule,
+        ScheduleForEmission(module, BufferSizeBytesFunction()));
 
     // Run buffer analysis on the HLO graph. This analysis figures out which
     // temporary buffers are required to run the computation.
@@ -1821,6 +2117,22 @@ HloCostAnalysis::ShapeSizeFunction CpuCompiler::ShapeSizeBytesFunction() const {
                               : CpuExecutable::ShapeSizeBytes;
 }
 
+StatusOr<std::unique_ptr<AotCompilationResult>>
+CpuCompiler::LoadAotCompilationResult(
+    const std::string& serialized_aot_result) {
+  XlaRuntimeCpuExecutableProto proto;
+  if (!proto.ParseFromString(serialized_aot_result)) {
+    return InternalError("Failed to parse serialized CPU executable.");
+  }
+  if (proto.has_legacy_executable()) {
+    return std::unique_ptr<AotCompilationResult>(
+        std::make_unique<CpuLegacyAotCompilationResult>(
+            std::move(*proto.mutable_legacy_executable())));
+  }
+  return std::unique_ptr<AotCompilationResult>(
+      std::make_unique<CpuXlaRuntimeAotCompilationResult>(std::move(proto)));
+}
+
 StatusOr<std::unique_ptr<AotCompilationResult>> CpuCompiler::Export(
     Executable* executable) const {
   auto* cpu_executable = tensorflow::down_cast<CpuExecutable*>(executable);
@@ -1828,6 +2140,18 @@ StatusOr<std::unique_ptr<AotCompilationResult>> CpuCompiler::Export(
     return Internal("Could not downcast Executable to CpuExecutable");
 
   HloModuleProto module_proto = cpu_executable->module().ToProto();
+  if (!cpu_executable->IsXlaRuntime()) {
+    if (cpu_executable->obj_files().empty()) {
+      return FailedPrecondition(
+          "Executable %s was compiled without keeping its object files, which "
+          "the JIT only does when xla_cpu_persistent_cache_dir is set",
+          cpu_executable->module().name());
+    }
+    return std::unique_ptr<AotCompilationResult>(
+        std::make_unique<CpuLegacyAotCompilationResult>(
+            std::move(module_proto), cpu_executable->obj_files(),
+            cpu_executable->entry_function_name()));
+  }
   TF_ASSIGN_OR_RETURN(auto obj_file, cpu_executable->GetObjFile());
   TF_ASSIGN_OR_RETURN(auto mlir_module, cpu_executable->GetMlirModule());
   TF_ASSIGN_OR_RETURN(XlaFrameworkMapping xla_framework_mapping,
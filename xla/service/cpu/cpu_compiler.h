@@ -19,8 +19,10 @@ limitations under the License.
 #include <memory>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "llvm/Target/TargetMachine.h"
 #include "xla/cpu_function_runtime.h"
 #include "xla/hlo/ir/hlo_module.h"
@@ -119,6 +121,30 @@ class CpuXlaRuntimeAotCompilationResult : public AotCompilationResult {
   XlaRuntimeCpuExecutableProto xla_runtime_cpu_executable_;
 };
 
+// The serialized form of an executable compiled by the legacy JIT: the object
+// files the JIT linked, which are linked again when loading it.
+class CpuLegacyAotCompilationResult : public AotCompilationResult {
+ public:
+  CpuLegacyAotCompilationResult(HloModuleProto hlo,
+                                absl::Span<const std::string> obj_files,
+                                std::string_view entry_function_name);
+
+  explicit CpuLegacyAotCompilationResult(LegacyCpuExecutableProto executable)
+      : legacy_cpu_executable_(std::move(executable)) {}
+
+  StatusOr<std::string> SerializeAsString() const override {
+    XlaRuntimeCpuExecutableProto proto;
+    *proto.mutable_legacy_executable() = legacy_cpu_executable_;
+    return proto.SerializeAsString();
+  }
+
+  StatusOr<std::unique_ptr<Executable>> LoadExecutable(
+      Compiler* compiler, se::StreamExecutor* executor) const override;
+
+ private:
+  LegacyCpuExecutableProto legacy_cpu_executable_;
+};
+
 class CpuAotCompilationResult : public AotCompilationResult {
  public:
   CpuAotCompilationResult(
@@ -197,9 +223,7 @@ class CpuCompiler : public LLVMCompiler {
   // Returns a (deserialized) AotCompilationResult from a serialized
   // AotCompilationResult.
   StatusOr<std::unique_ptr<AotCompilationResult>> LoadAotCompilationResult(
-      const std::string& serialized_aot_result) override {
-    return CpuXlaRuntimeAotCompilationResult::FromString(serialized_aot_result);
-  }
+      const std::string& serialized_aot_result) override;
 
   StatusOr<std::unique_ptr<CpuExecutable>> CompileXlaRuntimeCpuExecutable(
       std::unique_ptr<HloModule> module);
@@ -69,7 +69,8 @@ CpuExecutable::CpuExecutable(
                  std::move(hlo_profile_index_map)),
       jit_(std::move(jit)),
       assignment_(std::move(assignment)),
-      module_name_(entry_function_name) {
+      module_name_(entry_function_name),
+      entry_function_name_(entry_function_name) {
   if (assignment_) {
     buffer_assignment_ =
         std::make_shared<BufferAssignmentProto>(assignment_->ToProto());
@@ -190,6 +190,18 @@ class CpuExecutable : public Executable {
     ir_module_string_ = ir_module_string;
   }
 
+  // The object files the JIT linked, which are only kept when the executable
+  // is to be exported.
+  absl::Span<const std::string> obj_files() const { return obj_files_; }
+
+  void set_obj_files(std::vector<std::string> obj_files) {
+    obj_files_ = std::move(obj_files);
+  }
+
+  const std::string& entry_function_name() const {
+    return entry_function_name_;
+  }
+
   static int64_t ShapeSizeBytes(const Shape& shape);
 
   // Type of the computation function we expect in the JIT.
@@ -278,6 +290,9 @@ class CpuExecutable : public Executable {
   // Entry function name for the computation.
   const std::string entry_function_name_;
 
+  // See obj_files().
+  std::vector<std::string> obj_files_;
+
   // If not null, XLA Runtime is enabled.
   std::unique_ptr<XlaRuntimeCpuExecutable> xla_runtime_executable_;
 
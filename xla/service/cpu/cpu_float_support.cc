@@ -0,0 +1,34 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/cpu_float_support.h"
+
+#include "xla/service/cpu/dot_op_emitter.h"
+
+namespace xla {
+namespace cpu {
+
+bool CpuFloatSupport::IsSupportedDot(const HloInstruction& hlo) const {
+  // The output of a bf16 dot is converted to f32 first, since we don't
+  // support low precision outputs, so accept the dot both before and after.
+  return LowPrecisionType() == BF16 &&
+         (DotImplementationCanAccumulateBF16InF32(hlo,
+                                                  *target_machine_features_) ||
+          DotImplementationCanHandleMixedPrecision(hlo,
+                                                   *target_machine_features_));
+}
+
+}  // namespace cpu
+}  // namespace xla
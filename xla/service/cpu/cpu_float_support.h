@@ -0,0 +1,56 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_CPU_FLOAT_SUPPORT_H_
+#define XLA_SERVICE_CPU_CPU_FLOAT_SUPPORT_H_
+
+#include <cstdint>
+
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/service/cpu/target_machine_features.h"
+#include "xla/service/float_support.h"
+
+namespace xla {
+namespace cpu {
+
+// Keeps the bf16 operands of dots that call into the runtime, which accumulates
+// the products in f32, and upcasts bf16 everywhere else.
+class CpuFloatSupport : public FloatSupport {
+ public:
+  CpuFloatSupport(PrimitiveType low_precision_type,
+                  const TargetMachineFeatures* target_machine_features)
+      : FloatSupport(low_precision_type),
+        target_machine_features_(target_machine_features) {}
+
+  bool SupportsLowPrecisionOperand(const HloInstruction& hlo,
+                                   int64_t operand_index) const override {
+    return FloatSupport::SupportsLowPrecisionOperand(hlo, operand_index) ||
+           IsSupportedDot(hlo);
+  }
+
+  bool SupportsMixedPrecisions(const HloInstruction& hlo) const override {
+    return FloatSupport::SupportsMixedPrecisions(hlo) || IsSupportedDot(hlo);
+  }
+
+ private:
+  bool IsSupportedDot(const HloInstruction& hlo) const;
+
+  const TargetMachineFeatures* target_machine_features_;
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_CPU_FLOAT_SUPPORT_H_
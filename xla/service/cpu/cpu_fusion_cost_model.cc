@@ -0,0 +1,166 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/cpu_fusion_cost_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/shape_util.h"
+
+namespace xla {
+namespace cpu {
+
+namespace {
+
+// The percentile of the rates of the profiled elementwise instructions that is
+// taken as the memory bandwidth.
+constexpr double kBandwidthPercentile = 0.9;
+
+// The number of bytes of all arrays in `shape`.
+int64_t ArrayBytes(const Shape& shape) {
+  int64_t bytes = 0;
+  ShapeUtil::ForEachSubshape(
+      shape, [&](const Shape& subshape, const ShapeIndex& /*index*/) {
+        if (subshape.IsArray()) {
+          bytes += ShapeUtil::ByteSizeOfElements(subshape);
+        }
+      });
+  return bytes;
+}
+
+int64_t OperandBytes(const HloInstruction& instruction) {
+  int64_t bytes = 0;
+  for (const HloInstruction* operand : instruction.operands()) {
+    bytes += ArrayBytes(operand->shape());
+  }
+  return bytes;
+}
+
+}  // namespace
+
+ProfileGuidedFusionCostModel::ProfileGuidedFusionCostModel(
+    const ProfiledInstructionsProto& profile, const HloModule& module) {
+  for (const auto& cost : profile.costs()) {
+    cost_us_[cost.name()] = cost.cost_us();
+  }
+
+  // The instructions that run closest to the memory bandwidth are the ones
+  // that do the least work per byte, so their rate is the best estimate of the
+  // bandwidth itself. Only elementwise instructions are known to read their
+  // operands and write their result once; bitcasts, tuples and the like move
+  // no data at all. A high percentile rather than the maximum keeps a few
+  // mismeasured instructions from inflating the estimate.
+  std::vector<double> rates;
+  for (const HloComputation* computation : module.MakeNonfusionComputations()) {
+    for (const HloInstruction* instruction : computation->instructions()) {
+      if (!instruction->IsElementwise() || !instruction->shape().IsArray()) {
+        continue;
+      }
+      std::optional<double> cost_us = CostUs(*instruction);
+      if (!cost_us.has_value() || *cost_us <= 0) {
+        continue;
+      }
+      int64_t bytes =
+          OperandBytes(*instruction) + ArrayBytes(instruction->shape());
+      rates.push_back(bytes / *cost_us);
+    }
+  }
+  if (!rates.empty()) {
+    auto percentile = rates.begin() + std::lround(kBandwidthPercentile *
+                                                  (rates.size() - 1));
+    std::nth_element(rates.begin(), percentile, rates.end());
+    bytes_per_us_ = *percentile;
+  }
+}
+
+std::optional<double> ProfileGuidedFusionCostModel::CostUs(
+    const HloInstruction& instruction) const {
+  auto it = cost_us_.find(instruction.name());
+  if (it == cost_us_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+double ProfileGuidedFusionCostModel::MemoryUs(int64_t bytes) const {
+  return bytes_per_us_ > 0 ? bytes / bytes_per_us_ : 0;
+}
+
+double ProfileGuidedFusionCostModel::ComputeUs(
+    const HloInstruction& instruction, double cost_us) const {
+  return std::max(
+      cost_us - MemoryUs(OperandBytes(instruction) +
+                         ArrayBytes(instruction.shape())),
+      0.0);
+}
+
+std::optional<double> ProfileGuidedFusionCostModel::PredictedFusionGainUs(
+    const HloInstruction& producer, const HloInstruction& consumer,
+    bool consumer_reuses_producer) const {
+  std::optional<double> cost_us = CostUs(producer);
+  if (!cost_us.has_value()) {
+    return std::nullopt;
+  }
+
+  // Without reuse every element of the producer is computed once inside the
+  // fused loop; with reuse we assume each element of the consumer recomputes
+  // one element of the producer.
+  double recomputations = 1;
+  int64_t producer_elements = ShapeUtil::ElementsInRecursive(producer.shape());
+  if (consumer_reuses_producer && producer_elements > 0) {
+    recomputations =
+        std::max(1.0, static_cast<double>(
+                          ShapeUtil::ElementsInRecursive(consumer.shape())) /
+                          producer_elements);
+  }
+
+  double gain_us = MemoryUs(ArrayBytes(producer.shape())) -
+                   MemoryUs(OperandBytes(producer)) -
+                   recomputations * ComputeUs(producer, *cost_us);
+  // If the consumer is the only user the producer no longer runs on its own.
+  if (producer.user_count() == 1) {
+    gain_us += *cost_us;
+  }
+  return gain_us;
+}
+
+ProfiledInstructionsProto ProfiledInstructionsFromExecutionProfile(
+    const HloExecutionProfile& profile,
+    const HloProfileIndexMap& profile_index_map, double clock_rate_ghz) {
+  ProfiledInstructionsProto result;
+  for (const auto& [instruction, index] :
+       profile_index_map.instruction_to_profile_idx()) {
+    uint64_t cycles = profile.GetCyclesTakenBy(index);
+    if (cycles == 0) {
+      continue;
+    }
+    auto* cost = result.add_costs();
+    cost->set_name(instruction->name());
+    cost->set_cost_us(cycles / (clock_rate_ghz * 1e3));
+  }
+  std::sort(result.mutable_costs()->begin(), result.mutable_costs()->end(),
+            [](const auto& a, const auto& b) { return a.name() < b.name(); });
+  return result;
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,81 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_CPU_FUSION_COST_MODEL_H_
+#define XLA_SERVICE_CPU_CPU_FUSION_COST_MODEL_H_
+
+#include <optional>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/service/hlo_execution_profile.h"
+#include "xla/xla.pb.h"
+
+namespace xla {
+namespace cpu {
+
+// Predicts the benefit of fusing a producer into a consumer from measured
+// per-instruction run times, in the format used by the profile-guided latency
+// estimator (instructions are matched by name).
+//
+// Each profiled instruction is modeled as streaming its operands and result at
+// the memory bandwidth observed for the fastest elementwise instructions in
+// the profile, plus whatever time remains as compute. Fusing a producer saves
+// writing and re-reading its result, and the whole producer if the consumer is
+// its only user, at the cost of reading the producer's operands from the fused
+// loop and recomputing it once for every time the consumer reads an element.
+class ProfileGuidedFusionCostModel {
+ public:
+  ProfileGuidedFusionCostModel(const ProfiledInstructionsProto& profile,
+                               const HloModule& module);
+
+  // Returns the measured run time of `instruction`, if it was profiled.
+  std::optional<double> CostUs(const HloInstruction& instruction) const;
+
+  // Returns the predicted run time saved by fusing `producer` into `consumer`,
+  // which may be negative, or nullopt if `producer` was not profiled.
+  // `consumer_reuses_producer` tells whether the consumer may read elements of
+  // the producer more than once.
+  std::optional<double> PredictedFusionGainUs(
+      const HloInstruction& producer, const HloInstruction& consumer,
+      bool consumer_reuses_producer) const;
+
+  // The memory bandwidth inferred from the profile, in bytes per microsecond,
+  // or zero if no elementwise instruction was profiled.
+  double bytes_per_us() const { return bytes_per_us_; }
+
+ private:
+  // The estimated time spent in `instruction` beyond streaming its operands
+  // and result.
+  double ComputeUs(const HloInstruction& instruction, double cost_us) const;
+
+  double MemoryUs(int64_t bytes) const;
+
+  absl::flat_hash_map<std::string, double> cost_us_;
+  double bytes_per_us_ = 0;
+};
+
+// Converts the cycle counts of `profile` into run times of the instructions
+// they were measured for, skipping those that were not measured.
+ProfiledInstructionsProto ProfiledInstructionsFromExecutionProfile(
+    const HloExecutionProfile& profile,
+    const HloProfileIndexMap& profile_index_map, double clock_rate_ghz);
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_CPU_FUSION_COST_MODEL_H_
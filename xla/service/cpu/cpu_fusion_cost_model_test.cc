@@ -0,0 +1,184 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/cpu_fusion_cost_model.h"
+
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/service/cpu/cpu_fusion_cost_model_test_util.h"
+#include "xla/service/hlo_cost_analysis.h"
+#include "xla/service/hlo_execution_profile.h"
+#include "xla/shape_util.h"
+#include "xla/tests/hlo_test_base.h"
+#include "xla/xla.pb.h"
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/statusor.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+using ProfileGuidedFusionCostModelTest = HloTestBase;
+
+// The size of an f32[1024,1024] array.
+constexpr double kArrayBytes = 4 << 20;
+
+constexpr absl::string_view kBroadcastModule = R"(
+HloModule module
+
+ENTRY main {
+  p0 = f32[1024]{0} parameter(0)
+  p1 = f32[1024,1024]{1,0} parameter(1)
+  e = f32[1024]{0} exponential(p0)
+  b = f32[1024,1024]{1,0} broadcast(e), dimensions={1}
+  a = f32[1024,1024]{1,0} add(b, p1)
+  m = f32[1024,1024]{1,0} multiply(b, p1)
+  ROOT t = (f32[1024,1024]{1,0}, f32[1024,1024]{1,0}) tuple(a, m)
+}
+)";
+
+TEST_F(ProfileGuidedFusionCostModelTest, InfersBandwidthFromFastestOp) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kBroadcastModule));
+  ProfileGuidedFusionCostModel model(
+      MakeProfile({{"b", 1.1}, {"a", 3.0}, {"m", 6.0}}), *module);
+  EXPECT_DOUBLE_EQ(model.bytes_per_us(), kArrayBytes);
+
+  HloComputation* entry = module->entry_computation();
+  EXPECT_EQ(model.CostUs(*entry->GetInstructionWithName("m")), 6.0);
+  EXPECT_FALSE(model.CostUs(*entry->GetInstructionWithName("e")).has_value());
+}
+
+TEST_F(ProfileGuidedFusionCostModelTest, BandwidthIgnoresOpsMovingNoData) {
+  constexpr absl::string_view kModule = R"(
+HloModule module
+
+ENTRY main {
+  p0 = f32[1024,1024]{1,0} parameter(0)
+  p1 = f32[1024,1024]{1,0} parameter(1)
+  a0 = f32[1024,1024]{1,0} add(p0, p1)
+  a1 = f32[1024,1024]{1,0} add(a0, p1)
+  a2 = f32[1024,1024]{1,0} add(a1, p1)
+  a3 = f32[1024,1024]{1,0} add(a2, p1)
+  a4 = f32[1024,1024]{1,0} add(a3, p1)
+  a5 = f32[1024,1024]{1,0} add(a4, p1)
+  a6 = f32[1024,1024]{1,0} add(a5, p1)
+  a7 = f32[1024,1024]{1,0} add(a6, p1)
+  a8 = f32[1024,1024]{1,0} add(a7, p1)
+  a9 = f32[1024,1024]{1,0} add(a8, p1)
+  c = f32[1024,1024]{1,0} bitcast(a9)
+  r = f32[1048576]{0} reshape(a9)
+  ROOT t = (f32[1024,1024]{1,0}, f32[1048576]{0}) tuple(c, r)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kModule));
+  // The bitcast, the copy-free reshape and the tuple take no time but move no
+  // data either, and one of the adds was mismeasured.
+  ProfileGuidedFusionCostModel model(
+      MakeProfile({{"a0", 3.0},
+                   {"a1", 3.0},
+                   {"a2", 3.0},
+                   {"a3", 0.01},
+                   {"a4", 3.0},
+                   {"a5", 3.0},
+                   {"a6", 3.0},
+                   {"a7", 3.0},
+                   {"a8", 3.0},
+                   {"a9", 3.0},
+                   {"c", 0.001},
+                   {"r", 0.001},
+                   {"t", 0.001}}),
+      *module);
+  EXPECT_DOUBLE_EQ(model.bytes_per_us(), kArrayBytes);
+}
+
+TEST_F(ProfileGuidedFusionCostModelTest, DuplicatingBroadcastPaysOff) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kBroadcastModule));
+  ProfileGuidedFusionCostModel model(
+      MakeProfile({{"b", 1.1}, {"a", 3.0}, {"m", 6.0}}), *module);
+
+  // The broadcast has two users, so fusing it into one of them saves reading
+  // its result there, but costs reading its operand and computing it again.
+  HloComputation* entry = module->entry_computation();
+  const HloInstruction* broadcast = entry->GetInstructionWithName("b");
+  const HloInstruction* add = entry->GetInstructionWithName("a");
+  const double operand_us = 4096 / kArrayBytes;
+  const double compute_us = 1.1 - (kArrayBytes + 4096) / kArrayBytes;
+  EXPECT_NEAR(model
+                  .PredictedFusionGainUs(*broadcast, *add,
+                                         /*consumer_reuses_producer=*/false)
+                  .value(),
+              1.0 - operand_us - compute_us, 1e-9);
+}
+
+TEST_F(ProfileGuidedFusionCostModelTest, RecomputingExpensiveOpDoesNot) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kBroadcastModule));
+  ProfileGuidedFusionCostModel model(
+      MakeProfile({{"e", 2.0}, {"b", 1.1}, {"a", 3.0}, {"m", 6.0}}), *module);
+
+  HloComputation* entry = module->entry_computation();
+  const HloInstruction* exp = entry->GetInstructionWithName("e");
+  const HloInstruction* broadcast = entry->GetInstructionWithName("b");
+  // Each of the 1024 elements of the exponential would be computed 1024
+  // times inside the broadcast.
+  EXPECT_LT(model.PredictedFusionGainUs(*exp, *broadcast,
+                                        /*consumer_reuses_producer=*/true)
+                .value(),
+            -1000.0);
+  // Computed once, it only saves the traffic of the exponential itself.
+  EXPECT_GT(model.PredictedFusionGainUs(*exp, *broadcast,
+                                        /*consumer_reuses_producer=*/false)
+                .value(),
+            0.0);
+  EXPECT_FALSE(model
+                   .PredictedFusionGainUs(*entry->GetInstructionWithName("p1"),
+                                          *entry->GetInstructionWithName("a"),
+                                          /*consumer_reuses_producer=*/false)
+                   .has_value());
+}
+
+TEST_F(ProfileGuidedFusionCostModelTest, ConvertsExecutionProfile) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kBroadcastModule));
+  HloComputation* entry = module->entry_computation();
+  HloCostAnalysis cost_analysis(
+      [](const Shape& shape) { return ShapeUtil::ByteSizeOf(shape, 8); });
+  TF_ASSERT_OK(entry->Accept(&cost_analysis));
+  HloProfileIndexMap profile_index_map(*module);
+  std::unique_ptr<HloProfilePrinterData> printer_data =
+      CreateHloProfilePrinterData(profile_index_map, cost_analysis,
+                                  entry->name());
+  HloExecutionProfile execution_profile(printer_data.get(),
+                                        &profile_index_map);
+  execution_profile.SetCyclesTakenBy(entry->GetInstructionWithName("b"), 3000);
+  execution_profile.SetCyclesTakenBy(entry->GetInstructionWithName("a"), 1500);
+
+  ProfiledInstructionsProto profile = ProfiledInstructionsFromExecutionProfile(
+      execution_profile, profile_index_map, /*clock_rate_ghz=*/1.5);
+  ASSERT_EQ(profile.costs_size(), 2);
+  EXPECT_EQ(profile.costs(0).name(), "a");
+  EXPECT_DOUBLE_EQ(profile.costs(0).cost_us(), 1.0);
+  EXPECT_EQ(profile.costs(1).name(), "b");
+  EXPECT_DOUBLE_EQ(profile.costs(1).cost_us(), 2.0);
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
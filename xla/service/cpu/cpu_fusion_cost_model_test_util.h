@@ -0,0 +1,44 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_CPU_FUSION_COST_MODEL_TEST_UTIL_H_
+#define XLA_SERVICE_CPU_CPU_FUSION_COST_MODEL_TEST_UTIL_H_
+
+#include <string>
+#include <utility>
+
+#include "absl/types/span.h"
+#include "xla/xla.pb.h"
+
+namespace xla {
+namespace cpu {
+
+// Returns a profile with the given run times, in microseconds, of the
+// instructions with the given names.
+inline ProfiledInstructionsProto MakeProfile(
+    absl::Span<const std::pair<std::string, double>> costs) {
+  ProfiledInstructionsProto profile;
+  for (const auto& [name, cost_us] : costs) {
+    auto* cost = profile.add_costs();
+    cost->set_name(name);
+    cost->set_cost_us(cost_us);
+  }
+  return profile;
+}
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_CPU_FUSION_COST_MODEL_TEST_UTIL_H_
@@ -15,7 +15,12 @@ limitations under the License.
 
 #include "xla/service/cpu/cpu_instruction_fusion.h"
 
+#include <memory>
+#include <optional>
+
 #include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/service/cpu/cpu_fusion_cost_model.h"
+#include "xla/service/cpu/dot_op_emitter.h"
 #include "xla/service/fusion_node_indexing_evaluation.h"
 #include "xla/service/llvm_ir/fused_ir_emitter.h"
 
@@ -46,7 +51,8 @@ bool IsNonComplexNonBatchedMatrixVectorDot(const HloInstruction* hlo) {
   const Shape& hlo_shape = hlo->shape();
   return !ShapeUtil::ElementIsComplex(hlo_shape) &&
          hlo->opcode() == HloOpcode::kDot && hlo_shape.dimensions_size() <= 1 &&
-         hlo->dot_dimension_numbers().lhs_batch_dimensions_size() == 0;
+         hlo->dot_dimension_numbers().lhs_batch_dimensions_size() == 0 &&
+         !IsMixedPrecisionDot(*hlo);
 }
 
 bool HasExactlyOneUse(const HloInstruction& hlo_instr) {
@@ -68,6 +74,63 @@ bool CanBeOutputFusedIntoSomeOperand(const HloInstruction* consumer) {
 }
 }  // namespace
 
+StatusOr<bool> CpuInstructionFusion::Run(
+    HloModule* module,
+    const absl::flat_hash_set<absl::string_view>& execution_threads) {
+  fusion_node_evaluations_.clear();
+  if (!profile_.has_value()) {
+    return InstructionFusion::Run(module, execution_threads);
+  }
+
+  cost_model_ =
+      std::make_unique<ProfileGuidedFusionCostModel>(*profile_, *module);
+  pending_enabled_gain_us_.clear();
+  recorded_rejections_.clear();
+  if (stats_ != nullptr) {
+    *stats_ = ProfileGuidedStats();
+  }
+  StatusOr<bool> changed = InstructionFusion::Run(module, execution_threads);
+  cost_model_.reset();
+  pending_enabled_gain_us_.clear();
+  return changed;
+}
+
+std::optional<double> CpuInstructionFusion::ProfileGuidedGainUs(
+    HloInstruction* consumer, int64_t operand_index) {
+  const HloInstruction* producer = consumer->operand(operand_index);
+  if (cost_model_ == nullptr || producer->opcode() == HloOpcode::kFusion) {
+    return std::nullopt;
+  }
+  return cost_model_->PredictedFusionGainUs(
+      *producer, *consumer, ReusesOperandElements(consumer, operand_index));
+}
+
+void CpuInstructionFusion::RecordProfileGuidedDecision(
+    const HloInstruction& producer, const HloInstruction& consumer,
+    double gain_us) {
+  VLOG(2) << "Profile " << (gain_us < 0 ? "prevents" : "enables")
+          << " fusing " << producer.name() << " into " << consumer.name()
+          << ", predicted gain " << gain_us << "us";
+  if (stats_ == nullptr) {
+    return;
+  }
+  if (gain_us < 0) {
+    ++stats_->fusions_prevented;
+    stats_->predicted_gain_us -= gain_us;
+  } else {
+    ++stats_->fusions_enabled;
+    stats_->predicted_gain_us += gain_us;
+  }
+}
+
+bool CpuInstructionFusion::IsExpensiveToDuplicate(
+    const HloInstruction& instruction) const {
+  if (cost_model_ != nullptr && cost_model_->CostUs(instruction).has_value()) {
+    return false;
+  }
+  return InstructionFusion::IsExpensive(instruction);
+}
+
 FusionDecision CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
                                                 int64_t operand_index) {
   HloInstruction* producer = consumer->mutable_operand(operand_index);
@@ -89,10 +152,31 @@ FusionDecision CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
     return "Producer is not loop-fusible.";
   }
 
-  // Cost condition: not fuse (simple, expensive producers) and (consumers who
-  // reuse operand elements).
-  if (producer->opcode() != HloOpcode::kFusion && is_expensive(*producer) &&
-      ReusesOperandElements(consumer, operand_index)) {
+  // With a profile for the producer, weigh its measured cost against the
+  // memory traffic saved instead, which also covers duplicating it.
+  pending_enabled_gain_us_.erase(producer);
+  if (std::optional<double> gain_us =
+          ProfileGuidedGainUs(consumer, operand_index)) {
+    bool statically_profitable =
+        !InstructionFusion::IsExpensive(*producer) ||
+        (!ReusesOperandElements(consumer, operand_index) &&
+         !FusionWouldDuplicate(*producer, *consumer));
+    if (*gain_us < 0) {
+      if (statically_profitable &&
+          recorded_rejections_.emplace(producer->name(), consumer->name())
+              .second) {
+        RecordProfileGuidedDecision(*producer, *consumer, *gain_us);
+      }
+      return "Fusion is not profitable according to the profile.";
+    }
+    if (!statically_profitable) {
+      pending_enabled_gain_us_[producer] = *gain_us;
+    }
+  } else if (producer->opcode() != HloOpcode::kFusion &&
+             is_expensive(*producer) &&
+             ReusesOperandElements(consumer, operand_index)) {
+    // Cost condition: not fuse (simple, expensive producers) and (consumers
+    // who reuse operand elements).
     return "Fusion is not profitable.";
   }
 
@@ -141,7 +225,8 @@ FusionDecision CpuInstructionFusion::ShouldFuse(HloInstruction* consumer,
     // fusion can easily be overshadowed by the overhead of a naive GEMM
     // algorithm in the IR.
     const Shape& output_shape = consumer->shape();
-    if (output_shape.dimensions_size() <= 1) {
+    if (output_shape.dimensions_size() <= 1 &&
+        !IsMixedPrecisionDot(*consumer)) {
       // We fuse in cases where we have a matrix*vector or vector*matrix dot and
       // fusion can get rid of the larger tensor.  We assume that a naive
       // traversal of a small enough (to fit in L1) column or row tensor is
@@ -206,6 +291,11 @@ HloInstruction* CpuInstructionFusion::FuseInstruction(
                               FusionNodeIndexingEvaluation(fusion_instruction))
                      .first;
   }
+  if (auto it = pending_enabled_gain_us_.find(producer);
+      it != pending_enabled_gain_us_.end()) {
+    RecordProfileGuidedDecision(*producer, *fusion_instruction, it->second);
+    pending_enabled_gain_us_.erase(it);
+  }
   auto indexing_users = evaluation->second.RemoveFusionOperand(producer);
   HloInstruction* new_producer =
       InstructionFusion::FuseInstruction(fusion_instruction, producer);
@@ -16,27 +16,57 @@ limitations under the License.
 #ifndef XLA_SERVICE_CPU_CPU_INSTRUCTION_FUSION_H_
 #define XLA_SERVICE_CPU_CPU_INSTRUCTION_FUSION_H_
 
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/service/cpu/cpu_fusion_cost_model.h"
 #include "xla/service/fusion_node_indexing_evaluation.h"
 #include "xla/service/instruction_fusion.h"
+#include "xla/xla.pb.h"
 
 namespace xla {
 namespace cpu {
 
 class CpuInstructionFusion : public InstructionFusion {
  public:
+  // The fusion decisions on which a profile overruled the static heuristic.
+  struct ProfileGuidedStats {
+    // Fusions allowed although the producer is considered too expensive to
+    // duplicate or recompute.
+    int64_t fusions_enabled = 0;
+    // Fusions rejected although the static heuristic would have allowed them.
+    int64_t fusions_prevented = 0;
+    // The run time these decisions are predicted to save.
+    double predicted_gain_us = 0;
+  };
+
   CpuInstructionFusion()
       : InstructionFusion(CpuInstructionFusion::IsExpensive) {}
+
+  // Decides whether fusing a producer is profitable from its measured run time
+  // in `profile` instead of a static estimate, for the producers that were
+  // profiled. The other constraints on fusion still apply. If `stats` is not
+  // null it receives the decisions the profile changed.
+  explicit CpuInstructionFusion(ProfiledInstructionsProto profile,
+                                ProfileGuidedStats* stats = nullptr)
+      : InstructionFusion([this](const HloInstruction& instruction) {
+          return IsExpensiveToDuplicate(instruction);
+        }),
+        profile_(std::move(profile)),
+        stats_(stats) {}
+
   ~CpuInstructionFusion() override = default;
 
   using HloPassInterface::Run;
   StatusOr<bool> Run(HloModule* module,
                      const absl::flat_hash_set<absl::string_view>&
-                         execution_threads) override {
-    fusion_node_evaluations_.clear();
-    return InstructionFusion::Run(module, execution_threads);
-  }
+                         execution_threads) override;
 
  protected:
   FusionDecision ShouldFuse(HloInstruction* consumer,
@@ -45,6 +75,20 @@ class CpuInstructionFusion : public InstructionFusion {
       const HloInstruction* producer, const HloInstruction* consumer) override;
 
  private:
+  // Returns the predicted gain of fusing the `operand_index`th operand into
+  // `consumer`, or nullopt if there is no profile for the operand.
+  std::optional<double> ProfileGuidedGainUs(HloInstruction* consumer,
+                                            int64_t operand_index);
+
+  // Records a decision of the profile that differs from the static heuristic.
+  void RecordProfileGuidedDecision(const HloInstruction& producer,
+                                   const HloInstruction& consumer,
+                                   double gain_us);
+
+  // Profiled producers are never considered too expensive by the base class,
+  // as ShouldFuse has already weighed the cost of duplicating them.
+  bool IsExpensiveToDuplicate(const HloInstruction& instruction) const;
+
   HloInstruction* FuseInstruction(HloInstruction* fusion_instruction,
                                   HloInstruction* producer) override;
 
@@ -52,6 +96,17 @@ class CpuInstructionFusion : public InstructionFusion {
   // indexed with different index vectors.
   absl::flat_hash_map<const HloInstruction*, FusionNodeIndexingEvaluation>
       fusion_node_evaluations_;
+
+  std::optional<ProfiledInstructionsProto> profile_;
+  ProfileGuidedStats* stats_ = nullptr;
+  // Built from `profile_` for the module being run on.
+  std::unique_ptr<ProfileGuidedFusionCostModel> cost_model_;
+  // The predicted gains of the producers that may be fused only because of the
+  // profile, recorded once the fusion happens.
+  absl::flat_hash_map<const HloInstruction*, double> pending_enabled_gain_us_;
+  // The (producer, consumer) names of the rejections already recorded.
+  absl::flat_hash_set<std::pair<std::string, std::string>>
+      recorded_rejections_;
 };
 
 }  // namespace cpu
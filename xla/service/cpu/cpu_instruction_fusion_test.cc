@@ -18,14 +18,17 @@ limitations under the License.
 #include <algorithm>
 #include <memory>
 #include <set>
+#include <string>
 
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "xla/hlo/utils/hlo_matchers.h"
+#include "xla/service/cpu/cpu_fusion_cost_model_test_util.h"
 #include "xla/service/transpose_folding.h"
 #include "xla/shape.h"
 #include "xla/tests/hlo_test_base.h"
 #include "xla/tests/test_utils.h"
+#include "xla/xla.pb.h"
 
 namespace op = xla::testing::opcode_matchers;
 
@@ -927,6 +930,94 @@ ENTRY main {
   EXPECT_TRUE(fused_something);
   EXPECT_THAT(module->entry_computation()->root_instruction(), op::Fusion());
 }
+
+TEST_F(InstructionFusionTest, ProfileEnablesDuplicatingCheapExp) {
+  absl::string_view module_string = R"(
+HloModule module
+
+ENTRY main {
+  p = f32[1024,1024]{1,0} parameter(0)
+  e = f32[1024,1024]{1,0} exponential(p)
+  n = f32[1024,1024]{1,0} negate(e)
+  a = f32[1024,1024]{1,0} abs(e)
+  ROOT t = (f32[1024,1024]{1,0}, f32[1024,1024]{1,0}) tuple(n, a)
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(module_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool fused_something,
+                          CpuInstructionFusion().Run(module->Clone().get()));
+  EXPECT_FALSE(fused_something);
+
+  // The exponential runs as fast as streaming its operand and result, so it is
+  // no more expensive to recompute than to read back.
+  CpuInstructionFusion::ProfileGuidedStats stats;
+  CpuInstructionFusion fusion(
+      MakeProfile({{"e", 2.0}, {"n", 2.0}, {"a", 2.0}}), &stats);
+  TF_ASSERT_OK_AND_ASSIGN(fused_something, fusion.Run(module.get()));
+  EXPECT_TRUE(fused_something);
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              op::Tuple(op::Fusion(), op::Fusion()));
+  EXPECT_EQ(stats.fusions_enabled, 1);
+  EXPECT_EQ(stats.fusions_prevented, 0);
+  EXPECT_GE(stats.predicted_gain_us, 0);
+}
+
+TEST_F(InstructionFusionTest, ProfilePreventsDuplicatingBinaryOp) {
+  absl::string_view module_string = R"(
+HloModule module
+
+ENTRY main {
+  p0 = f32[1024,1024]{1,0} parameter(0)
+  p1 = f32[1024,1024]{1,0} parameter(1)
+  s = f32[1024,1024]{1,0} add(p0, p1)
+  n = f32[1024,1024]{1,0} negate(s)
+  a = f32[1024,1024]{1,0} abs(s)
+  ROOT t = (f32[1024,1024]{1,0}, f32[1024,1024]{1,0}) tuple(n, a)
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(module_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool fused_something,
+                          CpuInstructionFusion().Run(module->Clone().get()));
+  EXPECT_TRUE(fused_something);
+
+  // Duplicating the add into both users reads two arrays in each of them
+  // instead of one.
+  CpuInstructionFusion::ProfileGuidedStats stats;
+  CpuInstructionFusion fusion(
+      MakeProfile({{"s", 3.0}, {"n", 2.0}, {"a", 2.0}}), &stats);
+  TF_ASSERT_OK_AND_ASSIGN(fused_something, fusion.Run(module.get()));
+  EXPECT_FALSE(fused_something);
+  EXPECT_EQ(stats.fusions_enabled, 0);
+  EXPECT_EQ(stats.fusions_prevented, 2);
+  EXPECT_GT(stats.predicted_gain_us, 0);
+}
+
+TEST_F(InstructionFusionTest, UnprofiledProducersUseStaticHeuristic) {
+  absl::string_view module_string = R"(
+HloModule module
+
+ENTRY main {
+  p = f32[1024,1024]{1,0} parameter(0)
+  e = f32[1024,1024]{1,0} exponential(p)
+  n = f32[1024,1024]{1,0} negate(e)
+  a = f32[1024,1024]{1,0} abs(e)
+  ROOT t = (f32[1024,1024]{1,0}, f32[1024,1024]{1,0}) tuple(n, a)
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(module_string));
+  CpuInstructionFusion::ProfileGuidedStats stats;
+  CpuInstructionFusion fusion(MakeProfile({{"n", 2.0}, {"a", 2.0}}), &stats);
+  TF_ASSERT_OK_AND_ASSIGN(bool fused_something, fusion.Run(module.get()));
+  EXPECT_FALSE(fused_something);
+  EXPECT_EQ(stats.fusions_enabled, 0);
+  EXPECT_EQ(stats.fusions_prevented, 0);
+}
 }  // namespace
 }  // namespace cpu
 }  // namespace xla
@@ -105,6 +105,30 @@ std::optional<std::tuple<int64_t, int64_t, int64_t>> LlvmIrGemmTileSize(
                                                tile_size_n_in_vector_width);
 }
 
+std::optional<int64_t> MemoryLimitBytes(const HloModuleConfig& config) {
+  const int64_t limit = config.debug_options().xla_cpu_memory_limit_bytes();
+  if (limit <= 0) {
+    return std::nullopt;
+  }
+  return limit;
+}
+
+std::optional<int> CodegenParallelism(const HloModuleConfig& config) {
+  const int parallelism = config.debug_options().xla_cpu_codegen_parallelism();
+  if (parallelism <= 1) {
+    return std::nullopt;
+  }
+  return parallelism;
+}
+
+std::optional<int> AotParallelism(const HloModuleConfig& config) {
+  const int parallelism = config.debug_options().xla_cpu_aot_parallelism();
+  if (parallelism <= 1) {
+    return std::nullopt;
+  }
+  return parallelism;
+}
+
 }  // namespace options
 }  // namespace cpu
 }  // namespace xla
@@ -31,6 +31,15 @@ bool ForceEnableExperimentalLlvmIrGemm(const HloModuleConfig& config);
 std::optional<int64_t> LlvmIrGemvTilingFactor(const HloModuleConfig& config);
 std::optional<std::tuple<int64_t, int64_t, int64_t>> LlvmIrGemmTileSize(
     const HloModuleConfig& config);
+// Returns the peak memory budget of the module, if rematerialization to fit
+// one is requested.
+std::optional<int64_t> MemoryLimitBytes(const HloModuleConfig& config);
+// Returns the number of modules to split the LLVM IR into for parallel
+// compilation, if that is requested.
+std::optional<int> CodegenParallelism(const HloModuleConfig& config);
+// Returns the number of threads ahead-of-time compiled executables should
+// split their loops for, if multi-threaded AOT is requested.
+std::optional<int> AotParallelism(const HloModuleConfig& config);
 
 }  // namespace options
 }  // namespace cpu
@@ -0,0 +1,116 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/cpu_rematerialization.h"
+
+#include <cstdint>
+#include <utility>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/ir/hlo_schedule.h"
+#include "xla/service/buffer_value.h"
+#include "xla/service/hlo_cost_analysis.h"
+#include "xla/service/hlo_memory_scheduler.h"
+#include "xla/service/hlo_rematerialization.h"
+#include "xla/statusor.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/numbers.h"
+#include "tsl/platform/statusor.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+using ::tsl::strings::HumanReadableNumBytes;
+
+// The flops and bytes accessed by one execution of a module.
+struct ModuleCost {
+  double flops;
+  double bytes_accessed;
+};
+
+StatusOr<ModuleCost> ComputeModuleCost(
+    HloModule* module, const HloCostAnalysis::ShapeSizeFunction& shape_size) {
+  HloCostAnalysis analysis(shape_size);
+  TF_RETURN_IF_ERROR(module->entry_computation()->Accept(&analysis));
+  return ModuleCost{analysis.flop_count(), analysis.bytes_accessed()};
+}
+
+}  // namespace
+
+StatusOr<bool> CpuRematerialization::Run(
+    HloModule* module,
+    const absl::flat_hash_set<absl::string_view>& execution_threads) {
+  bool changed = false;
+  if (!module->has_schedule()) {
+    TF_ASSIGN_OR_RETURN(
+        HloSchedule schedule,
+        ScheduleModule(
+            module,
+            [this](const BufferValue& buffer) {
+              return shape_size_(buffer.shape());
+            },
+            ComputationSchedulerToModuleScheduler(DefaultMemoryScheduler),
+            execution_threads));
+    TF_RETURN_IF_ERROR(module->set_schedule(std::move(schedule)));
+    changed = true;
+  }
+
+  const int64_t instructions_before = module->instruction_count();
+  TF_ASSIGN_OR_RETURN(ModuleCost cost_before,
+                      ComputeModuleCost(module, shape_size_));
+
+  HloRematerialization::RematerializationSizes sizes;
+  HloRematerialization remat(
+      shape_size_, memory_limit_bytes_, &sizes,
+      HloRematerialization::RematerializationPass::kPostFusion,
+      /*block_size_limit=*/1, /*block_rematerialization_factor=*/1,
+      /*compact_shape_function=*/nullptr,
+      HloRematerialization::RematerializationMode::kRecomputeOnly);
+  TF_ASSIGN_OR_RETURN(bool rematerialized,
+                      remat.Run(module, execution_threads));
+  changed |= rematerialized;
+
+  TF_ASSIGN_OR_RETURN(ModuleCost cost_after,
+                      ComputeModuleCost(module, shape_size_));
+  Stats stats;
+  stats.peak_memory_before_bytes = sizes.before_bytes;
+  stats.peak_memory_after_bytes = sizes.after_bytes;
+  stats.instructions_added = module->instruction_count() - instructions_before;
+  stats.flops_added = cost_after.flops - cost_before.flops;
+  stats.bytes_accessed_added =
+      cost_after.bytes_accessed - cost_before.bytes_accessed;
+
+  LOG(INFO) << absl::StrFormat(
+      "Rematerialization of %s for a memory limit of %s reduced its peak "
+      "memory from %s to %s, adding %d instructions, %.0f flops and %s "
+      "accessed per execution.",
+      module->name(), HumanReadableNumBytes(memory_limit_bytes_),
+      HumanReadableNumBytes(stats.peak_memory_before_bytes),
+      HumanReadableNumBytes(stats.peak_memory_after_bytes),
+      stats.instructions_added, stats.flops_added,
+      HumanReadableNumBytes(stats.bytes_accessed_added));
+  if (stats_ != nullptr) {
+    *stats_ = stats;
+  }
+  return changed;
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,82 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_CPU_REMATERIALIZATION_H_
+#define XLA_SERVICE_CPU_CPU_REMATERIALIZATION_H_
+
+#include <cstdint>
+#include <utility>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/service/hlo_cost_analysis.h"
+#include "xla/service/hlo_pass_interface.h"
+#include "xla/statusor.h"
+
+namespace xla {
+namespace cpu {
+
+// An HLO pass that fits the peak memory of a module into a budget.
+//
+// Unless the module already has a schedule, it is first scheduled with the
+// memory-minimizing HloMemoryScheduler rather than the DFS order the CPU
+// backend uses by default. HloRematerialization then recomputes values close
+// to their uses until the peak memory of that schedule fits in the budget, or
+// nothing more can be rematerialized. The module keeps the schedule, which the
+// CPU compiler emits code in.
+//
+// Every run logs the peak memory before and after rematerialization together
+// with the compute it adds.
+class CpuRematerialization : public HloModulePass {
+ public:
+  // The effect of a run on the module.
+  struct Stats {
+    // Peak memory of the scheduled module before and after rematerialization.
+    int64_t peak_memory_before_bytes = 0;
+    int64_t peak_memory_after_bytes = 0;
+    // Net number of instructions added by rematerialization.
+    int64_t instructions_added = 0;
+    // Cost of the recomputation per execution of the module.
+    double flops_added = 0;
+    double bytes_accessed_added = 0;
+  };
+
+  // If `stats` is not null, it receives the effect of the last run.
+  CpuRematerialization(int64_t memory_limit_bytes,
+                       HloCostAnalysis::ShapeSizeFunction shape_size,
+                       Stats* stats = nullptr)
+      : memory_limit_bytes_(memory_limit_bytes),
+        shape_size_(std::move(shape_size)),
+        stats_(stats) {}
+
+  ~CpuRematerialization() override = default;
+  absl::string_view name() const override { return "cpu-rematerialization"; }
+
+  using HloPassInterface::Run;
+  StatusOr<bool> Run(
+      HloModule* module,
+      const absl::flat_hash_set<absl::string_view>& execution_threads) override;
+
+ private:
+  int64_t memory_limit_bytes_;
+  HloCostAnalysis::ShapeSizeFunction shape_size_;
+  Stats* stats_;
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_CPU_REMATERIALIZATION_H_
@@ -0,0 +1,114 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/cpu_rematerialization.h"
+
+#include <memory>
+
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/utils/hlo_matchers.h"
+#include "xla/shape_util.h"
+#include "xla/test.h"
+#include "xla/tests/hlo_test_base.h"
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/statusor.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+namespace op = xla::testing::opcode_matchers;
+
+// %bcast is live across %concat.1, which doubles the negated broadcast. The
+// module needs 16KiB, or 12KiB if %bcast is recomputed before %concat.2.
+constexpr char kRematerializableModule[] = R"(
+  HloModule RematerializableModule
+
+  ENTRY entry {
+    param = f32[1] parameter(0)
+    reshape = f32[] reshape(param)
+    bcast = f32[1024] broadcast(reshape), dimensions={}
+    negate = f32[1024] negate(bcast)
+    concat.1 = f32[2048] concatenate(negate, negate), dimensions={0}
+    slice.1 = f32[1] slice(concat.1), slice={[0:1]}
+    concat.2 = f32[1025] concatenate(bcast, slice.1), dimensions={0}
+    ROOT slice.2 = f32[1] slice(concat.2), slice={[0:1]}
+  }
+)";
+
+class CpuRematerializationTest : public HloTestBase {
+ protected:
+  StatusOr<bool> RunCpuRematerialization(int64_t memory_limit_bytes,
+                                         HloModule* module,
+                                         CpuRematerialization::Stats* stats) {
+    return CpuRematerialization(
+               memory_limit_bytes,
+               [](const Shape& shape) {
+                 return ShapeUtil::ByteSizeOf(shape, sizeof(void*));
+               },
+               stats)
+        .Run(module);
+  }
+};
+
+TEST_F(CpuRematerializationTest, RematerializesToFitMemoryLimit) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<HloModule> module,
+      ParseAndReturnVerifiedModule(kRematerializableModule));
+  const HloInstruction* bcast = FindInstruction(module.get(), "bcast");
+
+  CpuRematerialization::Stats stats;
+  TF_ASSERT_OK_AND_ASSIGN(
+      bool changed,
+      RunCpuRematerialization(/*memory_limit_bytes=*/14 * 1024, module.get(),
+                              &stats));
+  EXPECT_TRUE(changed);
+  EXPECT_TRUE(module->has_schedule());
+
+  // %concat.2 uses a recomputed broadcast.
+  const HloInstruction* concat = FindInstruction(module.get(), "concat.2");
+  EXPECT_THAT(concat->operand(0), op::Broadcast(::testing::Ne(bcast)));
+
+  EXPECT_GT(stats.peak_memory_before_bytes, 14 * 1024);
+  EXPECT_LE(stats.peak_memory_after_bytes, 14 * 1024);
+  EXPECT_EQ(stats.instructions_added, 1);
+  EXPECT_GT(stats.bytes_accessed_added, 0);
+}
+
+TEST_F(CpuRematerializationTest, OnlySchedulesUnderMemoryLimit) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<HloModule> module,
+      ParseAndReturnVerifiedModule(kRematerializableModule));
+  const int64_t instruction_count = module->instruction_count();
+
+  CpuRematerialization::Stats stats;
+  TF_ASSERT_OK_AND_ASSIGN(
+      bool changed,
+      RunCpuRematerialization(/*memory_limit_bytes=*/20 * 1024, module.get(),
+                              &stats));
+  // Adding the schedule changes the module.
+  EXPECT_TRUE(changed);
+  EXPECT_TRUE(module->has_schedule());
+  EXPECT_EQ(module->instruction_count(), instruction_count);
+
+  EXPECT_EQ(stats.peak_memory_before_bytes, stats.peak_memory_after_bytes);
+  EXPECT_EQ(stats.instructions_added, 0);
+  EXPECT_EQ(stats.flops_added, 0);
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -40,6 +40,7 @@ limitations under the License.
 #include "xla/refcounting_hash_map.h"
 #include "xla/service/collective_ops_utils.h"
 #include "xla/service/computation_placer.h"
+#include "xla/service/cpu/all_reduce_kernels.h"
 #include "xla/service/cpu/xfeed_manager.h"
 #include "xla/service/hlo_parser.h"
 #include "xla/shape_util.h"
@@ -80,6 +81,14 @@ extern const char* const kEigenMatMulS32SymbolName =
     "__xla_cpu_runtime_EigenMatMulS32";
 extern const char* const kEigenBatchMatMulF32SymbolName =
     "__xla_cpu_runtime_EigenBatchMatMulF32";
+extern const char* const kEigenMatMulBF16F32SymbolName =
+    "__xla_cpu_runtime_EigenMatMulBF16F32";
+extern const char* const kEigenMatMulS8S32SymbolName =
+    "__xla_cpu_runtime_EigenMatMulS8S32";
+extern const char* const kEigenBatchMatMulBF16F32SymbolName =
+    "__xla_cpu_runtime_EigenBatchMatMulBF16F32";
+extern const char* const kEigenBatchMatMulS8S32SymbolName =
+    "__xla_cpu_runtime_EigenBatchMatMulS8S32";
 extern const char* const kMKLConv2DF32SymbolName =
     "__xla_cpu_runtime_MKLConv2DF32";
 extern const char* const kACLConv2DF32SymbolName =
@@ -96,6 +105,10 @@ extern const char* const kMKLSingleThreadedMatMulF32SymbolName =
     "__xla_cpu_runtime_MKLSingleThreadedMatMulF32";
 extern const char* const kMKLSingleThreadedMatMulF64SymbolName =
     "__xla_cpu_runtime_MKLSingleThreadedMatMulF64";
+extern const char* const kMKLMatMulBF16F32SymbolName =
+    "__xla_cpu_runtime_MKLMatMulBF16F32";
+extern const char* const kMKLSingleThreadedMatMulBF16F32SymbolName =
+    "__xla_cpu_runtime_MKLSingleThreadedMatMulBF16F32";
 extern const char* const kEigenConv2DF16SymbolName =
     "__xla_cpu_runtime_EigenConv2DF16";
 extern const char* const kEigenConv2DF32SymbolName =
@@ -119,6 +132,10 @@ extern const char* const kEigenSingleThreadedMatMulC128SymbolName =
     "__xla_cpu_runtime_EigenSingleThreadedMatMulC128";
 extern const char* const kEigenSingleThreadedMatMulS32SymbolName =
     "__xla_cpu_runtime_EigenSingleThreadedMatMulS32";
+extern const char* const kEigenSingleThreadedMatMulBF16F32SymbolName =
+    "__xla_cpu_runtime_EigenSingleThreadedMatMulBF16F32";
+extern const char* const kEigenSingleThreadedMatMulS8S32SymbolName =
+    "__xla_cpu_runtime_EigenSingleThreadedMatMulS8S32";
 extern const char* const kEigenSingleThreadedConv2DF16SymbolName =
     "__xla_cpu_runtime_EigenSingleThreadedConv2DF16";
 extern const char* const kEigenSingleThreadedConv2DF32SymbolName =
@@ -143,7 +160,17 @@ extern const char* const kStatusIsSuccessSymbolName =
     "__xla_cpu_runtime_StatusIsSuccess";
 extern const char* const kKeyValueSortSymbolName =
     "__xla_cpu_runtime_KeyValueSort";
+extern const char* const kKeySortS32SymbolName = "__xla_cpu_runtime_KeySortS32";
+extern const char* const kKeySortS64SymbolName = "__xla_cpu_runtime_KeySortS64";
+extern const char* const kKeySortU32SymbolName = "__xla_cpu_runtime_KeySortU32";
+extern const char* const kKeySortU64SymbolName = "__xla_cpu_runtime_KeySortU64";
+extern const char* const kKeySortF32SymbolName = "__xla_cpu_runtime_KeySortF32";
+extern const char* const kKeySortF64SymbolName = "__xla_cpu_runtime_KeySortF64";
+extern const char* const kTopKBF16SymbolName = "__xla_cpu_runtime_TopKBF16";
+extern const char* const kTopKF16SymbolName = "__xla_cpu_runtime_TopKF16";
 extern const char* const kTopKF32SymbolName = "__xla_cpu_runtime_TopKF32";
+extern const char* const kTopKS32SymbolName = "__xla_cpu_runtime_TopKS32";
+extern const char* const kTopKU32SymbolName = "__xla_cpu_runtime_TopKU32";
 extern const char* const kTracingStartSymbolName =
     "__xla_cpu_runtime_TracingStart";
 extern const char* const kTracingEndSymbolName = "__xla_cpu_runtime_TracingEnd";
@@ -368,184 +395,108 @@ class CpuAllReduceRendezvous
   StatusOr<std::nullptr_t> RunCollectiveOp(
       const AllReduceParticipantData& participant) override {
     PrimitiveType datatype = participant.buffers.front().primitive_type;
-    bool primary = InitializationBarrier();
-
-    if (primary) {
-      switch (datatype) {
-        case S8:
-          DoAllReduce<S8>(participant);
-          break;
-        case PRED:
-        case U8:
-          DoAllReduce<U8>(participant);
-          break;
-        case S16:
-          DoAllReduce<S16>(participant);
-          break;
-        case U16:
-          DoAllReduce<U16>(participant);
-          break;
-        case S32:
-          DoAllReduce<S32>(participant);
-          break;
-        case U32:
-          DoAllReduce<U32>(participant);
-          break;
-        case S64:
-          DoAllReduce<S64>(participant);
-          break;
-        case U64:
-          DoAllReduce<U64>(participant);
-          break;
-        case F16:
-          DoAllReduce<F16>(participant);
-          break;
-        case F32:
-          DoAllReduce<F32>(participant);
-          break;
-        case F64:
-          DoAllReduce<F64>(participant);
-          break;
-        case C64:
-          DoAllReduce<C64>(participant);
-          break;
-        case C128:
-          DoAllReduce<C128>(participant);
-          break;
-        default:
-          LOG(FATAL) << "Unexpected datatype;";
-      }
+    switch (datatype) {
+      case S8:
+        DoAllReduce<S8>(participant);
+        break;
+      case PRED:
+      case U8:
+        DoAllReduce<U8>(participant);
+        break;
+      case S16:
+        DoAllReduce<S16>(participant);
+        break;
+      case U16:
+        DoAllReduce<U16>(participant);
+        break;
+      case S32:
+        DoAllReduce<S32>(participant);
+        break;
+      case U32:
+        DoAllReduce<U32>(participant);
+        break;
+      case S64:
+        DoAllReduce<S64>(participant);
+        break;
+      case U64:
+        DoAllReduce<U64>(participant);
+        break;
+      case F16:
+        DoAllReduce<F16>(participant);
+        break;
+      case F32:
+        DoAllReduce<F32>(participant);
+        break;
+      case F64:
+        DoAllReduce<F64>(participant);
+        break;
+      case C64:
+        DoAllReduce<C64>(participant);
+        break;
+      case C128:
+        DoAllReduce<C128>(participant);
+        break;
+      default:
+        LOG(FATAL) << "Unexpected datatype;";
     }
     return nullptr;
   }
 
  private:
+  // Runs on every participant once all of them have arrived. Each participant
+  // reduces its own slice of every buffer across all participants and writes
+  // the result to that slice of every participant's output (a reduce-scatter
+  // fused with an all-gather). Participants don't return from the rendezvous
+  // until all of them are done, so no further synchronization is needed.
   template <PrimitiveType PT>
-  void DoAllReduce(AllReduceParticipantData participant) {
+  void DoAllReduce(const AllReduceParticipantData& participant) {
     using T = typename primitive_util::PrimitiveTypeToNative<PT>::type;
-    absl::MutexLock lock(&mu_);
-    CHECK(!participants_.empty());
-    ReductionKind reduction_kind = participant.reduction_kind;
-    for (const auto& p : participants_) {
-      CHECK(p.reduction_kind == reduction_kind);
+    std::vector<AllReduceParticipantData> participants;
+    {
+      // All participants have arrived, so `participants_` no longer changes;
+      // copy it so that we don't hold the lock while reducing.
+      absl::MutexLock lock(&mu_);
+      participants = participants_;
     }
-    int num_participants = participants_.size();
-
-    // participant_idx -> buffer_idx -> buffer.
-    std::vector<std::vector<absl::Span<T>>> input_buffers;
-    std::vector<std::vector<absl::Span<T>>> output_buffers;
-    input_buffers.reserve(num_participants);
-    output_buffers.reserve(num_participants);
-    const AllReduceParticipantData& first_participant = participants_.front();
-
-    int buffers_per_participant = first_participant.buffers.size();
-    for (AllReduceParticipantData& p : participants_) {
-      CHECK_EQ(p.buffers.size(), buffers_per_participant);
-
-      input_buffers.emplace_back();
-      output_buffers.emplace_back();
-      std::vector<absl::Span<T>>& participant_input_buffers =
-          input_buffers.back();
-      std::vector<absl::Span<T>>& participant_output_buffers =
-          output_buffers.back();
-      participant_input_buffers.reserve(p.buffers.size());
-      participant_output_buffers.reserve(p.buffers.size());
-
-      for (int buffer_idx = 0; buffer_idx < buffers_per_participant;
-           buffer_idx++) {
-        auto& participant_buffer = p.buffers[buffer_idx];
-        participant_input_buffers.emplace_back(
-            static_cast<T*>(participant_buffer.source_data.opaque()),
-            participant_buffer.element_count);
-        participant_output_buffers.emplace_back(
-            static_cast<T*>(participant_buffer.destination_data.opaque()),
-            participant_buffer.element_count);
-        CHECK_EQ(participant_buffer.element_count,
-                 first_participant.buffers[buffer_idx].element_count);
+    CHECK(!participants.empty());
+    ReductionKind reduction_kind = participant.reduction_kind;
+    int num_participants = participants.size();
+    // Each participant reduces the slice of its position in `participants`,
+    // so it must be the only one with its device ordinal.
+    int rank = -1;
+    for (int i = 0; i < num_participants; ++i) {
+      CHECK(participants[i].reduction_kind == reduction_kind);
+      if (participants[i].device_ordinal == participant.device_ordinal) {
+        CHECK_EQ(rank, -1) << "Device ordinal " << participant.device_ordinal
+                           << " takes part in the all-reduce more than once";
+        rank = i;
       }
     }
+    CHECK_GE(rank, 0);
 
+    int buffers_per_participant = participant.buffers.size();
+    std::vector<const T*> inputs(num_participants);
+    std::vector<T*> outputs(num_participants);
     for (int buffer_idx = 0; buffer_idx < buffers_per_participant;
          buffer_idx++) {
-      int element_count = first_participant.buffers[buffer_idx].element_count;
-      for (int idx = 0; idx < element_count; idx++) {
-        T out = GetInitialValue<T>(reduction_kind);
-        for (int participant_idx = 0; participant_idx < participants_.size();
-             participant_idx++) {
-          out = PerformReductionStep<T>(
-              reduction_kind, out,
-              input_buffers[participant_idx][buffer_idx][idx]);
-        }
-        for (int participant_idx = 0; participant_idx < participants_.size();
-             participant_idx++) {
-          output_buffers[participant_idx][buffer_idx][idx] = out;
-        }
+      int64_t element_count = participant.buffers[buffer_idx].element_count;
+      auto [begin, end] = AllReduceSliceBounds(element_count, sizeof(T),
+                                               num_participants, rank);
+      if (begin == end) {
+        continue;
       }
-    }
-  }
-
-  template <typename T>
-  T GetInitialValue(ReductionKind reduction_kind) {
-    switch (reduction_kind) {
-      case ReductionKind::SUM:
-        return static_cast<T>(0);
-      case ReductionKind::PRODUCT:
-        return static_cast<T>(1);
-      case ReductionKind::MIN:
-        return std::numeric_limits<T>::max();
-      case ReductionKind::MAX:
-        return std::numeric_limits<T>::min();
-    }
-  }
-
-  template <typename T, bool kIsSignedIntegralType>
-  struct SumProductTypeForReductionStep {
-    using type = T;
-  };
-
-  template <typename T>
-  struct SumProductTypeForReductionStep<T, /*kIsSignedIntegralType=*/true> {
-    using type = typename std::make_unsigned_t<T>;
-  };
-
-  template <typename T,
-            typename std::enable_if<!is_complex_v<T>>::type* = nullptr>
-  T PerformReductionStep(ReductionKind reduction_kind, T a, T b) {
-    using SumProductType = typename SumProductTypeForReductionStep<
-        T, std::is_integral<T>::value && std::is_signed<T>::value>::type;
-    switch (reduction_kind) {
-      case ReductionKind::SUM:
-        return absl::bit_cast<T>(
-            static_cast<SumProductType>(absl::bit_cast<SumProductType>(a) +
-                                        absl::bit_cast<SumProductType>(b)));
-      case ReductionKind::PRODUCT:
-        return absl::bit_cast<T>(
-            static_cast<SumProductType>(absl::bit_cast<SumProductType>(a) *
-                                        absl::bit_cast<SumProductType>(b)));
-      case ReductionKind::MIN:
-        return std::min(a, b);
-      case ReductionKind::MAX:
-        return std::max(a, b);
-    }
-  }
-
-  template <typename T,
-            typename std::enable_if<is_complex_v<T>>::type* = nullptr>
-  T PerformReductionStep(ReductionKind reduction_kind, T a, T b) {
-    using SumProductType = typename SumProductTypeForReductionStep<
-        T, std::is_integral<T>::value && std::is_signed<T>::value>::type;
-    switch (reduction_kind) {
-      case ReductionKind::SUM:
-        return absl::bit_cast<T>(
-            static_cast<SumProductType>(absl::bit_cast<SumProductType>(a) +
-                                        absl::bit_cast<SumProductType>(b)));
-      case ReductionKind::PRODUCT:
-        return absl::bit_cast<T>(
-            static_cast<SumProductType>(absl::bit_cast<SumProductType>(a) *
-                                        absl::bit_cast<SumProductType>(b)));
-      case ReductionKind::MIN:
-      case ReductionKind::MAX:
-        LOG(FATAL) << "min/max not valid for complex types";
+      for (int participant_idx = 0; participant_idx < num_participants;
+           participant_idx++) {
+        AllReduceParticipantData& p = participants[participant_idx];
+        CHECK_EQ(p.buffers.size(), buffers_per_participant);
+        auto& participant_buffer = p.buffers[buffer_idx];
+        CHECK_EQ(participant_buffer.element_count, element_count);
+        inputs[participant_idx] =
+            static_cast<const T*>(participant_buffer.source_data.opaque());
+        outputs[participant_idx] =
+            static_cast<T*>(participant_buffer.destination_data.opaque());
+      }
+      AllReduceSlice<T>(reduction_kind, inputs, outputs, begin, end);
     }
   }
 };
@@ -48,6 +48,10 @@ extern const char* const kEigenMatMulC64SymbolName;
 extern const char* const kEigenMatMulC128SymbolName;
 extern const char* const kEigenMatMulS32SymbolName;
 extern const char* const kEigenBatchMatMulF32SymbolName;
+extern const char* const kEigenMatMulBF16F32SymbolName;
+extern const char* const kEigenMatMulS8S32SymbolName;
+extern const char* const kEigenBatchMatMulBF16F32SymbolName;
+extern const char* const kEigenBatchMatMulS8S32SymbolName;
 extern const char* const kMKLConv2DF32SymbolName;
 extern const char* const kACLConv2DF32SymbolName;
 extern const char* const kMKLMatMulF32SymbolName;
@@ -56,6 +60,8 @@ extern const char* const kACLMatMulF32SymbolName;
 extern const char* const kACLBatchMatMulF32SymbolName;
 extern const char* const kMKLSingleThreadedMatMulF32SymbolName;
 extern const char* const kMKLSingleThreadedMatMulF64SymbolName;
+extern const char* const kMKLMatMulBF16F32SymbolName;
+extern const char* const kMKLSingleThreadedMatMulBF16F32SymbolName;
 extern const char* const kEigenConv2DF16SymbolName;
 extern const char* const kEigenConv2DF32SymbolName;
 extern const char* const kEigenConv3DF16SymbolName;
@@ -68,6 +74,8 @@ extern const char* const kEigenSingleThreadedMatMulF64SymbolName;
 extern const char* const kEigenSingleThreadedMatMulC64SymbolName;
 extern const char* const kEigenSingleThreadedMatMulC128SymbolName;
 extern const char* const kEigenSingleThreadedMatMulS32SymbolName;
+extern const char* const kEigenSingleThreadedMatMulBF16F32SymbolName;
+extern const char* const kEigenSingleThreadedMatMulS8S32SymbolName;
 extern const char* const kEigenSingleThreadedConv2DF16SymbolName;
 extern const char* const kEigenSingleThreadedConv2DF32SymbolName;
 extern const char* const kEigenSingleThreadedConv3DF16SymbolName;
@@ -80,7 +88,17 @@ extern const char* const kParallelForkJoinSymbolName;
 extern const char* const kPrintfToStderrSymbolName;
 extern const char* const kStatusIsSuccessSymbolName;
 extern const char* const kKeyValueSortSymbolName;
+extern const char* const kKeySortS32SymbolName;
+extern const char* const kKeySortS64SymbolName;
+extern const char* const kKeySortU32SymbolName;
+extern const char* const kKeySortU64SymbolName;
+extern const char* const kKeySortF32SymbolName;
+extern const char* const kKeySortF64SymbolName;
+extern const char* const kTopKBF16SymbolName;
+extern const char* const kTopKF16SymbolName;
 extern const char* const kTopKF32SymbolName;
+extern const char* const kTopKS32SymbolName;
+extern const char* const kTopKU32SymbolName;
 extern const char* const kAllReduceSymbolName;
 extern const char* const kCollectivePermuteSymbolName;
 extern const char* const kPartitionIdSymbolName;
@@ -15,15 +15,22 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 #include "xla/service/cpu/cpu_runtime.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <memory>
+#include <random>
 #include <string>
 #include <tuple>
+#include <vector>
 
 #include "absl/strings/str_format.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "xla/array2d.h"
 #include "xla/client/local_client.h"
+#include "xla/executable_run_options.h"
 #include "xla/service/cpu/runtime_custom_call_status.h"
+#include "xla/service/cpu/runtime_key_value_sort.h"
 #include "xla/service/cpu/runtime_matmul.h"
 #include "xla/service/cpu/runtime_matmul_acl.h"
 #include "xla/service/cpu/runtime_matmul_mkl.h"
@@ -251,5 +258,72 @@ TEST_F(CpuRuntimeTest, FailureStatus) {
   ASSERT_FALSE(__xla_cpu_runtime_StatusIsSuccess(&success_status));
 }
 
+void LessThanF32(char* result, char* run_options, char** params,
+                 char** buffer_table, int64_t* prof_counters) {
+  float lhs, rhs;
+  std::memcpy(&lhs, params[0], sizeof(float));
+  std::memcpy(&rhs, params[1], sizeof(float));
+  *result = lhs < rhs;
+}
+
+TEST_F(CpuRuntimeTest, ParallelKeyValueSortMatchesSerialSort) {
+  constexpr int64_t a = 3, b = 1000, c = 5;
+  std::minstd_rand0 generator(42);
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  std::vector<float> keys(a * b * c);
+  std::vector<int32_t> values(a * b * c);
+  for (int64_t i = 0; i < keys.size(); ++i) {
+    keys[i] = distribution(generator);
+    values[i] = i;
+  }
+  std::vector<float> original_keys = keys;
+  std::vector<float> keys_only = keys;
+
+  Eigen::ThreadPool pool(8);
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  ExecutableRunOptions run_options;
+  run_options.set_intra_op_thread_pool(&device);
+
+  char* buffers[] = {reinterpret_cast<char*>(keys.data()),
+                     reinterpret_cast<char*>(values.data())};
+  int32_t sizes[] = {sizeof(float), sizeof(int32_t)};
+  __xla_cpu_runtime_KeyValueSort(a, b, c, buffers, 2, sizes,
+                                 /*is_stable=*/true,
+                                 reinterpret_cast<char*>(&run_options),
+                                 /*prof_counters=*/nullptr, LessThanF32);
+  __xla_cpu_runtime_KeySortF32(a, b, c, keys_only.data(), /*descending=*/false,
+                               /*total_order=*/false, /*is_stable=*/false,
+                               reinterpret_cast<char*>(&run_options));
+
+  for (int64_t i = 0; i < a; ++i) {
+    for (int64_t j = 0; j < c; ++j) {
+      std::vector<float> expected;
+      for (int64_t k = 0; k < b; ++k) {
+        expected.push_back(original_keys[(i * b + k) * c + j]);
+      }
+      std::sort(expected.begin(), expected.end());
+      for (int64_t k = 0; k < b; ++k) {
+        int64_t index = (i * b + k) * c + j;
+        EXPECT_EQ(keys[index], expected[k]);
+        EXPECT_EQ(keys_only[index], expected[k]);
+        EXPECT_EQ(original_keys[values[index]], keys[index]);
+      }
+    }
+  }
+}
+
+TEST_F(CpuRuntimeTest, KeySortF32TotalOrderDescending) {
+  std::vector<float> keys = {0.0f, -0.0f, 1.0f, -INFINITY, NAN, 2.0f};
+  __xla_cpu_runtime_KeySortF32(1, keys.size(), 1, keys.data(),
+                               /*descending=*/true, /*total_order=*/true,
+                               /*is_stable=*/false, /*run_options=*/nullptr);
+  EXPECT_TRUE(std::isnan(keys[0]));
+  EXPECT_EQ(keys[1], 2.0f);
+  EXPECT_EQ(keys[2], 1.0f);
+  EXPECT_FALSE(std::signbit(keys[3]));
+  EXPECT_TRUE(std::signbit(keys[4]));
+  EXPECT_EQ(keys[5], -INFINITY);
+}
+
 }  // namespace
 }  // namespace xla
@@ -84,6 +84,16 @@ struct DotInfo {
   }
 };
 
+// Returns true if `dot_info` multiplies bf16 (resp. s8) operands into an f32
+// (resp. s32) result.
+bool IsMixedPrecision(const DotInfo& dot_info) {
+  PrimitiveType operand_type = dot_info.lhs_shape.element_type();
+  PrimitiveType result_type = dot_info.result_shape.element_type();
+  return operand_type == dot_info.rhs_shape.element_type() &&
+         ((operand_type == BF16 && result_type == F32) ||
+          (operand_type == S8 && result_type == S32));
+}
+
 // Dictates how a dot operation is implemented.
 enum class DotImplementationStrategy {
   // The dot operation is lowered into LLVM IR that implements a naive nested
@@ -696,6 +706,16 @@ void DotOpEmitter::EmitNaiveLlvmIrGemm() {
 
   llvm::Value* lhs_element = lhs_array_.EmitReadArrayElement(lhs_index, b_);
   llvm::Value* rhs_element = rhs_array_.EmitReadArrayElement(rhs_index, b_);
+  if (IsMixedPrecision(dot_info_)) {
+    // Widen the operands to the type we accumulate in.
+    auto widen = [&](llvm::Value* element) {
+      return ShapeUtil::ElementIsIntegral(lhs_shape)
+                 ? b_->CreateSExt(element, accum_type)
+                 : b_->CreateFPExt(element, accum_type);
+    };
+    lhs_element = widen(lhs_element);
+    rhs_element = widen(rhs_element);
+  }
 
   llvm::Value* accum = b_->CreateLoad(accum_type, accum_address);
   llvm::Value* updated_accum;
@@ -807,6 +827,8 @@ Status DotOpEmitter::EmitCallToRuntime() {
   llvm::Function* function = b_->GetInsertBlock()->getParent();
   llvm::Module* module = function->getParent();
   llvm::Type* float_type;
+  // The operands of mixed precision dots are narrower than the result.
+  llvm::Type* operand_type = nullptr;
   const char* fn_name;
   switch (type) {
     case F16:
@@ -816,14 +838,32 @@ Status DotOpEmitter::EmitCallToRuntime() {
       float_type = b_->getHalfTy();
       break;
     case F32:
-      fn_name =
-          multi_threaded
-              ? (use_mkl_dnn ? runtime::kMKLMatMulF32SymbolName
-                             : (use_acl ? runtime::kACLMatMulF32SymbolName
-                                        : runtime::kEigenMatMulF32SymbolName))
-              : (use_mkl_dnn
-                     ? runtime::kMKLSingleThreadedMatMulF32SymbolName
-                     : runtime::kEigenSingleThreadedMatMulF32SymbolName);
+      if (IsMixedPrecision(dot_info_)) {
+        // MKL's bf16 GEMM only pays off on CPUs with bf16 dot product
+        // instructions; elsewhere Eigen converts the operands as it packs
+        // them.
+        bool use_mkl_bf16 =
+            use_mkl_dnn &&
+            target_machine_features_.has_bf16_dot_product_instructions();
+        fn_name =
+            multi_threaded
+                ? (use_mkl_bf16 ? runtime::kMKLMatMulBF16F32SymbolName
+                                : runtime::kEigenMatMulBF16F32SymbolName)
+                : (use_mkl_bf16
+                       ? runtime::kMKLSingleThreadedMatMulBF16F32SymbolName
+                       : runtime::kEigenSingleThreadedMatMulBF16F32SymbolName);
+        operand_type = b_->getBFloatTy();
+      } else {
+        fn_name =
+            multi_threaded
+                ? (use_mkl_dnn
+                       ? runtime::kMKLMatMulF32SymbolName
+                       : (use_acl ? runtime::kACLMatMulF32SymbolName
+                                  : runtime::kEigenMatMulF32SymbolName))
+                : (use_mkl_dnn
+                       ? runtime::kMKLSingleThreadedMatMulF32SymbolName
+                       : runtime::kEigenSingleThreadedMatMulF32SymbolName);
+      }
       float_type = b_->getFloatTy();
       break;
     case F64:
@@ -848,9 +888,16 @@ Status DotOpEmitter::EmitCallToRuntime() {
       float_type = llvm_ir::PrimitiveTypeToIrType(C128, module);
       break;
     case S32:
-      fn_name = multi_threaded
-                    ? runtime::kEigenMatMulS32SymbolName
-                    : runtime::kEigenSingleThreadedMatMulS32SymbolName;
+      if (IsMixedPrecision(dot_info_)) {
+        fn_name = multi_threaded
+                      ? runtime::kEigenMatMulS8S32SymbolName
+                      : runtime::kEigenSingleThreadedMatMulS8S32SymbolName;
+        operand_type = b_->getInt8Ty();
+      } else {
+        fn_name = multi_threaded
+                      ? runtime::kEigenMatMulS32SymbolName
+                      : runtime::kEigenSingleThreadedMatMulS32SymbolName;
+      }
       float_type = b_->getInt32Ty();
       break;
     default:
@@ -859,12 +906,14 @@ Status DotOpEmitter::EmitCallToRuntime() {
   }
 
   llvm::Type* float_ptr_type = float_type->getPointerTo();
+  llvm::Type* operand_ptr_type =
+      operand_type != nullptr ? operand_type->getPointerTo() : float_ptr_type;
   llvm::Type* int64_type = b_->getInt64Ty();
   llvm::Type* int32_type = b_->getInt32Ty();
   llvm::Type* int8_ptr_type = b_->getInt8Ty()->getPointerTo();
   llvm::FunctionType* matmul_type = llvm::FunctionType::get(
       b_->getVoidTy(),
-      {int8_ptr_type, float_ptr_type, float_ptr_type, float_ptr_type,
+      {int8_ptr_type, float_ptr_type, operand_ptr_type, operand_ptr_type,
        int64_type, int64_type, int64_type, int32_type, int32_type},
       /*isVarArg=*/false);
 
@@ -906,8 +955,8 @@ Status DotOpEmitter::EmitCallToRuntime() {
       matmul_func,
       {b_->CreateBitCast(executable_run_options_value_, int8_ptr_type),
        b_->CreateBitCast(target_array_.GetBasePointer(), float_ptr_type),
-       b_->CreateBitCast(lhs->GetBasePointer(), float_ptr_type),
-       b_->CreateBitCast(rhs->GetBasePointer(), float_ptr_type),
+       b_->CreateBitCast(lhs->GetBasePointer(), operand_ptr_type),
+       b_->CreateBitCast(rhs->GetBasePointer(), operand_ptr_type),
        b_->getInt64(mat_mult_dims.m), b_->getInt64(mat_mult_dims.n),
        b_->getInt64(mat_mult_dims.k), b_->getInt32(transpose_lhs),
        b_->getInt32(transpose_rhs)});
@@ -928,26 +977,41 @@ Status DotOpEmitter::EmitCallToBatchRuntime() {
   llvm::Function* function = b_->GetInsertBlock()->getParent();
   llvm::Module* module = function->getParent();
   llvm::Type* float_type;
+  // The operands of mixed precision dots are narrower than the result.
+  llvm::Type* operand_type = nullptr;
   const char* fn_name;
   switch (type) {
     case F32:
-      fn_name = use_acl ? runtime::kACLBatchMatMulF32SymbolName
-                        : runtime::kEigenBatchMatMulF32SymbolName;
+      if (IsMixedPrecision(dot_info_)) {
+        fn_name = runtime::kEigenBatchMatMulBF16F32SymbolName;
+        operand_type = b_->getBFloatTy();
+      } else {
+        fn_name = use_acl ? runtime::kACLBatchMatMulF32SymbolName
+                          : runtime::kEigenBatchMatMulF32SymbolName;
+      }
 
       float_type = b_->getFloatTy();
       break;
+    case S32:
+      TF_RET_CHECK(IsMixedPrecision(dot_info_));
+      fn_name = runtime::kEigenBatchMatMulS8S32SymbolName;
+      operand_type = b_->getInt8Ty();
+      float_type = b_->getInt32Ty();
+      break;
     default:
       return Unimplemented("Invalid type %s for dot operation",
                            PrimitiveType_Name(type));
   }
 
   llvm::Type* float_ptr_type = float_type->getPointerTo();
+  llvm::Type* operand_ptr_type =
+      operand_type != nullptr ? operand_type->getPointerTo() : float_ptr_type;
   llvm::Type* int64_type = b_->getInt64Ty();
   llvm::Type* int32_type = b_->getInt32Ty();
   llvm::Type* int8_ptr_type = b_->getInt8Ty()->getPointerTo();
   llvm::FunctionType* matmul_type = llvm::FunctionType::get(
       b_->getVoidTy(),
-      {int8_ptr_type, float_ptr_type, float_ptr_type, float_ptr_type,
+      {int8_ptr_type, float_ptr_type, operand_ptr_type, operand_ptr_type,
        int64_type, int64_type, int64_type, int64_type, int32_type, int32_type},
       /*isVarArg=*/false);
 
@@ -991,8 +1055,8 @@ Status DotOpEmitter::EmitCallToBatchRuntime() {
       matmul_func,
       {b_->CreateBitCast(executable_run_options_value_, int8_ptr_type),
        b_->CreateBitCast(target_array_.GetBasePointer(), float_ptr_type),
-       b_->CreateBitCast(lhs->GetBasePointer(), float_ptr_type),
-       b_->CreateBitCast(rhs->GetBasePointer(), float_ptr_type),
+       b_->CreateBitCast(lhs->GetBasePointer(), operand_ptr_type),
+       b_->CreateBitCast(rhs->GetBasePointer(), operand_ptr_type),
        b_->getInt64(mat_mult_dims.m), b_->getInt64(mat_mult_dims.n),
        b_->getInt64(mat_mult_dims.k), b_->getInt64(lhs_shape.dimensions(0)),
        b_->getInt32(static_cast<uint32_t>(transpose_lhs)),
@@ -1196,6 +1260,15 @@ bool CanEmitTiledLlvmIrGemm(
 DotImplementationStrategy GetDotImplementationStrategy(
     const HloModuleConfig& config, const DotInfo& dot_info,
     const TargetMachineFeatures& target_machine_features) {
+  // The tiled LLVM IR emitters expect the operands to have the type of the
+  // result, so mixed precision dots either call into the runtime or use the
+  // naive loop nest, which widens the operands as it reads them.
+  if (IsMixedPrecision(dot_info)) {
+    return IsAlignedGemm(dot_info, target_machine_features)
+               ? DotImplementationStrategy::kEigen
+               : DotImplementationStrategy::kNaiveLlvmIr;
+  }
+
   PrimitiveType element_type = dot_info.result_shape.element_type();
   // Any Matrix-Vector product of floating point or integral type, or
   // a transpose-dot fusion of the same can be lowered to a tiled LLVM
@@ -1361,7 +1434,7 @@ bool PotentiallyImplementedAsEigenMatmul(
       0, dot_info.dim_nums.rhs_contracting_dimensions(0) - num_batch_dims);
 
   PrimitiveType type = target_array.GetShape().element_type();
-  if (F32 != type) return false;
+  if (F32 != type && !IsMixedPrecision(dot_info)) return false;
 
   if (ShapeUtil::IsScalar(dot_info.lhs_shape) ||
       ShapeUtil::IsScalar(dot_info.rhs_shape)) {
@@ -1469,6 +1542,51 @@ bool IsBatchDot(const HloInstruction& instr) {
 }
 }  // namespace
 
+bool IsMixedPrecisionDot(const HloInstruction& hlo) {
+  return hlo.opcode() == HloOpcode::kDot && IsMixedPrecision(DotInfo(hlo));
+}
+
+namespace {
+// Returns true if `dot_info` is a mixed precision dot that we emit as a call
+// into the runtime.
+bool CanHandleMixedPrecision(
+    DotInfo dot_info, const TargetMachineFeatures& target_machine_features) {
+  if (!IsMixedPrecision(dot_info) ||
+      !ValidateDotDimensionNumbers(dot_info.dim_nums).ok()) {
+    return false;
+  }
+  // Batch dots are emitted as a GEMM per batch index.
+  int64_t num_batch_dims = dot_info.dim_nums.lhs_batch_dimensions_size();
+  auto drop_batch_dims = [&](const Shape& shape) {
+    return ShapeUtil::MakeShape(shape.element_type(),
+                                shape.dimensions().subspan(num_batch_dims));
+  };
+  dot_info.lhs_shape = drop_batch_dims(dot_info.lhs_shape);
+  dot_info.rhs_shape = drop_batch_dims(dot_info.rhs_shape);
+  dot_info.result_shape = drop_batch_dims(dot_info.result_shape);
+  return IsAlignedGemm(dot_info, target_machine_features);
+}
+}  // namespace
+
+bool DotImplementationCanHandleMixedPrecision(
+    const HloInstruction& dot_instr,
+    const TargetMachineFeatures& target_machine_features) {
+  return dot_instr.opcode() == HloOpcode::kDot &&
+         CanHandleMixedPrecision(DotInfo(dot_instr), target_machine_features);
+}
+
+bool DotImplementationCanAccumulateBF16InF32(
+    const HloInstruction& dot_instr,
+    const TargetMachineFeatures& target_machine_features) {
+  if (dot_instr.opcode() != HloOpcode::kDot ||
+      dot_instr.shape().element_type() != BF16) {
+    return false;
+  }
+  DotInfo dot_info(dot_instr);
+  dot_info.result_shape.set_element_type(F32);
+  return CanHandleMixedPrecision(dot_info, target_machine_features);
+}
+
 bool DotImplementationCanHandleTranspose(
     const HloInstruction& dot_instr,
     const TargetMachineFeatures& target_machine_features) {
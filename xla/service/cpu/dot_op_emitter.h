@@ -42,6 +42,24 @@ bool DotImplementationCanHandleTranspose(
     const HloInstruction& dot_instr,
     const TargetMachineFeatures& target_machine_features);
 
+// Returns true if `hlo` is a dot that multiplies bf16 (resp. s8) operands into
+// an f32 (resp. s32) result. The CPU backend keeps the operands of such dots
+// narrow instead of upcasting them to the result type.
+bool IsMixedPrecisionDot(const HloInstruction& hlo);
+
+// Returns true if our lowering strategy for `dot_instr`, a mixed precision dot
+// in the canonical form DotDecomposer produces, can read its operands in their
+// own type. This is the case for (batched) GEMMs, which call into the runtime.
+bool DotImplementationCanHandleMixedPrecision(
+    const HloInstruction& dot_instr,
+    const TargetMachineFeatures& target_machine_features);
+
+// Returns true if `dot_instr` is a bf16 dot that we could compute from its bf16
+// operands directly if it produced an f32 result instead.
+bool DotImplementationCanAccumulateBF16InF32(
+    const HloInstruction& dot_instr,
+    const TargetMachineFeatures& target_machine_features);
+
 // Returns the index for an operand to `hlo` that should ideally be column
 // major.  Returns nullopt if there is no such operand or if `hlo` is not a dot
 // or a fusion containing a dot.
@@ -0,0 +1,231 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/host_throughput.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/service/cpu/host_throughput.pb.h"
+#include "xla/status.h"
+#include "xla/util.h"
+#include "tsl/platform/blocking_counter.h"
+#include "tsl/platform/cpu_info.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/random.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+namespace cpu {
+
+namespace {
+
+// Larger than the last level cache of any host we run on, so that streaming
+// through it measures the memory bandwidth.
+constexpr int64_t kBufferBytes = 64LL << 20;
+
+// Each measurement is repeated and the fastest run is used.
+constexpr int kRepetitions = 3;
+
+// The number of independent multiply-add chains and the number of times each
+// of them is advanced by the flops benchmark. The chains are wide enough for
+// the compiler to vectorize them, like the loops XLA emits.
+constexpr int kFlopsLanes = 64;
+constexpr int64_t kFlopsIterations = 1 << 16;
+
+// Used when the host is not measured, or when a measurement gives a
+// nonsensical result, e.g. because the clock is too coarse. A few cores
+// together usually saturate the memory bandwidth.
+constexpr double kDefaultFlopsPerSecondPerCore = 1e10;
+constexpr double kDefaultBytesPerSecondPerCore = 1e10;
+constexpr double kDefaultBytesPerSecond = 4 * kDefaultBytesPerSecondPerCore;
+
+// Keeps the results of the benchmarks alive.
+volatile uint64_t benchmark_sink;
+
+uint64_t SumRange(const uint64_t* begin, const uint64_t* end) {
+  return std::accumulate(begin, end, uint64_t{0});
+}
+
+float MultiplyAddChains() {
+  float acc[kFlopsLanes];
+  for (int i = 0; i < kFlopsLanes; ++i) {
+    acc[i] = static_cast<float>(i);
+  }
+  for (int64_t iteration = 0; iteration < kFlopsIterations; ++iteration) {
+    for (int i = 0; i < kFlopsLanes; ++i) {
+      acc[i] = acc[i] * 0.999f + 0.001f;
+    }
+  }
+  return std::accumulate(acc, acc + kFlopsLanes, 0.0f);
+}
+
+// Returns the fastest of kRepetitions runs of `fn`, in seconds.
+template <typename Fn>
+double FastestRunSeconds(Fn fn) {
+  tsl::Env* env = tsl::Env::Default();
+  double fastest = std::numeric_limits<double>::infinity();
+  for (int i = 0; i < kRepetitions; ++i) {
+    const uint64_t start = env->NowNanos();
+    fn();
+    fastest = std::min(fastest, (env->NowNanos() - start) * 1e-9);
+  }
+  return fastest;
+}
+
+double RateOrDefault(double amount, double seconds, double default_rate) {
+  const double rate = amount / seconds;
+  return std::isfinite(rate) && rate > 0 ? rate : default_rate;
+}
+
+HostThroughputProto ToProto(const HostThroughput& throughput) {
+  HostThroughputProto proto;
+  proto.set_flops_per_second_per_core(throughput.flops_per_second_per_core);
+  proto.set_bytes_per_second_per_core(throughput.bytes_per_second_per_core);
+  proto.set_bytes_per_second(throughput.bytes_per_second);
+  return proto;
+}
+
+StatusOr<HostThroughput> FromProto(const HostThroughputProto& proto) {
+  if (!(proto.flops_per_second_per_core() > 0) ||
+      !(proto.bytes_per_second_per_core() > 0) ||
+      !(proto.bytes_per_second() > 0)) {
+    return InvalidArgument("Host throughput must be positive: %s",
+                           proto.ShortDebugString());
+  }
+  return HostThroughput{proto.flops_per_second_per_core(),
+                        proto.bytes_per_second_per_core(),
+                        proto.bytes_per_second()};
+}
+
+// Writes `throughput` to a temporary file that is then renamed to `path`, so
+// that processes that measure concurrently never read a partial file.
+Status WriteHostThroughput(const std::string& path,
+                           const HostThroughput& throughput) {
+  tsl::Env* env = tsl::Env::Default();
+  std::string tmp_path = absl::StrCat(
+      path, ".tmp.", absl::Hex(tsl::random::New64(), absl::kZeroPad16));
+  Status status = tsl::WriteTextProto(env, tmp_path, ToProto(throughput));
+  if (status.ok()) {
+    status = env->RenameFile(tmp_path, path);
+  }
+  if (!status.ok()) {
+    env->DeleteFile(tmp_path).IgnoreError();
+  }
+  return status;
+}
+
+}  // namespace
+
+HostThroughput DefaultHostThroughput() {
+  return HostThroughput{kDefaultFlopsPerSecondPerCore,
+                        kDefaultBytesPerSecondPerCore, kDefaultBytesPerSecond};
+}
+
+HostThroughput MeasureHostThroughput(int num_threads) {
+  num_threads = std::max(num_threads, 1);
+  HostThroughput throughput;
+
+  const double flops = 2.0 * kFlopsLanes * kFlopsIterations;
+  throughput.flops_per_second_per_core = RateOrDefault(
+      flops,
+      FastestRunSeconds([] {
+        benchmark_sink = static_cast<uint64_t>(MultiplyAddChains());
+      }),
+      kDefaultFlopsPerSecondPerCore);
+
+  std::vector<uint64_t> buffer(kBufferBytes / sizeof(uint64_t));
+  std::iota(buffer.begin(), buffer.end(), uint64_t{0});
+  const uint64_t* data = buffer.data();
+  const int64_t size = buffer.size();
+
+  throughput.bytes_per_second_per_core = RateOrDefault(
+      kBufferBytes,
+      FastestRunSeconds([&] { benchmark_sink = SumRange(data, data + size); }),
+      kDefaultBytesPerSecondPerCore);
+
+  throughput.bytes_per_second = throughput.bytes_per_second_per_core;
+  if (num_threads > 1) {
+    tsl::thread::ThreadPool pool(tsl::Env::Default(), "xla_host_throughput",
+                                 num_threads);
+    std::vector<uint64_t> sums(num_threads);
+    const double seconds = FastestRunSeconds([&] {
+      tsl::BlockingCounter done(num_threads);
+      for (int i = 0; i < num_threads; ++i) {
+        pool.Schedule([&, i] {
+          sums[i] = SumRange(data + size * i / num_threads,
+                             data + size * (i + 1) / num_threads);
+          done.DecrementCount();
+        });
+      }
+      done.Wait();
+      benchmark_sink = std::accumulate(sums.begin(), sums.end(), uint64_t{0});
+    });
+    // Sharing the memory bus never makes the cores faster than one of them on
+    // its own times their number.
+    throughput.bytes_per_second = std::clamp(
+        RateOrDefault(kBufferBytes, seconds, 0),
+        throughput.bytes_per_second_per_core,
+        throughput.bytes_per_second_per_core * num_threads);
+  }
+
+  VLOG(1) << "Host throughput: " << throughput.flops_per_second_per_core
+          << " flops/s per core, " << throughput.bytes_per_second_per_core
+          << " B/s per core, " << throughput.bytes_per_second
+          << " B/s with " << num_threads << " threads";
+  return throughput;
+}
+
+StatusOr<HostThroughput> LoadOrMeasureHostThroughput(const std::string& path) {
+  // The file is only read once per process, and measured at most once if it
+  // cannot be written.
+  static absl::Mutex mu(absl::kConstInit);
+  static auto* loaded ABSL_GUARDED_BY(mu) =
+      new absl::flat_hash_map<std::string, HostThroughput>();
+  absl::MutexLock lock(&mu);
+  if (auto it = loaded->find(path); it != loaded->end()) {
+    return it->second;
+  }
+
+  tsl::Env* env = tsl::Env::Default();
+  HostThroughput throughput;
+  if (env->FileExists(path).ok()) {
+    HostThroughputProto proto;
+    TF_RETURN_IF_ERROR(tsl::ReadTextProto(env, path, &proto));
+    TF_ASSIGN_OR_RETURN(throughput, FromProto(proto));
+  } else {
+    throughput = MeasureHostThroughput(tsl::port::MaxParallelism());
+    if (Status status = WriteHostThroughput(path, throughput); !status.ok()) {
+      LOG(WARNING) << "Failed to cache the host throughput in " << path
+                   << ": " << status;
+    }
+  }
+  loaded->emplace(path, throughput);
+  return throughput;
+}
+
+}  // namespace cpu
+}  // namespace xla
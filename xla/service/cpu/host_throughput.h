@@ -0,0 +1,56 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_HOST_THROUGHPUT_H_
+#define XLA_SERVICE_CPU_HOST_THROUGHPUT_H_
+
+#include <string>
+
+#include "xla/statusor.h"
+
+namespace xla {
+namespace cpu {
+
+// The compute and memory throughput of the host, as used by the parallel task
+// assignment cost model.
+struct HostThroughput {
+  // Vectorized single precision flops per second of a single core.
+  double flops_per_second_per_core;
+  // The memory bandwidth a single core can use, in bytes per second.
+  double bytes_per_second_per_core;
+  // The memory bandwidth of all cores together, in bytes per second.
+  double bytes_per_second;
+};
+
+// Returns the fixed throughput the cost model assumes when the host has not
+// been measured. It does not depend on the machine, so task assignment with
+// it is reproducible.
+HostThroughput DefaultHostThroughput();
+
+// Measures the throughput of the host with microbenchmarks that use up to
+// `num_threads` threads. Takes on the order of 100ms.
+HostThroughput MeasureHostThroughput(int num_threads);
+
+// Returns the throughput cached in the HostThroughputProto text file at
+// `path`. If there is no such file, the host is measured with
+// tsl::port::MaxParallelism() threads and the result is written to `path`, so
+// that each machine is measured once and every compilation on it then uses
+// the same numbers.
+StatusOr<HostThroughput> LoadOrMeasureHostThroughput(const std::string& path);
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_HOST_THROUGHPUT_H_
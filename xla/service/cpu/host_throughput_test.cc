@@ -0,0 +1,81 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/host_throughput.h"
+
+#include <string>
+
+#include "xla/service/cpu/host_throughput.pb.h"
+#include "xla/test.h"
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/statusor.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// LoadOrMeasureHostThroughput caches what it loads per path, so every test
+// uses files of its own.
+std::string TestFile(const std::string& name) {
+  return tsl::io::JoinPath(::testing::TempDir(), name);
+}
+
+TEST(HostThroughputTest, LoadsCachedThroughput) {
+  const std::string path = TestFile("loads_cached_throughput");
+  HostThroughputProto proto;
+  proto.set_flops_per_second_per_core(1e9);
+  proto.set_bytes_per_second_per_core(2e9);
+  proto.set_bytes_per_second(8e9);
+  TF_ASSERT_OK(tsl::WriteTextProto(tsl::Env::Default(), path, proto));
+
+  TF_ASSERT_OK_AND_ASSIGN(HostThroughput throughput,
+                          LoadOrMeasureHostThroughput(path));
+  EXPECT_EQ(throughput.flops_per_second_per_core, 1e9);
+  EXPECT_EQ(throughput.bytes_per_second_per_core, 2e9);
+  EXPECT_EQ(throughput.bytes_per_second, 8e9);
+}
+
+TEST(HostThroughputTest, MeasuresAndWritesMissingFile) {
+  const std::string path = TestFile("measures_and_writes_missing_file");
+  TF_ASSERT_OK_AND_ASSIGN(HostThroughput throughput,
+                          LoadOrMeasureHostThroughput(path));
+  EXPECT_GT(throughput.flops_per_second_per_core, 0);
+  EXPECT_GT(throughput.bytes_per_second_per_core, 0);
+  EXPECT_GE(throughput.bytes_per_second, throughput.bytes_per_second_per_core);
+
+  HostThroughputProto proto;
+  TF_ASSERT_OK(tsl::ReadTextProto(tsl::Env::Default(), path, &proto));
+  EXPECT_EQ(proto.flops_per_second_per_core(),
+            throughput.flops_per_second_per_core);
+  EXPECT_EQ(proto.bytes_per_second_per_core(),
+            throughput.bytes_per_second_per_core);
+  EXPECT_EQ(proto.bytes_per_second(), throughput.bytes_per_second);
+}
+
+TEST(HostThroughputTest, RejectsNonPositiveThroughput) {
+  const std::string path = TestFile("rejects_non_positive_throughput");
+  HostThroughputProto proto;
+  proto.set_flops_per_second_per_core(1e9);
+  proto.set_bytes_per_second(8e9);
+  TF_ASSERT_OK(tsl::WriteTextProto(tsl::Env::Default(), path, proto));
+
+  EXPECT_FALSE(LoadOrMeasureHostThroughput(path).ok());
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
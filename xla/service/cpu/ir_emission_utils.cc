@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "xla/service/cpu/ir_emission_utils.h"
 
+#include "xla/hlo/ir/hlo_casting_utils.h"
+#include "xla/hlo/ir/hlo_instructions.h"
 #include "xla/hlo/ir/hlo_module.h"
 #include "xla/layout_util.h"
 #include "xla/service/cpu/cpu_runtime.h"
@@ -110,5 +112,41 @@ bool PotentiallyImplementedAsEigenConvolution(
              kernel_shape.dimensions_size() - 1;
 }
 
+std::optional<SimpleSortComparator> MatchSimpleSortComparator(
+    const HloInstruction& sort) {
+  if (sort.opcode() != HloOpcode::kSort || sort.operand_count() != 1) {
+    return std::nullopt;
+  }
+  const HloComputation* comparator = sort.to_apply();
+  const HloInstruction* root = comparator->root_instruction();
+  if (root->opcode() != HloOpcode::kCompare ||
+      comparator->num_parameters() != 2) {
+    return std::nullopt;
+  }
+  const HloInstruction* lhs = root->operand(0);
+  const HloInstruction* rhs = root->operand(1);
+  if (lhs->opcode() != HloOpcode::kParameter ||
+      rhs->opcode() != HloOpcode::kParameter ||
+      lhs->parameter_number() == rhs->parameter_number()) {
+    return std::nullopt;
+  }
+  // Swapped parameters invert the sort order.
+  bool swapped = lhs->parameter_number() == 1;
+  const auto* compare = Cast<HloCompareInstruction>(root);
+  SimpleSortComparator result;
+  switch (compare->direction()) {
+    case ComparisonDirection::kLt:
+      result.descending = swapped;
+      break;
+    case ComparisonDirection::kGt:
+      result.descending = !swapped;
+      break;
+    default:
+      return std::nullopt;
+  }
+  result.total_order = compare->order() == ComparisonOrder::kTotal;
+  return result;
+}
+
 }  // namespace cpu
 }  // namespace xla
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef XLA_SERVICE_CPU_IR_EMISSION_UTILS_H_
 #define XLA_SERVICE_CPU_IR_EMISSION_UTILS_H_
 
+#include <optional>
+
 #include "llvm/IR/Value.h"
 #include "xla/hlo/ir/hlo_instruction.h"
 #include "xla/service/cpu/target_machine_features.h"
@@ -32,6 +34,21 @@ bool PotentiallyImplementedAsEigenConvolution(
 int64_t GetMinimumAlignmentForArray(
     const Shape& shape, const TargetMachineFeatures& target_machine_features);
 
+// Describes a sort comparator that is a single LT or GT comparison of the two
+// key parameters, see MatchSimpleSortComparator.
+struct SimpleSortComparator {
+  // Whether the comparator orders the keys in descending order (GT).
+  bool descending;
+  // Whether floating point keys are compared with the total order.
+  bool total_order;
+};
+
+// Returns the comparator properties if `sort` sorts a single array of keys
+// with a comparator of the form `compare(p0, p1), direction=LT|GT` (or the
+// equivalent with swapped parameters), and std::nullopt otherwise.
+std::optional<SimpleSortComparator> MatchSimpleSortComparator(
+    const HloInstruction& sort);
+
 // Dynamic loop bounds are specified as an array of dimension index
 // [start, limit) pairs of ir values (one for each partitioned outer dimension).
 //
@@ -52,5 +52,78 @@ ENTRY Conv {
       *conv_instr, target_machine_features));
 }
 
+TEST_F(IrEmitterTest, MatchesSimpleSortComparator) {
+  const char* const hlo_string = R"(
+HloModule ModuleWithSort
+
+compare {
+  p.0.lhs = f32[] parameter(0)
+  p.0.rhs = f32[] parameter(1)
+  ROOT gt = pred[] compare(p.0.lhs, p.0.rhs), direction=GT, type=TOTALORDER
+}
+
+ENTRY main {
+  a = f32[10] parameter(0)
+  ROOT result = f32[10] sort(a), dimensions={0}, to_apply=compare
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  auto comparator = cpu::MatchSimpleSortComparator(
+      *module->entry_computation()->root_instruction());
+  ASSERT_TRUE(comparator.has_value());
+  EXPECT_TRUE(comparator->descending);
+  EXPECT_TRUE(comparator->total_order);
+}
+
+TEST_F(IrEmitterTest, MatchesSimpleSortComparatorWithSwappedParameters) {
+  const char* const hlo_string = R"(
+HloModule ModuleWithSort
+
+compare {
+  p.0.lhs = s32[] parameter(0)
+  p.0.rhs = s32[] parameter(1)
+  ROOT lt = pred[] compare(p.0.rhs, p.0.lhs), direction=LT
+}
+
+ENTRY main {
+  a = s32[10] parameter(0)
+  ROOT result = s32[10] sort(a), dimensions={0}, to_apply=compare
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  auto comparator = cpu::MatchSimpleSortComparator(
+      *module->entry_computation()->root_instruction());
+  ASSERT_TRUE(comparator.has_value());
+  EXPECT_TRUE(comparator->descending);
+}
+
+TEST_F(IrEmitterTest, DoesNotMatchKeyValueSortComparator) {
+  const char* const hlo_string = R"(
+HloModule ModuleWithSort
+
+compare {
+  p.0.lhs = f32[] parameter(0)
+  p.0.rhs = f32[] parameter(1)
+  p.1.lhs = s32[] parameter(2)
+  p.1.rhs = s32[] parameter(3)
+  ROOT lt = pred[] compare(p.0.lhs, p.0.rhs), direction=LT
+}
+
+ENTRY main {
+  a = f32[10] parameter(0)
+  b = s32[10] parameter(1)
+  ROOT result = (f32[10], s32[10]) sort(a, b), dimensions={0},
+    to_apply=compare
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  EXPECT_FALSE(cpu::MatchSimpleSortComparator(
+                   *module->entry_computation()->root_instruction())
+                   .has_value());
+}
+
 }  // namespace
 }  // namespace xla
@@ -24,6 +24,7 @@ limitations under the License.
 #include <map>
 #include <memory>
 #include <numeric>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -614,6 +615,48 @@ Status IrEmitter::HandleSort(HloInstruction* hlo) {
     lower_dimensions *= normalized_keys_shape.dimensions(i);
   }
 
+  // Sorts of a single numeric array with a plain LT/GT comparator are handled
+  // by type-specialized runtime functions that don't call back into the
+  // comparator.
+  if (std::optional<SimpleSortComparator> simple_comparator =
+          MatchSimpleSortComparator(*sort)) {
+    const char* symbol_name = nullptr;
+    switch (keys_type) {
+      case S32:
+        symbol_name = runtime::kKeySortS32SymbolName;
+        break;
+      case S64:
+        symbol_name = runtime::kKeySortS64SymbolName;
+        break;
+      case U32:
+        symbol_name = runtime::kKeySortU32SymbolName;
+        break;
+      case U64:
+        symbol_name = runtime::kKeySortU64SymbolName;
+        break;
+      case F32:
+        symbol_name = runtime::kKeySortF32SymbolName;
+        break;
+      case F64:
+        symbol_name = runtime::kKeySortF64SymbolName;
+        break;
+      default:
+        break;
+    }
+    if (symbol_name != nullptr) {
+      EmitCallToFunc(
+          symbol_name,
+          {b_.getInt64(higher_dimensions), b_.getInt64(sort_dimension_elements),
+           b_.getInt64(lower_dimensions),
+           PointerCast(destination_addresses[0], b_.getInt8PtrTy()),
+           b_.getInt1(simple_comparator->descending),
+           b_.getInt1(simple_comparator->total_order),
+           b_.getInt1(sort->is_stable()), GetExecutableRunOptionsArgument()},
+          b_.getVoidTy());
+      return OkStatus();
+    }
+  }
+
   CHECK(absl::c_binary_search(thread_local_computations_, sort->to_apply()));
   llvm::Value* values = llvm_ir::EmitAllocaAtFunctionEntryWithCount(
       b_.getInt8PtrTy(), b_.getInt32(sort->operand_count()), "cc_values_alloca",
@@ -871,7 +914,8 @@ Status IrEmitter::HandleDot(HloInstruction* dot) {
   TF_RETURN_IF_ERROR(ElementTypesSameAndSupported(
       /*instruction=*/*dot, /*operands=*/{lhs, rhs},
       /*supported_types=*/
-      {PRED, S8, U8, S16, U16, S32, U32, S64, U64, F16, F32, F64, C64, C128}));
+      {PRED, S8, U8, S16, U16, S32, U32, S64, U64, F16, BF16, F32, F64, C64,
+       C128}));
   const DotDimensionNumbers& dnums = dot->dot_dimension_numbers();
 
   if (dnums.lhs_contracting_dimensions_size() != 1) {
@@ -1779,6 +1823,19 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
     return false;
   }
 
+  // If this is the root of a parallel computation, the loops over the
+  // partitioned (most major) dimensions of the output only cover the
+  // partition.
+  DynamicLoopBounds dynamic_loop_bounds;
+  if (ShouldEmitParallelLoopFor(*reduce)) {
+    if (num_dynamic_loop_bounds_ >= reduce->shape().rank()) {
+      *failure_reason =
+          "partitioning the minor dimension of the output not implemented";
+      return false;
+    }
+    dynamic_loop_bounds = compute_function_->GetDynamicLoopBounds();
+  }
+
   CHECK(!reduce->shape().IsTuple());
   TF_RETURN_IF_ERROR(EmitTargetAddressForOp(reduce));
 
@@ -1808,10 +1865,18 @@ StatusOr<bool> IrEmitter::EmitVectorizedReduce(
   for (int i = LayoutUtil::MinorToMajor(reduce->shape()).size() - 1; i > 0;
        --i) {
     int64_t dimension = LayoutUtil::Minor(reduce->shape().layout(), i);
-    int64_t start_index = 0;
-    int64_t end_index = reduce->shape().dimensions(dimension);
-    std::unique_ptr<llvm_ir::ForLoop> loop = loop_nest.AddLoop(
-        start_index, end_index, absl::StrFormat("dim.%d", dimension));
+    const int64_t bounds_index = reduce->shape().rank() - 1 - i;
+    std::unique_ptr<llvm_ir::ForLoop> loop;
+    if (bounds_index < dynamic_loop_bounds.size()) {
+      loop = loop_nest.AddLoop(absl::StrFormat("dim.%d", dimension),
+                               dynamic_loop_bounds[bounds_index].first,
+                               dynamic_loop_bounds[bounds_index].second);
+    } else {
+      int64_t start_index = 0;
+      int64_t end_index = reduce->shape().dimensions(dimension);
+      loop = loop_nest.AddLoop(start_index, end_index,
+                               absl::StrFormat("dim.%d", dimension));
+    }
     array_multi_index[dimension] = loop->GetIndVarValue();
   }
 
@@ -2394,7 +2459,28 @@ Status IrEmitter::HandleTopK(HloInstruction* hlo) {
   const HloInstruction* input = hlo->operand(0);
   const int64_t k = hlo->shape().tuple_shapes(0).dimensions().back();
   const bool has_batch = hlo->shape().tuple_shapes(0).dimensions_size() == 2;
-  TF_RET_CHECK(input->shape().element_type() == F32);
+  const PrimitiveType element_type = input->shape().element_type();
+  const char* symbol_name = nullptr;
+  switch (element_type) {
+    case BF16:
+      symbol_name = runtime::kTopKBF16SymbolName;
+      break;
+    case F16:
+      symbol_name = runtime::kTopKF16SymbolName;
+      break;
+    case F32:
+      symbol_name = runtime::kTopKF32SymbolName;
+      break;
+    case S32:
+      symbol_name = runtime::kTopKS32SymbolName;
+      break;
+    case U32:
+      symbol_name = runtime::kTopKU32SymbolName;
+      break;
+    default:
+      return Unimplemented("TopK is not implemented on CPU for %s.",
+                           PrimitiveType_Name(element_type));
+  }
   TF_RET_CHECK(LayoutUtil::IsMonotonicWithDim0Major(
       hlo->shape().tuple_shapes(0).layout()));
   TF_RET_CHECK(LayoutUtil::IsMonotonicWithDim0Major(
@@ -2414,13 +2500,20 @@ Status IrEmitter::HandleTopK(HloInstruction* hlo) {
       EmitBufferPointer(out_values_slice, hlo->shape().tuple_shapes(0));
   llvm::Value* out_indices_ptr =
       EmitBufferPointer(out_indices_slice, hlo->shape().tuple_shapes(1));
+  // BF16 and F16 values are passed to the runtime as their raw bit patterns.
+  llvm::Type* element_ptr_type =
+      primitive_util::BitWidth(element_type) == 16
+          ? b_.getInt16Ty()->getPointerTo()
+          : llvm_ir::PrimitiveTypeToIrType(element_type, module_)
+                ->getPointerTo();
   EmitCallToFunc(
-      runtime::kTopKF32SymbolName,
+      symbol_name,
       {b_.getInt64(has_batch ? input->shape().dimensions(0) : 1),
        b_.getInt64(input->shape().dimensions().back()), b_.getInt64(k),
-       BitCast(values_ptr, b_.getFloatTy()->getPointerTo()),
-       BitCast(out_values_ptr, b_.getFloatTy()->getPointerTo()),
-       BitCast(out_indices_ptr, b_.getInt32Ty()->getPointerTo())},
+       BitCast(values_ptr, element_ptr_type),
+       BitCast(out_values_ptr, element_ptr_type),
+       BitCast(out_indices_ptr, b_.getInt32Ty()->getPointerTo()),
+       GetExecutableRunOptionsArgument()},
       b_.getVoidTy());
 
   llvm_ir::EmitTuple(GetIrArrayFor(hlo), {out_values_ptr, out_indices_ptr},
@@ -16,6 +16,7 @@ limitations under the License.
 #include "xla/service/cpu/parallel_task_assignment.h"
 
 #include <algorithm>
+#include <limits>
 #include <memory>
 
 #include "absl/strings/str_cat.h"
@@ -52,77 +53,79 @@ class SimpleCostModel : public ParallelCostModel {
   const HloCostAnalysis::ShapeSizeFunction shape_size_;
 };
 
-class DefaultCostModel : public ParallelCostModel {
+// Picks the task count with the lowest estimated run time, given the work
+// HloCostAnalysis counts for an instruction and the measured throughput of the
+// host. Each task adds a fixed overhead, and memory bound instructions stop
+// getting faster once their tasks saturate the memory bandwidth.
+class CalibratedCostModel : public ParallelCostModel {
  public:
-  DefaultCostModel(const int64_t max_parallelism,
-                   const HloCostAnalysis::ShapeSizeFunction& shape_size,
-                   std::unique_ptr<HloCostAnalysis> cost_analysis)
+  CalibratedCostModel(const int64_t max_parallelism,
+                      const HostThroughput& host_throughput,
+                      std::unique_ptr<HloCostAnalysis> cost_analysis)
       : max_parallelism_(max_parallelism),
-        shape_size_(shape_size),
+        host_throughput_(host_throughput),
         cost_analysis_(std::move(cost_analysis)) {}
-  ~DefaultCostModel() override {}
+  ~CalibratedCostModel() override {}
 
   int64_t GetParallelTaskCount(HloInstruction* instruction) override {
-    // Parameters for parallel task count computation.
-    int64_t instruction_cost;
-    int64_t min_cost_per_thread;
-    int64_t max_parallelism;
-    // Calculate flops-to-bytes-ratio for 'instruction'.
-    const int64_t bytes_accessed =
-        std::max(int64_t{1}, cost_analysis_->bytes_accessed(*instruction));
-    const float flops_to_bytes_ratio =
-        cost_analysis_->flop_count(*instruction) /
-        static_cast<float>(bytes_accessed);
-    // Check for I/O bound instructions.
-    if (flops_to_bytes_ratio <= 1.0) {
-      // Limit max parallelism for I/O bound instructions by assuming a
-      // sub-linear scaling function (fit based on empirical benchmark results).
-      // TODO(b/29630486) Develop system bandwidth model.
-      max_parallelism = std::min<int64_t>(
-          max_parallelism_, std::ceil(std::sqrt(tsl::port::MaxParallelism())));
-      // Use shape size instruction cost and L2 cache size min per-thread cost.
-      instruction_cost = shape_size_(instruction->shape());
-      min_cost_per_thread = 256LL << 10;  // 256KB L2 Cache size.
-    } else {
-      // Use max parallelism for compute bound instructions.
-      max_parallelism = max_parallelism_;
-      // Calculate the instruction cost in cycles.
-      // TODO(b/29630486) Improve on this linear cost model.
-      // Consider making 'min_cost_per_thread' be a function of the target
-      // bandwidth limit for instructions with low arithmetic complexity.
-      instruction_cost =
-          1 * cost_analysis_->flop_count(*instruction) +
-          2 * cost_analysis_->transcendental_count(*instruction) +
-          10 * cost_analysis_->bytes_accessed(*instruction);
-      // Minimum per-thread cost is 100us of work on a 2GHz core.
-      min_cost_per_thread = 100000;
+    const double flops =
+        cost_analysis_->flop_count(*instruction) +
+        kFlopsPerTranscendental *
+            cost_analysis_->transcendental_count(*instruction);
+    const double bytes = cost_analysis_->bytes_accessed(*instruction);
+    int64_t best_task_count = 1;
+    double best_seconds = std::numeric_limits<double>::infinity();
+    for (int64_t task_count = 1; task_count <= max_parallelism_;
+         ++task_count) {
+      const double compute_seconds =
+          flops / (task_count * host_throughput_.flops_per_second_per_core);
+      const double bandwidth =
+          std::min(task_count * host_throughput_.bytes_per_second_per_core,
+                   host_throughput_.bytes_per_second);
+      const double memory_seconds = bytes / bandwidth;
+      const double seconds = std::max(compute_seconds, memory_seconds) +
+                             (task_count - 1) * kSecondsPerTask;
+      if (seconds < best_seconds) {
+        best_task_count = task_count;
+        best_seconds = seconds;
+      }
     }
-    // Return target parallel task count in [1, max_parallelism_].
-    return std::min(
-        max_parallelism,
-        std::max(int64_t{1}, instruction_cost / min_cost_per_thread));
+    return best_task_count;
   }
 
  private:
+  // HloCostAnalysis counts transcendental functions separately from flops;
+  // their polynomial approximations take about this many flops each.
+  static constexpr double kFlopsPerTranscendental = 20;
+  // The cost of handing a task to the thread pool and joining it.
+  static constexpr double kSecondsPerTask = 5e-6;
+
   const int64_t max_parallelism_;
-  const HloCostAnalysis::ShapeSizeFunction shape_size_;
+  const HostThroughput host_throughput_;
   const std::unique_ptr<HloCostAnalysis> cost_analysis_;
 };
 
 ParallelTaskAssignment::ParallelTaskAssignment(
     const int64_t max_parallelism,
     const HloCostAnalysis::ShapeSizeFunction& shape_size, HloModule* module,
-    const TargetMachineFeatures* target_machine_features)
+    const TargetMachineFeatures* target_machine_features,
+    const HostThroughput& host_throughput)
     : target_machine_features_(*target_machine_features) {
   VLOG(1) << "ParallelTaskAssignment max_parallelism: " << max_parallelism;
-  // Run cost analysis on 'module'.
+  // Run cost analysis on 'module', including the bodies of while loops and
+  // called computations, which get parallel tasks too.
   auto cost_analysis = std::make_unique<HloCostAnalysis>(shape_size);
-  HloComputation* computation = module->entry_computation();
-  Status status = computation->root_instruction()->Accept(cost_analysis.get());
+  Status status;
+  for (HloComputation* computation : module->MakeNonfusionComputations()) {
+    status = computation->Accept(cost_analysis.get());
+    if (!status.ok()) {
+      break;
+    }
+  }
   if (status.ok()) {
     // Set default cost model based on 'cost_analysis'.
-    cost_model_.reset(new DefaultCostModel(max_parallelism, shape_size,
-                                           std::move(cost_analysis)));
+    cost_model_.reset(new CalibratedCostModel(
+        max_parallelism, host_throughput, std::move(cost_analysis)));
   } else {
     // Fall back to a simple cost model based on hlo size and L2 cache size.
     // Note that HloCostAnalysis can returns an error status (likely because
@@ -223,9 +226,16 @@ bool ParallelTaskAssigner::AssignParallelTasksHelper(
     }
     // Get target parallel task count computed for 'instruction'.
     const int64_t target_parallel_task_count = (*it).second;
+    // Over-decompose instructions that may use every thread. Those the cost
+    // model limits to fewer tasks keep one partition per task, since the
+    // runtime runs up to one worker per partition.
+    const int64_t target_partition_count =
+        target_parallel_task_count >= max_parallelism_
+            ? target_parallel_task_count * kPartitionsPerTask
+            : target_parallel_task_count;
     // Assign feasible dimension partitions (based on actual dimension sizes).
     auto dim_partition_counts = ShapePartitionAssigner(instruction->shape())
-                                    .Run(target_parallel_task_count);
+                                    .Run(target_partition_count);
     const int64_t total_partition_count =
         ShapePartitionAssigner::GetTotalPartitionCount(dim_partition_counts);
     if (total_partition_count <= 1) {
@@ -256,9 +266,9 @@ bool ParallelTaskAssigner::AssignParallelTasksHelper(
 
 void ParallelTaskAssigner::ComputeTargetParallelTasks(
     HloModule* module, HloToParallelTasks* hlo_to_parallel_tasks) {
-  ParallelTaskAssignment parallel_task_assignment(max_parallelism_,
-                                                  shape_size_function_, module,
-                                                  &target_machine_features_);
+  ParallelTaskAssignment parallel_task_assignment(
+      max_parallelism_, shape_size_function_, module, &target_machine_features_,
+      host_throughput_);
 
   // Compute parallel task counts for all instructions in 'module'.
   for (auto* computation : module->MakeNonfusionComputations()) {
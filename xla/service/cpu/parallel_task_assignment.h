@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "xla/hlo/ir/hlo_module.h"
+#include "xla/service/cpu/host_throughput.h"
 #include "xla/service/cpu/target_machine_features.h"
 #include "xla/service/hlo_cost_analysis.h"
 #include "xla/service/hlo_pass_interface.h"
@@ -39,10 +40,12 @@ class ParallelTaskAssignment {
   // 'shape_size': shape size function used by HloCostAnalysis during parallel
   //               task assignment.
   // 'module': the containing HloModule.
+  // 'host_throughput': the throughput of the host the module will run on.
   ParallelTaskAssignment(const int64_t max_parallelism,
                          const HloCostAnalysis::ShapeSizeFunction& shape_size,
                          HloModule* module,
-                         const TargetMachineFeatures* target_machine_features);
+                         const TargetMachineFeatures* target_machine_features,
+                         const HostThroughput& host_throughput);
   ~ParallelTaskAssignment() {}
 
   // Computes and returns the target parallel task count for 'instruction'.
@@ -66,14 +69,23 @@ class ParallelTaskAssigner : public HloModulePass {
   // 'max_parallelism': the maximum parallel task count per instruction.
   // 'shape_size': shape size function used by HloCostAnalysis during parallel
   //               task assignment.
-  ParallelTaskAssigner(const int64_t max_parallelism,
-                       const HloCostAnalysis::ShapeSizeFunction& shape_size,
-                       const TargetMachineFeatures* target_machine_features)
+  // 'host_throughput': the throughput the cost model assumes.
+  ParallelTaskAssigner(
+      const int64_t max_parallelism,
+      const HloCostAnalysis::ShapeSizeFunction& shape_size,
+      const TargetMachineFeatures* target_machine_features,
+      const HostThroughput& host_throughput)
       : max_parallelism_(max_parallelism),
         shape_size_function_(shape_size),
-        target_machine_features_(*target_machine_features) {}
+        target_machine_features_(*target_machine_features),
+        host_throughput_(host_throughput) {}
   ~ParallelTaskAssigner() override {}
 
+  // Instructions that get 'max_parallelism' tasks are split into this many
+  // partitions per task. The fork/join runtime balances them over the threads
+  // it actually has, which evens out partitions that take longer than others.
+  static constexpr int64_t kPartitionsPerTask = 4;
+
   absl::string_view name() const override {
     return "cpu-parallel-task-assigner";
   }
@@ -107,6 +119,7 @@ class ParallelTaskAssigner : public HloModulePass {
   int64_t max_parallelism_;
   HloCostAnalysis::ShapeSizeFunction shape_size_function_;
   const TargetMachineFeatures& target_machine_features_;
+  const HostThroughput host_throughput_;
 };
 
 }  // namespace cpu
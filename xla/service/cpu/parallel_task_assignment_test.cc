@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "xla/service/cpu/parallel_task_assignment.h"
 
+#include "xla/service/cpu/backend_config.pb.h"
 #include "xla/service/cpu/cpu_executable.h"
 #include "xla/service/cpu/target_machine_features_fake.h"
 #include "xla/test.h"
@@ -35,6 +36,12 @@ class ParallelTaskAssignmentTest : public HloTestBase {
 
   cpu::TargetMachineFeaturesWithFakeAlignmentLogic target_machine_features_;
 
+  // A host whose memory bandwidth is saturated by four cores streaming data.
+  const cpu::HostThroughput host_throughput_ = {
+      /*flops_per_second_per_core=*/2e9,
+      /*bytes_per_second_per_core=*/1e10,
+      /*bytes_per_second=*/4e10};
+
   ParallelTaskAssignmentTest()
       : HloTestBase(), target_machine_features_([](int64_t shape_size) {
           return cpu::TargetMachineFeatures::kEigenExpectedTensorAlignment;
@@ -42,7 +49,8 @@ class ParallelTaskAssignmentTest : public HloTestBase {
 
   StatusOr<bool> RunParallelTaskAssigner(HloModule* module) {
     return cpu::ParallelTaskAssigner(max_parallelism_, shape_size_func_,
-                                     &target_machine_features_)
+                                     &target_machine_features_,
+                                     host_throughput_)
         .Run(module);
   }
 };
@@ -192,6 +200,154 @@ TEST_F(ParallelTaskAssignmentTest, AllReduceNotParallelized) {
   EXPECT_FALSE(changed);
 }
 
+// A compute bound loop large enough for every thread gets
+// kPartitionsPerTask partitions per thread.
+TEST_F(ParallelTaskAssignmentTest, ComputeBoundLoopIsOverDecomposed) {
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_overdecompose
+    fused_computation {
+      p = f32[1048576] parameter(0)
+      m0 = f32[1048576] multiply(p, p)
+      m1 = f32[1048576] multiply(m0, m0)
+      m2 = f32[1048576] multiply(m1, m1)
+      m3 = f32[1048576] multiply(m2, m2)
+      m4 = f32[1048576] multiply(m3, m3)
+      m5 = f32[1048576] multiply(m4, m4)
+      m6 = f32[1048576] multiply(m5, m5)
+      m7 = f32[1048576] multiply(m6, m6)
+      m8 = f32[1048576] multiply(m7, m7)
+      m9 = f32[1048576] multiply(m8, m8)
+      m10 = f32[1048576] multiply(m9, m9)
+      m11 = f32[1048576] multiply(m10, m10)
+      m12 = f32[1048576] multiply(m11, m11)
+      m13 = f32[1048576] multiply(m12, m12)
+      m14 = f32[1048576] multiply(m13, m13)
+      ROOT m15 = f32[1048576] multiply(m14, m14)
+    }
+
+    ENTRY entry {
+      input = f32[1048576] parameter(0)
+      ROOT fusion = f32[1048576] fusion(input), kind=kLoop,
+        calls=fused_computation
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_TRUE(changed);
+
+  const HloInstruction* fusion = m->entry_computation()
+                                  ->root_instruction()
+                                  ->to_apply()
+                                  ->root_instruction();
+  TF_ASSERT_OK_AND_ASSIGN(auto backend_config,
+                          fusion->backend_config<cpu::BackendConfig>());
+  EXPECT_THAT(backend_config.outer_dimension_partitions(),
+              ::testing::ElementsAre(
+                  max_parallelism_ *
+                  cpu::ParallelTaskAssigner::kPartitionsPerTask));
+}
+
+TEST_F(ParallelTaskAssignmentTest, SmallOperationNotParallelized) {
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_small
+    ENTRY entry {
+      p0 = f32[1024] parameter(0)
+      p1 = f32[1024] parameter(1)
+      ROOT add = f32[1024] add(p0, p1)
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_FALSE(changed);
+}
+
+// Threads beyond those needed to saturate the memory bandwidth do not make a
+// memory bound operation any faster.
+TEST_F(ParallelTaskAssignmentTest, MemoryBoundOperationSaturatesBandwidth) {
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_negate
+    ENTRY entry {
+      p = f32[4096,4096] parameter(0)
+      ROOT negate = f32[4096,4096] negate(p)
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_TRUE(changed);
+
+  // Four cores saturate the memory bandwidth, any more only add overhead.
+  const HloInstruction* negate = m->entry_computation()
+                                  ->root_instruction()
+                                  ->to_apply()
+                                  ->root_instruction();
+  TF_ASSERT_OK_AND_ASSIGN(auto backend_config,
+                          negate->backend_config<cpu::BackendConfig>());
+  EXPECT_THAT(backend_config.outer_dimension_partitions(),
+              ::testing::ElementsAre(4));
+}
+
+TEST_F(ParallelTaskAssignmentTest, ReduceIsParallelized) {
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_reduce
+    add {
+      lhs = f32[] parameter(0)
+      rhs = f32[] parameter(1)
+      ROOT add = f32[] add(lhs, rhs)
+    }
+
+    ENTRY entry {
+      p = f32[4096,4096] parameter(0)
+      zero = f32[] constant(0)
+      ROOT reduce = f32[4096] reduce(p, zero), dimensions={1}, to_apply=add
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_TRUE(changed);
+
+  const HloInstruction* reduce = m->entry_computation()
+                                  ->root_instruction()
+                                  ->to_apply()
+                                  ->root_instruction();
+  EXPECT_EQ(reduce->opcode(), HloOpcode::kReduce);
+  TF_ASSERT_OK_AND_ASSIGN(auto backend_config,
+                          reduce->backend_config<cpu::BackendConfig>());
+  ASSERT_EQ(backend_config.outer_dimension_partitions_size(), 1);
+  EXPECT_GT(backend_config.outer_dimension_partitions(0), 1);
+}
+
+// The outer dimension partitions only split the output, so a reduction to a
+// scalar runs on one thread.
+TEST_F(ParallelTaskAssignmentTest, ReduceToScalarNotParallelized) {
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_reduce_to_scalar
+    add {
+      lhs = f32[] parameter(0)
+      rhs = f32[] parameter(1)
+      ROOT add = f32[] add(lhs, rhs)
+    }
+
+    ENTRY entry {
+      p = f32[4096,4096] parameter(0)
+      zero = f32[] constant(0)
+      ROOT reduce = f32[] reduce(p, zero), dimensions={0,1}, to_apply=add
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_FALSE(changed);
+}
+
 TEST_F(ParallelTaskAssignmentTest, ConstantNotParallelized) {
   constexpr char hlo_string[] = R"(
   HloModule TestTaskParallel_constant
@@ -17,11 +17,22 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "absl/base/dynamic_annotations.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "xla/executable_run_options.h"
+#include "xla/service/cpu/runtime_thread_pool.h"
 #include "xla/service/custom_call_status_internal.h"
 #include "tsl/platform/blocking_counter.h"
 #include "tsl/platform/logging.h"
@@ -29,9 +40,110 @@ limitations under the License.
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
                                      void*, int64_t*, uint64_t*);
 
-// Dispatches 'num_partitions - 1' calls to 'function_ptr' in parallel.
-// Calls 'function_ptr' for first partition inline.
-// Uses blocking counter to synchronize threads after parallel calls complete.
+namespace {
+
+// The partitions [begin, end) a worker has yet to run. Both bounds are packed
+// into one word, so that the owner taking partitions from the front and
+// thieves taking them from the back each claim them with a single CAS.
+class PartitionRange {
+ public:
+  void Reset(int32_t begin, int32_t end) {
+    range_.store(Pack(begin, end), std::memory_order_release);
+  }
+
+  // Claims the first partition of the range, or returns -1 if it is empty.
+  int32_t PopFront() {
+    uint64_t range = range_.load(std::memory_order_acquire);
+    while (Begin(range) < End(range)) {
+      if (range_.compare_exchange_weak(range,
+                                       Pack(Begin(range) + 1, End(range)),
+                                       std::memory_order_acq_rel)) {
+        return Begin(range);
+      }
+    }
+    return -1;
+  }
+
+  // Claims the back half of the range, rounded up, and returns the claimed
+  // partitions. Returns an empty range if there is nothing to steal.
+  std::pair<int32_t, int32_t> StealHalf() {
+    uint64_t range = range_.load(std::memory_order_acquire);
+    while (Begin(range) < End(range)) {
+      int32_t mid = Begin(range) + (End(range) - Begin(range)) / 2;
+      if (range_.compare_exchange_weak(range, Pack(Begin(range), mid),
+                                       std::memory_order_acq_rel)) {
+        return {mid, End(range)};
+      }
+    }
+    return {0, 0};
+  }
+
+ private:
+  static uint64_t Pack(int32_t begin, int32_t end) {
+    return static_cast<uint64_t>(begin) << 32 | static_cast<uint32_t>(end);
+  }
+  static int32_t Begin(uint64_t range) { return range >> 32; }
+  static int32_t End(uint64_t range) { return range & 0xffffffff; }
+
+  // Keep the ranges of different workers on different cache lines.
+  alignas(64) std::atomic<uint64_t> range_{0};
+};
+
+// The state shared by the workers of one ParallelForkJoin call. Helpers the
+// pool only gets around to running after all partitions have been claimed
+// still see it, so it is reference counted rather than owned by the caller.
+struct ForkJoinState {
+  ForkJoinState(int32_t num_partitions, int32_t num_workers)
+      : ranges(num_workers), statuses(num_partitions), pending(num_partitions) {
+    // Start every worker on a contiguous block of partitions, so that
+    // neighbouring partitions tend to run on the same core.
+    for (int32_t i = 0; i < num_workers; ++i) {
+      ranges[i].Reset(
+          static_cast<int64_t>(num_partitions) * i / num_workers,
+          static_cast<int64_t>(num_partitions) * (i + 1) / num_workers);
+    }
+  }
+
+  // Claims a partition from the range of `worker`, or if that is exhausted,
+  // steals half of the partitions left to another worker. Returns -1 once
+  // every partition has been claimed.
+  int32_t Claim(int32_t worker) {
+    int32_t partition = ranges[worker].PopFront();
+    if (partition >= 0) {
+      return partition;
+    }
+    const int32_t num_workers = ranges.size();
+    for (int32_t i = 1; i < num_workers; ++i) {
+      auto [begin, end] = ranges[(worker + i) % num_workers].StealHalf();
+      if (begin < end) {
+        ranges[worker].Reset(begin + 1, end);
+        return begin;
+      }
+    }
+    return -1;
+  }
+
+  std::vector<PartitionRange> ranges;
+  std::vector<XlaCustomCallStatus> statuses;
+  // Counts down the partitions that have not finished running.
+  tsl::BlockingCounter pending;
+};
+
+}  // namespace
+
+// Calls 'function_ptr' once for each partition, in parallel.
+//
+// The partitions are spread over the calling thread and up to one helper task
+// per thread of the pool: the RuntimeThreadPool of 'run_options_ptr' if it has
+// one, otherwise its intra-op pool. Without either, as may be the case for
+// ahead-of-time compiled executables, every partition runs on the calling
+// thread. Each worker starts on its own contiguous
+// block of partitions and steals half of the remaining partitions of another
+// worker when it runs out, so the compiler can over-decompose loops into more
+// partitions than there are threads and skewed partitions still keep every
+// core busy. The caller only waits for partitions to finish, not for helpers
+// to start, so calls from inside the pool (e.g. nested parallelism) degrade to
+// running on the calling thread instead of waiting on a busy pool.
 //
 // The 'partitions' array has a total number of elements equal to
 // 'num_partitions * num_partitioned_dims * 2' (the '2' is necessary to specify
@@ -73,34 +185,61 @@ ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_ParallelForkJoin(
   const xla::ExecutableRunOptions* run_options =
       static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
   CHECK_NE(run_options, nullptr);
-  CHECK_NE(run_options->intra_op_thread_pool(), nullptr);
+  const xla::cpu::RuntimeThreadPool* runtime_pool =
+      run_options->cpu_runtime_thread_pool();
+  const Eigen::ThreadPoolDevice* pool =
+      runtime_pool == nullptr ? run_options->intra_op_thread_pool() : nullptr;
 
   ComputeFunctionType function =
       reinterpret_cast<ComputeFunctionType>(function_ptr);
   // Compute partition stride in 'partitions' array.
   const int64_t stride = 2 * num_partitioned_dims;
 
-  std::vector<XlaCustomCallStatus> statuses(num_partitions);
-
-  // Dispatch 'num_partitions - 1' compute functions to run in parallel.
-  tsl::BlockingCounter bc(num_partitions - 1);
-  for (int32_t i = 1; i < num_partitions; ++i) {
-    const int64_t offset = i * stride;
-    run_options->intra_op_thread_pool()->enqueueNoNotification(
-        [i, function, result_ptr, run_options_ptr, buffer_table, prof_counters,
-         partitions, offset, &bc, &statuses]() {
-          function(result_ptr, run_options_ptr, nullptr, buffer_table,
-                   &statuses[i], &partitions[offset], prof_counters);
-          bc.DecrementCount();
-          VLOG(3) << "ParallelForkJoin partition " << i << " done.";
-        });
+  // A caller that is itself a pool thread already occupies one of them.
+  int num_threads = 0;
+  bool nested = false;
+  if (runtime_pool != nullptr) {
+    num_threads = runtime_pool->NumThreads();
+    nested = runtime_pool->CurrentThreadId() >= 0;
+  } else if (pool != nullptr) {
+    num_threads = pool->numThreads();
+    nested = pool->currentThreadId() >= 0;
   }
+  const int32_t num_workers = std::max(
+      1, std::min(num_partitions, num_threads + (nested ? 0 : 1)));
+  auto state = std::make_shared<ForkJoinState>(num_partitions, num_workers);
 
-  // Call first compute function inline.
-  function(result_ptr, run_options_ptr, params, buffer_table, &statuses[0],
-           &partitions[0], prof_counters);
-  VLOG(3) << "ParallelForkJoin partition 0 done.";
-  bc.Wait();
+  auto run_worker = [function, result_ptr, run_options_ptr, buffer_table,
+                     prof_counters, partitions,
+                     stride](ForkJoinState& fork_join, int32_t worker) {
+    for (int32_t i = fork_join.Claim(worker); i >= 0;
+         i = fork_join.Claim(worker)) {
+      function(result_ptr, run_options_ptr, nullptr, buffer_table,
+               &fork_join.statuses[i], &partitions[i * stride], prof_counters);
+      VLOG(3) << "ParallelForkJoin partition " << i << " done on worker "
+              << worker << ".";
+      fork_join.pending.DecrementCount();
+    }
+  };
+
+  // Dispatch 'num_workers - 1' helpers and run the first worker inline.
+  for (int32_t worker = 1; worker < num_workers; ++worker) {
+    auto helper = [state, worker, run_worker]() { run_worker(*state, worker); };
+    if (runtime_pool != nullptr) {
+      runtime_pool->Schedule(
+          [](void* arg) {
+            std::unique_ptr<std::function<void()>> fn(
+                static_cast<std::function<void()>*>(arg));
+            (*fn)();
+          },
+          new std::function<void()>(std::move(helper)));
+    } else {
+      pool->enqueueNoNotification(std::move(helper));
+    }
+  }
+  run_worker(*state, 0);
+  state->pending.Wait();
+  std::vector<XlaCustomCallStatus>& statuses = state->statuses;
 
   // Collect all error messages (if any).
   std::vector<std::pair<int32_t, absl::string_view>> error_messages;
@@ -0,0 +1,279 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include "xla/service/cpu/runtime_fork_join.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "xla/executable_run_options.h"
+#include "xla/service/cpu/runtime_thread_pool.h"
+#include "xla/service/custom_call_status.h"
+#include "xla/service/custom_call_status_internal.h"
+#include "tsl/platform/blocking_counter.h"
+#include "tsl/platform/cpu_info.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+
+namespace xla {
+namespace {
+
+// Returns the bounds of `num_partitions` partitions of a single dimension of
+// size `size`, in the layout ParallelForkJoin expects.
+std::vector<int64_t> PartitionDimension(int64_t size, int32_t num_partitions) {
+  std::vector<int64_t> partitions;
+  for (int32_t i = 0; i < num_partitions; ++i) {
+    partitions.push_back(size * i / num_partitions);
+    partitions.push_back(size * (i + 1) / num_partitions);
+  }
+  return partitions;
+}
+
+// Counts the elements of its partition in the std::atomic<int> array passed as
+// the first buffer.
+void CountElements(void* /*result*/, const void* /*run_options*/,
+                   const void** /*params*/, void** buffer_table,
+                   void* /*status*/, int64_t* partition,
+                   uint64_t* /*prof_counters*/) {
+  auto* counts = static_cast<std::atomic<int>*>(buffer_table[0]);
+  for (int64_t i = partition[0]; i < partition[1]; ++i) {
+    counts[i].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+// Fails the partitions that start at an odd index.
+void FailOddPartitions(void* /*result*/, const void* /*run_options*/,
+                       const void** /*params*/, void** /*buffer_table*/,
+                       void* status, int64_t* partition,
+                       uint64_t* /*prof_counters*/) {
+  if (partition[0] % 2 == 1) {
+    std::string message = absl::StrCat("odd start ", partition[0]);
+    XlaCustomCallStatusSetFailure(static_cast<XlaCustomCallStatus*>(status),
+                                  message.data(), message.size());
+  }
+}
+
+void ForkJoin(const ExecutableRunOptions& run_options, void** buffer_table,
+              XlaCustomCallStatus* status, std::vector<int64_t>& partitions,
+              void (*function)(void*, const void*, const void**, void**, void*,
+                               int64_t*, uint64_t*)) {
+  __xla_cpu_runtime_ParallelForkJoin(
+      /*result_ptr=*/nullptr, &run_options, /*params=*/nullptr, buffer_table,
+      status, /*prof_counters=*/nullptr, partitions.size() / 2,
+      partitions.data(), /*num_partitioned_dims=*/1,
+      reinterpret_cast<void*>(function));
+}
+
+class ParallelForkJoinTest
+    : public ::testing::TestWithParam<std::tuple<int, int32_t>> {};
+
+TEST_P(ParallelForkJoinTest, RunsEveryPartitionOnce) {
+  auto [num_threads, num_partitions] = GetParam();
+  Eigen::ThreadPool pool(num_threads);
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  ExecutableRunOptions run_options;
+  run_options.set_intra_op_thread_pool(&device);
+
+  constexpr int64_t kSize = 5000;
+  std::vector<std::atomic<int>> counts(kSize);
+  void* buffer_table[] = {counts.data()};
+  std::vector<int64_t> partitions = PartitionDimension(kSize, num_partitions);
+  XlaCustomCallStatus status;
+  ForkJoin(run_options, buffer_table, &status, partitions, CountElements);
+
+  EXPECT_FALSE(CustomCallStatusGetMessage(&status).has_value());
+  for (int64_t i = 0; i < kSize; ++i) {
+    EXPECT_EQ(counts[i].load(), 1) << "at " << i;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(ParallelForkJoinTestInstantiation,
+                         ParallelForkJoinTest,
+                         ::testing::Combine(::testing::Values(1, 2, 8),
+                                            ::testing::Values(2, 7, 64, 1000)));
+
+TEST(ParallelForkJoinErrorTest, ReportsFailedPartitions) {
+  Eigen::ThreadPool pool(3);
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  ExecutableRunOptions run_options;
+  run_options.set_intra_op_thread_pool(&device);
+
+  std::vector<int64_t> partitions = PartitionDimension(4, 4);
+  XlaCustomCallStatus status;
+  ForkJoin(run_options, /*buffer_table=*/nullptr, &status, partitions,
+           FailOddPartitions);
+
+  std::optional<absl::string_view> message =
+      CustomCallStatusGetMessage(&status);
+  ASSERT_TRUE(message.has_value());
+  EXPECT_EQ(*message,
+            "Partition 1 error: odd start 1\nPartition 3 error: odd start 3");
+}
+
+// Fork/joins from inside the pool must not wait on pool threads that are busy
+// with the callers themselves.
+TEST(ParallelForkJoinNestedTest, CompletesWhenCalledFromEveryPoolThread) {
+  constexpr int kNumThreads = 2;
+  Eigen::ThreadPool pool(kNumThreads);
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  ExecutableRunOptions run_options;
+  run_options.set_intra_op_thread_pool(&device);
+
+  constexpr int64_t kSize = 1000;
+  std::vector<std::atomic<int>> counts(kSize);
+  void* buffer_table[] = {counts.data()};
+  std::vector<int64_t> partitions = PartitionDimension(kSize, 16);
+
+  tsl::BlockingCounter outer(kNumThreads);
+  for (int i = 0; i < kNumThreads; ++i) {
+    pool.Schedule([&]() {
+      XlaCustomCallStatus status;
+      ForkJoin(run_options, buffer_table, &status, partitions, CountElements);
+      outer.DecrementCount();
+    });
+  }
+  outer.Wait();
+
+  for (int64_t i = 0; i < kSize; ++i) {
+    EXPECT_EQ(counts[i].load(), kNumThreads) << "at " << i;
+  }
+}
+
+// A RuntimeThreadPool on top of an Eigen pool that counts the functions
+// scheduled on it.
+class CountingRuntimeThreadPool : public cpu::RuntimeThreadPool {
+ public:
+  explicit CountingRuntimeThreadPool(int num_threads) : pool_(num_threads) {}
+
+  int NumThreads() const override { return pool_.NumThreads(); }
+  int CurrentThreadId() const override { return pool_.CurrentThreadId(); }
+  void Schedule(void (*fn)(void*), void* arg) const override {
+    num_scheduled_.fetch_add(1, std::memory_order_relaxed);
+    pool_.Schedule([fn, arg]() { fn(arg); });
+  }
+
+  int num_scheduled() const { return num_scheduled_.load(); }
+
+ private:
+  mutable Eigen::ThreadPool pool_;
+  mutable std::atomic<int> num_scheduled_{0};
+};
+
+TEST(ParallelForkJoinRuntimeThreadPoolTest, RunsOnRuntimeThreadPool) {
+  CountingRuntimeThreadPool runtime_pool(4);
+  Eigen::ThreadPool pool(4);
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  ExecutableRunOptions run_options;
+  run_options.set_intra_op_thread_pool(&device);
+  run_options.set_cpu_runtime_thread_pool(&runtime_pool);
+
+  constexpr int64_t kSize = 5000;
+  std::vector<std::atomic<int>> counts(kSize);
+  void* buffer_table[] = {counts.data()};
+  std::vector<int64_t> partitions = PartitionDimension(kSize, 64);
+  XlaCustomCallStatus status;
+  ForkJoin(run_options, buffer_table, &status, partitions, CountElements);
+
+  EXPECT_FALSE(CustomCallStatusGetMessage(&status).has_value());
+  for (int64_t i = 0; i < kSize; ++i) {
+    EXPECT_EQ(counts[i].load(), 1) << "at " << i;
+  }
+  // One helper per pool thread, the calling thread being the fifth worker.
+  EXPECT_EQ(runtime_pool.num_scheduled(), 4);
+}
+
+TEST(ParallelForkJoinNoThreadPoolTest, RunsOnCallingThread) {
+  ExecutableRunOptions run_options;
+
+  constexpr int64_t kSize = 1000;
+  std::vector<std::atomic<int>> counts(kSize);
+  void* buffer_table[] = {counts.data()};
+  std::vector<int64_t> partitions = PartitionDimension(kSize, 16);
+  XlaCustomCallStatus status;
+  ForkJoin(run_options, buffer_table, &status, partitions, CountElements);
+
+  EXPECT_FALSE(CustomCallStatusGetMessage(&status).has_value());
+  for (int64_t i = 0; i < kSize; ++i) {
+    EXPECT_EQ(counts[i].load(), 1) << "at " << i;
+  }
+}
+
+// Spins for a number of iterations given by the partition, so that the
+// benchmarks can skew the work between partitions.
+void Spin(void* /*result*/, const void* /*run_options*/,
+          const void** /*params*/, void** /*buffer_table*/, void* /*status*/,
+          int64_t* partition, uint64_t* /*prof_counters*/) {
+  float value = 1.0f;
+  for (int64_t i = partition[0]; i < partition[1]; ++i) {
+    value = value * 0.999f + 1.0f;
+  }
+  tsl::testing::DoNotOptimize(value);
+}
+
+// Runs state.range(0) partitions that spin for a total of state.range(1)
+// iterations. If state.range(2) is nonzero, the first eighth of the partitions
+// do as much work as all others together.
+void BM_ParallelForkJoin(::testing::benchmark::State& state) {
+  const int32_t num_partitions = state.range(0);
+  const int64_t total_work = state.range(1);
+  const bool skewed = state.range(2);
+
+  // The spin function reads the amount of work from the partition bounds.
+  std::vector<int64_t> partitions;
+  const int32_t num_heavy = skewed ? std::max(1, num_partitions / 8) : 0;
+  for (int32_t i = 0; i < num_partitions; ++i) {
+    int64_t work =
+        !skewed ? total_work / num_partitions
+        : i < num_heavy
+            ? total_work / 2 / num_heavy
+            : total_work / 2 / std::max(1, num_partitions - num_heavy);
+    partitions.push_back(0);
+    partitions.push_back(work);
+  }
+
+  Eigen::ThreadPool pool(tsl::port::MaxParallelism());
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  ExecutableRunOptions run_options;
+  run_options.set_intra_op_thread_pool(&device);
+
+  for (auto s : state) {
+    XlaCustomCallStatus status;
+    ForkJoin(run_options, /*buffer_table=*/nullptr, &status, partitions, Spin);
+  }
+  state.SetItemsProcessed(state.iterations() * total_work);
+}
+
+BENCHMARK(BM_ParallelForkJoin)
+    ->ArgNames({"partitions", "work", "skewed"})
+    ->Args({16, 1 << 16, 0})
+    ->Args({16, 1 << 22, 0})
+    ->Args({16, 1 << 22, 1})
+    ->Args({64, 1 << 22, 0})
+    ->Args({64, 1 << 22, 1})
+    ->Args({256, 1 << 22, 0})
+    ->Args({256, 1 << 22, 1});
+
+}  // namespace
+}  // namespace xla
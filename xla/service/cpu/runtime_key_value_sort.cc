@@ -14,14 +14,146 @@ limitations under the License.
 ==============================================================================*/
 #include "xla/service/cpu/runtime_key_value_sort.h"
 
+#define EIGEN_USE_THREADS
+
 #include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <numeric>
-#include <string>
+#include <type_traits>
 
 #include "absl/base/dynamic_annotations.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "xla/executable_run_options.h"
+
+namespace {
+
+// High-level idea of the iteration/sorting logic:
+// Conceptually we have a 3-dimensional shape [a, b, c]. b corresponds to the
+// dimension to sort, c is the product of the more minor dimensions (set to 1
+// if b is the most minor dimension), and a is the product of the more major
+// dimensions (set to 1 if b is the most major dimension). There are a * c
+// many rows that we need to sort. We iterate through these, calculate a
+// 'base_offset' value which points to the first element in that row, and add
+// i * c for accessing the 'i'-th element in that row.
+//
+// 'index' can be split into two values which index into the 'c' dimension
+// and the 'a' dimension, respectively. 'index' % 'c' is the index into the
+// 'c' dimension, 'index' / 'c' is the index into the 'a' dimension. When
+// calculating the base offset, we need to multiply the index into the 'a'
+// dimension with 'b' * 'c'.
+// 'index' / 'c' * 'c' * 'b' = ('index' - 'index' % 'c') * 'b'.
+int64_t RowBaseOffset(int64_t index, int64_t b, int64_t c) {
+  return index % c + (index - index % c) * b;
+}
+
+// Runs 'sort_rows(first_row, last_row)' over the 'num_rows' independent rows,
+// splitting them across the intra-op thread pool from 'run_options' if there
+// is one. 'sort_rows' is invoked once per shard so that it can reuse its
+// scratch space for all the rows in the shard.
+void ForEachRowShard(int64_t num_rows, int64_t row_size,
+                     int64_t bytes_per_element, const char* run_options,
+                     bool allow_parallelism,
+                     const std::function<void(int64_t, int64_t)>& sort_rows) {
+  const xla::ExecutableRunOptions* options =
+      reinterpret_cast<const xla::ExecutableRunOptions*>(run_options);
+  const Eigen::ThreadPoolDevice* pool =
+      options == nullptr ? nullptr : options->intra_op_thread_pool();
+  if (!allow_parallelism || pool == nullptr || num_rows <= 1 ||
+      pool->numThreads() <= 1) {
+    sort_rows(0, num_rows);
+    return;
+  }
+  // Sorting a row costs O(b * log(b)) comparisons, each of which loads and
+  // stores its operands a small number of times.
+  double log_row_size = std::max(1.0, std::log2(static_cast<double>(row_size)));
+  Eigen::TensorOpCost cost(
+      /*bytes_loaded=*/bytes_per_element * row_size * log_row_size,
+      /*bytes_stored=*/bytes_per_element * row_size,
+      /*compute_cycles=*/row_size * log_row_size * 8);
+  pool->parallelFor(num_rows, cost,
+                    [&](Eigen::Index first, Eigen::Index last) {
+                      sort_rows(first, last);
+                    });
+}
+
+// Maps the bit pattern of a floating point value to a signed integer such
+// that integer comparison implements the total order
+// -NaN < -Inf < -Finite < -0 < +0 < +Finite < +Inf < +NaN.
+template <typename F, typename I>
+I ToTotalOrder(F value) {
+  static_assert(sizeof(F) == sizeof(I));
+  I bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits < 0 ? bits ^ std::numeric_limits<I>::max() : bits;
+}
+
+template <typename T>
+void SortKeys(int64_t a, int64_t b, int64_t c, T* keys, bool descending,
+              bool total_order, bool is_stable, const char* run_options) {
+  ABSL_ANNOTATE_MEMORY_IS_INITIALIZED(keys, a * b * c * sizeof(T));
+
+  auto sort_row = [&](T* begin, T* end, auto compare) {
+    if (is_stable) {
+      std::stable_sort(begin, end, compare);
+    } else {
+      std::sort(begin, end, compare);
+    }
+  };
+  auto sort_contiguous_row = [&](T* begin, T* end) {
+    if constexpr (std::is_floating_point_v<T>) {
+      if (total_order) {
+        using I = std::conditional_t<sizeof(T) == 4, int32_t, int64_t>;
+        if (descending) {
+          sort_row(begin, end, [](T lhs, T rhs) {
+            return ToTotalOrder<T, I>(lhs) > ToTotalOrder<T, I>(rhs);
+          });
+        } else {
+          sort_row(begin, end, [](T lhs, T rhs) {
+            return ToTotalOrder<T, I>(lhs) < ToTotalOrder<T, I>(rhs);
+          });
+        }
+        return;
+      }
+    }
+    if (descending) {
+      sort_row(begin, end, std::greater<T>());
+    } else {
+      sort_row(begin, end, std::less<T>());
+    }
+  };
+
+  ForEachRowShard(
+      a * c, b, sizeof(T), run_options, /*allow_parallelism=*/true,
+      [&](int64_t first_row, int64_t last_row) {
+        if (c == 1) {
+          // Rows are contiguous, sort them in place.
+          for (int64_t index = first_row; index < last_row; ++index) {
+            T* row = keys + index * b;
+            sort_contiguous_row(row, row + b);
+          }
+          return;
+        }
+        // Strided rows are gathered into a per-shard scratch buffer, sorted
+        // and scattered back.
+        std::unique_ptr<T[]> scratch(new T[b]);
+        for (int64_t index = first_row; index < last_row; ++index) {
+          T* row = keys + RowBaseOffset(index, b, c);
+          for (int64_t i = 0; i < b; ++i) {
+            scratch[i] = row[i * c];
+          }
+          sort_contiguous_row(scratch.get(), scratch.get() + b);
+          for (int64_t i = 0; i < b; ++i) {
+            row[i * c] = scratch[i];
+          }
+        }
+      });
+}
+
+}  // namespace
 
 ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_KeyValueSort(
     int64_t a, int64_t b, int64_t c, char** values, int32_t values_count,
@@ -34,78 +166,106 @@ ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_KeyValueSort(
   ABSL_ANNOTATE_MEMORY_IS_INITIALIZED(values_primitive_type_size_in_bytes,
                                       values_count * sizeof(int32_t));
 
-  // High-level idea of the iteration/sorting logic:
-  // Conceptually we have a 3-dimensional shape [a, b, c]. b corresponds to the
-  // dimension to sort, c is the product of the more minor dimensions (set to 1
-  // if b is the most minor dimension), and a is the product of the more major
-  // dimensions (set to 1 if b is the most major dimension). There are a * c
-  // many rows that we need to sort. We iterate through these, calculate a
-  // 'base_offset' value which points to the first element in that row, and add
-  // i * c for accessing the 'i'-th element in that row.
-
   int64_t sort_dimension_elements = b;
   int64_t num_iteration_elements = a * c;
   int64_t sort_dimension_offset = c;
 
-  std::unique_ptr<int64_t[]> indices(new int64_t[sort_dimension_elements]);
-  std::unique_ptr<char*[]> comparison_values(new char*[2 * values_count]);
-  std::iota(indices.get(), indices.get() + sort_dimension_elements, 0);
-  std::unique_ptr<std::string[]> reordered_values(
-      new std::string[sort_dimension_elements]);
-  for (int64_t index = 0; index < num_iteration_elements; ++index) {
-    // If the sort should be stable, we have to reinitialize indices to iota to
-    // guarantee that we still keep the relative order in case of ties.
-    if (is_stable && index > 0) {
-      std::iota(indices.get(), indices.get() + sort_dimension_elements, 0);
-    }
-    // 'index' can be split into two values which index into the 'c' dimension
-    // and the 'a' dimension, respectively. 'index' % 'c' is the index into the
-    // 'c' dimension, 'index' / 'c' is the index into the 'a' dimension. When
-    // calculating the base offset, we need to multiply the index into the 'a'
-    // dimension with 'b' * 'c'.
-    // 'index' / 'c' * 'c' * 'b' = ('index' - 'index' % 'c') * 'b'.
-    int64_t base_offset =
-        index % sort_dimension_offset +
-        (index - index % sort_dimension_offset) * sort_dimension_elements;
-    auto compare_function = [&](int64_t a, int64_t b) -> bool {
-      for (int32_t i = 0; i < values_count; ++i) {
-        int64_t memory_index_lhs = (base_offset + a * sort_dimension_offset) *
-                                   values_primitive_type_size_in_bytes[i];
-        int64_t memory_index_rhs = (base_offset + b * sort_dimension_offset) *
-                                   values_primitive_type_size_in_bytes[i];
-        comparison_values[i * 2] = values[i] + memory_index_lhs;
-        comparison_values[i * 2 + 1] = values[i] + memory_index_rhs;
-      }
-      char result = 0;  // Overwritten by less_than.
-      less_than(&result, run_options, comparison_values.get(), nullptr,
-                prof_counters);
-      return result != 0u;
-    };
-    if (is_stable) {
-      std::stable_sort(indices.get(), indices.get() + sort_dimension_elements,
-                       compare_function);
-    } else {
-      std::sort(indices.get(), indices.get() + sort_dimension_elements,
-                compare_function);
-    }
+  int64_t bytes_per_element = 0;
+  int32_t max_primitive_type_size = 0;
+  for (int32_t i = 0; i < values_count; ++i) {
+    bytes_per_element += values_primitive_type_size_in_bytes[i];
+    max_primitive_type_size = std::max(max_primitive_type_size,
+                                       values_primitive_type_size_in_bytes[i]);
+  }
 
-    // Reorder the values according to the order defined by 'indices'.
-    for (int32_t idx = 0; idx < values_count; ++idx) {
-      for (int64_t i = 0; i < sort_dimension_elements; ++i) {
-        int64_t memory_index =
-            (base_offset + indices[i] * sort_dimension_offset) *
-            values_primitive_type_size_in_bytes[idx];
+  // The comparator is emitted as a thread-local computation, so it can be
+  // called concurrently. Profile counters, however, are updated without
+  // synchronization, so we only sort rows in parallel when profiling is off.
+  ForEachRowShard(
+      num_iteration_elements, sort_dimension_elements, bytes_per_element,
+      run_options, /*allow_parallelism=*/prof_counters == nullptr,
+      [&](int64_t first_row, int64_t last_row) {
+        // Scratch space is allocated once per shard and reused for every row
+        // in it.
+        std::unique_ptr<int64_t[]> indices(
+            new int64_t[sort_dimension_elements]);
+        std::unique_ptr<char*[]> comparison_values(
+            new char*[2 * values_count]);
+        std::unique_ptr<char[]> reordered_values(
+            new char[sort_dimension_elements * max_primitive_type_size]);
 
-        reordered_values[i] =
-            std::string(values[idx] + memory_index,
-                        values_primitive_type_size_in_bytes[idx]);
-      }
-      for (int64_t i = 0; i < sort_dimension_elements; ++i) {
-        int64_t memory_index = (base_offset + i * sort_dimension_offset) *
-                               values_primitive_type_size_in_bytes[idx];
-        memcpy(values[idx] + memory_index, reordered_values[i].c_str(),
-               values_primitive_type_size_in_bytes[idx]);
-      }
-    }
-  }
+        for (int64_t index = first_row; index < last_row; ++index) {
+          // Indices have to be reinitialized to iota for every row; for stable
+          // sorts this also guarantees that we keep the relative order in case
+          // of ties.
+          std::iota(indices.get(), indices.get() + sort_dimension_elements, 0);
+          int64_t base_offset =
+              RowBaseOffset(index, sort_dimension_elements,
+                            sort_dimension_offset);
+          auto compare_function = [&](int64_t a, int64_t b) -> bool {
+            for (int32_t i = 0; i < values_count; ++i) {
+              int64_t memory_index_lhs =
+                  (base_offset + a * sort_dimension_offset) *
+                  values_primitive_type_size_in_bytes[i];
+              int64_t memory_index_rhs =
+                  (base_offset + b * sort_dimension_offset) *
+                  values_primitive_type_size_in_bytes[i];
+              comparison_values[i * 2] = values[i] + memory_index_lhs;
+              comparison_values[i * 2 + 1] = values[i] + memory_index_rhs;
+            }
+            char result = 0;  // Overwritten by less_than.
+            less_than(&result, run_options, comparison_values.get(), nullptr,
+                      prof_counters);
+            return result != 0u;
+          };
+          if (is_stable) {
+            std::stable_sort(indices.get(),
+                             indices.get() + sort_dimension_elements,
+                             compare_function);
+          } else {
+            std::sort(indices.get(), indices.get() + sort_dimension_elements,
+                      compare_function);
+          }
+
+          // Reorder the values according to the order defined by 'indices'.
+          for (int32_t idx = 0; idx < values_count; ++idx) {
+            int32_t size = values_primitive_type_size_in_bytes[idx];
+            for (int64_t i = 0; i < sort_dimension_elements; ++i) {
+              int64_t memory_index =
+                  (base_offset + indices[i] * sort_dimension_offset) * size;
+              std::memcpy(reordered_values.get() + i * size,
+                          values[idx] + memory_index, size);
+            }
+            if (sort_dimension_offset == 1) {
+              std::memcpy(values[idx] + base_offset * size,
+                          reordered_values.get(),
+                          sort_dimension_elements * size);
+              continue;
+            }
+            for (int64_t i = 0; i < sort_dimension_elements; ++i) {
+              int64_t memory_index =
+                  (base_offset + i * sort_dimension_offset) * size;
+              std::memcpy(values[idx] + memory_index,
+                          reordered_values.get() + i * size, size);
+            }
+          }
+        }
+      });
 }
+
+#define XLA_CPU_RUNTIME_KEY_SORT(NAME, TYPE)                                  \
+  ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_KeySort##NAME(     \
+      int64_t a, int64_t b, int64_t c, TYPE* keys, bool descending,           \
+      bool total_order, bool is_stable, char* run_options) {                  \
+    SortKeys<TYPE>(a, b, c, keys, descending, total_order, is_stable,         \
+                   run_options);                                              \
+  }
+
+XLA_CPU_RUNTIME_KEY_SORT(S32, int32_t)
+XLA_CPU_RUNTIME_KEY_SORT(S64, int64_t)
+XLA_CPU_RUNTIME_KEY_SORT(U32, uint32_t)
+XLA_CPU_RUNTIME_KEY_SORT(U64, uint64_t)
+XLA_CPU_RUNTIME_KEY_SORT(F32, float)
+XLA_CPU_RUNTIME_KEY_SORT(F64, double)
+
+#undef XLA_CPU_RUNTIME_KEY_SORT
@@ -36,11 +36,43 @@ extern "C" {
 // - pointers to the parameter buffers (char**)
 // - pointers to the buffer tables = nullptr for thread local functions (char**)
 // - profile counters = 'prof_counters' (int64_t*)
+// The a * c rows are sorted in parallel on the intra-op thread pool of
+// 'run_options' unless 'prof_counters' is non-null.
 extern void __xla_cpu_runtime_KeyValueSort(
     int64_t a, int64_t b, int64_t c, char** values, int32_t values_count,
     int32_t* values_primitive_type_size_in_bytes, bool is_stable,
     char* run_options, int64_t* prof_counters,
     void (*less_than)(char*, char*, char**, char**, int64_t*));
+
+// Specializations of __xla_cpu_runtime_KeyValueSort for a single array of
+// numeric keys compared with a plain LT ('descending' = false) or GT
+// ('descending' = true) comparator. For floating point keys, 'total_order'
+// selects the total order comparison instead of the IEEE one. These avoid
+// calling back into the JIT-compiled comparator for every comparison.
+extern void __xla_cpu_runtime_KeySortS32(int64_t a, int64_t b, int64_t c,
+                                         int32_t* keys, bool descending,
+                                         bool total_order, bool is_stable,
+                                         char* run_options);
+extern void __xla_cpu_runtime_KeySortS64(int64_t a, int64_t b, int64_t c,
+                                         int64_t* keys, bool descending,
+                                         bool total_order, bool is_stable,
+                                         char* run_options);
+extern void __xla_cpu_runtime_KeySortU32(int64_t a, int64_t b, int64_t c,
+                                         uint32_t* keys, bool descending,
+                                         bool total_order, bool is_stable,
+                                         char* run_options);
+extern void __xla_cpu_runtime_KeySortU64(int64_t a, int64_t b, int64_t c,
+                                         uint64_t* keys, bool descending,
+                                         bool total_order, bool is_stable,
+                                         char* run_options);
+extern void __xla_cpu_runtime_KeySortF32(int64_t a, int64_t b, int64_t c,
+                                         float* keys, bool descending,
+                                         bool total_order, bool is_stable,
+                                         char* run_options);
+extern void __xla_cpu_runtime_KeySortF64(int64_t a, int64_t b, int64_t c,
+                                         double* keys, bool descending,
+                                         bool total_order, bool is_stable,
+                                         char* run_options);
 }
 
 #endif  // XLA_SERVICE_CPU_RUNTIME_KEY_VALUE_SORT_H_
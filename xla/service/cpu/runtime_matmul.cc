@@ -17,6 +17,8 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <type_traits>
+
 #include "absl/base/dynamic_annotations.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 #include "xla/executable_run_options.h"
@@ -32,8 +34,8 @@ bool Is16BytesAligned(void* ptr) {
   return reinterpret_cast<uintptr_t>(ptr) % 16 == 0;
 }
 
-template <typename T, Eigen::AlignmentType Alignment>
-void MatMul(const void* run_options_ptr, T* out, T* lhs, T* rhs, int64_t m,
+template <typename T, Eigen::AlignmentType Alignment, typename InT = T>
+void MatMul(const void* run_options_ptr, T* out, InT* lhs, InT* rhs, int64_t m,
             int64_t n, int64_t k, int32_t transpose_lhs,
             int32_t transpose_rhs) {
   const xla::ExecutableRunOptions* run_options =
@@ -51,10 +53,10 @@ void MatMul(const void* run_options_ptr, T* out, T* lhs, T* rhs, int64_t m,
     std::swap(rhs_rows, rhs_cols);
   }
 
-  const Eigen::TensorMap<Eigen::Tensor<const T, 2>, Alignment> A(lhs, lhs_rows,
-                                                                 lhs_cols);
-  const Eigen::TensorMap<Eigen::Tensor<const T, 2>, Alignment> B(rhs, rhs_rows,
-                                                                 rhs_cols);
+  const Eigen::TensorMap<Eigen::Tensor<const InT, 2>, Alignment> A(
+      lhs, lhs_rows, lhs_cols);
+  const Eigen::TensorMap<Eigen::Tensor<const InT, 2>, Alignment> B(
+      rhs, rhs_rows, rhs_cols);
   Eigen::TensorMap<Eigen::Tensor<T, 2>, Alignment> C(out, m, n);
 
   typedef typename Eigen::Tensor<T, 2>::DimensionPair DimPair;
@@ -67,11 +69,18 @@ void MatMul(const void* run_options_ptr, T* out, T* lhs, T* rhs, int64_t m,
   // the contraction is performed along dimension 1 of the lhs and dimension
   // 0 of the rhs.
   XLA_LIGHTWEIGHT_CHECK(run_options->intra_op_thread_pool() != nullptr);
-  C.device(*run_options->intra_op_thread_pool()) = A.contract(B, dims);
+  if constexpr (std::is_same_v<InT, T>) {
+    C.device(*run_options->intra_op_thread_pool()) = A.contract(B, dims);
+  } else {
+    // Narrower inputs are converted while the contraction packs them, so
+    // mixed precision products don't need a converted copy of their operands.
+    C.device(*run_options->intra_op_thread_pool()) =
+        A.template cast<T>().contract(B.template cast<T>(), dims);
+  }
 }
 
-template <typename T, Eigen::AlignmentType Alignment>
-void MatMul_Batch(const void* run_options_ptr, T* out, T* lhs, T* rhs,
+template <typename T, Eigen::AlignmentType Alignment, typename InT = T>
+void MatMul_Batch(const void* run_options_ptr, T* out, InT* lhs, InT* rhs,
                   int64_t m, int64_t n, int64_t k, Eigen::Index batch_size,
                   int32_t transpose_lhs, int32_t transpose_rhs) {
   const xla::ExecutableRunOptions* run_options =
@@ -89,9 +98,9 @@ void MatMul_Batch(const void* run_options_ptr, T* out, T* lhs, T* rhs,
     std::swap(rhs_rows, rhs_cols);
   }
 
-  const Eigen::TensorMap<Eigen::Tensor<const T, 3>, Alignment> A(
+  const Eigen::TensorMap<Eigen::Tensor<const InT, 3>, Alignment> A(
       lhs, lhs_rows, lhs_cols, batch_size);
-  const Eigen::TensorMap<Eigen::Tensor<const T, 3>, Alignment> B(
+  const Eigen::TensorMap<Eigen::Tensor<const InT, 3>, Alignment> B(
       rhs, rhs_rows, rhs_cols, batch_size);
   Eigen::TensorMap<Eigen::Tensor<T, 3>, Alignment> C(out, m, n, batch_size);
 
@@ -108,42 +117,51 @@ void MatMul_Batch(const void* run_options_ptr, T* out, T* lhs, T* rhs,
   XLA_LIGHTWEIGHT_CHECK(run_options->intra_op_thread_pool() != nullptr);
 
   for (int64_t i = 0; i < batch_size; ++i) {
-    C.chip(i, 2).device(*run_options->intra_op_thread_pool()) =
-        A.chip(i, 2).contract(B.chip(i, 2), dims);
+    if constexpr (std::is_same_v<InT, T>) {
+      C.chip(i, 2).device(*run_options->intra_op_thread_pool()) =
+          A.chip(i, 2).contract(B.chip(i, 2), dims);
+    } else {
+      C.chip(i, 2).device(*run_options->intra_op_thread_pool()) =
+          A.chip(i, 2).template cast<T>().contract(
+              B.chip(i, 2).template cast<T>(), dims);
+    }
   }
 }
 
-template <typename T>
-void MatMulDispatch(const void* run_options_ptr, T* out, T* lhs, T* rhs,
+template <typename T, typename InT = T>
+void MatMulDispatch(const void* run_options_ptr, T* out, InT* lhs, InT* rhs,
                     int64_t m, int64_t n, int64_t k, int32_t transpose_lhs,
                     int32_t transpose_rhs) {
   bool all_buffers_16b_aligned =
       Is16BytesAligned(out) && Is16BytesAligned(lhs) && Is16BytesAligned(rhs);
 
   if (!all_buffers_16b_aligned) {
-    MatMul<T, Eigen::Unaligned>(run_options_ptr, out, lhs, rhs, m, n, k,
-                                transpose_lhs, transpose_rhs);
+    MatMul<T, Eigen::Unaligned, InT>(run_options_ptr, out, lhs, rhs, m, n, k,
+                                     transpose_lhs, transpose_rhs);
     return;
   }
 
-  MatMul<T, Eigen::Aligned16>(run_options_ptr, out, lhs, rhs, m, n, k,
-                              transpose_lhs, transpose_rhs);
+  MatMul<T, Eigen::Aligned16, InT>(run_options_ptr, out, lhs, rhs, m, n, k,
+                                   transpose_lhs, transpose_rhs);
 }
 
-template <typename T>
-void BatchMatMulDispatch(const void* run_options_ptr, T* out, T* lhs, T* rhs,
-                         int64_t m, int64_t n, int64_t k, int64_t batch_size,
-                         int32_t transpose_lhs, int32_t transpose_rhs) {
+template <typename T, typename InT = T>
+void BatchMatMulDispatch(const void* run_options_ptr, T* out, InT* lhs,
+                         InT* rhs, int64_t m, int64_t n, int64_t k,
+                         int64_t batch_size, int32_t transpose_lhs,
+                         int32_t transpose_rhs) {
   bool all_buffers_16b_aligned =
       Is16BytesAligned(out) && Is16BytesAligned(lhs) && Is16BytesAligned(rhs);
 
   if (!all_buffers_16b_aligned) {
-    MatMul_Batch<T, Eigen::Unaligned>(run_options_ptr, out, lhs, rhs, m, n, k,
-                                      batch_size, transpose_lhs, transpose_rhs);
+    MatMul_Batch<T, Eigen::Unaligned, InT>(run_options_ptr, out, lhs, rhs, m,
+                                           n, k, batch_size, transpose_lhs,
+                                           transpose_rhs);
     return;
   }
-  MatMul_Batch<T, Eigen::Aligned16>(run_options_ptr, out, lhs, rhs, m, n, k,
-                                    batch_size, transpose_lhs, transpose_rhs);
+  MatMul_Batch<T, Eigen::Aligned16, InT>(run_options_ptr, out, lhs, rhs, m, n,
+                                         k, batch_size, transpose_lhs,
+                                         transpose_rhs);
 }
 
 }  // namespace
@@ -202,3 +220,38 @@ ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_EigenBatchMatMulF32(
   BatchMatMulDispatch<float>(run_options_ptr, out, lhs, rhs, m, n, k,
                              batch_size, transpose_lhs, transpose_rhs);
 }
+
+ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_EigenMatMulBF16F32(
+    const void* run_options_ptr, float* out, Eigen::bfloat16* lhs,
+    Eigen::bfloat16* rhs, int64_t m, int64_t n, int64_t k,
+    int32_t transpose_lhs, int32_t transpose_rhs) {
+  MatMulDispatch<float, Eigen::bfloat16>(run_options_ptr, out, lhs, rhs, m, n,
+                                         k, transpose_lhs, transpose_rhs);
+}
+
+ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_EigenMatMulS8S32(
+    const void* run_options_ptr, int32_t* out, int8_t* lhs, int8_t* rhs,
+    int64_t m, int64_t n, int64_t k, int32_t transpose_lhs,
+    int32_t transpose_rhs) {
+  MatMulDispatch<int32_t, int8_t>(run_options_ptr, out, lhs, rhs, m, n, k,
+                                  transpose_lhs, transpose_rhs);
+}
+
+ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void
+__xla_cpu_runtime_EigenBatchMatMulBF16F32(
+    const void* run_options_ptr, float* out, Eigen::bfloat16* lhs,
+    Eigen::bfloat16* rhs, int64_t m, int64_t n, int64_t k, int64_t batch_size,
+    int32_t transpose_lhs, int32_t transpose_rhs) {
+  BatchMatMulDispatch<float, Eigen::bfloat16>(run_options_ptr, out, lhs, rhs,
+                                              m, n, k, batch_size,
+                                              transpose_lhs, transpose_rhs);
+}
+
+ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_EigenBatchMatMulS8S32(
+    const void* run_options_ptr, int32_t* out, int8_t* lhs, int8_t* rhs,
+    int64_t m, int64_t n, int64_t k, int64_t batch_size, int32_t transpose_lhs,
+    int32_t transpose_rhs) {
+  BatchMatMulDispatch<int32_t, int8_t>(run_options_ptr, out, lhs, rhs, m, n, k,
+                                       batch_size, transpose_lhs,
+                                       transpose_rhs);
+}
@@ -63,6 +63,29 @@ extern void __xla_cpu_runtime_EigenBatchMatMulF32(
     const void* /* xla::ExecutableRunOptions* */ run_options_ptr, float* out,
     float* lhs, float* rhs, int64_t m, int64_t n, int64_t k, int64_t batch_size,
     int32_t transpose_lhs, int32_t transpose_rhs);
+
+// Mixed precision variants of the above, which multiply bf16 (resp. s8)
+// matrices and accumulate the products in f32 (resp. s32).
+extern void __xla_cpu_runtime_EigenMatMulBF16F32(
+    const void* /* xla::ExecutableRunOptions* */ run_options_ptr, float* out,
+    Eigen::bfloat16* lhs, Eigen::bfloat16* rhs, int64_t m, int64_t n,
+    int64_t k, int32_t transpose_lhs, int32_t transpose_rhs);
+
+extern void __xla_cpu_runtime_EigenMatMulS8S32(
+    const void* /* xla::ExecutableRunOptions* */ run_options_ptr, int32_t* out,
+    int8_t* lhs, int8_t* rhs, int64_t m, int64_t n, int64_t k,
+    int32_t transpose_lhs, int32_t transpose_rhs);
+
+extern void __xla_cpu_runtime_EigenBatchMatMulBF16F32(
+    const void* /* xla::ExecutableRunOptions* */ run_options_ptr, float* out,
+    Eigen::bfloat16* lhs, Eigen::bfloat16* rhs, int64_t m, int64_t n,
+    int64_t k, int64_t batch_size, int32_t transpose_lhs,
+    int32_t transpose_rhs);
+
+extern void __xla_cpu_runtime_EigenBatchMatMulS8S32(
+    const void* /* xla::ExecutableRunOptions* */ run_options_ptr, int32_t* out,
+    int8_t* lhs, int8_t* rhs, int64_t m, int64_t n, int64_t k,
+    int64_t batch_size, int32_t transpose_lhs, int32_t transpose_rhs);
 }  // extern "C"
 
 #endif  // XLA_SERVICE_CPU_RUNTIME_MATMUL_H_
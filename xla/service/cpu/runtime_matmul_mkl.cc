@@ -69,6 +69,25 @@ void MatMulF64(const void* run_options_ptr, double* out, double* lhs,
               lda, rhs, ldb, beta, out, ldc);
 }
 
+// BLAS-like GEMM API for bf16 Matrix Multiplication with f32 accumulation.
+
+// MatMul function is defined as: c = alpha * op(a) * op(b) + beta * c.
+// Since XLA MatMul does not used alpha, beta, we set them to 1.0 and 0.0.
+// Matrix lhs, rhs and out are all column-major.
+void MatMulBF16F32(const void* run_options_ptr, float* out, uint16_t* lhs,
+                   uint16_t* rhs, int64_t m, int64_t n, int64_t k,
+                   int32_t transpose_lhs, int32_t transpose_rhs) {
+  const float alpha = 1.0f, beta = 0.0f;
+  // See MatMulF32 for the leading dimensions.
+  int lda = transpose_lhs ? k : m;
+  int ldb = transpose_rhs ? n : k;
+  int ldc = m;
+  cblas_gemm_bf16bf16f32(CblasColMajor,
+                         transpose_lhs ? CblasTrans : CblasNoTrans,
+                         transpose_rhs ? CblasTrans : CblasNoTrans, m, n, k,
+                         alpha, lhs, lda, rhs, ldb, beta, out, ldc);
+}
+
 }  // namespace
 
 ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_MKLMatMulF32(
@@ -126,4 +145,31 @@ __xla_cpu_runtime_MKLSingleThreadedMatMulF64(const void* run_options_ptr,
   // Set thread number back to the previous number.
   mkl_set_num_threads_local(prev_num_threads);
 }
+
+ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_MKLMatMulBF16F32(
+    const void* run_options_ptr, float* out, uint16_t* lhs, uint16_t* rhs,
+    int64_t m, int64_t n, int64_t k, int32_t transpose_lhs,
+    int32_t transpose_rhs) {
+  const xla::ExecutableRunOptions* run_options =
+      static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
+  // BLAS GEMM MatMul uses OpenMP for parallelization, so we pass the thread
+  // number specified in intra_op_thread_pool to MKL.
+  int prev_num_threads = mkl_set_num_threads_local(
+      run_options->intra_op_thread_pool()->numThreads());
+  MatMulBF16F32(nullptr, out, lhs, rhs, m, n, k, transpose_lhs, transpose_rhs);
+  // Set thread number back to the previous number.
+  mkl_set_num_threads_local(prev_num_threads);
+}
+
+ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void
+__xla_cpu_runtime_MKLSingleThreadedMatMulBF16F32(
+    const void* run_options_ptr, float* out, uint16_t* lhs, uint16_t* rhs,
+    int64_t m, int64_t n, int64_t k, int32_t transpose_lhs,
+    int32_t transpose_rhs) {
+  // Set the thread number to 1 for single threaded execution.
+  int prev_num_threads = mkl_set_num_threads_local(1);
+  MatMulBF16F32(nullptr, out, lhs, rhs, m, n, k, transpose_lhs, transpose_rhs);
+  // Set thread number back to the previous number.
+  mkl_set_num_threads_local(prev_num_threads);
+}
 #endif  // ENABLE_MKL
@@ -37,6 +37,17 @@ extern void __xla_cpu_runtime_MKLSingleThreadedMatMulF64(
     const void* /* xla::ExecutableRunOptions* */ run_options_ptr, double* out,
     double* lhs, double* rhs, int64_t m, int64_t n, int64_t k,
     int32_t transpose_lhs, int32_t transpose_rhs);
+// Multiplies bf16 matrices, passed as their raw bit patterns, and accumulates
+// the products in f32. MKL uses AVX512_BF16 or AMX for these when the CPU has
+// them.
+extern void __xla_cpu_runtime_MKLMatMulBF16F32(
+    const void* /* xla::ExecutableRunOptions* */ run_options_ptr, float* out,
+    uint16_t* lhs, uint16_t* rhs, int64_t m, int64_t n, int64_t k,
+    int32_t transpose_lhs, int32_t transpose_rhs);
+extern void __xla_cpu_runtime_MKLSingleThreadedMatMulBF16F32(
+    const void* /* xla::ExecutableRunOptions* */ run_options_ptr, float* out,
+    uint16_t* lhs, uint16_t* rhs, int64_t m, int64_t n, int64_t k,
+    int32_t transpose_lhs, int32_t transpose_rhs);
 
 #else
 inline extern void __xla_cpu_runtime_MKLMatMulF32(
@@ -71,6 +82,22 @@ inline extern void __xla_cpu_runtime_MKLSingleThreadedMatMulF64(
                "ENABLE_MKL. Add --config=mkl to build with MKL.";
   exit(1);
 }
+inline extern void __xla_cpu_runtime_MKLMatMulBF16F32(
+    const void* /* xla::ExecutableRunOptions* */ run_options_ptr, float* out,
+    uint16_t* lhs, uint16_t* rhs, int64_t m, int64_t n, int64_t k,
+    int32_t transpose_lhs, int32_t transpose_rhs) {
+  std::cerr << "Attempt to call MKL MatMul runtime library without defining "
+               "ENABLE_MKL. Add --config=mkl to build with MKL.";
+  exit(1);
+}
+inline extern void __xla_cpu_runtime_MKLSingleThreadedMatMulBF16F32(
+    const void* /* xla::ExecutableRunOptions* */ run_options_ptr, float* out,
+    uint16_t* lhs, uint16_t* rhs, int64_t m, int64_t n, int64_t k,
+    int32_t transpose_lhs, int32_t transpose_rhs) {
+  std::cerr << "Attempt to call MKL MatMul runtime library without defining "
+               "ENABLE_MKL. Add --config=mkl to build with MKL.";
+  exit(1);
+}
 
 #endif  // ENABLE_MKL
 #endif  // XLA_SERVICE_CPU_RUNTIME_MATMUL_MKL_H_
@@ -0,0 +1,265 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include "xla/service/cpu/runtime_matmul.h"
+
+#include <cstdint>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "xla/executable_run_options.h"
+#include "xla/service/cpu/runtime_single_threaded_matmul.h"
+#include "tsl/platform/cpu_info.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+
+namespace xla {
+namespace {
+
+// Returns the column major product of the column major m x k matrix `lhs` (or
+// its transpose) and k x n matrix `rhs` (or its transpose), accumulated in
+// `Out`.
+template <typename Out, typename In>
+std::vector<Out> ReferenceMatMul(const std::vector<In>& lhs,
+                                 const std::vector<In>& rhs, int64_t m,
+                                 int64_t n, int64_t k, bool transpose_lhs,
+                                 bool transpose_rhs) {
+  std::vector<Out> result(m * n);
+  for (int64_t i = 0; i < m; ++i) {
+    for (int64_t j = 0; j < n; ++j) {
+      Out sum = 0;
+      for (int64_t l = 0; l < k; ++l) {
+        In a = transpose_lhs ? lhs[l + i * k] : lhs[i + l * m];
+        In b = transpose_rhs ? rhs[j + l * n] : rhs[l + j * k];
+        sum += static_cast<Out>(a) * static_cast<Out>(b);
+      }
+      result[i + j * m] = sum;
+    }
+  }
+  return result;
+}
+
+std::vector<Eigen::bfloat16> RandomBF16(int64_t size, uint32_t seed) {
+  std::minstd_rand0 generator(seed);
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  std::vector<Eigen::bfloat16> result(size);
+  for (Eigen::bfloat16& value : result) {
+    value = Eigen::bfloat16(distribution(generator));
+  }
+  return result;
+}
+
+std::vector<int8_t> RandomS8(int64_t size, uint32_t seed) {
+  std::minstd_rand0 generator(seed);
+  std::uniform_int_distribution<int> distribution(-128, 127);
+  std::vector<int8_t> result(size);
+  for (int8_t& value : result) {
+    value = distribution(generator);
+  }
+  return result;
+}
+
+// Parameterized over m, n, k, transpose_lhs and transpose_rhs.
+class MixedPrecisionMatMulTest
+    : public ::testing::TestWithParam<
+          std::tuple<int64_t, int64_t, int64_t, bool, bool>> {
+ protected:
+  MixedPrecisionMatMulTest()
+      : pool_(4), device_(&pool_, pool_.NumThreads()) {
+    run_options_.set_intra_op_thread_pool(&device_);
+  }
+
+  Eigen::ThreadPool pool_;
+  Eigen::ThreadPoolDevice device_;
+  ExecutableRunOptions run_options_;
+};
+
+TEST_P(MixedPrecisionMatMulTest, BF16F32) {
+  auto [m, n, k, transpose_lhs, transpose_rhs] = GetParam();
+  std::vector<Eigen::bfloat16> lhs = RandomBF16(m * k, 1);
+  std::vector<Eigen::bfloat16> rhs = RandomBF16(k * n, 2);
+  std::vector<float> expected =
+      ReferenceMatMul<float>(lhs, rhs, m, n, k, transpose_lhs, transpose_rhs);
+
+  std::vector<float> out(m * n);
+  __xla_cpu_runtime_EigenMatMulBF16F32(&run_options_, out.data(), lhs.data(),
+                                       rhs.data(), m, n, k, transpose_lhs,
+                                       transpose_rhs);
+  for (int64_t i = 0; i < m * n; ++i) {
+    EXPECT_NEAR(out[i], expected[i], 1e-4 * k) << "at " << i;
+  }
+
+  std::vector<float> single_threaded_out(m * n);
+  __xla_cpu_runtime_EigenSingleThreadedMatMulBF16F32(
+      /*run_options_ptr=*/nullptr, single_threaded_out.data(), lhs.data(),
+      rhs.data(), m, n, k, transpose_lhs, transpose_rhs);
+  for (int64_t i = 0; i < m * n; ++i) {
+    EXPECT_NEAR(single_threaded_out[i], expected[i], 1e-4 * k) << "at " << i;
+  }
+}
+
+TEST_P(MixedPrecisionMatMulTest, S8S32) {
+  auto [m, n, k, transpose_lhs, transpose_rhs] = GetParam();
+  std::vector<int8_t> lhs = RandomS8(m * k, 3);
+  std::vector<int8_t> rhs = RandomS8(k * n, 4);
+  std::vector<int32_t> expected =
+      ReferenceMatMul<int32_t>(lhs, rhs, m, n, k, transpose_lhs, transpose_rhs);
+
+  // The products of s8 values overflow s8, so this also checks that they are
+  // accumulated in s32.
+  std::vector<int32_t> out(m * n);
+  __xla_cpu_runtime_EigenMatMulS8S32(&run_options_, out.data(), lhs.data(),
+                                     rhs.data(), m, n, k, transpose_lhs,
+                                     transpose_rhs);
+  EXPECT_EQ(out, expected);
+
+  std::vector<int32_t> single_threaded_out(m * n);
+  __xla_cpu_runtime_EigenSingleThreadedMatMulS8S32(
+      /*run_options_ptr=*/nullptr, single_threaded_out.data(), lhs.data(),
+      rhs.data(), m, n, k, transpose_lhs, transpose_rhs);
+  EXPECT_EQ(single_threaded_out, expected);
+}
+
+TEST_P(MixedPrecisionMatMulTest, BatchS8S32) {
+  auto [m, n, k, transpose_lhs, transpose_rhs] = GetParam();
+  constexpr int64_t kBatchSize = 3;
+  std::vector<int8_t> lhs = RandomS8(kBatchSize * m * k, 5);
+  std::vector<int8_t> rhs = RandomS8(kBatchSize * k * n, 6);
+
+  std::vector<int32_t> out(kBatchSize * m * n);
+  __xla_cpu_runtime_EigenBatchMatMulS8S32(&run_options_, out.data(), lhs.data(),
+                                          rhs.data(), m, n, k, kBatchSize,
+                                          transpose_lhs, transpose_rhs);
+  for (int64_t batch = 0; batch < kBatchSize; ++batch) {
+    std::vector<int8_t> batch_lhs(lhs.begin() + batch * m * k,
+                                  lhs.begin() + (batch + 1) * m * k);
+    std::vector<int8_t> batch_rhs(rhs.begin() + batch * k * n,
+                                  rhs.begin() + (batch + 1) * k * n);
+    std::vector<int32_t> batch_out(out.begin() + batch * m * n,
+                                   out.begin() + (batch + 1) * m * n);
+    EXPECT_EQ(batch_out,
+              ReferenceMatMul<int32_t>(batch_lhs, batch_rhs, m, n, k,
+                                       transpose_lhs, transpose_rhs));
+  }
+}
+
+TEST_P(MixedPrecisionMatMulTest, BatchBF16F32) {
+  auto [m, n, k, transpose_lhs, transpose_rhs] = GetParam();
+  constexpr int64_t kBatchSize = 2;
+  std::vector<Eigen::bfloat16> lhs = RandomBF16(kBatchSize * m * k, 7);
+  std::vector<Eigen::bfloat16> rhs = RandomBF16(kBatchSize * k * n, 8);
+
+  std::vector<float> out(kBatchSize * m * n);
+  __xla_cpu_runtime_EigenBatchMatMulBF16F32(
+      &run_options_, out.data(), lhs.data(), rhs.data(), m, n, k, kBatchSize,
+      transpose_lhs, transpose_rhs);
+  for (int64_t batch = 0; batch < kBatchSize; ++batch) {
+    std::vector<Eigen::bfloat16> batch_lhs(lhs.begin() + batch * m * k,
+                                           lhs.begin() + (batch + 1) * m * k);
+    std::vector<Eigen::bfloat16> batch_rhs(rhs.begin() + batch * k * n,
+                                           rhs.begin() + (batch + 1) * k * n);
+    std::vector<float> expected =
+        ReferenceMatMul<float>(batch_lhs, batch_rhs, m, n, k, transpose_lhs,
+                               transpose_rhs);
+    for (int64_t i = 0; i < m * n; ++i) {
+      EXPECT_NEAR(out[batch * m * n + i], expected[i], 1e-4 * k);
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    MixedPrecisionMatMulTestInstantiation, MixedPrecisionMatMulTest,
+    ::testing::Values(std::make_tuple(1, 1, 1, false, false),
+                      std::make_tuple(7, 5, 3, false, false),
+                      std::make_tuple(7, 5, 3, true, false),
+                      std::make_tuple(7, 5, 3, false, true),
+                      std::make_tuple(64, 48, 300, true, true),
+                      std::make_tuple(128, 128, 128, false, false)));
+
+// Benchmarks a square matmul of side state.range(0) with operands of type `In`
+// accumulated in `Out`, multi-threaded if state.range(1) is nonzero.
+template <typename Out, typename In>
+void BM_MatMul(::testing::benchmark::State& state,
+               void (*matmul)(const void*, Out*, In*, In*, int64_t, int64_t,
+                              int64_t, int32_t, int32_t),
+               void (*single_threaded_matmul)(const void*, Out*, In*, In*,
+                                              int64_t, int64_t, int64_t,
+                                              int32_t, int32_t)) {
+  const int64_t size = state.range(0);
+  const bool multi_threaded = state.range(1);
+  std::vector<In> lhs(size * size, In(1));
+  std::vector<In> rhs(size * size, In(1));
+  std::vector<Out> out(size * size);
+
+  Eigen::ThreadPool pool(tsl::port::MaxParallelism());
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  ExecutableRunOptions run_options;
+  run_options.set_intra_op_thread_pool(&device);
+
+  for (auto s : state) {
+    (multi_threaded ? matmul : single_threaded_matmul)(
+        &run_options, out.data(), lhs.data(), rhs.data(), size, size, size,
+        /*transpose_lhs=*/0, /*transpose_rhs=*/0);
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * size * size * size);
+}
+
+void BM_MatMulF32(::testing::benchmark::State& state) {
+  BM_MatMul<float, float>(state, __xla_cpu_runtime_EigenMatMulF32,
+                          __xla_cpu_runtime_EigenSingleThreadedMatMulF32);
+}
+
+void BM_MatMulBF16F32(::testing::benchmark::State& state) {
+  BM_MatMul<float, Eigen::bfloat16>(
+      state, __xla_cpu_runtime_EigenMatMulBF16F32,
+      __xla_cpu_runtime_EigenSingleThreadedMatMulBF16F32);
+}
+
+void BM_MatMulS8S32(::testing::benchmark::State& state) {
+  BM_MatMul<int32_t, int8_t>(state, __xla_cpu_runtime_EigenMatMulS8S32,
+                             __xla_cpu_runtime_EigenSingleThreadedMatMulS8S32);
+}
+
+BENCHMARK(BM_MatMulF32)
+    ->ArgNames({"size", "multi_threaded"})
+    ->Args({64, 0})
+    ->Args({64, 1})
+    ->Args({256, 0})
+    ->Args({256, 1})
+    ->Args({1024, 0})
+    ->Args({1024, 1});
+BENCHMARK(BM_MatMulBF16F32)
+    ->ArgNames({"size", "multi_threaded"})
+    ->Args({64, 0})
+    ->Args({64, 1})
+    ->Args({256, 0})
+    ->Args({256, 1})
+    ->Args({1024, 0})
+    ->Args({1024, 1});
+BENCHMARK(BM_MatMulS8S32)
+    ->ArgNames({"size", "multi_threaded"})
+    ->Args({64, 0})
+    ->Args({64, 1})
+    ->Args({256, 0})
+    ->Args({256, 1})
+    ->Args({1024, 0})
+    ->Args({1024, 1});
+
+}  // namespace
+}  // namespace xla
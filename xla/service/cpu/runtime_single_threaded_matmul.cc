@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "xla/service/cpu/runtime_single_threaded_matmul.h"
 
+#include <type_traits>
+
 #include "absl/base/attributes.h"
 #include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
 
@@ -28,8 +30,8 @@ bool Is16BytesAligned(void* ptr) {
   return reinterpret_cast<uintptr_t>(ptr) % 16 == 0;
 }
 
-template <typename T, Eigen::AlignmentType Alignment>
-void MatMul(const void* run_options_ptr, T* out, T* lhs, T* rhs, int64_t m,
+template <typename T, Eigen::AlignmentType Alignment, typename InT = T>
+void MatMul(const void* run_options_ptr, T* out, InT* lhs, InT* rhs, int64_t m,
             int64_t n, int64_t k, int32_t transpose_lhs,
             int32_t transpose_rhs) {
   int64_t lhs_rows = m;
@@ -44,10 +46,10 @@ void MatMul(const void* run_options_ptr, T* out, T* lhs, T* rhs, int64_t m,
     std::swap(rhs_rows, rhs_cols);
   }
 
-  const Eigen::TensorMap<Eigen::Tensor<const T, 2>, Alignment> A(lhs, lhs_rows,
-                                                                 lhs_cols);
-  const Eigen::TensorMap<Eigen::Tensor<const T, 2>, Alignment> B(rhs, rhs_rows,
-                                                                 rhs_cols);
+  const Eigen::TensorMap<Eigen::Tensor<const InT, 2>, Alignment> A(
+      lhs, lhs_rows, lhs_cols);
+  const Eigen::TensorMap<Eigen::Tensor<const InT, 2>, Alignment> B(
+      rhs, rhs_rows, rhs_cols);
   Eigen::TensorMap<Eigen::Tensor<T, 2>, Alignment> C(out, m, n);
 
   typedef typename Eigen::Tensor<T, 2>::DimensionPair DimPair;
@@ -59,24 +61,31 @@ void MatMul(const void* run_options_ptr, T* out, T* lhs, T* rhs, int64_t m,
   // Matrix multiply is a special case of the "contract" operation where
   // the contraction is performed along dimension 1 of the lhs and dimension
   // 0 of the rhs.
-  C = A.contract(B, dims);
+  if constexpr (std::is_same_v<InT, T>) {
+    C = A.contract(B, dims);
+  } else {
+    // Narrower inputs are converted while the contraction packs them, so
+    // mixed precision products don't need a converted copy of their operands.
+    C = A.template cast<T>().contract(B.template cast<T>(), dims);
+  }
 }
 
-template <typename T>
-void SingleThreadedMatMulDispatch(const void* run_options_ptr, T* out, T* lhs,
-                                  T* rhs, int64_t m, int64_t n, int64_t k,
-                                  int32_t transpose_lhs,
+template <typename T, typename InT = T>
+void SingleThreadedMatMulDispatch(const void* run_options_ptr, T* out,
+                                  InT* lhs, InT* rhs, int64_t m, int64_t n,
+                                  int64_t k, int32_t transpose_lhs,
                                   int32_t transpose_rhs) {
   bool all_buffers_16b_aligned =
       Is16BytesAligned(out) && Is16BytesAligned(lhs) && Is16BytesAligned(rhs);
 
   if (!all_buffers_16b_aligned) {
-    MatMul<T, Eigen::Unaligned>(run_options_ptr, out, lhs, rhs, m, n, k,
-                                transpose_lhs, transpose_rhs);
+    MatMul<T, Eigen::Unaligned, InT>(run_options_ptr, out, lhs, rhs, m, n, k,
+                                     transpose_lhs, transpose_rhs);
+    return;
   }
 
-  MatMul<T, Eigen::Aligned16>(run_options_ptr, out, lhs, rhs, m, n, k,
-                              transpose_lhs, transpose_rhs);
+  MatMul<T, Eigen::Aligned16, InT>(run_options_ptr, out, lhs, rhs, m, n, k,
+                                   transpose_lhs, transpose_rhs);
 }
 
 }  // namespace
@@ -139,3 +148,21 @@ __xla_cpu_runtime_EigenSingleThreadedMatMulS32(const void* run_options_ptr,
   SingleThreadedMatMulDispatch<int32_t>(run_options_ptr, out, lhs, rhs, m, n, k,
                                         transpose_lhs, transpose_rhs);
 }
+
+ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void
+__xla_cpu_runtime_EigenSingleThreadedMatMulBF16F32(
+    const void* run_options_ptr, float* out, Eigen::bfloat16* lhs,
+    Eigen::bfloat16* rhs, int64_t m, int64_t n, int64_t k,
+    int32_t transpose_lhs, int32_t transpose_rhs) {
+  SingleThreadedMatMulDispatch<float, Eigen::bfloat16>(
+      run_options_ptr, out, lhs, rhs, m, n, k, transpose_lhs, transpose_rhs);
+}
+
+ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void
+__xla_cpu_runtime_EigenSingleThreadedMatMulS8S32(
+    const void* run_options_ptr, int32_t* out, int8_t* lhs, int8_t* rhs,
+    int64_t m, int64_t n, int64_t k, int32_t transpose_lhs,
+    int32_t transpose_rhs) {
+  SingleThreadedMatMulDispatch<int32_t, int8_t>(
+      run_options_ptr, out, lhs, rhs, m, n, k, transpose_lhs, transpose_rhs);
+}
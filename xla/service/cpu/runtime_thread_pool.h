@@ -0,0 +1,48 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_RUNTIME_THREAD_POOL_H_
+#define XLA_SERVICE_CPU_RUNTIME_THREAD_POOL_H_
+
+namespace xla {
+namespace cpu {
+
+// The thread pool interface the parallel loops of XLA:CPU executables run on
+// when it is passed in ExecutableRunOptions. It has no dependencies, so that
+// ahead-of-time compiled models can run multi-threaded on any pool the client
+// already has, without linking another thread pool implementation.
+//
+// Implementations must be thread safe.
+class RuntimeThreadPool {
+ public:
+  virtual ~RuntimeThreadPool() = default;
+
+  // Returns the number of threads in the pool.
+  virtual int NumThreads() const = 0;
+
+  // Returns the index of the calling thread in [0, NumThreads()), or -1 if the
+  // calling thread does not belong to the pool.
+  virtual int CurrentThreadId() const = 0;
+
+  // Runs `fn(arg)` on a thread of the pool. Every scheduled function must
+  // eventually run, but the caller never blocks waiting for one to start, so
+  // they may be queued behind work that is already running.
+  virtual void Schedule(void (*fn)(void*), void* arg) const = 0;
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_RUNTIME_THREAD_POOL_H_
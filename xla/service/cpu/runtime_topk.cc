@@ -15,61 +15,262 @@ limitations under the License.
 
 #include "xla/service/cpu/runtime_topk.h"
 
+#define EIGEN_USE_THREADS
+
 #include <algorithm>
 #include <cstring>
 #include <limits>
 #include <memory>
 #include <numeric>
+#include <type_traits>
 #include <vector>
 
 #include "absl/base/dynamic_annotations.h"
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "xla/executable_run_options.h"
+
+namespace {
+
+// Below this many elements per row we never use the threshold filter: the
+// sampling overhead isn't worth it.
+constexpr int64_t kFilterMinInputSize = 16 * 1024;
+// Largest k for which we use a bounded heap.
+constexpr int64_t kHeapMaxK = 64;
+
+// Converts the bit pattern of a floating point value into a signed integer
+// whose integer order implements the total order
+// -NaN < -Inf < -Finite < -0 < +0 < +Finite < +Inf < +NaN.
+template <typename Bits>
+int32_t FloatBitsToTotalOrder(Bits bits) {
+  using Signed = std::make_signed_t<Bits>;
+  Signed value = static_cast<Signed>(bits);
+  return value < 0 ? value ^ std::numeric_limits<Signed>::max() : value;
+}
+
+// Traits describing how elements of a TopK input are ranked. `Storage` is the
+// in-memory representation of an element, `Key` is an integer whose natural
+// order is the TopK order.
+struct F32Traits {
+  using Storage = float;
+  using Key = int32_t;
+  static Key ToKey(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return FloatBitsToTotalOrder(bits);
+  }
+};
+
+// BF16 and F16 values are passed as their raw 16 bit patterns.
+struct F16BitsTraits {
+  using Storage = uint16_t;
+  using Key = int32_t;
+  static Key ToKey(uint16_t bits) { return FloatBitsToTotalOrder(bits); }
+};
 
 template <typename T>
-static void TopK(int64_t batch_size, int64_t input_size, int64_t k,
-                 const T* values, T* out_values, int32_t* out_indices) {
+struct IntegerTraits {
+  using Storage = T;
+  using Key = T;
+  static Key ToKey(T value) { return value; }
+};
+
+template <typename Key>
+struct Candidate {
+  Key key;
+  int32_t index;
+};
+
+// Returns true if `lhs` ranks before `rhs`: larger keys first, ties broken by
+// the smaller index.
+template <typename Key>
+bool RanksBefore(const Candidate<Key>& lhs, const Candidate<Key>& rhs) {
+  return lhs.key != rhs.key ? lhs.key > rhs.key : lhs.index < rhs.index;
+}
+
+// Computes the top k elements of rows of a TopK input. Holds scratch space
+// that is reused for all rows processed by the same instance.
+template <typename Traits>
+class TopKRowSelector {
+ public:
+  using Storage = typename Traits::Storage;
+  using Key = typename Traits::Key;
+
+  TopKRowSelector(int64_t input_size, int64_t k)
+      : input_size_(input_size), k_(k) {}
+
+  void Run(const Storage* values, Storage* out_values, int32_t* out_indices) {
+    if (k_ == 0) {
+      return;
+    }
+    if (k_ <= kHeapMaxK && k_ * 16 <= input_size_) {
+      SelectWithHeap(values);
+    } else if (input_size_ >= kFilterMinInputSize && k_ * 16 <= input_size_) {
+      SelectWithThresholdFilter(values);
+    } else {
+      SelectWithNthElement(values);
+    }
+    for (int64_t i = 0; i < k_; ++i) {
+      out_indices[i] = candidates_[i].index;
+      out_values[i] = values[candidates_[i].index];
+    }
+  }
+
+ private:
+  // Keeps the best k elements seen so far in a heap whose front is the worst
+  // of them. Most elements are rejected by a single comparison.
+  void SelectWithHeap(const Storage* values) {
+    candidates_.resize(k_);
+    for (int32_t i = 0; i < k_; ++i) {
+      candidates_[i] = {Traits::ToKey(values[i]), i};
+    }
+    std::make_heap(candidates_.begin(), candidates_.end(), RanksBefore<Key>);
+    for (int32_t i = k_; i < input_size_; ++i) {
+      Candidate<Key> candidate{Traits::ToKey(values[i]), i};
+      if (RanksBefore(candidate, candidates_.front())) {
+        std::pop_heap(candidates_.begin(), candidates_.end(),
+                      RanksBefore<Key>);
+        candidates_.back() = candidate;
+        std::push_heap(candidates_.begin(), candidates_.end(),
+                       RanksBefore<Key>);
+      }
+    }
+    std::sort_heap(candidates_.begin(), candidates_.end(), RanksBefore<Key>);
+  }
+
+  void SelectWithNthElement(const Storage* values) {
+    candidates_.resize(input_size_);
+    for (int32_t i = 0; i < input_size_; ++i) {
+      candidates_[i] = {Traits::ToKey(values[i]), i};
+    }
+    SelectFromCandidates(input_size_);
+  }
+
+  // Estimates a lower bound for the k-th largest key from a strided sample,
+  // then keeps only the elements whose keys reach it. The filter loop has no
+  // data-dependent branches so that it vectorizes.
+  void SelectWithThresholdFilter(const Storage* values) {
+    constexpr int64_t kSampleSize = 1024;
+    const int64_t stride = input_size_ / kSampleSize;
+    sample_.resize(kSampleSize);
+    for (int64_t i = 0; i < kSampleSize; ++i) {
+      sample_[i] = Traits::ToKey(values[i * stride]);
+    }
+    // Oversample the expected rank of the k-th element so that the threshold
+    // is very likely to let at least k elements through.
+    const int64_t rank = std::min<int64_t>(
+        kSampleSize - 1, 2 * k_ * kSampleSize / input_size_ + 16);
+    std::nth_element(sample_.begin(), sample_.begin() + rank, sample_.end(),
+                     std::greater<Key>());
+    const Key threshold = sample_[rank];
+
+    // One extra slot since every element is written before we know whether
+    // it passes the filter.
+    candidates_.resize(input_size_ + 1);
+    int64_t num_candidates = 0;
+    for (int32_t i = 0; i < input_size_; ++i) {
+      Key key = Traits::ToKey(values[i]);
+      candidates_[num_candidates] = {key, i};
+      num_candidates += key >= threshold;
+    }
+    if (num_candidates < k_) {
+      // The sample was unlucky, fall back to selecting from all elements.
+      SelectWithNthElement(values);
+      return;
+    }
+    // Every element of the top k has a key at least as large as the k-th
+    // largest candidate, which is >= threshold, so it is among the candidates.
+    SelectFromCandidates(num_candidates);
+  }
+
+  // Moves the top k of the first `num_candidates` candidates to the front in
+  // sorted order.
+  void SelectFromCandidates(int64_t num_candidates) {
+    auto begin = candidates_.begin();
+    if (k_ < num_candidates) {
+      std::nth_element(begin, begin + k_, begin + num_candidates,
+                       RanksBefore<Key>);
+    }
+    std::sort(begin, begin + k_, RanksBefore<Key>);
+  }
+
+  const int64_t input_size_;
+  const int64_t k_;
+  std::vector<Candidate<Key>> candidates_;
+  std::vector<Key> sample_;
+};
+
+template <typename Traits>
+void TopK(int64_t batch_size, int64_t input_size, int64_t k,
+          const typename Traits::Storage* values,
+          typename Traits::Storage* out_values, int32_t* out_indices,
+          const void* run_options_ptr) {
+  using Storage = typename Traits::Storage;
   // 'values' is managed by the JIT code, so msan can't tell they are
   // initialized.
-  ABSL_ANNOTATE_MEMORY_IS_INITIALIZED(values,
-                                      input_size * batch_size * sizeof(T));
-
-  std::vector<int32_t> temp_indices(input_size);
-  for (int64_t batch = 0; batch != batch_size; ++batch) {
-    std::iota(temp_indices.begin(), temp_indices.end(), 0);
-
-    const T* values_batch = values + batch * input_size;
-
-    auto convert_to_int = [](T value) {
-      uint32_t x;
-      std::memcpy(&x, &value, sizeof(x));
-      return static_cast<int32_t>(x) < 0
-                 ? std::numeric_limits<int32_t>::max() - x
-                 : x;
-    };
-
-    auto kth_element = temp_indices.begin() + k;
-    std::partial_sort(temp_indices.begin(), kth_element, temp_indices.end(),
-                      [&](size_t i1, size_t i2) {
-                        // Do the comparison in integers to enforce a total
-                        // order of -NaN < -Inf < -0 < +0 < +Inf < +NaN.
-                        int32_t v1 = convert_to_int(values_batch[i1]);
-                        int32_t v2 = convert_to_int(values_batch[i2]);
-                        if (v1 == v2) {
-                          return i1 < i2;  // Stabilize sorting.
-                        }
-                        return v1 > v2;
-                      });
-
-    T* out_values_batch = out_values + batch * k;
-    int32_t* out_indices_batch = out_indices + batch * k;
-    std::copy(temp_indices.begin(), kth_element, out_indices_batch);
-    for (int64_t i = 0; i < k; i++) {
-      out_values_batch[i] = values_batch[temp_indices[i]];
+  ABSL_ANNOTATE_MEMORY_IS_INITIALIZED(
+      values, input_size * batch_size * sizeof(Storage));
+
+  auto process_rows = [&](int64_t first_batch, int64_t last_batch) {
+    TopKRowSelector<Traits> selector(input_size, k);
+    for (int64_t batch = first_batch; batch < last_batch; ++batch) {
+      selector.Run(values + batch * input_size, out_values + batch * k,
+                   out_indices + batch * k);
     }
+  };
+
+  const xla::ExecutableRunOptions* run_options =
+      static_cast<const xla::ExecutableRunOptions*>(run_options_ptr);
+  const Eigen::ThreadPoolDevice* pool =
+      run_options == nullptr ? nullptr : run_options->intra_op_thread_pool();
+  if (pool == nullptr || batch_size <= 1 || pool->numThreads() <= 1) {
+    process_rows(0, batch_size);
+    return;
   }
+  // Every row loads its input once and performs a few operations per
+  // element; selecting and sorting the top k adds O(k * log(k)).
+  Eigen::TensorOpCost cost(
+      /*bytes_loaded=*/input_size * sizeof(Storage),
+      /*bytes_stored=*/k * (sizeof(Storage) + sizeof(int32_t)),
+      /*compute_cycles=*/4 * input_size + 8 * k * std::max<int64_t>(1, k / 8));
+  pool->parallelFor(batch_size, cost,
+                    [&](Eigen::Index first, Eigen::Index last) {
+                      process_rows(first, last);
+                    });
 }
 
+}  // namespace
+
 ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_TopKF32(
     int64_t batch_size, int64_t input_size, int64_t k, const float* values,
-    float* out_values, int32_t* out_indices) {
-  TopK(batch_size, input_size, k, values, out_values, out_indices);
+    float* out_values, int32_t* out_indices, const void* run_options) {
+  TopK<F32Traits>(batch_size, input_size, k, values, out_values, out_indices,
+                  run_options);
+}
+
+ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_TopKBF16(
+    int64_t batch_size, int64_t input_size, int64_t k, const uint16_t* values,
+    uint16_t* out_values, int32_t* out_indices, const void* run_options) {
+  TopK<F16BitsTraits>(batch_size, input_size, k, values, out_values,
+                      out_indices, run_options);
+}
+
+ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_TopKF16(
+    int64_t batch_size, int64_t input_size, int64_t k, const uint16_t* values,
+    uint16_t* out_values, int32_t* out_indices, const void* run_options) {
+  TopK<F16BitsTraits>(batch_size, input_size, k, values, out_values,
+                      out_indices, run_options);
+}
+
+ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_TopKS32(
+    int64_t batch_size, int64_t input_size, int64_t k, const int32_t* values,
+    int32_t* out_values, int32_t* out_indices, const void* run_options) {
+  TopK<IntegerTraits<int32_t>>(batch_size, input_size, k, values, out_values,
+                               out_indices, run_options);
+}
+
+ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_TopKU32(
+    int64_t batch_size, int64_t input_size, int64_t k, const uint32_t* values,
+    uint32_t* out_values, int32_t* out_indices, const void* run_options) {
+  TopK<IntegerTraits<uint32_t>>(batch_size, input_size, k, values, out_values,
+                                out_indices, run_options);
 }
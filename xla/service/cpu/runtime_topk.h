@@ -21,10 +21,38 @@ limitations under the License.
 extern "C" {
 
 // Calculates `batch_size` topk operations with `input_size` inputs each. The
-// outputs are written to `out_values` and `out_indices`.
+// outputs are written to `out_values` and `out_indices`. Elements are ordered
+// from largest to smallest, floating point values in the total order
+// -NaN < -Inf < -Finite < -0 < +0 < +Finite < +Inf < +NaN, and ties are broken
+// by the smaller index. Batch rows are processed in parallel on the intra-op
+// thread pool of `run_options` (a xla::ExecutableRunOptions*) if it is
+// non-null and has one.
 extern void __xla_cpu_runtime_TopKF32(int64_t batch_size, int64_t input_size,
                                       int64_t k, const float* values,
-                                      float* out_values, int32_t* out_indices);
+                                      float* out_values, int32_t* out_indices,
+                                      const void* run_options);
+
+// Variants of __xla_cpu_runtime_TopKF32 for other element types. BF16 and F16
+// values are passed as their raw bit patterns.
+extern void __xla_cpu_runtime_TopKBF16(int64_t batch_size, int64_t input_size,
+                                       int64_t k, const uint16_t* values,
+                                       uint16_t* out_values,
+                                       int32_t* out_indices,
+                                       const void* run_options);
+extern void __xla_cpu_runtime_TopKF16(int64_t batch_size, int64_t input_size,
+                                      int64_t k, const uint16_t* values,
+                                      uint16_t* out_values,
+                                      int32_t* out_indices,
+                                      const void* run_options);
+extern void __xla_cpu_runtime_TopKS32(int64_t batch_size, int64_t input_size,
+                                      int64_t k, const int32_t* values,
+                                      int32_t* out_values, int32_t* out_indices,
+                                      const void* run_options);
+extern void __xla_cpu_runtime_TopKU32(int64_t batch_size, int64_t input_size,
+                                      int64_t k, const uint32_t* values,
+                                      uint32_t* out_values,
+                                      int32_t* out_indices,
+                                      const void* run_options);
 }
 
 #endif  // XLA_SERVICE_CPU_RUNTIME_TOPK_H_
@@ -0,0 +1,201 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include "xla/service/cpu/runtime_topk.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "xla/executable_run_options.h"
+#include "tsl/platform/cpu_info.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+
+namespace xla {
+namespace {
+
+// Returns the expected TopK indices of every batch row, computed with a
+// stable sort over all elements.
+template <typename T, typename Greater>
+std::vector<int32_t> ReferenceTopKIndices(const std::vector<T>& values,
+                                          int64_t batch_size,
+                                          int64_t input_size, int64_t k,
+                                          Greater greater) {
+  std::vector<int32_t> result;
+  std::vector<int32_t> indices(input_size);
+  for (int64_t batch = 0; batch < batch_size; ++batch) {
+    const T* row = values.data() + batch * input_size;
+    std::iota(indices.begin(), indices.end(), 0);
+    std::stable_sort(indices.begin(), indices.end(), [&](int32_t a, int32_t b) {
+      return greater(row[a], row[b]);
+    });
+    result.insert(result.end(), indices.begin(), indices.begin() + k);
+  }
+  return result;
+}
+
+bool TotalOrderGreater(float a, float b) {
+  auto to_int = [](float value) {
+    int32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits < 0 ? bits ^ std::numeric_limits<int32_t>::max() : bits;
+  };
+  return to_int(a) > to_int(b);
+}
+
+class TopKTest
+    : public ::testing::TestWithParam<std::tuple<int64_t, int64_t, bool>> {};
+
+TEST_P(TopKTest, F32MatchesStableSort) {
+  auto [input_size, k, use_thread_pool] = GetParam();
+  constexpr int64_t kBatchSize = 4;
+  std::minstd_rand0 generator(input_size * 31 + k);
+  // Draw from a small range so that there are many ties.
+  std::uniform_int_distribution<int> distribution(-100, 100);
+  std::vector<float> values(kBatchSize * input_size);
+  for (float& value : values) {
+    value = distribution(generator) * 0.25f;
+  }
+  values[0] = NAN;
+  values[values.size() - 1] = -0.0f;
+
+  Eigen::ThreadPool pool(4);
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  ExecutableRunOptions run_options;
+  run_options.set_intra_op_thread_pool(&device);
+
+  std::vector<float> out_values(kBatchSize * k);
+  std::vector<int32_t> out_indices(kBatchSize * k);
+  __xla_cpu_runtime_TopKF32(kBatchSize, input_size, k, values.data(),
+                            out_values.data(), out_indices.data(),
+                            use_thread_pool ? &run_options : nullptr);
+
+  EXPECT_EQ(out_indices, ReferenceTopKIndices(values, kBatchSize, input_size,
+                                              k, TotalOrderGreater));
+  for (int64_t batch = 0; batch < kBatchSize; ++batch) {
+    for (int64_t i = 0; i < k; ++i) {
+      float expected = values[batch * input_size + out_indices[batch * k + i]];
+      float actual = out_values[batch * k + i];
+      EXPECT_TRUE(std::memcmp(&expected, &actual, sizeof(float)) == 0);
+    }
+  }
+}
+
+TEST_P(TopKTest, S32MatchesStableSort) {
+  auto [input_size, k, use_thread_pool] = GetParam();
+  constexpr int64_t kBatchSize = 3;
+  std::minstd_rand0 generator(input_size * 17 + k);
+  std::uniform_int_distribution<int32_t> distribution(-1000, 1000);
+  std::vector<int32_t> values(kBatchSize * input_size);
+  for (int32_t& value : values) {
+    value = distribution(generator);
+  }
+
+  Eigen::ThreadPool pool(4);
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  ExecutableRunOptions run_options;
+  run_options.set_intra_op_thread_pool(&device);
+
+  std::vector<int32_t> out_values(kBatchSize * k);
+  std::vector<int32_t> out_indices(kBatchSize * k);
+  __xla_cpu_runtime_TopKS32(kBatchSize, input_size, k, values.data(),
+                            out_values.data(), out_indices.data(),
+                            use_thread_pool ? &run_options : nullptr);
+
+  EXPECT_EQ(out_indices,
+            ReferenceTopKIndices(values, kBatchSize, input_size, k,
+                                 [](int32_t a, int32_t b) { return a > b; }));
+}
+
+// Covers k = 0, and the heap (small k), threshold filter (large input,
+// moderate k) and nth_element selection strategies.
+INSTANTIATE_TEST_SUITE_P(
+    TopKTestInstantiation, TopKTest,
+    ::testing::Values(std::make_tuple(1000, 0, false),
+                      std::make_tuple(1000, 0, true),
+                      std::make_tuple(1, 1, false),
+                      std::make_tuple(100, 100, false),
+                      std::make_tuple(1000, 5, false),
+                      std::make_tuple(1000, 5, true),
+                      std::make_tuple(1000, 300, true),
+                      std::make_tuple(50000, 200, false),
+                      std::make_tuple(50000, 200, true),
+                      std::make_tuple(50000, 40000, true)));
+
+TEST(TopKBF16Test, OrdersNegativeValuesAndNaNs) {
+  // Bit patterns of bf16 -1.0, +1.0, -0.0, +NaN, -2.0, +0.0.
+  std::vector<uint16_t> values = {0xbf80, 0x3f80, 0x8000,
+                                  0x7fc0, 0xc000, 0x0000};
+  std::vector<uint16_t> out_values(values.size());
+  std::vector<int32_t> out_indices(values.size());
+  __xla_cpu_runtime_TopKBF16(1, values.size(), values.size(), values.data(),
+                             out_values.data(), out_indices.data(),
+                             /*run_options=*/nullptr);
+  EXPECT_EQ(out_indices, std::vector<int32_t>({3, 1, 5, 2, 0, 4}));
+  EXPECT_EQ(out_values, std::vector<uint16_t>({0x7fc0, 0x3f80, 0x0000, 0x8000,
+                                               0xbf80, 0xc000}));
+}
+
+void BM_TopKF32(::testing::benchmark::State& state) {
+  const int64_t batch_size = state.range(0);
+  const int64_t input_size = state.range(1);
+  const int64_t k = state.range(2);
+
+  std::minstd_rand0 generator(0);
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  std::vector<float> values(batch_size * input_size);
+  for (float& value : values) {
+    value = distribution(generator);
+  }
+  std::vector<float> out_values(batch_size * k);
+  std::vector<int32_t> out_indices(batch_size * k);
+
+  Eigen::ThreadPool pool(tsl::port::MaxParallelism());
+  Eigen::ThreadPoolDevice device(&pool, pool.NumThreads());
+  ExecutableRunOptions run_options;
+  run_options.set_intra_op_thread_pool(&device);
+
+  for (auto s : state) {
+    __xla_cpu_runtime_TopKF32(batch_size, input_size, k, values.data(),
+                              out_values.data(), out_indices.data(),
+                              &run_options);
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size * input_size);
+}
+
+BENCHMARK(BM_TopKF32)
+    ->ArgNames({"batch", "n", "k"})
+    ->Args({1, 1000, 10})
+    ->Args({1, 50000, 10})
+    ->Args({1, 50000, 1000})
+    ->Args({64, 1000, 10})
+    ->Args({64, 50000, 10})
+    ->Args({64, 50000, 128})
+    ->Args({64, 50000, 1000})
+    ->Args({64, 50000, 25000})
+    ->Args({256, 4096, 64});
+
+}  // namespace
+}  // namespace xla
@@ -21,7 +21,9 @@ limitations under the License.
 #include <cstdio>
 #include <list>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/JITSymbol.h"
@@ -30,6 +32,7 @@ limitations under the License.
 #include "llvm/IR/Mangler.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/Support/CodeGen.h"
+#include "llvm/Support/Error.h"
 #include "llvm/TargetParser/Host.h"
 #include "mlir/ExecutionEngine/CRunnerUtils.h"  // from @llvm-project
 #include "xla/service/cpu/cpu_runtime.h"
@@ -55,6 +58,7 @@ limitations under the License.
 #include "xla/service/cpu/windows_compatibility.h"
 #include "xla/service/custom_call_target_registry.h"
 #include "xla/types.h"
+#include "tsl/platform/blocking_counter.h"
 #include "tsl/platform/logging.h"
 
 // Provided by compiler-rt and MLIR.
@@ -107,7 +111,15 @@ SimpleOrcJIT::SimpleOrcJIT(
     LLVMCompiler::ModuleHook pre_optimization_hook,
     LLVMCompiler::ModuleHook post_optimization_hook,
     std::function<void(const llvm::object::ObjectFile&)> post_codegen_hook)
-    : target_machine_(InferTargetMachineForJIT(target_options, opt_level)),
+    : target_options_(target_options),
+      opt_level_(opt_level),
+      make_compiler_([=](llvm::TargetMachine* target_machine) {
+        return std::make_unique<CompilerFunctor>(
+            target_machine, opt_level, optimize_for_size,
+            disable_expensive_passes, disable_slp_vectorizer, fast_math_flags,
+            pre_optimization_hook, post_optimization_hook, post_codegen_hook);
+      }),
+      target_machine_(InferTargetMachineForJIT(target_options, opt_level)),
       target_triple_(target_machine_->getTargetTriple()),
       data_layout_(target_machine_->createDataLayout()),
       target_process_control_(std::move(target_process_control)),
@@ -117,13 +129,8 @@ SimpleOrcJIT::SimpleOrcJIT(
                       return std::make_unique<llvm::SectionMemoryManager>(
                           orc_jit_memory_mapper::GetInstance());
                     }),
-      compile_layer_(
-          *execution_session_, object_layer_,
-          std::make_unique<CompilerFunctor>(
-              target_machine_.get(), opt_level, optimize_for_size,
-              disable_expensive_passes, disable_slp_vectorizer, fast_math_flags,
-              std::move(pre_optimization_hook),
-              std::move(post_optimization_hook), std::move(post_codegen_hook))),
+      compile_layer_(*execution_session_, object_layer_,
+                     make_compiler_(target_machine_.get())),
       main_jit_dylib_(&execution_session_->createBareJITDylib("<main>")),
       gdb_jit_event_listener_(
           llvm::JITEventListener::createGDBRegistrationListener()),
@@ -242,6 +249,51 @@ llvm::Error SimpleOrcJIT::AddModule(llvm::orc::ThreadSafeModule module) {
   return compile_layer_.add(*main_jit_dylib_, std::move(module));
 }
 
+llvm::Error SimpleOrcJIT::AddModulesInParallel(
+    std::vector<llvm::orc::ThreadSafeModule> modules,
+    tsl::thread::ThreadPool* thread_pool) {
+  // Target machines are not thread-safe, so every module gets its own.
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> objects(modules.size());
+  std::vector<std::string> errors(modules.size());
+  tsl::BlockingCounter counter(modules.size());
+  for (int i = 0; i < modules.size(); ++i) {
+    thread_pool->Schedule([&, i] {
+      std::unique_ptr<llvm::TargetMachine> target_machine =
+          InferTargetMachineForJIT(target_options_, opt_level_);
+      std::unique_ptr<CompilerFunctor> compiler =
+          make_compiler_(target_machine.get());
+      modules[i].withModuleDo([&](llvm::Module& module) {
+        llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> object =
+            (*compiler)(module);
+        if (object) {
+          objects[i] = std::move(*object);
+        } else {
+          errors[i] = llvm::toString(object.takeError());
+        }
+      });
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+
+  for (int i = 0; i < modules.size(); ++i) {
+    if (!errors[i].empty()) {
+      return llvm::make_error<llvm::StringError>(
+          errors[i], llvm::inconvertibleErrorCode());
+    }
+    if (llvm::Error error =
+            object_layer_.add(*main_jit_dylib_, std::move(objects[i]))) {
+      return error;
+    }
+  }
+  return llvm::Error::success();
+}
+
+llvm::Error SimpleOrcJIT::AddObjFile(
+    std::unique_ptr<llvm::MemoryBuffer> obj_file) {
+  return object_layer_.add(*main_jit_dylib_, std::move(obj_file));
+}
+
 void SimpleOrcJIT::DoneCompiling() {
   // The target machine takes a non-trivial amount of memory, so once we are
   // done compiling throw it away.
@@ -297,10 +349,16 @@ bool RegisterKnownJITSymbols() {
   REGISTER_CPU_RUNTIME_SYMBOL(EigenMatMulC128);
   REGISTER_CPU_RUNTIME_SYMBOL(EigenMatMulS32);
   REGISTER_CPU_RUNTIME_SYMBOL(EigenBatchMatMulF32);
+  REGISTER_CPU_RUNTIME_SYMBOL(EigenMatMulBF16F32);
+  REGISTER_CPU_RUNTIME_SYMBOL(EigenMatMulS8S32);
+  REGISTER_CPU_RUNTIME_SYMBOL(EigenBatchMatMulBF16F32);
+  REGISTER_CPU_RUNTIME_SYMBOL(EigenBatchMatMulS8S32);
   REGISTER_CPU_RUNTIME_SYMBOL(MKLMatMulF32);
   REGISTER_CPU_RUNTIME_SYMBOL(MKLMatMulF64);
   REGISTER_CPU_RUNTIME_SYMBOL(MKLSingleThreadedMatMulF32);
   REGISTER_CPU_RUNTIME_SYMBOL(MKLSingleThreadedMatMulF64);
+  REGISTER_CPU_RUNTIME_SYMBOL(MKLMatMulBF16F32);
+  REGISTER_CPU_RUNTIME_SYMBOL(MKLSingleThreadedMatMulBF16F32);
   REGISTER_CPU_RUNTIME_SYMBOL(ACLMatMulF32);
   REGISTER_CPU_RUNTIME_SYMBOL(ACLBatchMatMulF32);
   REGISTER_CPU_RUNTIME_SYMBOL(ACLConv2DF32);
@@ -315,13 +373,25 @@ bool RegisterKnownJITSymbols() {
   REGISTER_CPU_RUNTIME_SYMBOL(EigenSingleThreadedMatMulC64);
   REGISTER_CPU_RUNTIME_SYMBOL(EigenSingleThreadedMatMulC128);
   REGISTER_CPU_RUNTIME_SYMBOL(EigenSingleThreadedMatMulS32);
+  REGISTER_CPU_RUNTIME_SYMBOL(EigenSingleThreadedMatMulBF16F32);
+  REGISTER_CPU_RUNTIME_SYMBOL(EigenSingleThreadedMatMulS8S32);
   REGISTER_CPU_RUNTIME_SYMBOL(ParallelForkJoin);
   REGISTER_CPU_RUNTIME_SYMBOL(PrintfToStderr);
   REGISTER_CPU_RUNTIME_SYMBOL(ReleaseInfeedBufferAfterDequeue);
   REGISTER_CPU_RUNTIME_SYMBOL(ReleaseOutfeedBufferAfterPopulation);
   REGISTER_CPU_RUNTIME_SYMBOL(StatusIsSuccess);
   REGISTER_CPU_RUNTIME_SYMBOL(KeyValueSort);
+  REGISTER_CPU_RUNTIME_SYMBOL(KeySortS32);
+  REGISTER_CPU_RUNTIME_SYMBOL(KeySortS64);
+  REGISTER_CPU_RUNTIME_SYMBOL(KeySortU32);
+  REGISTER_CPU_RUNTIME_SYMBOL(KeySortU64);
+  REGISTER_CPU_RUNTIME_SYMBOL(KeySortF32);
+  REGISTER_CPU_RUNTIME_SYMBOL(KeySortF64);
+  REGISTER_CPU_RUNTIME_SYMBOL(TopKBF16);
+  REGISTER_CPU_RUNTIME_SYMBOL(TopKF16);
   REGISTER_CPU_RUNTIME_SYMBOL(TopKF32);
+  REGISTER_CPU_RUNTIME_SYMBOL(TopKS32);
+  REGISTER_CPU_RUNTIME_SYMBOL(TopKU32);
   REGISTER_CPU_RUNTIME_SYMBOL(TracingStart);
   REGISTER_CPU_RUNTIME_SYMBOL(TracingEnd);
 
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef XLA_SERVICE_CPU_SIMPLE_ORC_JIT_H_
 #define XLA_SERVICE_CPU_SIMPLE_ORC_JIT_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -31,6 +32,7 @@ limitations under the License.
 #include "llvm/TargetParser/Triple.h"
 #include "xla/service/cpu/compiler_functor.h"
 #include "xla/types.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 namespace cpu {
@@ -81,6 +83,19 @@ class SimpleOrcJIT : public llvm::JITEventListener {
 
   llvm::Error AddModule(llvm::orc::ThreadSafeModule module);
 
+  // Optimizes and compiles `modules` to machine code concurrently on
+  // `thread_pool`, each with its own target machine, and adds the objects to
+  // the JIT, which resolves the references between them when linking. The
+  // modules should not share an LLVM context, as compiling a module holds the
+  // lock of its context. The module hooks may be called concurrently.
+  llvm::Error AddModulesInParallel(
+      std::vector<llvm::orc::ThreadSafeModule> modules,
+      tsl::thread::ThreadPool* thread_pool);
+
+  // Adds an object file the JIT compiled earlier, e.g. one kept by the
+  // post-codegen hook of another SimpleOrcJIT with the same target.
+  llvm::Error AddObjFile(std::unique_ptr<llvm::MemoryBuffer> obj_file);
+
   // Discards objects we no longer need once we are done compiling.
   void DoneCompiling();
 
@@ -110,6 +125,13 @@ class SimpleOrcJIT : public llvm::JITEventListener {
       const llvm::RuntimeDyld::LoadedObjectInfo& object_info) override;
   void notifyFreeingObject(llvm::JITEventListener::ObjectKey key) override;
 
+  const llvm::TargetOptions target_options_;
+  const llvm::CodeGenOpt::Level opt_level_;
+  // Creates a compiler with the options of this JIT for `target_machine`.
+  std::function<std::unique_ptr<CompilerFunctor>(
+      llvm::TargetMachine* target_machine)>
+      make_compiler_;
+
   std::unique_ptr<llvm::TargetMachine> target_machine_;
   llvm::Triple target_triple_;
   const llvm::DataLayout data_layout_;
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 
+#include "llvm/MC/MCSubtargetInfo.h"
 #include "xla/cpu_function_runtime.h"
 #include "tsl/platform/logging.h"
 
@@ -51,5 +52,15 @@ int64_t LLVMTargetMachineFeatures::minimum_alignment_for_allocation(
                            cpu_function_runtime::MinAlign());
 }
 
+bool LLVMTargetMachineFeatures::has_bf16_dot_product_instructions() const {
+  if (!target_machine_->getTargetTriple().isX86()) {
+    return false;
+  }
+  const llvm::MCSubtargetInfo* subtarget_info =
+      target_machine_->getMCSubtargetInfo();
+  return subtarget_info->checkFeatures("+avx512bf16") ||
+         subtarget_info->checkFeatures("+amx-bf16");
+}
+
 }  // namespace cpu
 }  // namespace xla
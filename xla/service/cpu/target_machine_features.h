@@ -62,6 +62,10 @@ class TargetMachineFeatures {
   virtual int64_t minimum_alignment_for_allocation(
       int64_t size_bytes) const = 0;
 
+  // Returns true if the target has instructions that multiply bf16 values and
+  // accumulate the products in f32, e.g. AVX512_BF16 or AMX-BF16.
+  virtual bool has_bf16_dot_product_instructions() const = 0;
+
   virtual ~TargetMachineFeatures() = default;
 };
 
@@ -101,6 +105,8 @@ class LLVMTargetMachineFeatures : public TargetMachineFeatures {
 
   int64_t minimum_alignment_for_allocation(int64_t size_bytes) const override;
 
+  bool has_bf16_dot_product_instructions() const override;
+
  private:
   llvm::TargetTransformInfo* GetTargetTransformInfoFor(
       const llvm::Function& function) const;
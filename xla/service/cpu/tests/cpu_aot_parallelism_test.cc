@@ -0,0 +1,87 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <string>
+
+#include "xla/service/cpu/cpu_compiler.h"
+#include "xla/service/cpu/test_target_triple_helper.h"
+#include "xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+using CpuAotParallelismTest = CpuCodegenTest;
+
+constexpr char kHloText[] = R"(
+HloModule module
+
+ENTRY main {
+  p = f32[4096,4096] parameter(0)
+  ROOT n = f32[4096,4096] negate(p)
+}
+)";
+
+CpuAotCompilationOptions AotOptions() {
+  return CpuAotCompilationOptions{
+      /*triple=*/kTargetTripleForHost, /*cpu_name=*/kTargetCpuForHost,
+      /*features=*/"",
+      /*entry_point_name=*/"entry",
+      /*relocation_model=*/CpuAotCompilationOptions::RelocationModel::Static};
+}
+
+TEST_F(CpuAotParallelismTest, SingleThreadedByDefault) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHloText));
+  CompileAheadOfTimeAndVerifyIr(std::move(module), AotOptions(), R"(
+CHECK-NOT: __xla_cpu_runtime_ParallelForkJoin
+)",
+                                /*match_optimized_ir=*/false);
+}
+
+TEST_F(CpuAotParallelismTest, ParallelLoopsWhenRequested) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHloText));
+  DebugOptions debug_options = module->config().debug_options();
+  debug_options.set_xla_cpu_aot_parallelism(4);
+  module->config().set_debug_options(debug_options);
+  CompileAheadOfTimeAndVerifyIr(std::move(module), AotOptions(), R"(
+CHECK: call void @__xla_cpu_runtime_ParallelForkJoin
+)",
+                                /*match_optimized_ir=*/false);
+}
+
+// The throughput of the build host says nothing about the machine an AOT
+// executable runs on, so it is neither measured nor read.
+TEST_F(CpuAotParallelismTest, DoesNotMeasureBuildHost) {
+  const std::string host_throughput_path =
+      tsl::io::JoinPath(::testing::TempDir(), "aot_host_throughput");
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHloText));
+  DebugOptions debug_options = module->config().debug_options();
+  debug_options.set_xla_cpu_aot_parallelism(4);
+  debug_options.set_xla_cpu_host_throughput_path(host_throughput_path);
+  module->config().set_debug_options(debug_options);
+  CompileAheadOfTimeAndVerifyIr(std::move(module), AotOptions(), R"(
+CHECK: call void @__xla_cpu_runtime_ParallelForkJoin
+)",
+                                /*match_optimized_ir=*/false);
+  EXPECT_FALSE(tsl::Env::Default()->FileExists(host_throughput_path).ok());
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -93,6 +93,22 @@ TEST_P(CpuEigenDotOperationTest, DotTransposeOp) {
   CompileAndCheck(builder.Build(), spec.filecheck_lines);
 }
 
+TEST_F(CpuEigenDotOperationTest, MixedPrecisionS8DotOp) {
+  HloComputation::Builder builder(TestName());
+
+  auto param_shape = ShapeUtil::MakeShape(S8, {128, 128});
+  auto result_shape = ShapeUtil::MakeShape(S32, {128, 128});
+
+  HloInstruction* lhs = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, param_shape, "input"));
+  HloInstruction* rhs = builder.AddInstruction(
+      HloInstruction::CreateParameter(1, param_shape, "input"));
+
+  builder.AddInstruction(CreateCanonicalDot(result_shape, lhs, rhs));
+  CompileAndCheck(builder.Build(),
+                  R"(CHECK: call void @__xla_cpu_runtime_EigenMatMulS8S32)");
+}
+
 std::vector<DotTestSpec> GetDotTestCases() {
   std::vector<DotTestSpec> result;
   // The fp16 test runs a 32-bit matmul because we promote fp16 gemms to fp32
@@ -101,6 +117,9 @@ std::vector<DotTestSpec> GetDotTestCases() {
       {F16, R"(CHECK: call void @__xla_cpu_runtime_EigenMatMulF32)"});
   result.push_back(
       {F32, R"(CHECK: call void @__xla_cpu_runtime_EigenMatMulF32)"});
+  // bf16 gemms accumulate in f32 without converting their operands first.
+  result.push_back(
+      {BF16, R"(CHECK: call void @__xla_cpu_runtime_EigenMatMulBF16F32)"});
   result.push_back(
       {F64, R"(CHECK: call void @__xla_cpu_runtime_EigenMatMulF64)"});
   return result;
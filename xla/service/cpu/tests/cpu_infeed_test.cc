@@ -16,13 +16,17 @@ limitations under the License.
 #include <unistd.h>
 
 #include <memory>
+#include <vector>
 
+#include "xla/client/client_library.h"
 #include "xla/client/global_data.h"
 #include "xla/client/lib/arithmetic.h"
 #include "xla/client/local_client.h"
 #include "xla/client/xla_builder.h"
 #include "xla/client/xla_computation.h"
 #include "xla/literal.h"
+#include "xla/literal_util.h"
+#include "xla/service/platform_util.h"
 #include "xla/shape_util.h"
 #include "xla/statusor.h"
 #include "xla/test_helpers.h"
@@ -31,6 +35,7 @@ limitations under the License.
 #include "xla/xla_data.pb.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
 
 namespace xla {
 namespace {
@@ -287,5 +292,66 @@ TEST_F(InfeedTest, DISABLED_TwoInfeedsInTotalOrder) {
   LiteralTestUtil::ExpectR0Near<float>(66.0f, result_literal, ErrorSpec{1e-7});
 }
 
+// Measures the latency of a round trip through a compiled while loop that
+// infeeds a small value and outfeeds it again, as a streaming computation
+// does once per step.
+void BM_InfeedOutfeedRoundTripInWhile(::testing::benchmark::State& state) {
+  constexpr int32_t kRoundTrips = 1000;
+  se::Platform* platform = PlatformUtil::GetDefaultPlatform().value();
+  LocalClient* client = ClientLibrary::GetOrCreateLocalClient(platform).value();
+
+  const Shape value_shape = ShapeUtil::MakeShape(F32, {16});
+  const Shape state_shape = ShapeUtil::MakeTupleShape(
+      {ShapeUtil::MakeShape(S32, {}), ShapeUtil::MakeTokenShape()});
+  XlaComputation condition;
+  {
+    XlaBuilder builder("condition");
+    auto prev = Parameter(&builder, 0, state_shape, "prev");
+    Lt(GetTupleElement(prev, 0), ConstantR0<int32_t>(&builder, kRoundTrips));
+    condition = builder.Build().value();
+  }
+  XlaComputation body;
+  {
+    XlaBuilder builder("body");
+    auto prev = Parameter(&builder, 0, state_shape, "prev");
+    auto infeed = InfeedWithToken(GetTupleElement(prev, 1), value_shape);
+    auto token = OutfeedWithToken(GetTupleElement(infeed, 0),
+                                  GetTupleElement(infeed, 1), value_shape, "");
+    Tuple(&builder,
+          {Add(GetTupleElement(prev, 0), ConstantR0<int32_t>(&builder, 1)),
+           token});
+    body = builder.Build().value();
+  }
+  XlaBuilder builder("round_trips");
+  While(condition, body,
+        Tuple(&builder,
+              {ConstantR0<int32_t>(&builder, 0), CreateToken(&builder)}));
+  auto executable =
+      std::move(client
+                    ->Compile(builder.Build().value(), {},
+                              ExecutableBuildOptions())
+                    .value()[0]);
+
+  Literal input = LiteralUtil::CreateR1<float>(std::vector<float>(16, 1.0f));
+  Literal output(value_shape);
+  for (auto s : state) {
+    std::unique_ptr<tsl::Thread> computation_thread(
+        tsl::Env::Default()->StartThread(
+            tsl::ThreadOptions{}, "computation_thread", [&] {
+              TF_CHECK_OK(executable
+                              ->Run(absl::Span<const ShapedBuffer* const>(),
+                                    ExecutableRunOptions())
+                              .status());
+            }));
+    for (int32_t i = 0; i < kRoundTrips; ++i) {
+      TF_CHECK_OK(client->TransferToInfeedLocal(input, /*device_ordinal=*/0));
+      TF_CHECK_OK(client->TransferFromOutfeedLocal(/*device_ordinal=*/0,
+                                                   &output));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kRoundTrips);
+}
+BENCHMARK(BM_InfeedOutfeedRoundTripInWhile)->UseRealTime();
+
 }  // namespace
 }  // namespace xla
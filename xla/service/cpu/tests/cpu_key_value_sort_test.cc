@@ -58,6 +58,40 @@ CHECK: call void @__xla_cpu_runtime_KeyValueSort
                                 /*match_optimized_ir=*/true);
 }
 
+TEST_F(CpuKeyValueSortTest, SortR2WithSimpleComparatorUsesKeySort) {
+  const std::string hlo_text = R"(
+HloModule KeySort
+
+compare {
+  p.0.lhs = f32[] parameter(0)
+  p.0.rhs = f32[] parameter(1)
+  ROOT gt = pred[] compare(p.0.lhs, p.0.rhs), direction=GT
+}
+
+ENTRY main {
+  a = f32[4,10] parameter(0)
+
+  ROOT result = f32[4,10] sort(f32[4,10] a), dimensions={1}, to_apply=compare
+}
+)";
+
+  std::string filecheck_pattern = R"(
+CHECK: call void @__xla_cpu_runtime_KeySortF32(i64 4, i64 10, i64 1,
+CHECK-NOT: call void @__xla_cpu_runtime_KeyValueSort
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo_text));
+
+  CpuAotCompilationOptions options{
+      /*triple=*/kTargetTripleForHost, /*cpu_name=*/kTargetCpuForHost,
+      /*features=*/"",
+      /*entry_point_name=*/"entry",
+      /*relocation_model=*/CpuAotCompilationOptions::RelocationModel::Static};
+
+  CompileAheadOfTimeAndVerifyIr(std::move(module), options, filecheck_pattern,
+                                /*match_optimized_ir=*/true);
+}
+
 }  // namespace
 }  // namespace cpu
 }  // namespace xla
@@ -0,0 +1,122 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "xla/client/client_library.h"
+#include "xla/client/executable_build_options.h"
+#include "xla/client/lib/arithmetic.h"
+#include "xla/client/local_client.h"
+#include "xla/client/xla_builder.h"
+#include "xla/literal.h"
+#include "xla/service/cpu/cpu_compiler.h"
+#include "xla/service/cpu/tests/cpu_codegen_test.h"
+#include "xla/service/platform_util.h"
+#include "xla/shape_util.h"
+#include "xla/tests/literal_test_util.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+class CpuParallelCodegenTest : public CpuCodegenTest,
+                               public ::testing::WithParamInterface<int> {};
+
+// The module emits several functions that call each other, so that the split
+// LLVM modules have to be linked, and a small constant used from the entry
+// function.
+TEST_P(CpuParallelCodegenTest, SplitModulesAreLinked) {
+  const std::string hlo_text = R"(
+HloModule module
+
+add {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  ROOT s = f32[] add(a, b)
+}
+
+less {
+  l = f32[] parameter(0)
+  r = f32[] parameter(1)
+  ROOT lt = pred[] compare(l, r), direction=LT
+}
+
+ENTRY entry {
+  i = f32[64,4] iota(), iota_dimension=0
+  small = f32[4] constant({4, 3, 2, 1})
+  b = f32[64,4] broadcast(small), dimensions={1}
+  m = f32[64,4] multiply(i, b)
+  n = f32[64,4] negate(m)
+  s = f32[64,4] sort(n), dimensions={0}, to_apply=less
+  zero = f32[] constant(0)
+  ROOT r = f32[4] reduce(s, zero), dimensions={0}, to_apply=add
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo_text));
+  DebugOptions debug_options = module->config().debug_options();
+  debug_options.set_xla_cpu_codegen_parallelism(GetParam());
+  module->config().set_debug_options(debug_options);
+
+  Literal result = ExecuteAndTransfer(std::move(module), {});
+  LiteralTestUtil::ExpectR1Equal<float>({-8064, -6048, -4032, -2016}, result);
+}
+
+// More shards than functions leaves the callers of the nested computations in
+// modules of their own, together with their internal callees.
+INSTANTIATE_TEST_SUITE_P(CpuParallelCodegenTestInstantiation,
+                         CpuParallelCodegenTest, ::testing::Values(2, 64));
+
+// Benchmark that measures the JIT compile time of a computation with many
+// reductions, each with a reducer of its own, for the codegen parallelism given
+// as the argument.
+void BM_ParallelCodegenCompile(::testing::benchmark::State& state) {
+  constexpr int kNumReductions = 64;
+  se::Platform* platform = PlatformUtil::GetDefaultPlatform().value();
+  LocalClient* client = ClientLibrary::GetOrCreateLocalClient(platform).value();
+
+  const Shape shape = ShapeUtil::MakeShape(F32, {128, 256});
+  XlaBuilder builder("reductions");
+  XlaOp x = Parameter(&builder, 0, shape, "x");
+  std::vector<XlaOp> reductions;
+  for (int i = 0; i < kNumReductions; ++i) {
+    XlaOp scaled = Mul(x, ConstantR0<float>(&builder, i));
+    reductions.push_back(
+        Reduce(scaled, ConstantR0<float>(&builder, 0),
+               i % 2 == 0 ? CreateScalarAddComputation(F32, &builder)
+                          : CreateScalarMaxComputation(F32, &builder),
+               /*dimensions_to_reduce=*/{1}));
+  }
+  Tuple(&builder, reductions);
+  XlaComputation computation = builder.Build().value();
+
+  ExecutableBuildOptions options;
+  options.mutable_debug_options()->set_xla_cpu_codegen_parallelism(
+      state.range(0));
+  for (auto s : state) {
+    client->Compile(computation, {&shape}, options).value();
+  }
+}
+
+BENCHMARK(BM_ParallelCodegenCompile)->Arg(1)->Arg(4)->Arg(16)->UseRealTime();
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
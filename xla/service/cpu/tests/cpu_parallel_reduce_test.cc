@@ -0,0 +1,84 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "xla/error_spec.h"
+#include "xla/service/cpu/tests/cpu_codegen_test.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// The reductions below are large enough to be split into parallel tasks over
+// the major dimensions of their output, which the vectorized reduce emitter
+// has to restrict its loops to. Reducing a dimension other than the minor one
+// keeps them on the vectorized path.
+class CpuParallelReduceTest : public CpuCodegenTest {
+ protected:
+  void RunAndCompareWithThreads(absl::string_view hlo_text) {
+    TF_ASSERT_OK_AND_ASSIGN(auto module,
+                            ParseAndReturnVerifiedModule(hlo_text));
+    module->config().set_intra_op_parallelism_threads(4);
+    EXPECT_TRUE(RunAndCompare(std::move(module), ErrorSpec{1e-3, 1e-3}));
+  }
+};
+
+TEST_F(CpuParallelReduceTest, PartitionedReduceToRank2) {
+  const std::string hlo_text = R"(
+HloModule module
+
+add {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  ROOT s = f32[] add(a, b)
+}
+
+ENTRY entry {
+  p = f32[32,512,64] parameter(0)
+  zero = f32[] constant(0)
+  ROOT r = f32[32,64] reduce(p, zero), dimensions={1}, to_apply=add
+}
+)";
+  RunAndCompareWithThreads(hlo_text);
+}
+
+TEST_F(CpuParallelReduceTest, PartitionedReduceToRank3) {
+  const std::string hlo_text = R"(
+HloModule module
+
+add {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  ROOT s = f32[] add(a, b)
+}
+
+ENTRY entry {
+  p = f32[6,10,256,64] parameter(0)
+  zero = f32[] constant(0)
+  ROOT r = f32[6,10,64] reduce(p, zero), dimensions={2}, to_apply=add
+}
+)";
+  RunAndCompareWithThreads(hlo_text);
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -15,6 +15,17 @@ limitations under the License.
 
 #include "xla/service/cpu/xfeed_manager.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "xla/shape_util.h"
 #include "tsl/platform/logging.h"
 
@@ -27,43 +38,133 @@ void XfeedManager::Reset() {
   outfeed()->Reset();
 }
 
+namespace {
+
+// How many times a consumer polls an empty queue before it parks. A poll is
+// a load of a cache line written by the producer, so this spins for a few
+// microseconds.
+constexpr int kSpinIterations = 4096;
+
+size_t RoundUpToPowerOfTwo(int capacity) {
+  size_t rounded = 1;
+  while (rounded < static_cast<size_t>(std::max(capacity, 1))) {
+    rounded <<= 1;
+  }
+  return rounded;
+}
+
+}  // namespace
+
+XfeedQueueManager::XfeedQueueManager(std::string queue_name, int capacity)
+    : queue_name_(std::move(queue_name)),
+      capacity_(RoundUpToPowerOfTwo(capacity)),
+      slots_(std::make_unique<XfeedBuffer*[]>(capacity_)) {}
+
 void XfeedQueueManager::Reset() {
-  absl::MutexLock l(&mu_);
+  absl::MutexLock l(&producer_mu_);
   CHECK(current_buffer_ == nullptr);
-  for (auto buffer : enqueued_buffers_) {
+  const uint64_t tail = tail_.load(std::memory_order_relaxed);
+  for (uint64_t i = head_.load(std::memory_order_relaxed); i != tail; ++i) {
+    slots_[i & (capacity_ - 1)]->Done(ShapeUtil::MakeNil());
+  }
+  head_.store(tail);
+  for (auto buffer : overflow_) {
     buffer->Done(ShapeUtil::MakeNil());
   }
-  enqueued_buffers_.clear();
+  overflow_.clear();
+  overflow_size_.store(0);
+}
+
+void XfeedQueueManager::RefillFromOverflow() {
+  const uint64_t tail = tail_.load(std::memory_order_relaxed);
+  const uint64_t head = head_.load(std::memory_order_acquire);
+  const size_t count = std::min<size_t>(capacity_ - (tail - head),
+                                        overflow_.size());
+  for (size_t i = 0; i < count; ++i) {
+    slots_[(tail + i) & (capacity_ - 1)] = overflow_.front();
+    overflow_.pop_front();
+  }
+  overflow_size_.store(overflow_.size());
+  tail_.store(tail + count);
 }
 
 void XfeedQueueManager::EnqueueBuffersAtomically(
     absl::Span<XfeedBuffer* const> buffers) {
-  absl::MutexLock l(&mu_);
-  bool was_empty = enqueued_buffers_.empty();
-  for (XfeedBuffer* b : buffers) {
-    VLOG(3) << "Enqueueing " << queue_name_ << " buffer (of " << buffers.size()
-            << " buffers) with length: " << b->length();
-    enqueued_buffers_.push_back(b);
+  if (buffers.empty()) {
+    return;
   }
-  if (was_empty && !buffers.empty()) {
-    // This has the potential to suffer from the notified thread
-    // immediately trying and failing to acquire mu_, but seems
-    // preferable to the alternative of notifying outside the lock
-    // on every enqueue.
-    cv_.Signal();
+  {
+    absl::MutexLock l(&producer_mu_);
+    for (XfeedBuffer* b : buffers) {
+      VLOG(3) << "Enqueueing " << queue_name_ << " buffer (of "
+              << buffers.size() << " buffers) with length: " << b->length();
+    }
+    size_t num_in_ring = 0;
+    // Buffers go to the ring only behind those already in the overflow list.
+    if (overflow_.empty()) {
+      const uint64_t tail = tail_.load(std::memory_order_relaxed);
+      const uint64_t head = head_.load(std::memory_order_acquire);
+      num_in_ring = std::min(capacity_ - (tail - head), buffers.size());
+      for (size_t i = 0; i < num_in_ring; ++i) {
+        slots_[(tail + i) & (capacity_ - 1)] = buffers[i];
+      }
+      tail_.store(tail + num_in_ring);
+    }
+    if (num_in_ring < buffers.size()) {
+      overflow_.insert(overflow_.end(), buffers.begin() + num_in_ring,
+                       buffers.end());
+      RefillFromOverflow();
+    }
   }
+  WakeUpConsumer();
 }
 
-XfeedBuffer* XfeedQueueManager::BlockingDequeueBuffer() {
-  absl::MutexLock l(&mu_);
+void XfeedQueueManager::WakeUpConsumer() {
+  // Pairs with the store to `consumer_waiting_` and the subsequent loads in
+  // WaitForBuffers: either the consumer sees the new buffers, or we see that
+  // it is waiting and it is either still checking for buffers under
+  // `park_mu_` or waiting on `park_cv_`.
+  if (consumer_waiting_.load()) {
+    absl::MutexLock l(&park_mu_);
+    park_cv_.Signal();
+  }
+}
+
+void XfeedQueueManager::WaitForBuffers(uint64_t head) {
+  auto has_buffers = [&] {
+    return tail_.load() != head || overflow_size_.load() != 0;
+  };
+  // Spinning only delays the producer if it has to share our CPU.
+  static const int spin_iterations =
+      std::thread::hardware_concurrency() > 1 ? kSpinIterations : 0;
+  for (int i = 0; i < spin_iterations; ++i) {
+    if (has_buffers()) {
+      return;
+    }
+  }
   VLOG(3) << "Waiting for an available buffer.";
-  while (enqueued_buffers_.empty()) {
-    cv_.Wait(&mu_);
+  absl::MutexLock l(&park_mu_);
+  consumer_waiting_.store(true);
+  while (!has_buffers()) {
+    park_cv_.Wait(&park_mu_);
   }
-  VLOG(3) << "A buffer is available!";
+  consumer_waiting_.store(false);
+}
+
+XfeedBuffer* XfeedQueueManager::BlockingDequeueBuffer() {
   CHECK(current_buffer_ == nullptr);
-  current_buffer_ = enqueued_buffers_.front();
-  enqueued_buffers_.pop_front();
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  while (tail_.load(std::memory_order_acquire) == head) {
+    if (overflow_size_.load(std::memory_order_acquire) != 0) {
+      absl::MutexLock l(&producer_mu_);
+      RefillFromOverflow();
+    } else {
+      WaitForBuffers(head);
+    }
+  }
+  VLOG(3) << "A buffer is available!";
+  current_buffer_ = slots_[head & (capacity_ - 1)];
+  head_.store(head + 1, std::memory_order_release);
   return current_buffer_;
 }
 
@@ -72,12 +173,12 @@ void XfeedQueueManager::ReleaseCurrentBuffer(int32_t length, void* data,
   VLOG(3) << "Releasing buffer with shape: "
           << (shape.ok() ? ShapeUtil::HumanString(shape.value())
                          : "<error status>");
-  absl::MutexLock l(&mu_);
   CHECK(current_buffer_ != nullptr);
   CHECK_EQ(length, current_buffer_->length());
   CHECK_EQ(data, current_buffer_->data());
-  current_buffer_->Done(std::move(shape));
+  XfeedBuffer* buffer = current_buffer_;
   current_buffer_ = nullptr;
+  buffer->Done(std::move(shape));
 }
 
 int64_t GetByteSizeRequirement(const Shape& shape, int64_t pointer_size) {
@@ -20,8 +20,15 @@ limitations under the License.
 #ifndef XLA_SERVICE_CPU_XFEED_MANAGER_H_
 #define XLA_SERVICE_CPU_XFEED_MANAGER_H_
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <deque>
+#include <memory>
+#include <string>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xla/shape.h"
 #include "xla/statusor.h"
@@ -48,9 +55,22 @@ class XfeedBuffer {
 };
 
 // Reusable component for managing the infeed and outfeed queue state.
+//
+// The queue is a bounded ring buffer of `capacity` slots. The runtime, which
+// is the only consumer, dequeues without taking any lock, and a consumer that
+// finds the ring empty spins for a while before it parks, so that the small
+// per-step messages of a streaming computation are handed over without futex
+// round trips. Producers take a lock among themselves only, so that the
+// buffers of one call to EnqueueBuffersAtomically are never interleaved with
+// those of another. Producers never block: buffers that do not fit into the
+// ring wait in an overflow list, from which the ring is refilled.
 class XfeedQueueManager {
  public:
-  XfeedQueueManager(std::string queue_name) : queue_name_(queue_name) {}
+  static constexpr int kDefaultCapacity = 1024;
+
+  // `capacity` is rounded up to a power of two.
+  explicit XfeedQueueManager(std::string queue_name,
+                             int capacity = kDefaultCapacity);
 
   // Calls the completion callback for any enqueued buffers that have
   // not been dequeued by the runtime, and empties the
@@ -84,21 +104,47 @@ class XfeedQueueManager {
   // sanity checking purposes.
   void ReleaseCurrentBuffer(int32_t length, void* data, StatusOr<Shape> shape);
 
+  size_t capacity() const { return capacity_; }
+
  private:
-  const std::string queue_name_;
+  // Moves buffers from the overflow list into the free slots of the ring.
+  void RefillFromOverflow() ABSL_EXCLUSIVE_LOCKS_REQUIRED(producer_mu_);
 
-  absl::Mutex mu_;
+  // Called by the consumer to wait until there is a buffer in the ring or the
+  // overflow list: spins first, then parks on `park_cv_`.
+  void WaitForBuffers(uint64_t head);
 
-  // Condition variable that is signaled every time a buffer is
-  // enqueued to an empty queue.
-  absl::CondVar cv_;
+  // Wakes up the consumer if it is parked or about to park.
+  void WakeUpConsumer();
+
+  const std::string queue_name_;
+  const size_t capacity_;
 
   // XfeedBuffer* queue contents are not owned, but buffer->Done must
-  // be called when the buffer is no longer needed by the runtime.
-  std::deque<XfeedBuffer*> enqueued_buffers_;
+  // be called when the buffer is no longer needed by the runtime. The slots
+  // in [head_, tail_) modulo the capacity hold the enqueued buffers.
+  const std::unique_ptr<XfeedBuffer*[]> slots_;
+
+  // Written by the consumer only.
+  alignas(64) std::atomic<uint64_t> head_{0};
+  // Written while holding `producer_mu_` only.
+  alignas(64) std::atomic<uint64_t> tail_{0};
+
+  // Serializes producers, and the consumer when it refills the ring.
+  alignas(64) absl::Mutex producer_mu_;
+  std::deque<XfeedBuffer*> overflow_ ABSL_GUARDED_BY(producer_mu_);
+  // The size of `overflow_`, readable without the lock.
+  std::atomic<size_t> overflow_size_{0};
+
+  // Parking lot of the consumer; `consumer_waiting_` says whether it is
+  // parked or about to park.
+  absl::Mutex park_mu_;
+  absl::CondVar park_cv_;
+  std::atomic<bool> consumer_waiting_{false};
 
   // If non-NULL, the buffer that is currently being processed by the
-  // runtime. Not owned.
+  // runtime. Not owned. Only accessed by the consumer, and by Reset while
+  // there is no consumer.
   XfeedBuffer* current_buffer_ = nullptr;
 };
 
@@ -113,8 +159,8 @@ class XfeedManager {
   XfeedQueueManager* outfeed() { return &outfeed_; }
 
  private:
-  XfeedQueueManager infeed_ = {"infeed"};
-  XfeedQueueManager outfeed_ = {"outfeed"};
+  XfeedQueueManager infeed_{"infeed"};
+  XfeedQueueManager outfeed_{"outfeed"};
 };
 
 int64_t GetByteSizeRequirement(const Shape& shape, int64_t pointer_size);
@@ -16,6 +16,7 @@ limitations under the License.
 #include "xla/service/cpu/xfeed_manager.h"
 
 #include <memory>
+#include <vector>
 
 #include "xla/service/cpu/cpu_runtime.h"
 #include "xla/shape_util.h"
@@ -23,6 +24,7 @@ limitations under the License.
 #include "tsl/platform/env.h"
 #include "tsl/platform/logging.h"
 #include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
 #include "tsl/platform/threadpool.h"
 
 namespace xla {
@@ -152,5 +154,126 @@ TEST_F(InfeedManagerTest, OutfeedWrongShape) {
   ProcessNextOutfeedBuffer(32, ShapeUtil::MakeShape(U8, {33}));
 }
 
+// A buffer that records the order in which it was released.
+class SequencedBuffer : public cpu::runtime::XfeedBuffer {
+ public:
+  explicit SequencedBuffer(int id, std::vector<int>* done_ids = nullptr)
+      : id_(id), done_ids_(done_ids) {}
+
+  int id() const { return id_; }
+  int32_t length() override { return 0; }
+  void* data() override { return nullptr; }
+  void Done(StatusOr<Shape> shape) override {
+    if (done_ids_ != nullptr) {
+      done_ids_->push_back(id_);
+    }
+  }
+
+ private:
+  int id_;
+  std::vector<int>* done_ids_;
+};
+
+int DequeueId(cpu::runtime::XfeedQueueManager& queue) {
+  auto* buffer =
+      static_cast<SequencedBuffer*>(queue.BlockingDequeueBuffer());
+  queue.ReleaseCurrentBuffer(0, nullptr, ShapeUtil::MakeNil());
+  return buffer->id();
+}
+
+TEST_F(InfeedManagerTest, QueueWrapsAroundAndOverflows) {
+  cpu::runtime::XfeedQueueManager queue("test", /*capacity=*/3);
+  EXPECT_EQ(queue.capacity(), 4);
+  std::vector<std::unique_ptr<SequencedBuffer>> buffers;
+  std::vector<cpu::runtime::XfeedBuffer*> pointers;
+  for (int i = 0; i < 10; ++i) {
+    buffers.push_back(std::make_unique<SequencedBuffer>(i));
+    pointers.push_back(buffers.back().get());
+  }
+  absl::Span<cpu::runtime::XfeedBuffer* const> span(pointers);
+  // Three buffers fit, the fourth sequence only partly.
+  queue.EnqueueBuffersAtomically(span.subspan(0, 3));
+  EXPECT_EQ(DequeueId(queue), 0);
+  queue.EnqueueBuffersAtomically(span.subspan(3, 5));
+  queue.EnqueueBuffersAtomically(span.subspan(8, 2));
+  for (int i = 1; i < 10; ++i) {
+    EXPECT_EQ(DequeueId(queue), i);
+  }
+}
+
+TEST_F(InfeedManagerTest, ResetReleasesQueuedAndOverflowBuffers) {
+  cpu::runtime::XfeedQueueManager queue("test", /*capacity=*/2);
+  std::vector<int> done_ids;
+  std::vector<std::unique_ptr<SequencedBuffer>> buffers;
+  std::vector<cpu::runtime::XfeedBuffer*> pointers;
+  for (int i = 0; i < 5; ++i) {
+    buffers.push_back(std::make_unique<SequencedBuffer>(i, &done_ids));
+    pointers.push_back(buffers.back().get());
+  }
+  queue.EnqueueBuffersAtomically(pointers);
+  queue.Reset();
+  EXPECT_EQ(done_ids, std::vector<int>({0, 1, 2, 3, 4}));
+
+  SequencedBuffer next(5);
+  queue.EnqueueBuffersAtomically({&next});
+  EXPECT_EQ(DequeueId(queue), 5);
+}
+
+TEST_F(InfeedManagerTest, ConcurrentProducersEnqueueAtomically) {
+  constexpr int kNumProducers = 4;
+  constexpr int kNumBatches = 1000;
+  constexpr int kBatchSize = 3;
+  cpu::runtime::XfeedQueueManager queue("test", /*capacity=*/16);
+  std::vector<std::unique_ptr<SequencedBuffer>> buffers;
+  for (int i = 0; i < kNumProducers * kNumBatches * kBatchSize; ++i) {
+    buffers.push_back(std::make_unique<SequencedBuffer>(i));
+  }
+  {
+    tsl::thread::ThreadPool pool(tsl::Env::Default(), "test", kNumProducers);
+    for (int p = 0; p < kNumProducers; ++p) {
+      pool.Schedule([&, p] {
+        for (int b = 0; b < kNumBatches; ++b) {
+          int first = (p * kNumBatches + b) * kBatchSize;
+          queue.EnqueueBuffersAtomically({buffers[first].get(),
+                                          buffers[first + 1].get(),
+                                          buffers[first + 2].get()});
+        }
+      });
+    }
+    std::vector<int> next_batch(kNumProducers, 0);
+    for (int i = 0; i < kNumProducers * kNumBatches; ++i) {
+      int first = DequeueId(queue);
+      ASSERT_EQ(first % kBatchSize, 0);
+      // Batches are contiguous and each producer's are in order.
+      int p = first / (kNumBatches * kBatchSize);
+      EXPECT_EQ(first, (p * kNumBatches + next_batch[p]++) * kBatchSize);
+      EXPECT_EQ(DequeueId(queue), first + 1);
+      EXPECT_EQ(DequeueId(queue), first + 2);
+    }
+  }
+}
+
+// Measures the latency of handing a buffer to another thread and back, as a
+// streaming computation does with an infeed followed by an outfeed.
+void BM_QueueRoundTrip(::testing::benchmark::State& state) {
+  cpu::runtime::XfeedQueueManager to_runtime("infeed");
+  cpu::runtime::XfeedQueueManager from_runtime("outfeed");
+  SequencedBuffer request(0);
+  SequencedBuffer response(1);
+  SequencedBuffer stop(-1);
+  tsl::thread::ThreadPool pool(tsl::Env::Default(), "runtime", 1);
+  pool.Schedule([&] {
+    while (DequeueId(to_runtime) >= 0) {
+      from_runtime.EnqueueBuffersAtomically({&response});
+    }
+  });
+  for (auto s : state) {
+    to_runtime.EnqueueBuffersAtomically({&request});
+    tsl::testing::DoNotOptimize(DequeueId(from_runtime));
+  }
+  to_runtime.EnqueueBuffersAtomically({&stop});
+}
+BENCHMARK(BM_QueueRoundTrip);
+
 }  // namespace
 }  // namespace xla
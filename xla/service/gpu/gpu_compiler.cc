@@ -375,7 +375,10 @@ Status GpuCompiler::OptimizeHloModule(HloModule* hlo_module,
   // The SPMD partitioner would mess up the sort+slice structure, so we need to
   // rewrite Topk before that happens.
   pre_spmd_pipeline.AddPass<TopkRewriter>(
-      [](const HloSortInstruction*, int64_t) { return true; });
+      [](const HloSortInstruction* sort, int64_t) {
+        PrimitiveType element_type = sort->operand(0)->shape().element_type();
+        return element_type == F32 || element_type == BF16;
+      });
 
   TF_RETURN_IF_ERROR(pre_spmd_pipeline.Run(hlo_module).status());
 
@@ -305,6 +305,7 @@ bool GpuMultiOutputFusion::FuseSiblings(HloInstruction* parent,
       } else {
         remaining->FuseInstructionIntoMultiOutput(fused);
         CHECK_EQ(0, fused->user_count());
+        reachability_->RemoveInstruction(fused);
         TF_CHECK_OK(computation_->RemoveInstruction(fused));
       }
       DumpFusionState(*remaining,
@@ -313,7 +314,7 @@ bool GpuMultiOutputFusion::FuseSiblings(HloInstruction* parent,
       TF_CHECK_OK(cost_analysis->RevisitInstruction(remaining));
       changed = true;
       siblings.erase(j);
-      RecomputeReachability();
+      reachability_->UpdateReachabilityThroughInstruction(remaining);
     }
   }
   return changed;
@@ -385,6 +386,7 @@ StatusOr<bool> GpuMultiOutputFusion::DoMultiOutputFusion() {
       } else {
         consumer_for_fusion->FuseInstructionIntoMultiOutput(producer);
         CHECK_EQ(0, producer->user_count());
+        reachability_->RemoveInstruction(producer);
         TF_CHECK_OK(computation_->RemoveInstruction(producer));
       }
       TF_RETURN_IF_ERROR(cost_analysis.RevisitInstruction(consumer_for_fusion));
@@ -394,7 +396,7 @@ StatusOr<bool> GpuMultiOutputFusion::DoMultiOutputFusion() {
           absl::StrCat("Fusing producer |", producer_name, "| into consumer |",
                        consumer_for_fusion->name(),
                        "| inside GPU multi-output fusion"));
-      RecomputeReachability();
+      reachability_->UpdateReachabilityThroughInstruction(consumer_for_fusion);
       continue;
     }
     HloInstruction* input_fusion =
@@ -409,6 +411,9 @@ StatusOr<bool> GpuMultiOutputFusion::DoMultiOutputFusion() {
         absl::StrCat("About to fuse |", producer_name, "| into consumer |",
                      input_fusion->name(), "| inside GPU multi-output fusion"),
         /*producer=*/input_fusion);
+    // The new fusion takes over the index of the consumer, so that the users
+    // of the consumer see no change in reachability.
+    reachability_->Replace(consumer_for_fusion, input_fusion);
     TF_CHECK_OK(
         computation_->ReplaceInstruction(consumer_for_fusion, input_fusion));
     if (producer->opcode() == HloOpcode::kFusion) {
@@ -416,6 +421,7 @@ StatusOr<bool> GpuMultiOutputFusion::DoMultiOutputFusion() {
     } else {
       input_fusion->FuseInstructionIntoMultiOutput(producer);
       CHECK_EQ(0, producer->user_count());
+      reachability_->RemoveInstruction(producer);
       TF_CHECK_OK(computation_->RemoveInstruction(producer));
     }
     TF_RETURN_IF_ERROR(cost_analysis.RevisitInstruction(input_fusion));
@@ -424,7 +430,7 @@ StatusOr<bool> GpuMultiOutputFusion::DoMultiOutputFusion() {
         *input_fusion,
         absl::StrCat("Fusing producer |", producer_name, "| into consumer |",
                      input_fusion->name(), "| inside GPU multi-output fusion"));
-    RecomputeReachability();
+    reachability_->UpdateReachabilityThroughInstruction(input_fusion);
   }
   return changed;
 }
@@ -16,6 +16,7 @@ limitations under the License.
 #include "xla/service/heap_simulator.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -42,6 +43,7 @@ limitations under the License.
 #include "xla/service/memory_space_assignment_repacking.h"
 #include "xla/status.h"
 #include "xla/util.h"
+#include "tsl/platform/env.h"
 
 namespace xla {
 
@@ -643,49 +645,160 @@ void GlobalDecreasingSizeBestFitHeap<BufferType>::Free(const BufferType* buffer,
 
 using Chunk = HeapSimulator::Chunk;
 
+namespace {
+
+// A subtree is rebuilt when one of the children of its root holds more than
+// kScapegoatBalance of its nodes.
+constexpr double kScapegoatBalance = 0.7;
+
+int64_t SubtreeSize(const BufferIntervalTreeNode* node) {
+  int64_t size = 0;
+  std::vector<const BufferIntervalTreeNode*> visiting_stack;
+  if (node != nullptr) {
+    visiting_stack.push_back(node);
+  }
+  while (!visiting_stack.empty()) {
+    const BufferIntervalTreeNode* top = visiting_stack.back();
+    visiting_stack.pop_back();
+    ++size;
+    if (top->left != nullptr) {
+      visiting_stack.push_back(top->left);
+    }
+    if (top->right != nullptr) {
+      visiting_stack.push_back(top->right);
+    }
+  }
+  return size;
+}
+
+// Links `nodes`, sorted by start time, into a perfectly balanced subtree under
+// `parent` and returns its root.
+BufferIntervalTreeNode* BuildBalancedSubtree(
+    absl::Span<BufferIntervalTreeNode* const> nodes,
+    BufferIntervalTreeNode* parent) {
+  if (nodes.empty()) {
+    return nullptr;
+  }
+  const size_t mid = (nodes.size() - 1) / 2;
+  BufferIntervalTreeNode* node = nodes[mid];
+  node->parent = parent;
+  node->left = BuildBalancedSubtree(nodes.subspan(0, mid), node);
+  node->right = BuildBalancedSubtree(nodes.subspan(mid + 1), node);
+  node->subtree_end = node->end;
+  if (node->left != nullptr) {
+    node->subtree_end = std::max(node->subtree_end, node->left->subtree_end);
+  }
+  if (node->right != nullptr) {
+    node->subtree_end = std::max(node->subtree_end, node->right->subtree_end);
+  }
+  return node;
+}
+
+}  // namespace
+
 void BufferIntervalTree::Add(int64_t start, int64_t end, const Chunk& chunk) {
   node_storage_.emplace_back(BufferIntervalTreeNode{
       start, end, end, chunk,
       /*left=*/nullptr, /*right=*/nullptr, /*parent=*/nullptr});
+  BufferIntervalTreeNode* node = &node_storage_.back();
+  ++num_nodes_;
   if (root_ == nullptr) {
-    root_ = &node_storage_.back();
+    root_ = node;
     // This is root.
     return;
   }
 
   BufferIntervalTreeNode* parent = root_;
+  int64_t depth = 0;
   while (true) {
     parent->subtree_end = std::max(parent->subtree_end, end);
-    if (parent->start > start) {
-      if (parent->left == nullptr) {
-        parent->left = &node_storage_.back();
-        node_storage_.back().parent = parent;
-        return;
-      }
-      parent = parent->left;
-    } else {
-      if (parent->right == nullptr) {
-        parent->right = &node_storage_.back();
-        node_storage_.back().parent = parent;
-        return;
-      }
-      parent = parent->right;
+    ++depth;
+    BufferIntervalTreeNode*& child =
+        parent->start > start ? parent->left : parent->right;
+    if (child == nullptr) {
+      child = node;
+      node->parent = parent;
+      break;
     }
+    parent = child;
+  }
+  if (depth > std::log(static_cast<double>(num_nodes_)) /
+                  std::log(1 / kScapegoatBalance)) {
+    Rebalance(node);
+  }
+}
+
+void BufferIntervalTree::Rebalance(BufferIntervalTreeNode* node) {
+  // Walk up to the lowest ancestor that is out of balance. Such an ancestor
+  // exists whenever `node` is deeper than log(num_nodes_) / log(1 / balance).
+  BufferIntervalTreeNode* scapegoat = nullptr;
+  int64_t size = 1;
+  for (BufferIntervalTreeNode* child = node; child->parent != nullptr;
+       child = child->parent) {
+    BufferIntervalTreeNode* ancestor = child->parent;
+    const BufferIntervalTreeNode* sibling =
+        ancestor->left == child ? ancestor->right : ancestor->left;
+    const int64_t ancestor_size = size + 1 + SubtreeSize(sibling);
+    if (size > kScapegoatBalance * ancestor_size) {
+      scapegoat = ancestor;
+      break;
+    }
+    size = ancestor_size;
+  }
+  if (scapegoat == nullptr) {
+    return;
+  }
+
+  // Collect the nodes of the scapegoat's subtree in order and relink them.
+  // The subtree keeps its set of intervals, so the subtree_end of the
+  // scapegoat's ancestors is unchanged.
+  std::vector<BufferIntervalTreeNode*> nodes;
+  std::vector<BufferIntervalTreeNode*> visiting_stack;
+  for (BufferIntervalTreeNode* current = scapegoat;
+       current != nullptr || !visiting_stack.empty();) {
+    if (current != nullptr) {
+      visiting_stack.push_back(current);
+      current = current->left;
+      continue;
+    }
+    current = visiting_stack.back();
+    visiting_stack.pop_back();
+    nodes.push_back(current);
+    current = current->right;
+  }
+  BufferIntervalTreeNode* parent = scapegoat->parent;
+  BufferIntervalTreeNode* subtree_root = BuildBalancedSubtree(nodes, parent);
+  if (parent == nullptr) {
+    root_ = subtree_root;
+  } else if (parent->left == scapegoat) {
+    parent->left = subtree_root;
+  } else {
+    parent->right = subtree_root;
   }
 }
 
 bool BufferIntervalTree::Remove(int64_t start, int64_t end,
                                 const Chunk& chunk) {
-  BufferIntervalTreeNode* to_delete = root_;
-  while (to_delete != nullptr) {
-    if (to_delete->start == start && to_delete->end == end &&
-        to_delete->chunk.offset == chunk.offset) {
+  // Rebalancing may move nodes with the same start time as a node into its
+  // left subtree, so both subtrees are searched on ties.
+  BufferIntervalTreeNode* to_delete = nullptr;
+  std::vector<BufferIntervalTreeNode*> visiting_stack;
+  if (root_ != nullptr) {
+    visiting_stack.push_back(root_);
+  }
+  while (!visiting_stack.empty()) {
+    BufferIntervalTreeNode* top = visiting_stack.back();
+    visiting_stack.pop_back();
+    if (top->start == start && top->end == end &&
+        top->chunk.offset == chunk.offset) {
+      to_delete = top;
       break;
     }
-    if (start < to_delete->start) {
-      to_delete = to_delete->left;
-    } else {
-      to_delete = to_delete->right;
+    if (start <= top->start && top->left != nullptr) {
+      visiting_stack.push_back(top->left);
+    }
+    if (start >= top->start && top->right != nullptr) {
+      visiting_stack.push_back(top->right);
     }
   }
   if (to_delete == nullptr) {
@@ -693,6 +806,7 @@ bool BufferIntervalTree::Remove(int64_t start, int64_t end,
     return false;
   }
   // Found the node to be deleted, enter deletion sequence.
+  --num_nodes_;
 
   // Recursively traverse the parents of node and fix up the `subtree_end`
   // invariant of a node. Recursive lambda need an explicit
@@ -733,6 +847,9 @@ bool BufferIntervalTree::Remove(int64_t start, int64_t end,
     if (root_ == to_delete) {
       // Deleting root is simply reseting root;
       root_ = to_delete->left;
+      if (root_ != nullptr) {
+        root_->parent = nullptr;
+      }
       return true;
     }
 
@@ -1537,6 +1654,31 @@ GlobalDecreasingSizeBestFitHeap<BufferType>::MakeFreeChunks(
   return free_chunks;
 }
 
+template <typename BufferType>
+bool GlobalDecreasingSizeBestFitHeap<BufferType>::IsRangeFree(
+    const BufferInterval& buffer_interval, int64_t offset,
+    int64_t size) const {
+  auto overlaps = [&](const std::vector<Chunk>& used_chunks) {
+    return absl::c_any_of(used_chunks, [&](const Chunk& used_chunk) {
+      return used_chunk.offset < offset + size &&
+             used_chunk.chunk_end() > offset;
+    });
+  };
+  if (overlaps(interval_tree_.ChunksOverlappingInTime(buffer_interval.start,
+                                                      buffer_interval.end))) {
+    return false;
+  }
+  for (const BufferType* colocation :
+       GetTransitiveColocations(buffer_interval)) {
+    const BufferInterval& interval = buffer_intervals_.at(colocation);
+    if (overlaps(interval_tree_.ChunksOverlappingInTime(interval.start,
+                                                        interval.end))) {
+      return false;
+    }
+  }
+  return true;
+}
+
 template <typename BufferType>
 std::vector<typename GlobalDecreasingSizeBestFitHeap<BufferType>::Chunk>
 GlobalDecreasingSizeBestFitHeap<BufferType>::FindChunkCandidates(
@@ -1561,6 +1703,14 @@ GlobalDecreasingSizeBestFitHeap<BufferType>::FindChunkCandidates(
         std::max(max_colocation_size, buffer_intervals_.at(colocation).size);
   }
 
+  // An aligned preferred offset whose range is free is the chunk that would be
+  // found in the free chunks, so skip building them.
+  if (preferred_offset >= 0 && preferred_offset % alignment_ == 0 &&
+      max_colocation_size > 0 &&
+      IsRangeFree(buffer_interval, preferred_offset, max_colocation_size)) {
+    return {Chunk::FromOffsetSize(preferred_offset, max_colocation_size)};
+  }
+
   // Get all colocated buffers and gather all interferenced chunks.
   FreeChunks free_chunks = MakeFreeChunks(buffer_interval, max_colocation_size);
 
@@ -1678,10 +1828,29 @@ HeapSimulator::Result<BufferType>
 ChooseBestHeapAlgorithm<BufferType>::Finish() {
   DCHECK(!algorithms_.empty());
   std::vector<Result> results(algorithms_.size());
+  auto finish = [&](int i) { results[i] = algorithms_[i]->Finish(); };
+  {
+    // The algorithms don't share any state, so each one but the first runs on
+    // its own thread and the first one runs on this thread.
+    const bool parallel = num_buffers_ >= kMinBuffersForParallelFinish;
+    std::vector<std::unique_ptr<tsl::Thread>> threads;
+    for (int i = 1; i < algorithms_.size(); ++i) {
+      if (parallel) {
+        threads.emplace_back(
+            tsl::Env::Default()->StartThread(tsl::ThreadOptions(),
+                                             "heap_simulator",
+                                             [&finish, i] { finish(i); }));
+      } else {
+        finish(i);
+      }
+    }
+    finish(0);
+    // Destroying `threads` joins them.
+  }
+
   int64_t min_size = INT64_MAX;
   int min_size_index = -1;
   for (int i = 0; i < algorithms_.size(); ++i) {
-    results[i] = algorithms_[i]->Finish();
     if (results[i].heap_size < min_size) {
       min_size = results[i].heap_size;
       min_size_index = i;
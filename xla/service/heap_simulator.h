@@ -356,6 +356,13 @@ struct BufferIntervalTreeNode {
 };
 
 // An interval tree that can query buffers overlapping in time.
+//
+// The tree is kept balanced as a scapegoat tree: when an insertion makes a
+// node deeper than log(size) / log(1 / 0.7), the subtree of the lowest
+// ancestor whose larger child holds more than 70% of its nodes is rebuilt
+// into a perfectly balanced one. Buffers are added in roughly increasing
+// order of their start times, which would otherwise degrade the tree into a
+// list and make every query linear in the number of buffers.
 class BufferIntervalTree {
  public:
   using Chunk = HeapSimulator::Chunk;
@@ -373,8 +380,14 @@ class BufferIntervalTree {
   BufferIntervalTreeNode* GetRoot() { return root_; }
 
  private:
+  // Rebuilds the subtree of the scapegoat ancestor of `node`, which was just
+  // inserted too deep for the tree to be balanced.
+  void Rebalance(BufferIntervalTreeNode* node);
+
   BufferIntervalTreeNode* root_ = nullptr;
   std::list<BufferIntervalTreeNode> node_storage_;
+  // Number of nodes reachable from root_.
+  int64_t num_nodes_ = 0;
 };
 
 // GlobalDecreasingSizeBestFitHeap collects the live intervals of all buffers,
@@ -698,6 +711,11 @@ class GlobalDecreasingSizeBestFitHeap : public HeapAlgorithm<BufferType> {
   FreeChunks MakeFreeChunks(const BufferInterval& buffer_interval,
                             int64_t max_colocation_size) const;
 
+  // Returns true if no chunk allocated during the lifetime of buffer_interval
+  // or of the buffers colocated with it overlaps [offset, offset + size).
+  bool IsRangeFree(const BufferInterval& buffer_interval, int64_t offset,
+                   int64_t size) const;
+
   // These two methods below are exposed to other heap algorithms that inherit
   // from this class. The Finish() method tries to find a candidate chunk for
   // each BufferInterval, after calling GetSortedBufferIntervals. If a
@@ -782,12 +800,19 @@ class ConstrainedGlobalDecreasingSizeBestFitHeap
 };
 
 // A heap algorithm that chooses the best results from other algorithms added to
-// it.
+// it. The algorithms are finished concurrently for heaps with many buffers; of
+// the results with the smallest heap size, the one of the algorithm added
+// first is chosen.
 template <typename BufferType>
 class ChooseBestHeapAlgorithm : public HeapAlgorithm<BufferType> {
  public:
   using Result = HeapSimulator::Result<BufferType>;
 
+  // Minimum number of buffers for which Finish() runs the algorithms on
+  // separate threads. Smaller heaps are finished faster than the threads
+  // start.
+  static constexpr int64_t kMinBuffersForParallelFinish = 1024;
+
   ChooseBestHeapAlgorithm(
       std::unique_ptr<std::vector<std::unique_ptr<HeapAlgorithm<BufferType>>>>
           algorithms)
@@ -795,6 +820,7 @@ class ChooseBestHeapAlgorithm : public HeapAlgorithm<BufferType> {
   ~ChooseBestHeapAlgorithm() override {}
 
   void Alloc(const BufferType* buffer, int64_t size) override {
+    ++num_buffers_;
     for (auto& algorithm : algorithms_) {
       algorithm->Alloc(buffer, size);
     }
@@ -817,6 +843,7 @@ class ChooseBestHeapAlgorithm : public HeapAlgorithm<BufferType> {
 
  private:
   std::vector<std::unique_ptr<HeapAlgorithm<BufferType>>> algorithms_;
+  int64_t num_buffers_ = 0;
 };
 
 extern template class GlobalDecreasingSizeBestFitHeap<HloValue>;
@@ -15,12 +15,17 @@ limitations under the License.
 
 #include "xla/service/heap_simulator.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <functional>
 #include <limits>
 #include <memory>
+#include <random>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_join.h"
 #include "xla/hlo/ir/hlo_computation.h"
@@ -30,11 +35,13 @@ limitations under the License.
 #include "xla/service/buffer_value.h"
 #include "xla/service/hlo_ordering.h"
 #include "xla/service/hlo_value.h"
+#include "xla/service/memory_space_assignment_repacking.h"
 #include "xla/service/tuple_points_to_analysis.h"
 #include "xla/status_macros.h"
 #include "xla/tests/hlo_test_base.h"
 #include "tsl/lib/core/status_test_util.h"
 #include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
 
 namespace xla {
 namespace {
@@ -1707,6 +1714,71 @@ TEST_F(IntervalTreeTest, ThreeLevelsRightLeftChunkDifferent) {
   ASSERT_EQ(tree.GetRoot(), nullptr);
 }
 
+int64_t Height(const BufferIntervalTreeNode* node) {
+  return node == nullptr
+             ? 0
+             : 1 + std::max(Height(node->left), Height(node->right));
+}
+
+TEST_F(IntervalTreeTest, StaysBalancedAndQueriesMatch) {
+  constexpr int kNumIntervals = 1024;
+  BufferIntervalTree tree;
+  // Intervals [i, i + i % 7], added in increasing order of start time as
+  // the heap simulator does.
+  for (int i = 0; i < kNumIntervals; ++i) {
+    tree.Add(i, i + i % 7, HeapSimulator::Chunk::FromOffsetSize(i, 1));
+  }
+  EXPECT_LE(Height(tree.GetRoot()),
+            1 + std::log(kNumIntervals) / std::log(1 / 0.7));
+
+  auto expected_overlapping = [](int64_t start, int64_t end, bool odd_only) {
+    std::vector<int64_t> offsets;
+    for (int i = odd_only ? 1 : 0; i < kNumIntervals; i += odd_only ? 2 : 1) {
+      if (i <= end && i + i % 7 >= start) {
+        offsets.push_back(i);
+      }
+    }
+    return offsets;
+  };
+  auto overlapping = [&](int64_t start, int64_t end) {
+    std::vector<int64_t> offsets;
+    for (const HeapSimulator::Chunk& chunk :
+         tree.ChunksOverlappingInTime(start, end)) {
+      offsets.push_back(chunk.offset);
+    }
+    absl::c_sort(offsets);
+    return offsets;
+  };
+  for (int64_t start : {0, 100, 513, 1020}) {
+    EXPECT_EQ(overlapping(start, start + 3),
+              expected_overlapping(start, start + 3, /*odd_only=*/false));
+  }
+
+  for (int i = 0; i < kNumIntervals; i += 2) {
+    EXPECT_TRUE(
+        tree.Remove(i, i + i % 7, HeapSimulator::Chunk::FromOffsetSize(i, 1)));
+  }
+  for (int64_t start : {0, 100, 513, 1020}) {
+    EXPECT_EQ(overlapping(start, start + 3),
+              expected_overlapping(start, start + 3, /*odd_only=*/true));
+  }
+}
+
+TEST_F(IntervalTreeTest, RemoveWithSameStartTimes) {
+  // Rebalancing moves intervals with the same start time to both sides of
+  // their subtree roots.
+  constexpr int kNumIntervals = 64;
+  BufferIntervalTree tree;
+  for (int i = 0; i < kNumIntervals; ++i) {
+    tree.Add(i / 8, 100, HeapSimulator::Chunk::FromOffsetSize(i, 1));
+  }
+  for (int i = kNumIntervals - 1; i >= 0; --i) {
+    EXPECT_TRUE(
+        tree.Remove(i / 8, 100, HeapSimulator::Chunk::FromOffsetSize(i, 1)));
+  }
+  EXPECT_EQ(tree.GetRoot(), nullptr);
+}
+
 class SlicedAllocationFinderTest : public ::testing::Test {
  public:
   using HeapTy = GlobalDecreasingSizeBestFitHeap<HloValue>;
@@ -2492,5 +2564,96 @@ t0 |xxxxx000        xxxx      xxxxxxxxxxxxxx   xxxxxxxxxxxxxxxxxxxxxxxxxxxx
                                      Chunk::FromOffsetSize(11, 0)));
 }
 
+using AllocationBlock = MemorySpaceAssignmentRepacker::AllocationBlock;
+
+// A pseudo-random sequence of allocations and frees of `num_buffers` buffers,
+// each one live for a few of the following allocations.
+class RandomHeapSequence {
+ public:
+  explicit RandomHeapSequence(int num_buffers) : blocks_(num_buffers) {
+    std::mt19937 generator(/*seed=*/0);
+    std::uniform_int_distribution<int64_t> size_distribution(1, 1 << 20);
+    std::geometric_distribution<int> lifetime_distribution(0.05);
+    std::vector<std::pair<int, int>> frees;  // (free time, buffer)
+    for (int i = 0; i < num_buffers; ++i) {
+      blocks_[i].id = i;
+      blocks_[i].size = size_distribution(generator);
+      events_.push_back({i, /*alloc=*/true});
+      frees.push_back({i + lifetime_distribution(generator), i});
+      // Free the buffers whose time has come.
+      absl::c_sort(frees, std::greater<>());
+      while (!frees.empty() && frees.back().first <= i) {
+        events_.push_back({frees.back().second, /*alloc=*/false});
+        frees.pop_back();
+      }
+    }
+    for (auto it = frees.rbegin(); it != frees.rend(); ++it) {
+      events_.push_back({it->second, /*alloc=*/false});
+    }
+  }
+
+  void Simulate(HeapAlgorithm<AllocationBlock>& heap) const {
+    for (const auto& [buffer, alloc] : events_) {
+      if (alloc) {
+        heap.Alloc(&blocks_[buffer], blocks_[buffer].size);
+      } else {
+        heap.Free(&blocks_[buffer], blocks_[buffer].size);
+      }
+    }
+  }
+
+ private:
+  std::vector<AllocationBlock> blocks_;
+  std::vector<std::pair<int, bool>> events_;
+};
+
+// Heaps this large are finished with one thread per algorithm, which must not
+// change the result.
+TEST(ChooseBestHeapAlgorithmTest, ParallelFinishMatchesBestAlgorithm) {
+  using Heap = GlobalDecreasingSizeBestFitHeap<AllocationBlock>;
+  using ChooseBest = ChooseBestHeapAlgorithm<AllocationBlock>;
+  const RandomHeapSequence sequence(2 *
+                                    ChooseBest::kMinBuffersForParallelFinish);
+
+  std::vector<HeapSimulator::Result<AllocationBlock>> expected;
+  auto algorithms = std::make_unique<
+      std::vector<std::unique_ptr<HeapAlgorithm<AllocationBlock>>>>();
+  for (Heap::Type type : {Heap::kSpatial, Heap::kTemporal}) {
+    Heap heap(/*alignment=*/64, type);
+    sequence.Simulate(heap);
+    expected.push_back(heap.Finish());
+    algorithms->push_back(std::make_unique<Heap>(/*alignment=*/64, type));
+  }
+  const HeapSimulator::Result<AllocationBlock>& best =
+      expected[1].heap_size < expected[0].heap_size ? expected[1]
+                                                    : expected[0];
+
+  ChooseBest heap(std::move(algorithms));
+  sequence.Simulate(heap);
+  HeapSimulator::Result<AllocationBlock> result = heap.Finish();
+  EXPECT_EQ(result.heap_size, best.heap_size);
+  ASSERT_EQ(result.heap_results.size(), 1);
+  EXPECT_EQ(result.heap_results[0].chunk_map, best.heap_results[0].chunk_map);
+}
+
+void BM_GlobalDecreasingSizeBestFitHeap(::testing::benchmark::State& state) {
+  const RandomHeapSequence sequence(state.range(0));
+  const auto type =
+      static_cast<GlobalDecreasingSizeBestFitHeap<AllocationBlock>::Type>(
+          state.range(1));
+  for (auto s : state) {
+    GlobalDecreasingSizeBestFitHeap<AllocationBlock> heap(/*alignment=*/64,
+                                                          type);
+    sequence.Simulate(heap);
+    tsl::testing::DoNotOptimize(heap.Finish());
+  }
+}
+
+BENCHMARK(BM_GlobalDecreasingSizeBestFitHeap)
+    ->ArgPair(1 << 10, GlobalDecreasingSizeBestFitHeap<HloValue>::kSpatial)
+    ->ArgPair(1 << 10, GlobalDecreasingSizeBestFitHeap<HloValue>::kTemporal)
+    ->ArgPair(1 << 14, GlobalDecreasingSizeBestFitHeap<HloValue>::kSpatial)
+    ->ArgPair(1 << 14, GlobalDecreasingSizeBestFitHeap<HloValue>::kTemporal);
+
 }  // namespace
 }  // namespace xla
@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef XLA_SERVICE_HLO_CSE_H_
 #define XLA_SERVICE_HLO_CSE_H_
 
+#include <vector>
+
+#include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_module.h"
 #include "xla/service/hlo_pass_interface.h"
 
@@ -25,7 +28,7 @@ namespace xla {
 // and identical instructions with the same operands are commoned. The pass
 // iterates over the instructions in topological order which enables the pass to
 // find arbitrarily large common expressions.
-class HloCSE : public HloModulePass {
+class HloCSE : public HloComputationLocalPass {
  public:
   // If is_layout_sensitive is true, then the simplifier preserves layout during
   // transformation. Otherwise, layout is ignored.
@@ -36,12 +39,12 @@ class HloCSE : public HloModulePass {
   ~HloCSE() override = default;
   absl::string_view name() const override { return "cse"; }
 
-  // Run CSE on the given module. Returns whether the module was changed (common
-  // subexpressions were found and eliminated).
-  using HloPassInterface::Run;
-  StatusOr<bool> Run(
+  // CSE runs on each computation independently. Run returns whether the module
+  // was changed (common subexpressions were found and eliminated).
+  std::vector<HloComputation*> ComputationsToProcess(
       HloModule* module,
       const absl::flat_hash_set<absl::string_view>& execution_threads) override;
+  StatusOr<bool> ProcessComputation(HloComputation* computation) override;
 
  private:
   const bool is_layout_sensitive_;
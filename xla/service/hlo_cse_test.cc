@@ -850,6 +850,51 @@ TEST_F(HloCseTest, CustomCallSideEffects) {
   EXPECT_EQ(changed, false);
 }
 
+TEST_F(HloCseTest, ProcessesCalleesBeforeCallers) {
+  // f0 and f1 are only identical once the common subexpression in f0 is
+  // removed. The entry computation is stored before them, so the calls are
+  // only commoned if the callees are processed first.
+  const Shape shape = ShapeUtil::MakeShape(F32, {8});
+  auto make_callee = [&](absl::string_view name, bool duplicate_add) {
+    HloComputation::Builder builder(name);
+    HloInstruction* param =
+        builder.AddInstruction(HloInstruction::CreateParameter(0, shape, "p"));
+    HloInstruction* a = builder.AddInstruction(
+        HloInstruction::CreateBinary(shape, HloOpcode::kAdd, param, param));
+    HloInstruction* b =
+        duplicate_add ? builder.AddInstruction(HloInstruction::CreateBinary(
+                            shape, HloOpcode::kAdd, param, param))
+                      : a;
+    builder.AddInstruction(
+        HloInstruction::CreateBinary(shape, HloOpcode::kMultiply, a, b));
+    return builder.Build();
+  };
+  std::unique_ptr<HloComputation> f0 = make_callee("f0", true);
+  std::unique_ptr<HloComputation> f1 = make_callee("f1", false);
+
+  HloComputation::Builder builder(TestName());
+  HloInstruction* param =
+      builder.AddInstruction(HloInstruction::CreateParameter(0, shape, "p"));
+  HloInstruction* call0 = builder.AddInstruction(
+      HloInstruction::CreateCall(shape, {param}, f0.get()));
+  HloInstruction* call1 = builder.AddInstruction(
+      HloInstruction::CreateCall(shape, {param}, f1.get()));
+  builder.AddInstruction(HloInstruction::CreateTuple({call0, call1}));
+
+  auto module = CreateNewVerifiedModule();
+  HloComputation* entry = module->AddEntryComputation(builder.Build());
+  module->AddEmbeddedComputation(std::move(f0));
+  module->AddEmbeddedComputation(std::move(f1));
+  ASSERT_EQ(*module->computations().begin(), entry);
+
+  HloCSE cse(/*is_layout_sensitive=*/false);
+  EXPECT_TRUE(cse.Run(module.get()).value());
+  EXPECT_THAT(entry->root_instruction(),
+              op::Tuple(op::Call(param), op::Call(param)));
+  EXPECT_EQ(entry->root_instruction()->operand(0),
+            entry->root_instruction()->operand(1));
+}
+
 class HloCseCommutativeOpTest
     : public HloCseTest,
       public ::testing::WithParamInterface<std::string /*op*/> {};
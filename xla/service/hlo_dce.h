@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef XLA_SERVICE_HLO_DCE_H_
 #define XLA_SERVICE_HLO_DCE_H_
 
+#include <vector>
+
 #include "absl/container/flat_hash_map.h"
 #include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_instruction.h"
@@ -34,7 +36,7 @@ namespace xla {
 //
 // This pass does not remove dead parameter instructions, as parameter
 // instructions cannot be deleted.
-class HloDCE : public HloModulePass {
+class HloDCE : public HloComputationLocalPass {
  public:
   HloDCE() : remove_cross_partition_collective_ops_(false) {}
   explicit HloDCE(bool remove_cross_partition_collective_ops)
@@ -54,6 +56,24 @@ class HloDCE : public HloModulePass {
       HloModule* module,
       const absl::flat_hash_set<absl::string_view>& execution_threads) override;
 
+  std::vector<HloComputation*> ComputationsToProcess(
+      HloModule* module,
+      const absl::flat_hash_set<absl::string_view>& execution_threads)
+      override {
+    return module->MakeComputationPostOrder(execution_threads);
+  }
+  StatusOr<bool> ProcessComputation(HloComputation* computation) override {
+    return RunOnComputation(computation,
+                            remove_cross_partition_collective_ops_);
+  }
+  // Removes the computations that are no longer called.
+  StatusOr<bool> FinishRun(
+      HloModule* module,
+      const absl::flat_hash_set<absl::string_view>& execution_threads)
+      override {
+    return RecursivelyRemoveDeadComputations(module, execution_threads);
+  }
+
  private:
   // Finds all computations that are not called by any instruction and removes
   // them from the module. Returns whether any dead code was removed.
@@ -43,6 +43,14 @@ bool IsIdentifierChar(char c) {
          c == '.' || c == '_';
 }
 
+// Returns the end of the run of decimal digits starting at `ptr`.
+const char* SkipDigits(const char* ptr, const char* end) {
+  while (ptr != end && absl::ascii_isdigit(static_cast<unsigned char>(*ptr))) {
+    ++ptr;
+  }
+  return ptr;
+}
+
 }  // namespace
 
 int HloLexer::GetNextChar() {
@@ -329,7 +337,10 @@ TokKind HloLexer::LexIdentifier() {
 
 #undef KEYWORD
 
-  {
+  // The identifier scan stops at the '?' or the '>' of a dim labels pattern,
+  // so there is no need to try the regular expression on any other
+  // identifier.
+  if (PeekCurrentChar() == '?' || PeekCurrentChar() == '>') {
     absl::string_view consumable = StringViewFromPointers(
         token_state_.token_start, buf_.data() + buf_.size());
     static LazyRE2 dim_labels_pattern = {
@@ -341,7 +352,7 @@ TokKind HloLexer::LexIdentifier() {
     }
   }
 
-  token_state_.str_val = std::string(identifier);
+  token_state_.str_val.assign(identifier.data(), identifier.size());
   return TokKind::kIdent;
 }
 
@@ -373,14 +384,58 @@ TokKind HloLexer::LexPercent() {
 // int ::=  [-]?[0-9]+
 // negative inf ::= '-inf'
 TokKind HloLexer::LexNumberOrPattern() {
+  // Plain integers and decimals, which make up the bulk of large constants,
+  // are scanned by hand. Only tokens that may continue into one of the other
+  // patterns, i.e. that are followed by an identifier character, '?' or '>',
+  // go through the regular expressions below.
+  {
+    const char* end = buf_.data() + buf_.size();
+    const char* ptr = token_state_.token_start;
+    if (*ptr == '-') {
+      ++ptr;
+    }
+    const char* digits_end = SkipDigits(ptr, end);
+    if (digits_end != ptr) {
+      ptr = digits_end;
+      bool is_decimal = false;
+      if (ptr != end && *ptr == '.') {
+        ptr = SkipDigits(ptr + 1, end);
+        is_decimal = true;
+      }
+      if (ptr != end && (*ptr == 'e' || *ptr == 'E')) {
+        const char* exponent = ptr + 1;
+        if (exponent != end && (*exponent == '+' || *exponent == '-')) {
+          ++exponent;
+        }
+        const char* exponent_end = SkipDigits(exponent, end);
+        if (exponent_end != exponent) {
+          ptr = exponent_end;
+          is_decimal = true;
+        }
+      }
+      if (ptr == end || (!IsIdentifierChar(*ptr) && *ptr != '?' &&
+                         *ptr != '>')) {
+        current_ptr_ = ptr;
+        auto slice =
+            StringViewFromPointers(token_state_.token_start, current_ptr_);
+        if (is_decimal) {
+          CHECK(absl::SimpleAtod(slice, &token_state_.decimal_val));
+          return TokKind::kDecimal;
+        }
+        return LexInt64(slice);
+      }
+    }
+  }
+
   absl::string_view consumable = StringViewFromPointers(
       token_state_.token_start, buf_.data() + buf_.size());
   static LazyRE2 float_pattern = {
       R"([-]?((\d+|\d+[.]\d*|\d*[.]\d+)([eE][+-]?\d+))|[-]?(\d+[.]\d*|\d*[.]\d+))"};
   if (RE2::Consume(&consumable, *float_pattern)) {
     current_ptr_ = consumable.data();
-    CHECK(absl::SimpleAtod(std::string(token_state_.token_start, current_ptr_),
-                           &token_state_.decimal_val));
+    CHECK(absl::SimpleAtod(
+        StringViewFromPointers(token_state_.token_start, current_ptr_),
+        &token_state_.decimal_val));
     return TokKind::kDecimal;
   }
 
@@ -411,17 +466,8 @@ TokKind HloLexer::LexNumberOrPattern() {
   static LazyRE2 int_pattern = {R"([-]?\d+)"};
   if (RE2::Consume(&consumable, *int_pattern)) {
     current_ptr_ = consumable.data();
-    auto slice = StringViewFromPointers(token_state_.token_start, current_ptr_);
-    if (absl::SimpleAtoi(slice, &token_state_.int64_val)) {
-      return TokKind::kInt;
-    }
-    uint64_t uint64_val;
-    if (absl::SimpleAtoi(slice, &uint64_val)) {
-      token_state_.int64_val = absl::bit_cast<int64_t>(uint64_val);
-      return TokKind::kInt;
-    }
-    LOG(ERROR) << "Failed to parse int literal: " << slice;
-    return TokKind::kError;
+    return LexInt64(
+        StringViewFromPointers(token_state_.token_start, current_ptr_));
   }
 
   static LazyRE2 neg_inf = {"-inf"};
@@ -449,6 +495,19 @@ TokKind HloLexer::LexNumberOrPattern() {
   return TokKind::kError;
 }
 
+TokKind HloLexer::LexInt64(absl::string_view slice) {
+  if (absl::SimpleAtoi(slice, &token_state_.int64_val)) {
+    return TokKind::kInt;
+  }
+  uint64_t uint64_val;
+  if (absl::SimpleAtoi(slice, &uint64_val)) {
+    token_state_.int64_val = absl::bit_cast<int64_t>(uint64_val);
+    return TokKind::kInt;
+  }
+  LOG(ERROR) << "Failed to parse int literal: " << slice;
+  return TokKind::kError;
+}
+
 std::pair<unsigned, unsigned> HloLexer::GetLineAndColumn(LocTy location) const {
   unsigned line_no = 1;
   const char* start = buf_.data();
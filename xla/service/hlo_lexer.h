@@ -97,7 +97,7 @@ class HloLexer {
   TokKind Lex() { return token_state_.current_kind = LexToken(); }
 
   TokKind GetKind() const { return token_state_.current_kind; }
-  std::string GetStrVal() const {
+  const std::string& GetStrVal() const {
     switch (GetKind()) {
       case TokKind::kName:
       case TokKind::kAttributeName:
@@ -162,6 +162,9 @@ class HloLexer {
   TokKind LexShape();
   TokKind LexConstant();
   TokKind LexNumberOrPattern();
+  // Sets the int64 value of the current token to `slice`, which matches
+  // [-]?[0-9]+, wrapping values that only fit in a uint64.
+  TokKind LexInt64(absl::string_view slice);
   TokKind LexString();
 
   std::optional<int64_t> LexNanPayload(absl::string_view& consumable);
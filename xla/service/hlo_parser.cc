@@ -3535,7 +3535,8 @@ bool HloParserImpl::SetValueInLiteralHelper(LocTy loc, ParsedElemT value,
   }
 
   // Check that the index is in range and assign into the literal
-  if (index >= ShapeUtil::ElementsIn(literal->shape())) {
+  absl::Span<LiteralNativeT> data = literal->data<LiteralNativeT>();
+  if (index >= static_cast<int64_t>(data.size())) {
     return Error(loc, StrCat("tries to set value ", StringifyValue(value),
                              " to a literal in shape ",
                              ShapeUtil::HumanString(literal->shape()),
@@ -3603,9 +3604,8 @@ bool HloParserImpl::SetValueInLiteralHelper(LocTy loc, ParsedElemT value,
       return false;
     }
   }
-  literal->data<LiteralNativeT>().at(index) =
-      LiteralNativeFromRealImag<LiteralNativeT>(literal_real_value,
-                                                literal_imag_value);
+  data[index] = LiteralNativeFromRealImag<LiteralNativeT>(literal_real_value,
+                                                          literal_imag_value);
   return true;
 }
 
@@ -37,6 +37,7 @@ limitations under the License.
 #include "tsl/platform/status_matchers.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
 
 namespace xla {
 namespace {
@@ -4502,5 +4503,71 @@ comp2 {
       Layout({1, 0, 2, 3}));
 }
 
+// Returns the text of a module in the style of a large dump: a long chain of
+// elementwise instructions with layouts and metadata.
+std::string MakeLargeModuleText(int64_t num_instructions) {
+  std::string text = R"(HloModule large_module
+
+ENTRY main {
+  p0 = f32[128,256]{1,0} parameter(0)
+  p1 = f32[128,256]{1,0} parameter(1)
+  op.0 = f32[128,256]{1,0} add(p0, p1)
+)";
+  for (int64_t i = 1; i < num_instructions; ++i) {
+    absl::StrAppend(&text, i + 1 == num_instructions ? "  ROOT " : "  ",
+                    "op.", i, " = f32[128,256]{1,0} ",
+                    i % 2 == 0 ? "add" : "multiply", "(op.", i - 1,
+                    ", p1), metadata={op_name=\"jit(f)/op.", i,
+                    "\" source_file=\"model.py\" source_line=", i, "}\n");
+  }
+  absl::StrAppend(&text, "}\n");
+  return text;
+}
+
+void BM_ParseLargeModule(::testing::benchmark::State& state) {
+  const std::string text = MakeLargeModuleText(state.range(0));
+  for (auto s : state) {
+    auto module = ParseAndReturnUnverifiedModule(text);
+    CHECK(module.ok()) << module.status();
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_ParseLargeModule)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 17);
+
+// Returns the text of a module holding one dense constant of `num_elements`
+// elements, as decimals if `floating` and as integers otherwise.
+std::string MakeLargeConstantText(int64_t num_elements, bool floating) {
+  std::string text = absl::StrCat("HloModule large_constant\n\nENTRY main {\n",
+                                  "  ROOT c = ", floating ? "f32" : "s32", "[",
+                                  num_elements, "]{0} constant({");
+  for (int64_t i = 0; i < num_elements; ++i) {
+    if (i > 0) {
+      absl::StrAppend(&text, ", ");
+    }
+    if (floating) {
+      absl::StrAppend(&text, (i - num_elements / 2) * 0.125);
+    } else {
+      absl::StrAppend(&text, i - num_elements / 2);
+    }
+  }
+  absl::StrAppend(&text, "})\n}\n");
+  return text;
+}
+
+void BM_ParseLargeConstant(::testing::benchmark::State& state) {
+  const std::string text =
+      MakeLargeConstantText(state.range(0), /*floating=*/state.range(1) != 0);
+  for (auto s : state) {
+    auto module = ParseAndReturnUnverifiedModule(text);
+    CHECK(module.ok()) << module.status();
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_ParseLargeConstant)
+    ->ArgPair(1 << 10, 0)
+    ->ArgPair(1 << 10, 1)
+    ->ArgPair(1 << 20, 0)
+    ->ArgPair(1 << 20, 1);
+
 }  // namespace
 }  // namespace xla
@@ -49,6 +49,9 @@ class HloPassFix : public Pass {
     return OkStatus();
   }
 
+  // Iterating to a fixed point is not expressible per computation.
+  HloComputationLocalPass* AsComputationLocalPass() override { return nullptr; }
+
   using HloPassInterface::Run;
   StatusOr<bool> Run(HloModule* module,
                      const absl::flat_hash_set<absl::string_view>&
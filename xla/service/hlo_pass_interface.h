@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef XLA_SERVICE_HLO_PASS_INTERFACE_H_
 #define XLA_SERVICE_HLO_PASS_INTERFACE_H_
 
+#include <vector>
+
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
 #include "xla/hlo/ir/hlo_module.h"
@@ -26,6 +28,8 @@ limitations under the License.
 
 namespace xla {
 
+class HloComputationLocalPass;
+
 // Base class for HLO passes. These are used with the HloPassPipeline to
 // organize a sequence of passes. An HLO pass should not extend this class
 // directly; it should extend HloModulePass or HloModuleGroupPass.
@@ -140,6 +144,11 @@ class HloPassInterface {
       const absl::flat_hash_set<absl::string_view>& execution_threads) = 0;
 
   virtual bool IsPassPipeline() { return false; }
+
+  // Returns this pass if its computations can be processed concurrently, see
+  // HloComputationLocalPass. Wrappers that change what Run does on top of a
+  // computation-local pass must return nullptr.
+  virtual HloComputationLocalPass* AsComputationLocalPass() { return nullptr; }
 };
 
 // Base class for passes which are module-scoped.
@@ -167,6 +176,52 @@ class HloModulePass : public HloPassInterface {
   virtual void UpdateLayout(Shape* shape) {}
 };
 
+// Base class for module passes which transform each computation on its own.
+// Such passes can be run over independent computations concurrently by an
+// HloPassPipeline with a computation thread pool; Run processes them serially.
+//
+// ProcessComputation may modify the computation it is given and read the
+// computations it calls, which are never processed at the same time. It must
+// not add or remove computations, touch any other computation, or keep state
+// in the pass that is not safe to share between threads. Module-level work,
+// such as removing computations that became dead, belongs in FinishRun;
+// overrides of Run are bypassed when the pass runs concurrently.
+class HloComputationLocalPass : public HloModulePass {
+ public:
+  using HloPassInterface::Run;
+  StatusOr<bool> Run(HloModule* module,
+                     const absl::flat_hash_set<absl::string_view>&
+                         execution_threads) override {
+    bool changed = false;
+    for (HloComputation* computation :
+         ComputationsToProcess(module, execution_threads)) {
+      TF_ASSIGN_OR_RETURN(bool computation_changed,
+                          ProcessComputation(computation));
+      changed |= computation_changed;
+    }
+    TF_ASSIGN_OR_RETURN(bool module_changed,
+                        FinishRun(module, execution_threads));
+    return changed || module_changed;
+  }
+
+  // Returns the computations to process, in the order Run visits them.
+  virtual std::vector<HloComputation*> ComputationsToProcess(
+      HloModule* module,
+      const absl::flat_hash_set<absl::string_view>& execution_threads) = 0;
+
+  // Transforms a single computation. Returns whether it was changed.
+  virtual StatusOr<bool> ProcessComputation(HloComputation* computation) = 0;
+
+  // Runs once after all computations were processed.
+  virtual StatusOr<bool> FinishRun(
+      HloModule* module,
+      const absl::flat_hash_set<absl::string_view>& execution_threads) {
+    return false;
+  }
+
+  HloComputationLocalPass* AsComputationLocalPass() override { return this; }
+};
+
 // Base class for passes which are module-group scoped. These passes cannot run
 // on an HLO module.
 class HloModuleGroupPass : public HloPassInterface {
@@ -15,22 +15,28 @@ limitations under the License.
 
 #include "xla/service/hlo_pass_pipeline.h"
 
+#include <algorithm>
 #include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "xla/service/dump.h"
 #include "xla/service/hlo_graph_dumper.h"
 #include "xla/service/hlo_proto_util.h"
 #include "xla/status_macros.h"
 #include "xla/types.h"
 #include "xla/util.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/logging.h"
 #include "tsl/platform/status.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 
@@ -121,8 +127,111 @@ void SetInstructionMetadata(HloModuleGroup& module_group) {
   }
 }
 
+// Runs `pass` over its computations on `thread_pool`. Computations are
+// grouped by their height in the call graph (leaves have height 0), so a
+// computation only runs after every computation it calls was processed and
+// no two computations running at the same time call each other.
+StatusOr<bool> RunComputationLocalPass(
+    HloComputationLocalPass* pass, HloModule* module,
+    const absl::flat_hash_set<absl::string_view>& execution_threads,
+    tsl::thread::ThreadPool* thread_pool) {
+  absl::flat_hash_map<const HloComputation*, int> heights;
+  for (const HloComputation* computation : module->MakeComputationPostOrder()) {
+    int height = 0;
+    for (const HloInstruction* instruction : computation->instructions()) {
+      for (const HloComputation* callee : instruction->called_computations()) {
+        height = std::max(height, heights[callee] + 1);
+      }
+    }
+    heights[computation] = height;
+  }
+  std::vector<std::vector<HloComputation*>> levels;
+  for (HloComputation* computation :
+       pass->ComputationsToProcess(module, execution_threads)) {
+    int height = heights[computation];
+    if (levels.size() <= static_cast<size_t>(height)) {
+      levels.resize(height + 1);
+    }
+    levels[height].push_back(computation);
+  }
+
+  bool changed = false;
+  Status status;
+  module->BeginConcurrentComputationMutation();
+  for (const std::vector<HloComputation*>& level : levels) {
+    std::vector<StatusOr<bool>> results(level.size(), false);
+    if (level.size() == 1) {
+      results[0] = pass->ProcessComputation(level[0]);
+    } else if (level.size() > 1) {
+      absl::BlockingCounter counter(level.size());
+      for (int i = 0; i < level.size(); ++i) {
+        thread_pool->Schedule([&, i] {
+          results[i] = pass->ProcessComputation(level[i]);
+          counter.DecrementCount();
+        });
+      }
+      counter.Wait();
+    }
+    // Report the first error in computation order so that failures are
+    // deterministic as well.
+    for (StatusOr<bool>& result : results) {
+      if (!result.ok()) {
+        status = result.status();
+        break;
+      }
+      changed |= *result;
+    }
+    if (!status.ok()) {
+      break;
+    }
+  }
+  module->EndConcurrentComputationMutation();
+  TF_RETURN_IF_ERROR(status);
+
+  TF_ASSIGN_OR_RETURN(bool module_changed,
+                      pass->FinishRun(module, execution_threads));
+  return changed || module_changed;
+}
+
 }  // namespace
 
+StatusOr<bool> HloPassPipeline::RunHelper(
+    HloPassInterface* pass, HloModule* module,
+    const absl::flat_hash_set<absl::string_view>& execution_threads) {
+  tsl::thread::ThreadPool* thread_pool = computation_thread_pool_;
+  if (thread_pool == nullptr) {
+    int num_threads =
+        module->config().debug_options().xla_hlo_pass_computation_threads();
+    if (num_threads > 1) {
+      if (owned_computation_thread_pool_ == nullptr) {
+        owned_computation_thread_pool_ =
+            std::make_unique<tsl::thread::ThreadPool>(
+                tsl::Env::Default(), "hlo_pass_computations", num_threads);
+      }
+      thread_pool = owned_computation_thread_pool_.get();
+    }
+  }
+  // Nested pipelines are owned by this one, so they can share its pool.
+  if (pass->IsPassPipeline() && thread_pool != nullptr) {
+    auto* pipeline = static_cast<HloPassPipeline*>(pass);
+    if (pipeline->computation_thread_pool_ == nullptr) {
+      pipeline->set_computation_thread_pool(thread_pool);
+    }
+  }
+  HloComputationLocalPass* computation_local_pass =
+      pass->AsComputationLocalPass();
+  bool changed;
+  if (thread_pool != nullptr && computation_local_pass != nullptr) {
+    TF_ASSIGN_OR_RETURN(
+        changed, RunComputationLocalPass(computation_local_pass, module,
+                                         execution_threads, thread_pool));
+  } else {
+    TF_ASSIGN_OR_RETURN(changed, pass->Run(module, execution_threads));
+  }
+  module->Cleanup();
+  return changed;
+}
+
 template <typename HloT>
 Status HloPassPipeline::RunInvariantCheckers(
     HloT* hlo, absl::string_view after_pass_name,
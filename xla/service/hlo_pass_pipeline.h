@@ -27,6 +27,7 @@ limitations under the License.
 #include "xla/service/hlo_pass_interface.h"
 #include "xla/statusor.h"
 #include "xla/types.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 
@@ -89,6 +90,16 @@ class HloPassPipeline : public HloPassInterface {
 
   bool IsPassPipeline() override { return true; }
 
+  // Runs HloComputationLocalPass passes over independent computations of a
+  // module concurrently on `thread_pool`. The resulting module is the same
+  // for any number of threads. The pool must not be the one calling Run. When
+  // unset, --xla_hlo_pass_computation_threads > 1 makes the pipeline create
+  // a pool of that many threads on first use, which it owns and shares with
+  // its nested pipelines.
+  void set_computation_thread_pool(tsl::thread::ThreadPool* thread_pool) {
+    computation_thread_pool_ = thread_pool;
+  }
+
   // Return size of passes_.
   int PassesSize() { return passes_.size(); }
   // Return reference to pass specified by index.
@@ -134,13 +145,9 @@ class HloPassPipeline : public HloPassInterface {
   // empty thread list means all `execution_threads` are considered. These
   // helpers enable templating of the core of the pipeline logic by providing
   // HloModule and HloModuleGroup specific methods with the same name.
-  static StatusOr<bool> RunHelper(
+  StatusOr<bool> RunHelper(
       HloPassInterface* pass, HloModule* module,
-      const absl::flat_hash_set<absl::string_view>& execution_threads) {
-    TF_ASSIGN_OR_RETURN(bool changed, pass->Run(module, execution_threads));
-    module->Cleanup();
-    return changed;
-  }
+      const absl::flat_hash_set<absl::string_view>& execution_threads);
   static StatusOr<bool> RunHelper(
       HloPassInterface* pass, HloModuleGroup* module_group,
       const absl::flat_hash_set<absl::string_view>& execution_threads) {
@@ -154,6 +161,8 @@ class HloPassPipeline : public HloPassInterface {
   std::vector<std::unique_ptr<HloPassInterface>> passes_;
   std::vector<std::unique_ptr<HloPassInterface>> invariant_checkers_;
   bool run_called_ = false;
+  tsl::thread::ThreadPool* computation_thread_pool_ = nullptr;
+  std::unique_ptr<tsl::thread::ThreadPool> owned_computation_thread_pool_;
 
   CompilationStats* compilation_stats_;
   // Default stats instance for when one is not passed in the constructor.
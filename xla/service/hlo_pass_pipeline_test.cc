@@ -15,13 +15,25 @@ limitations under the License.
 
 #include "xla/service/hlo_pass_pipeline.h"
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
 #include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_instruction.h"
 #include "xla/hlo/ir/hlo_module.h"
+#include "xla/service/hlo_cse.h"
+#include "xla/service/hlo_dce.h"
 #include "xla/service/hlo_parser.h"
+#include "xla/shape_util.h"
 #include "xla/tests/hlo_test_base.h"
 #include "xla/util.h"
 #include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/test_benchmark.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 namespace {
@@ -400,5 +412,219 @@ TEST_F(HloPassPipelineTest, SetHloModuleMetadata) {
   }
 }
 
+// A computation-local pass which wraps the root of every non-fusion
+// computation in two negations, adding instructions that need ids and names.
+class DoubleNegateRootPass : public HloComputationLocalPass {
+ public:
+  absl::string_view name() const override { return "double-negate-root"; }
+
+  std::vector<HloComputation*> ComputationsToProcess(
+      HloModule* module,
+      const absl::flat_hash_set<absl::string_view>& execution_threads)
+      override {
+    return module->MakeNonfusionComputations(execution_threads);
+  }
+
+  StatusOr<bool> ProcessComputation(HloComputation* computation) override {
+    HloInstruction* root = computation->root_instruction();
+    HloInstruction* negate = computation->AddInstruction(
+        HloInstruction::CreateUnary(root->shape(), HloOpcode::kNegate, root));
+    computation->set_root_instruction(
+        computation->AddInstruction(HloInstruction::CreateUnary(
+            root->shape(), HloOpcode::kNegate, negate)));
+    return true;
+  }
+};
+
+// Returns a module whose entry computation calls `num_computations`
+// independent computations, each with a common subexpression and dead code.
+std::string ModuleWithIndependentComputations(int num_computations) {
+  std::string hlo = "HloModule independent_computations\n\n";
+  for (int i = 0; i < num_computations; ++i) {
+    absl::StrAppend(&hlo, "f", i, R"( {
+  p = f32[8] parameter(0)
+  k = f32[] constant()", i, R"()
+  kb = f32[8] broadcast(k), dimensions={}
+  a = f32[8] add(p, p)
+  b = f32[8] add(p, p)
+  dead = f32[8] subtract(a, b)
+  m = f32[8] multiply(a, b)
+  ROOT r = f32[8] add(m, kb)
+}
+
+)");
+  }
+  absl::StrAppend(&hlo, "ENTRY entry {\n  p = f32[8] parameter(0)\n");
+  for (int i = 0; i < num_computations; ++i) {
+    absl::StrAppend(&hlo, "  c", i, " = f32[8] call(p), to_apply=f", i, "\n");
+  }
+  absl::StrAppend(&hlo, "  ROOT t = (");
+  for (int i = 0; i < num_computations; ++i) {
+    absl::StrAppend(&hlo, i == 0 ? "" : ", ", "f32[8]");
+  }
+  absl::StrAppend(&hlo, ") tuple(");
+  for (int i = 0; i < num_computations; ++i) {
+    absl::StrAppend(&hlo, i == 0 ? "" : ", ", "c", i);
+  }
+  absl::StrAppend(&hlo, ")\n}\n");
+  return hlo;
+}
+
+TEST_F(HloPassPipelineTest, ComputationLocalPassesMatchSerialRun) {
+  const std::string hlo = ModuleWithIndependentComputations(32);
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> serial_module,
+                          ParseAndReturnVerifiedModule(hlo));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> parallel_module,
+                          ParseAndReturnVerifiedModule(hlo));
+
+  auto add_passes = [](HloPassPipeline& pipeline) {
+    pipeline.AddPass<HloCSE>(/*is_layout_sensitive=*/false);
+    pipeline.AddPass<HloDCE>();
+    pipeline.AddPass<DoubleNegateRootPass>();
+  };
+  HloPassPipeline serial_pipeline("serial");
+  add_passes(serial_pipeline);
+  TF_ASSERT_OK_AND_ASSIGN(bool serial_changed,
+                          serial_pipeline.Run(serial_module.get()));
+
+  tsl::thread::ThreadPool pool(tsl::Env::Default(), "test", 4);
+  HloPassPipeline parallel_pipeline("parallel");
+  add_passes(parallel_pipeline);
+  parallel_pipeline.set_computation_thread_pool(&pool);
+  TF_ASSERT_OK_AND_ASSIGN(bool parallel_changed,
+                          parallel_pipeline.Run(parallel_module.get()));
+
+  EXPECT_TRUE(serial_changed);
+  EXPECT_TRUE(parallel_changed);
+  TF_ASSERT_OK(verifier().Run(parallel_module.get()).status());
+  TF_ASSERT_OK(
+      parallel_module->CheckUniqueNamesAndIdsForComputationsAndInstructions());
+  // Instructions added concurrently get the same names and ids as in a serial
+  // run.
+  EXPECT_EQ(serial_module->ToString(), parallel_module->ToString());
+  for (const HloComputation* computation : parallel_module->computations()) {
+    for (const HloInstruction* instruction : computation->instructions()) {
+      EXPECT_NE(instruction->name(), "dead");
+    }
+  }
+}
+
+TEST_F(HloPassPipelineTest, ComputationLocalPassesRenumberInPostOrder) {
+  // The entry computation is stored before the computations it calls, so the
+  // storage order differs from the post order serial passes visit.
+  constexpr int kNumCallees = 8;
+  auto make_module = [&] {
+    auto module = CreateNewVerifiedModule();
+    const Shape shape = ShapeUtil::MakeShape(F32, {8});
+    HloComputation::Builder entry_builder("entry");
+    HloInstruction* param = entry_builder.AddInstruction(
+        HloInstruction::CreateParameter(0, shape, "p"));
+    std::vector<std::unique_ptr<HloComputation>> callees;
+    std::vector<HloInstruction*> calls;
+    for (int i = 0; i < kNumCallees; ++i) {
+      HloComputation::Builder builder(absl::StrCat("f", i));
+      HloInstruction* callee_param = builder.AddInstruction(
+          HloInstruction::CreateParameter(0, shape, "p"));
+      builder.AddInstruction(
+          HloInstruction::CreateUnary(shape, HloOpcode::kExp, callee_param));
+      callees.push_back(builder.Build());
+      calls.push_back(entry_builder.AddInstruction(
+          HloInstruction::CreateCall(shape, {param}, callees.back().get())));
+    }
+    entry_builder.AddInstruction(HloInstruction::CreateTuple(calls));
+    module->AddEntryComputation(entry_builder.Build());
+    for (auto it = callees.rbegin(); it != callees.rend(); ++it) {
+      module->AddEmbeddedComputation(std::move(*it));
+    }
+    return module;
+  };
+  std::unique_ptr<VerifiedHloModule> serial_module = make_module();
+  std::unique_ptr<VerifiedHloModule> parallel_module = make_module();
+  ASSERT_EQ(*parallel_module->computations().begin(),
+            parallel_module->entry_computation());
+  ASSERT_EQ(parallel_module->MakeComputationPostOrder().back(),
+            parallel_module->entry_computation());
+
+  HloPassPipeline serial_pipeline("serial");
+  serial_pipeline.AddPass<DoubleNegateRootPass>();
+  TF_ASSERT_OK(serial_pipeline.Run(serial_module.get()).status());
+
+  tsl::thread::ThreadPool pool(tsl::Env::Default(), "test", 4);
+  HloPassPipeline parallel_pipeline("parallel");
+  parallel_pipeline.AddPass<DoubleNegateRootPass>();
+  parallel_pipeline.set_computation_thread_pool(&pool);
+  TF_ASSERT_OK(parallel_pipeline.Run(parallel_module.get()).status());
+
+  TF_ASSERT_OK(
+      parallel_module->CheckUniqueNamesAndIdsForComputationsAndInstructions());
+  auto names_and_ids = [](const HloModule& module) {
+    std::vector<std::pair<std::string, int>> result;
+    for (const HloComputation* computation :
+         module.MakeComputationPostOrder()) {
+      for (const HloInstruction* instruction : computation->instructions()) {
+        result.emplace_back(instruction->name(), instruction->unique_id());
+      }
+    }
+    return result;
+  };
+  EXPECT_EQ(names_and_ids(*serial_module), names_and_ids(*parallel_module));
+}
+
+TEST_F(HloPassPipelineTest, ComputationThreadsFlagUsesOwnedPool) {
+  const std::string hlo = ModuleWithIndependentComputations(16);
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> serial_module,
+                          ParseAndReturnVerifiedModule(hlo));
+  HloModuleConfig config = GetModuleConfigForTest();
+  DebugOptions debug_options = config.debug_options();
+  debug_options.set_xla_hlo_pass_computation_threads(4);
+  config.set_debug_options(debug_options);
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> parallel_module,
+                          ParseAndReturnVerifiedModule(hlo, config));
+
+  // The pool created by the outer pipeline is shared with the nested one and
+  // lives as long as the outer pipeline.
+  auto run = [](HloModule* module) {
+    HloPassPipeline pipeline("outer");
+    auto& nested = pipeline.AddPass<HloPassPipeline>("nested");
+    nested.AddPass<HloCSE>(/*is_layout_sensitive=*/false);
+    nested.AddPass<HloDCE>();
+    return pipeline.Run(module);
+  };
+  TF_ASSERT_OK(run(serial_module.get()).status());
+  TF_ASSERT_OK(run(parallel_module.get()).status());
+
+  TF_ASSERT_OK(
+      parallel_module->CheckUniqueNamesAndIdsForComputationsAndInstructions());
+  EXPECT_EQ(serial_module->ToString(), parallel_module->ToString());
+}
+
+void BM_ComputationLocalPipeline(::testing::benchmark::State& state) {
+  const int num_threads = state.range(0);
+  const int num_computations = state.range(1);
+  std::unique_ptr<HloModule> module =
+      ParseAndReturnUnverifiedModule(
+          ModuleWithIndependentComputations(num_computations))
+          .value();
+  std::unique_ptr<tsl::thread::ThreadPool> pool;
+  if (num_threads > 1) {
+    pool = std::make_unique<tsl::thread::ThreadPool>(tsl::Env::Default(),
+                                                     "bench", num_threads);
+  }
+  for (auto s : state) {
+    state.PauseTiming();
+    std::unique_ptr<HloModule> clone = module->Clone();
+    HloPassPipeline pipeline("bench");
+    pipeline.AddPass<HloCSE>(/*is_layout_sensitive=*/false);
+    pipeline.AddPass<HloDCE>();
+    pipeline.set_computation_thread_pool(pool.get());
+    state.ResumeTiming();
+    TF_CHECK_OK(pipeline.Run(clone.get()).status());
+  }
+}
+BENCHMARK(BM_ComputationLocalPipeline)
+    ->ArgPair(1, 1024)
+    ->ArgPair(4, 1024)
+    ->ArgPair(16, 1024);
+
 }  // namespace
 }  // namespace xla
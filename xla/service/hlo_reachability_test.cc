@@ -15,19 +15,38 @@ limitations under the License.
 
 #include "xla/hlo/ir/hlo_reachability.h"
 
+#include <memory>
 #include <set>
+#include <vector>
 
 #include "xla/hlo/ir/hlo_instruction.h"
 #include "xla/service/computation_placer.h"
 #include "xla/test.h"
 #include "xla/test_helpers.h"
 #include "xla/tests/hlo_test_base.h"
+#include "tsl/lib/core/status_test_util.h"
+#include "tsl/platform/test_benchmark.h"
 
 namespace xla {
 
 namespace {
 
-class HloReachabilityTest : public HloTestBase {};
+class HloReachabilityTest : public HloTestBase {
+ protected:
+  // Expects `reachability` to agree with a map built from scratch for every
+  // pair of instructions in `computation`.
+  void ExpectMatchesRebuiltMap(const HloReachabilityMap& reachability,
+                               const HloComputation* computation) {
+    auto expected = HloReachabilityMap::Build(computation);
+    for (const HloInstruction* a : computation->instructions()) {
+      ASSERT_TRUE(reachability.IsPresent(a)) << a->name();
+      for (const HloInstruction* b : computation->instructions()) {
+        EXPECT_EQ(reachability.IsReachable(a, b), expected->IsReachable(a, b))
+            << a->name() << " -> " << b->name();
+      }
+    }
+  }
+};
 
 TEST_F(HloReachabilityTest, Reachability) {
   // Construct and test a reachability graph of the following form:
@@ -209,6 +228,41 @@ TEST_F(HloReachabilityTest, ChannelReachability) {
   EXPECT_FALSE(reachability->IsReachable(send_done, recv));
 }
 
+TEST_F(HloReachabilityTest, UpdateFollowsChannelDependencies) {
+  const Shape shape = ShapeUtil::MakeShape(F32, {5, 7});
+  HloComputation::Builder builder("UpdateFollowsChannelDependencies");
+  auto p0 =
+      builder.AddInstruction(HloInstruction::CreateParameter(0, shape, "p0"));
+  auto p1 =
+      builder.AddInstruction(HloInstruction::CreateParameter(1, shape, "p1"));
+  auto token0 = builder.AddInstruction(HloInstruction::CreateToken());
+  auto send = builder.AddInstruction(HloInstruction::CreateSend(p0, token0, 1));
+  builder.AddInstruction(HloInstruction::CreateSendDone(send));
+  auto token1 = builder.AddInstruction(HloInstruction::CreateToken());
+  auto recv =
+      builder.AddInstruction(HloInstruction::CreateRecv(shape, token1, 1));
+  auto recv_done = builder.AddInstruction(HloInstruction::CreateRecvDone(recv));
+
+  auto module = CreateNewVerifiedModule();
+  module->config().set_use_spmd_partitioning(false);
+  module->config().set_static_device_assignment(DeviceAssignment(1, 2));
+  auto computation = module->AddEntryComputation(builder.Build(recv_done));
+  auto reachability = HloReachabilityMap::Build(computation);
+  EXPECT_TRUE(reachability->IsReachable(p0, recv_done));
+  EXPECT_FALSE(reachability->IsReachable(p1, recv_done));
+
+  // Send `p0 + p1` instead of `p0`. The recv-done depends on the operands of
+  // the send through the channel, so it becomes reachable from `p1`.
+  HloInstruction* add = computation->AddInstruction(
+      HloInstruction::CreateBinary(shape, HloOpcode::kAdd, p0, p1));
+  TF_ASSERT_OK(send->ReplaceOperandWith(0, add));
+  reachability->AddInstruction(add);
+
+  EXPECT_TRUE(reachability->IsReachable(p1, recv_done));
+  EXPECT_TRUE(reachability->IsReachable(add, recv_done));
+  ExpectMatchesRebuiltMap(*reachability, computation);
+}
+
 TEST_F(HloReachabilityTest, ReplaceInstructions) {
   auto module = ParseAndReturnVerifiedModule(R"(
     HloModule test
@@ -240,6 +294,168 @@ TEST_F(HloReachabilityTest, ReplaceInstructions) {
   EXPECT_TRUE(reachability->IsReachable(p0, fusion));
 }
 
+TEST_F(HloReachabilityTest, AddInstruction) {
+  auto module = ParseAndReturnVerifiedModule(R"(
+    HloModule test
+
+    ENTRY entry {
+      p0 = f32[8] parameter(0)
+      p1 = f32[8] parameter(1)
+      a = f32[8] negate(p0)
+      b = f32[8] exponential(a)
+      ROOT c = f32[8] add(b, p0)
+    })")
+                    .value();
+  HloComputation* computation = module->entry_computation();
+  auto reachability = HloReachabilityMap::Build(computation);
+  HloInstruction* p1 = computation->parameter_instruction(1);
+  HloInstruction* b = computation->root_instruction()->mutable_operand(0);
+  HloInstruction* c = computation->root_instruction();
+  EXPECT_FALSE(reachability->IsReachable(p1, c));
+
+  // Insert `p1 + a` between `a` and `b`.
+  HloInstruction* a = b->mutable_operand(0);
+  HloInstruction* add = computation->AddInstruction(
+      HloInstruction::CreateBinary(a->shape(), HloOpcode::kAdd, p1, a));
+  TF_ASSERT_OK(b->ReplaceOperandWith(0, add));
+  reachability->AddInstruction(add);
+
+  EXPECT_TRUE(reachability->IsReachable(a, add));
+  EXPECT_TRUE(reachability->IsReachable(add, c));
+  EXPECT_TRUE(reachability->IsReachable(p1, c));
+  EXPECT_FALSE(reachability->IsReachable(add, a));
+  ExpectMatchesRebuiltMap(*reachability, computation);
+}
+
+TEST_F(HloReachabilityTest, RemoveInstruction) {
+  auto module = ParseAndReturnVerifiedModule(R"(
+    HloModule test
+
+    ENTRY entry {
+      p0 = f32[8] parameter(0)
+      dead = f32[8] negate(p0)
+      ROOT root = f32[8] exponential(p0)
+    })")
+                    .value();
+  HloComputation* computation = module->entry_computation();
+  auto reachability = HloReachabilityMap::Build(computation);
+  HloInstruction* dead = FindInstruction(module.get(), "dead");
+  ASSERT_TRUE(reachability->IsPresent(dead));
+  EXPECT_EQ(reachability->size(), 3);
+
+  reachability->RemoveInstruction(dead);
+  EXPECT_FALSE(reachability->IsPresent(dead));
+  EXPECT_EQ(reachability->size(), 2);
+  TF_ASSERT_OK(computation->RemoveInstruction(dead));
+  ExpectMatchesRebuiltMap(*reachability, computation);
+}
+
+TEST_F(HloReachabilityTest, UpdateAfterMultiOutputFusion) {
+  auto module = ParseAndReturnVerifiedModule(R"(
+    HloModule test
+
+    ENTRY entry {
+      p0 = f32[8] parameter(0)
+      p1 = f32[8] parameter(1)
+      producer = f32[8] exponential(p0)
+      consumer = f32[8] add(producer, p1)
+      other = f32[8] negate(producer)
+      ROOT tuple = (f32[8], f32[8]) tuple(consumer, other)
+    })")
+                    .value();
+  HloComputation* computation = module->entry_computation();
+  auto reachability = HloReachabilityMap::Build(computation);
+  HloInstruction* p1 = computation->parameter_instruction(1);
+  HloInstruction* producer = FindInstruction(module.get(), "producer");
+  HloInstruction* consumer = FindInstruction(module.get(), "consumer");
+  HloInstruction* other = FindInstruction(module.get(), "other");
+  EXPECT_FALSE(reachability->IsReachable(p1, other));
+
+  // Fuse `producer` into `consumer` the way multi-output fusion does. The
+  // remaining user of `producer` then reads a get-tuple-element of the fusion.
+  HloInstruction* fusion =
+      computation->AddInstruction(HloInstruction::CreateFusion(
+          consumer->shape(), HloInstruction::FusionKind::kLoop, consumer));
+  reachability->Replace(consumer, fusion);
+  TF_ASSERT_OK(computation->ReplaceInstruction(consumer, fusion));
+  fusion->FuseInstructionIntoMultiOutput(producer);
+  reachability->RemoveInstruction(producer);
+  TF_ASSERT_OK(computation->RemoveInstruction(producer));
+  reachability->UpdateReachabilityThroughInstruction(fusion);
+
+  EXPECT_TRUE(reachability->IsReachable(p1, other));
+  EXPECT_TRUE(reachability->IsReachable(fusion, other));
+  ExpectMatchesRebuiltMap(*reachability, computation);
+}
+
+// Builds an entry computation of `n` elementwise ops. A deep computation is
+// a chain where every op uses the previous one; in a wide computation every
+// op only uses the parameter and all of them feed the root tuple.
+std::unique_ptr<HloModule> MakeBenchmarkModule(int64_t n, bool wide) {
+  auto module = std::make_unique<HloModule>("reachability", HloModuleConfig());
+  const Shape shape = ShapeUtil::MakeShape(F32, {8});
+  auto builder = HloComputation::Builder("entry");
+  HloInstruction* param =
+      builder.AddInstruction(HloInstruction::CreateParameter(0, shape, "p"));
+  std::vector<HloInstruction*> ops;
+  HloInstruction* prev = param;
+  for (int64_t i = 0; i < n; ++i) {
+    prev = builder.AddInstruction(HloInstruction::CreateBinary(
+        shape, HloOpcode::kAdd, wide ? param : prev, param));
+    ops.push_back(prev);
+  }
+  if (wide) {
+    builder.AddInstruction(HloInstruction::CreateTuple(ops));
+  }
+  module->AddEntryComputation(builder.Build());
+  return module;
+}
+
+void BM_ReachabilityBuild(::testing::benchmark::State& state) {
+  const int64_t n = state.range(0);
+  const bool wide = state.range(1);
+  auto module = MakeBenchmarkModule(n, wide);
+  for (auto s : state) {
+    auto reachability = HloReachabilityMap::Build(module->entry_computation());
+    tsl::testing::DoNotOptimize(reachability);
+  }
+}
+
+// Measures keeping the map up to date while copies are inserted in the middle
+// of the computation. Without incremental updates, every insertion would cost
+// a BM_ReachabilityBuild.
+void BM_ReachabilityAddInstruction(::testing::benchmark::State& state) {
+  const int64_t n = state.range(0);
+  const bool wide = state.range(1);
+  auto module = MakeBenchmarkModule(n, wide);
+  HloComputation* computation = module->entry_computation();
+  std::vector<HloInstruction*> ops = computation->MakeInstructionPostOrder();
+  auto reachability = HloReachabilityMap::Build(computation);
+  int64_t i = 0;
+  for (auto s : state) {
+    state.PauseTiming();
+    // Insert a copy between an op in the second half and its first user.
+    HloInstruction* op = ops[ops.size() / 2 + i++ % (ops.size() / 2 - 1)];
+    HloInstruction* user = op->users().front();
+    HloInstruction* copy = computation->AddInstruction(
+        HloInstruction::CreateUnary(op->shape(), HloOpcode::kCopy, op));
+    TF_CHECK_OK(op->ReplaceUseWith(user, copy));
+    state.ResumeTiming();
+    reachability->AddInstruction(copy);
+  }
+}
+
+BENCHMARK(BM_ReachabilityBuild)
+    ->ArgPair(1 << 10, false)
+    ->ArgPair(1 << 14, false)
+    ->ArgPair(1 << 10, true)
+    ->ArgPair(1 << 14, true);
+BENCHMARK(BM_ReachabilityAddInstruction)
+    ->ArgPair(1 << 10, false)
+    ->ArgPair(1 << 14, false)
+    ->ArgPair(1 << 10, true)
+    ->ArgPair(1 << 14, true);
+
 }  // namespace
 
 }  // namespace xla
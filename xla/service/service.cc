@@ -94,6 +94,18 @@ Status RecordResult(const ShapedBuffer& result, se::Stream* stream,
   return OkStatus();
 }
 
+// Unless it is set, the number of compilation cache shards follows the size
+// of the intra-op thread pool.
+CompilationCache::Options CompilationCacheOptions(
+    const ServiceOptions& options) {
+  CompilationCache::Options result = options.compilation_cache_options();
+  if (result.num_shards <= 0 && options.intra_op_parallelism_threads() > 0) {
+    result.num_shards = CompilationCache::DefaultNumShards(
+        options.intra_op_parallelism_threads());
+  }
+  return result;
+}
+
 }  // namespace
 
 ServiceOptions& ServiceOptions::set_platform(se::Platform* platform) {
@@ -130,6 +142,17 @@ const std::optional<std::set<int>>& ServiceOptions::allowed_devices() const {
   return allowed_devices_;
 }
 
+ServiceOptions& ServiceOptions::set_compilation_cache_options(
+    const CompilationCache::Options& compilation_cache_options) {
+  compilation_cache_options_ = compilation_cache_options;
+  return *this;
+}
+
+const CompilationCache::Options& ServiceOptions::compilation_cache_options()
+    const {
+  return compilation_cache_options_;
+}
+
 /* static */ StatusOr<std::unique_ptr<Service>> Service::NewService(
     se::Platform* platform) {
   ServiceOptions default_options;
@@ -157,6 +180,7 @@ const std::optional<std::set<int>>& ServiceOptions::allowed_devices() const {
 Service::Service(const ServiceOptions& options,
                  std::unique_ptr<Backend> execute_backend)
     : options_(options),
+      compilation_cache_(CompilationCacheOptions(options)),
       allocation_tracker_(execute_backend.get()),
       execute_backend_(std::move(execute_backend)) {
   CHECK_GT(options_.number_of_replicas(), 0);
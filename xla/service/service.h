@@ -67,11 +67,18 @@ class ServiceOptions {
       const std::optional<std::set<int>>& allowed_devices);
   const std::optional<std::set<int>>& allowed_devices() const;
 
+  // Sets the byte budget, eviction policy and sharding of the cache holding
+  // compiled executables.
+  ServiceOptions& set_compilation_cache_options(
+      const CompilationCache::Options& compilation_cache_options);
+  const CompilationCache::Options& compilation_cache_options() const;
+
  private:
   se::Platform* platform_ = nullptr;
   int number_of_replicas_ = 1;
   int intra_op_parallelism_threads_ = -1;
   std::optional<std::set<int>> allowed_devices_;
+  CompilationCache::Options compilation_cache_options_;
 };
 
 // The XLA service object, which is the same across all platforms. It maintains
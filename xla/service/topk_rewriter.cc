@@ -146,7 +146,7 @@ static bool IsNanSafeGt(HloComputation* comp) {
 
   auto match_all_types = [](HloInstruction* root, auto callback) {
     bool result = false;
-    for (auto type : {BF16, F32, S32, U32}) {
+    for (auto type : {BF16, F16, F32, S32, U32}) {
       result = result || Match(root, callback(type));
     }
     return result;
@@ -259,7 +259,8 @@ StatusOr<bool> TopkRewriter::TransformToCustomCall(
       const PrimitiveType element_type = data->shape().element_type();
 
       if ((data->shape().rank() != 1 && data->shape().rank() != 2) ||
-          (element_type != F32 && element_type != BF16)) {
+          (element_type != F32 && element_type != BF16 && element_type != F16 &&
+           element_type != S32 && element_type != U32)) {
         continue;
       }
 
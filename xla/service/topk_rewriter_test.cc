@@ -350,6 +350,33 @@ ENTRY cluster {
   EXPECT_THAT(cc->custom_call_target(), "TopK");
 }
 
+TEST_F(TopkRewriterTest, RewriteS32) {
+  const std::string hlo_string = R"(
+HloModule module
+
+%compare {
+  %p.1.lhs = s32[] parameter(0)
+  %p.1.rhs = s32[] parameter(1)
+  ROOT %gt = pred[] compare(%p.1.lhs, %p.1.rhs), direction=GT
+}
+
+ENTRY cluster {
+  %arg_tuple.1 = s32[8,1234] parameter(0)
+  %sort.27 = s32[8,1234] sort(%arg_tuple.1), dimensions={1}, is_stable=true, to_apply=%compare
+  ROOT %slice.29 = s32[8,5] slice(%sort.27), slice={[0:8], [0:5]}
+})";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TopkRewriter rewriter(
+      [](const HloSortInstruction*, int64_t) { return true; });
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, rewriter.Run(module.get()));
+  TF_ASSERT_OK(HloDCE().Run(module.get()).status());
+  EXPECT_TRUE(changed);
+  EXPECT_THAT(
+      module->entry_computation()->root_instruction(),
+      GmockMatch(m::GetTupleElement(m::CustomCall(m::Parameter(0)), 0)));
+}
+
 TEST_F(TopkRewriterTest, RoundTripNoIota) {
   const std::string hlo_string = R"(
 HloModule module
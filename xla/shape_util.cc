@@ -1767,6 +1767,37 @@ struct ParallelState {
   return pstate.status;
 }
 
+/* static */ void ShapeUtil::ForEachLinearBlockParallel(
+    int64_t count, int64_t min_block_size,
+    ForEachLinearBlockVisitorFunction visitor_function) {
+  if (count <= 0) {
+    return;
+  }
+  tsl::thread::ThreadPool* pool = ParallelState(/*task_count=*/0).pool;
+  const int thread_id = pool->CurrentThreadId();
+  // A few blocks per thread evens out blocks that take longer than others.
+  const int64_t max_blocks = thread_id == -1 ? 4 * pool->NumThreads() : 1;
+  const int64_t block_size = CeilOfRatio(
+      count, std::clamp<int64_t>(count / std::max<int64_t>(min_block_size, 1),
+                                 1, max_blocks));
+  if (block_size >= count) {
+    visitor_function(0, count, thread_id);
+    return;
+  }
+
+  ParallelState pstate(CeilOfRatio(count, block_size) - 1);
+  for (int64_t begin = block_size; begin < count; begin += block_size) {
+    pstate.pool->Schedule([&, begin] {
+      visitor_function(begin, std::min(begin + block_size, count),
+                       pstate.pool->CurrentThreadId());
+      pstate.TaskComplete();
+    });
+  }
+  // The calling thread takes the first block.
+  visitor_function(0, std::min(block_size, count), thread_id);
+  pstate.Wait();
+}
+
 /* static */ int ShapeUtil::GetForEachIndexParallelThreadCount() {
   ParallelState pstate(/*task_count=*/0);
   return pstate.pool->NumThreads();
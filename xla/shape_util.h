@@ -797,6 +797,20 @@ class ShapeUtil {
       const Shape& shape,
       const ForEachParallelVisitorFunction& visitor_function);
 
+  using ForEachLinearBlockVisitorFunction =
+      absl::FunctionRef<void(int64_t, int64_t, int)>;
+
+  // Splits [0, count) into contiguous blocks of at least `min_block_size`
+  // elements and calls visitor_function(begin, end, thread_id) once per block,
+  // in parallel on the threadpool of ForEachIndexParallel*. `thread_id` has
+  // the same meaning as for ForEachIndexParallel. Unlike ForEachIndexParallel,
+  // which schedules a task per index, the number of tasks is bounded by the
+  // number of threads. When called from a thread of that pool, e.g. from a
+  // nested parallel loop, all blocks run on the calling thread.
+  static void ForEachLinearBlockParallel(
+      int64_t count, int64_t min_block_size,
+      ForEachLinearBlockVisitorFunction visitor_function);
+
   // In this case, we care about transposes that swap two dimensions of a
   // a shape that can be viewed as three logical components 0-1-2 in the order
   // of major to minor.
@@ -15,8 +15,10 @@ limitations under the License.
 
 #include "xla/shape_util.h"
 
+#include <atomic>
 #include <numeric>
 #include <optional>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
@@ -696,6 +698,44 @@ TEST(ShapeUtilTest, ForEachIndexParallel_Empty) {
   EXPECT_FALSE(called);
 }
 
+TEST(ShapeUtilTest, ForEachLinearBlockParallel) {
+  const int kThreadCount = ShapeUtil::GetForEachIndexParallelThreadCount();
+  for (int64_t count : {0, 1, 7, 1000, 100003}) {
+    for (int64_t min_block_size : {1, 64, 1 << 20}) {
+      std::vector<std::atomic<int>> visits(count);
+      auto visit = [&](int64_t begin, int64_t end, int thread_id) {
+        EXPECT_LT(begin, end);
+        EXPECT_GE(thread_id, -1);
+        EXPECT_LT(thread_id, kThreadCount);
+        for (int64_t i = begin; i < end; ++i) {
+          visits[i].fetch_add(1);
+        }
+      };
+      ShapeUtil::ForEachLinearBlockParallel(count, min_block_size, visit);
+      for (int64_t i = 0; i < count; ++i) {
+        ASSERT_EQ(visits[i].load(), 1) << "count=" << count << " i=" << i;
+      }
+    }
+  }
+}
+
+TEST(ShapeUtilTest, ForEachLinearBlockParallel_Nested) {
+  constexpr int64_t kOuter = 64;
+  constexpr int64_t kInner = 1000;
+  std::atomic<int64_t> sum = 0;
+  ShapeUtil::ForEachLinearBlockParallel(
+      kOuter, /*min_block_size=*/1, [&](int64_t begin, int64_t end, int) {
+        for (int64_t i = begin; i < end; ++i) {
+          ShapeUtil::ForEachLinearBlockParallel(
+              kInner, /*min_block_size=*/1,
+              [&](int64_t inner_begin, int64_t inner_end, int) {
+                sum.fetch_add(inner_end - inner_begin);
+              });
+        }
+      });
+  EXPECT_EQ(sum.load(), kOuter * kInner);
+}
+
 TEST(ShapeUtilTest, ForEachIndexParallel_DimensionPinnedWithZeros) {
   // Some users of ForEachIndex use base = a, count = 0, incr = 0 to indicate
   // that the given dimension should be pinned to the value "a" during the
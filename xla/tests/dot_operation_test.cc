@@ -2076,6 +2076,116 @@ ENTRY MatrixVectorBF16 {
   EXPECT_TRUE(RunAndCompare(hlo_string, ErrorSpec{4e-3, 4e-3}));
 }
 
+XLA_TEST_F(DotOperationTextTest, MixedPrecisionGemmBF16F32) {
+  absl::string_view hlo_string =
+      R"(
+HloModule MixedPrecisionGemmBF16F32
+
+ENTRY MixedPrecisionGemmBF16F32 {
+  p0 = bf16[64,96] parameter(0)
+  p1 = bf16[96,48] parameter(1)
+  ROOT dot = f32[64,48] dot(p0, p1), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+}
+)";
+
+  EXPECT_TRUE(RunAndCompare(hlo_string, ErrorSpec{4e-3, 4e-3}));
+}
+
+XLA_TEST_F(DotOperationTextTest, MixedPrecisionBatchGemmBF16F32) {
+  absl::string_view hlo_string =
+      R"(
+HloModule MixedPrecisionBatchGemmBF16F32
+
+ENTRY MixedPrecisionBatchGemmBF16F32 {
+  p0 = bf16[3,64,96] parameter(0)
+  p1 = bf16[3,96,48] parameter(1)
+  ROOT dot = f32[3,64,48] dot(p0, p1), lhs_batch_dims={0}, lhs_contracting_dims={2}, rhs_batch_dims={0}, rhs_contracting_dims={1}
+}
+)";
+
+  EXPECT_TRUE(RunAndCompare(hlo_string, ErrorSpec{4e-3, 4e-3}));
+}
+
+XLA_TEST_F(DotOperationTextTest, MixedPrecisionGemmS8S32) {
+  absl::string_view hlo_string =
+      R"(
+HloModule MixedPrecisionGemmS8S32
+
+ENTRY MixedPrecisionGemmS8S32 {
+  p0 = s8[64,96] parameter(0)
+  p1 = s8[96,48] parameter(1)
+  ROOT dot = s32[64,48] dot(p0, p1), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+}
+)";
+
+  EXPECT_TRUE(RunAndCompare(hlo_string, ErrorSpec{0, 0}));
+}
+
+XLA_TEST_F(DotOperationTextTest, MixedPrecisionBatchGemmS8S32) {
+  absl::string_view hlo_string =
+      R"(
+HloModule MixedPrecisionBatchGemmS8S32
+
+ENTRY MixedPrecisionBatchGemmS8S32 {
+  p0 = s8[3,64,96] parameter(0)
+  p1 = s8[3,96,48] parameter(1)
+  ROOT dot = s32[3,64,48] dot(p0, p1), lhs_batch_dims={0}, lhs_contracting_dims={2}, rhs_batch_dims={0}, rhs_contracting_dims={1}
+}
+)";
+
+  EXPECT_TRUE(RunAndCompare(hlo_string, ErrorSpec{0, 0}));
+}
+
+XLA_TEST_F(DotOperationTextTest, MixedPrecisionGemmColumnMajor) {
+  absl::string_view hlo_string =
+      R"(
+HloModule MixedPrecisionGemmColumnMajor
+
+ENTRY MixedPrecisionGemmColumnMajor {
+  p0 = bf16[64,96]{0,1} parameter(0)
+  p1 = bf16[96,48]{0,1} parameter(1)
+  p2 = s8[64,96]{0,1} parameter(2)
+  p3 = s8[96,48]{0,1} parameter(3)
+  dot.0 = f32[64,48]{0,1} dot(p0, p1), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  dot.1 = s32[64,48]{0,1} dot(p2, p3), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  convert = f32[64,48]{0,1} convert(dot.1)
+  ROOT tuple = (f32[64,48]{0,1}, f32[64,48]{0,1}) tuple(dot.0, convert)
+}
+)";
+
+  EXPECT_TRUE(RunAndCompare(hlo_string, ErrorSpec{4e-3, 4e-3}));
+}
+
+// Dots that are not GEMMs get their operands upcast before they are emitted.
+// With the upcasting disabled, the mixed precision dots below are emitted as
+// naive loops that widen each operand element.
+XLA_TEST_F(DotOperationTextTest,
+           DISABLED_ON_GPU(MixedPrecisionMatrixVectorNoUpcast)) {
+  absl::string_view hlo_string =
+      R"(
+HloModule MixedPrecisionMatrixVectorNoUpcast
+
+ENTRY MixedPrecisionMatrixVectorNoUpcast {
+  p0 = bf16[64,96]{0,1} parameter(0)
+  p1 = bf16[96] parameter(1)
+  p2 = s8[64,96]{0,1} parameter(2)
+  p3 = s8[96] parameter(3)
+  dot.0 = f32[64] dot(p0, p1), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  dot.1 = s32[64] dot(p2, p3), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+  convert = f32[64] convert(dot.1)
+  ROOT tuple = (f32[64], f32[64]) tuple(dot.0, convert)
+}
+)";
+
+  auto mod_config = GetModuleConfigForTest();
+  auto debug_options = GetDebugOptionsForTest();
+  debug_options.add_xla_disable_hlo_passes("operand_upcaster");
+  mod_config.set_debug_options(debug_options);
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(hlo_string, mod_config));
+  EXPECT_TRUE(RunAndCompare(std::move(module), ErrorSpec{4e-3, 4e-3}));
+}
+
 // Regression test for b/138155357, where we were incorrectly creating a dot-add
 // fusion where the dot had a batch dimension.  This isn't supported on the CPU
 // backend.
@@ -24,10 +24,12 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "xla/hlo/ir/hlo_module.h"
 #include "xla/literal.h"
+#include "xla/literal_container.h"
 #include "xla/pjrt/gpu/se_gpu_pjrt_client.h"
 #include "xla/pjrt/pjrt_client.h"
 #include "xla/pjrt/pjrt_executable.h"
@@ -447,19 +449,75 @@ Status FunctionalHloRunner::LoadAndRunAndDump(
     const xla::FunctionalHloRunner::RawCompileOptions& raw_compile_options,
     const xla::FunctionalHloRunner::RunningOptions& running_options,
     absl::Span<const std::string> hlo_files, InputFormat input_format,
-    std::string dump_output_to, int task_id) {
+    std::string dump_output_to, int task_id, std::string arguments_file) {
   TF_ASSIGN_OR_RETURN(CompileOptions compile_options,
                       FunctionalHloRunner::CreateCompileOptions(
                           client, raw_compile_options, task_id));
-  TF_ASSIGN_OR_RETURN(FunctionalHloRunner::PerDeviceLiteralVecType output,
-                      FunctionalHloRunner::LoadAndRun(
-                          client, preproc_options, compile_options,
-                          running_options, hlo_files, input_format));
+  FunctionalHloRunner::PerDeviceLiteralVecType output;
+  if (arguments_file.empty()) {
+    TF_ASSIGN_OR_RETURN(output, FunctionalHloRunner::LoadAndRun(
+                                    client, preproc_options, compile_options,
+                                    running_options, hlo_files, input_format));
+  } else {
+    const ExecutableBuildOptions& build_options =
+        compile_options.executable_build_options;
+    if (!build_options.has_device_assignment()) {
+      return InvalidArgument(
+          "Loading arguments from %s requires a device assignment.",
+          arguments_file);
+    }
+    TF_ASSIGN_OR_RETURN(LiteralVec argument_literals,
+                        LoadArgumentsFromLiteralContainer(arguments_file));
+    // All participating local devices share the same argument literals.
+    const DeviceAssignment& device_assignment =
+        build_options.device_assignment();
+    absl::flat_hash_set<int> participating_device_ids;
+    for (int replica = 0; replica < device_assignment.replica_count();
+         ++replica) {
+      for (int computation = 0;
+           computation < device_assignment.computation_count(); ++computation) {
+        participating_device_ids.insert(
+            device_assignment(replica, computation));
+      }
+    }
+    std::vector<int> argument_indices(argument_literals.size());
+    absl::c_iota(argument_indices, 0);
+    PerDeviceIndexVecType per_device_index_vec;
+    for (PjRtDevice* device : GetLocalDevices(client)) {
+      if (participating_device_ids.contains(device->id())) {
+        per_device_index_vec[device->id()] = argument_indices;
+      }
+    }
+    TF_ASSIGN_OR_RETURN(
+        output, FunctionalHloRunner::LoadAndRun(
+                    client, preproc_options, compile_options, running_options,
+                    hlo_files, input_format, argument_literals,
+                    per_device_index_vec));
+  }
   return dump_output_to.empty()
              ? OkStatus()
              : FunctionalHloRunner::DumpOutput(output, dump_output_to, task_id);
 }
 
+StatusOr<FunctionalHloRunner::LiteralVec>
+FunctionalHloRunner::LoadArgumentsFromLiteralContainer(
+    const std::string& path) {
+  TF_ASSIGN_OR_RETURN(MappedLiteral arguments, MappedLiteral::Open(path));
+  const Shape& shape = arguments.literal().shape();
+  if (!shape.IsTuple()) {
+    return InvalidArgument(
+        "Expected %s to hold a tuple of arguments, but its shape is %s.", path,
+        ShapeUtil::HumanString(shape));
+  }
+  LiteralVec argument_literals;
+  argument_literals.reserve(shape.tuple_shapes_size());
+  for (int i = 0; i < shape.tuple_shapes_size(); ++i) {
+    argument_literals.push_back(
+        LiteralSlice(arguments.literal(), {i}).Clone());
+  }
+  return argument_literals;
+}
+
 StatusOr<FunctionalHloRunner::PerDeviceLiteralVecType>
 FunctionalHloRunner::LoadAndRun(PjRtClient& client,
                                 const PreprocessingOptions& preproc_options,
@@ -221,6 +221,9 @@ class FunctionalHloRunner {
 
   // Runs on HLO module and dumps the output if needed.
   //
+  // If `arguments_file` is not empty, every device runs the module with the
+  // arguments loaded by LoadArgumentsFromLiteralContainer.
+  //
   // This is the highest level API in this file.
   static Status LoadAndRunAndDump(
       PjRtClient& client,
@@ -228,7 +231,15 @@ class FunctionalHloRunner {
       const xla::FunctionalHloRunner::RawCompileOptions& raw_compile_options,
       const xla::FunctionalHloRunner::RunningOptions& running_options,
       absl::Span<const std::string> hlo_files, InputFormat input_format,
-      std::string dump_output_to = "", int task_id = 0);
+      std::string dump_output_to = "", int task_id = 0,
+      std::string arguments_file = "");
+
+  // Loads module arguments from a binary literal container (see
+  // xla/literal_container.h) holding a tuple with one element per parameter.
+  // The container is memory-mapped, so each argument is copied out of the page
+  // cache once instead of being parsed from a LiteralProto.
+  static StatusOr<LiteralVec> LoadArgumentsFromLiteralContainer(
+      const std::string& path);
 
   // Loads an HLO module from hlo_file according to input_format and run it.
   // The HLO module is run with the provided arguments if the arguments map is
@@ -65,6 +65,7 @@ int main(int argc, char** argv) {
   std::string hlo_file = "";
   bool should_run = true;
   std::string dump_output_literal_to = "";
+  std::string arguments_file = "";
   int task_id = 0;
   std::string device_type_str = "gpu";
   xla::FunctionalHloRunner::PreprocessingOptions preproc_options;
@@ -78,6 +79,10 @@ int main(int argc, char** argv) {
       tsl::Flag("hlo_file", &hlo_file,
                 "A text or proto buf file for HLO input"),
       tsl::Flag("run", &should_run, "Should we run the compiled HLO?"),
+      tsl::Flag("arguments_file", &arguments_file,
+                "A binary literal container (see xla/literal_container.h) "
+                "holding a tuple of the module arguments, used by every "
+                "device instead of snapshot or generated arguments."),
       tsl::Flag("dump_output_literal_to", &dump_output_literal_to,
                 "A path to which the HLO output will be dumped. "
                 "Example: /a/b/literal.txt."),
@@ -120,7 +125,8 @@ int main(int argc, char** argv) {
   if (should_run) {
     TF_QCHECK_OK(xla::FunctionalHloRunner::LoadAndRunAndDump(
         *client.value(), preproc_options, raw_compile_options, running_options,
-        {hlo_file}, input_format, dump_output_literal_to, task_id));
+        {hlo_file}, input_format, dump_output_literal_to, task_id,
+        arguments_file));
   } else {
     TF_QCHECK_OK(xla::FunctionalHloRunner::LoadAndCompile(
         *client.value(), preproc_options, raw_compile_options, hlo_file,
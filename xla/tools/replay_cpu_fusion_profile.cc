@@ -0,0 +1,152 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A tool for comparing the predicted and the actual benefit of profile-guided
+// CPU fusion. See kUsage for details.
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "xla/debug_options_flags.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/literal.h"
+#include "xla/service/cpu/cpu_instruction_fusion.h"
+#include "xla/service/hlo_runner.h"
+#include "xla/service/platform_util.h"
+#include "xla/tests/test_utils.h"
+#include "xla/tools/hlo_module_loader.h"
+#include "xla/xla.pb.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/init_main.h"
+#include "tsl/platform/logging.h"
+#include "tsl/util/command_line_flags.h"
+
+namespace {
+const char* const kUsage = R"(
+This tool replays a ProfiledInstructionsProto (as read by
+--xla_cpu_fusion_profile_path) against an HLO module on the CPU. It reports the
+run time the profile-guided fusion decisions are predicted to save, then
+compiles the module with and without the profile, runs both on the same fake
+arguments and reports the run time they actually save.
+
+The prediction is made by running the fusion pass on the module as given, so
+pass the module as the CPU fusion pass sees it, e.g. as dumped with
+--xla_dump_hlo_pass_re=fusion.
+
+Usage:
+
+  bazel run replay_cpu_fusion_profile -- -input=path/to/hlo_module \
+    -format=[hlo|pb|pbtxt] -profile=path/to/profile.pbtxt [-num_runs=10]
+)";
+
+// Returns the median compute time of `num_runs` runs of `module`, in
+// microseconds.
+double MedianRunTimeUs(xla::HloRunner& runner,
+                       std::unique_ptr<xla::HloModule> module,
+                       const std::vector<xla::Literal>& arguments,
+                       int num_runs) {
+  std::unique_ptr<xla::Executable> executable =
+      runner.CreateExecutable(std::move(module), /*run_hlo_passes=*/true)
+          .value();
+  std::vector<const xla::Literal*> argument_ptrs;
+  for (const xla::Literal& argument : arguments) {
+    argument_ptrs.push_back(&argument);
+  }
+  // The first run warms up the caches and the thread pool.
+  TF_CHECK_OK(runner
+                  .ExecuteWithExecutable(executable.get(), argument_ptrs,
+                                         /*profile=*/nullptr)
+                  .status());
+  std::vector<int64_t> times_ns;
+  for (int i = 0; i < num_runs; ++i) {
+    xla::ExecutionProfile profile;
+    TF_CHECK_OK(
+        runner.ExecuteWithExecutable(executable.get(), argument_ptrs, &profile)
+            .status());
+    times_ns.push_back(profile.compute_time_ns());
+  }
+  std::nth_element(times_ns.begin(), times_ns.begin() + times_ns.size() / 2,
+                   times_ns.end());
+  return times_ns[times_ns.size() / 2] / 1e3;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string input, format, profile_path;
+  int32_t num_runs = 10;
+  std::vector<tsl::Flag> flag_list = {
+      tsl::Flag("input", &input, "input file"),
+      tsl::Flag("format", &format, "hlo|pb|pbtxt"),
+      tsl::Flag("profile", &profile_path,
+                "ProfiledInstructionsProto text file"),
+      tsl::Flag("num_runs", &num_runs, "timed runs per configuration")};
+  xla::AppendDebugOptionsFlags(&flag_list);
+  const std::string kUsageString =
+      absl::StrCat(kUsage, "\n\n", tsl::Flags::Usage(argv[0], flag_list));
+  bool parse_ok = tsl::Flags::Parse(&argc, argv, flag_list);
+  tsl::port::InitMain(kUsageString.c_str(), &argc, &argv);
+  if (!parse_ok || profile_path.empty() || num_runs < 1) {
+    LOG(QFATAL) << kUsageString;
+  }
+
+  std::unique_ptr<xla::HloModule> module =
+      xla::LoadModuleFromFile(input, {}, format).value();
+  xla::ProfiledInstructionsProto profile;
+  TF_CHECK_OK(tsl::ReadTextProto(tsl::Env::Default(), profile_path, &profile));
+
+  xla::cpu::CpuInstructionFusion::ProfileGuidedStats stats;
+  TF_CHECK_OK(xla::cpu::CpuInstructionFusion(profile, &stats)
+                  .Run(module->Clone().get())
+                  .status());
+
+  xla::HloRunner runner(xla::PlatformUtil::GetPlatform("cpu").value());
+  std::vector<xla::Literal> arguments =
+      xla::MakeFakeArguments(module.get()).value();
+
+  std::unique_ptr<xla::HloModule> static_module = module->Clone();
+  xla::DebugOptions static_options = static_module->config().debug_options();
+  static_options.clear_xla_cpu_fusion_profile_path();
+  static_module->config().set_debug_options(static_options);
+  double static_us = MedianRunTimeUs(runner, std::move(static_module),
+                                     arguments, num_runs);
+
+  std::unique_ptr<xla::HloModule> guided_module = module->Clone();
+  xla::DebugOptions guided_options = guided_module->config().debug_options();
+  guided_options.set_xla_cpu_fusion_profile_path(profile_path);
+  guided_module->config().set_debug_options(guided_options);
+  double guided_us = MedianRunTimeUs(runner, std::move(guided_module),
+                                     arguments, num_runs);
+
+  std::cout << absl::StrFormat(
+                   "Profile-guided fusion decisions: %d enabled, %d "
+                   "prevented.\n",
+                   stats.fusions_enabled, stats.fusions_prevented)
+            << absl::StrFormat("Predicted gain: %.2f us\n",
+                               stats.predicted_gain_us)
+            << absl::StrFormat(
+                   "Median run time: %.2f us static, %.2f us profile-guided "
+                   "over %d runs\n",
+                   static_us, guided_us, num_runs)
+            << absl::StrFormat("Actual gain: %.2f us\n",
+                               static_us - guided_us);
+  return 0;
+}
@@ -30,8 +30,10 @@ limitations under the License.
 #include "xla/hlo/ir/hlo_module.h"
 #include "xla/literal.h"
 #include "xla/literal_comparison.h"
+#include "xla/literal_container.h"
 #include "xla/service/hlo_runner.h"
 #include "xla/service/hlo_verifier.h"
+#include "xla/shape_util.h"
 #include "xla/tests/test_utils.h"
 #include "xla/tools/hlo_control_flow_flattening.h"
 #include "xla/tools/hlo_module_loader.h"
@@ -145,8 +147,33 @@ Status RunAndCompare(
                                         options.use_large_float_range,
                                         options.treat_gte_as_data_formatting));
   // Use provided input literals as arguments, if any.
-  if (iteration_literals_proto != nullptr &&
-      iteration_literals_proto->arguments_size() != 0) {
+  if (!options.input_literals_file.empty()) {
+    // The container is memory-mapped, so each argument is copied straight out
+    // of the page cache without decoding a proto.
+    TF_ASSIGN_OR_RETURN(MappedLiteral input_literals,
+                        MappedLiteral::Open(options.input_literals_file));
+    const Shape& input_shape = input_literals.literal().shape();
+    if (!input_shape.IsTuple() ||
+        ShapeUtil::TupleElementCount(input_shape) != args.size()) {
+      return xla::InvalidArgument(
+          "Failed to use %s as arguments; expected a tuple of %d arguments, "
+          "got %s.",
+          options.input_literals_file, args.size(),
+          ShapeUtil::HumanString(input_shape));
+    }
+    for (int i = 0; i < args.size(); ++i) {
+      if (!literal_comparison::EqualShapes(args[i].shape(),
+                                           input_shape.tuple_shapes(i))
+               .ok()) {
+        return xla::InvalidArgument(
+            "Failed to use input literals for argument %d "
+            "because of a shape mismatch.",
+            i);
+      }
+      args[i] = LiteralSlice(input_literals.literal(), {i}).Clone();
+    }
+  } else if (iteration_literals_proto != nullptr &&
+             iteration_literals_proto->arguments_size() != 0) {
     if (iteration_literals_proto->arguments_size() != args.size()) {
       return xla::InvalidArgument(
           "Failed to use input literals as arguments; mismatched "
@@ -246,7 +273,8 @@ Status RunAndCompare(
       LoadModuleFromFile(hlo_filename, hlo_module_loader_details::Config(),
                          options.input_format, config_modifier_hook));
   std::unique_ptr<RunHloModuleIterationLiterals> iteration_literals_proto_local;
-  if (iteration_literals_proto == nullptr) {
+  if (iteration_literals_proto == nullptr &&
+      options.input_literals_file.empty()) {
     // User did not explicitly give input
     if (!options.force_fake_data &&
         (options.input_format == "pb" || options.input_format == "pbtxt")) {
@@ -123,6 +123,11 @@ int main(int argc, char** argv) {
       tsl::Flag("input_module", &opts.input_module,
                 "A path to a file containing the HLO module. Can also pass "
                 "a this as argv[1], but this flag is more explicit."),
+      tsl::Flag("input_literals_file", &opts.input_literals_file,
+                "A path to a binary literal container (see "
+                "xla/literal_container.h) holding a tuple with one element per "
+                "module parameter. The file is memory-mapped and its elements "
+                "are used as arguments instead of fake or snapshot data."),
       tsl::Flag(
           "iterations", &opts.iterations,
           "The number of times to run the module. Each iteration will be run "
@@ -13,16 +13,18 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-// Usage: show_literal <path-to-serialized-literal-proto>
+// Usage: show_literal <path-to-serialized-literal>
 //
 // Dumps out the Literal::ToString of a tsl::WriteBinaryProto format
-// Literal serialized on disk.
+// Literal serialized on disk, or of a binary literal container (see
+// xla/literal_container.h), which is memory-mapped rather than read.
 
 #include <stdio.h>
 
 #include <string>
 
 #include "xla/literal.h"
+#include "xla/literal_container.h"
 #include "xla/types.h"
 #include "xla/xla_data.pb.h"
 #include "tsl/platform/env.h"
@@ -34,8 +36,13 @@ int main(int argc, char **argv) {
   tsl::port::InitMain(argv[0], &argc, &argv);
 
   if (argc < 2) {
-    LOG(QFATAL) << "Usage: " << argv[0]
-                << " <path-to-serialized-literal-proto>";
+    LOG(QFATAL) << "Usage: " << argv[0] << " <path-to-serialized-literal>";
+  }
+
+  if (xla::IsLiteralContainerFile(argv[1]).value()) {
+    xla::MappedLiteral mapped = xla::MappedLiteral::Open(argv[1]).value();
+    fprintf(stderr, "%s\n", mapped.literal().ToString().c_str());
+    return 0;
   }
 
   xla::LiteralProto literal_proto;